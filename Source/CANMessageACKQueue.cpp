@@ -1,11 +1,17 @@
 #include "CANMessageACKQueue.h"
-#include <N_USData_Runner.h>
+#include "ISOTP_Common.h"
+#include "ISOTP_InstrumentedMutex.h"
 
-CANMessageACKQueue::CANMessageACKQueue(CANInterface& canInterface, OSInterface& osInterface, const char* tag)
+#include <ranges>
+
+CANMessageACKQueue::CANMessageACKQueue(CANInterface& canInterface, OSInterface& osInterface, const char* tag,
+                                       ISOTP_Statistics* statistics)
 {
     this->tag          = tag;
-    mutex              = osInterface.osCreateMutex();
+    mutex              = ISOTP_InstrumentedMutex::wrap(osInterface.osCreateMutex(), ISOTP_ACKQueueLock, osInterface,
+                                                       statistics);
     this->canInterface = &canInterface;
+    this->statistics   = statistics;
 }
 CANMessageACKQueue::~CANMessageACKQueue()
 {
@@ -23,6 +29,10 @@ void CANMessageACKQueue::saveAck(const ACKResult ack)
                 OSInterfaceLogDebug(this->tag, "Processing ACK %s for runner with N_AI=%s", ackResultToString(ack),
                                     nAiToString(runner->getN_AI()));
                 runnerAck = ack; // Update the ACK result for the runner.
+                if (ISOTP_TraceBuffer* buffer = traceBuffer.load(std::memory_order_acquire); buffer != nullptr)
+                {
+                    buffer->recordACK(runner->getN_AI(), ack);
+                }
                 break;
             }
         }
@@ -36,16 +46,21 @@ void CANMessageACKQueue::runStep()
 {
     if (const ACKResult ack = canInterface->getWriteFrameACK(); ack != ACK_NONE)
     {
-        OSInterfaceLogDebug(this->tag, "ACK received: %s", ackResultToString(ack));
-        if (mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
-        {
-            saveAck(ack);
-            mutex->signal();
-        }
-        else
-        {
-            OSInterfaceLogError(this->tag, "Failed to acquire mutex for ACK storage of %s", ackResultToString(ack));
-        }
+        onWriteAck(ack);
+    }
+}
+
+void CANMessageACKQueue::onWriteAck(const ACKResult ack)
+{
+    OSInterfaceLogDebug(this->tag, "ACK received: %s", ackResultToString(ack));
+    if (mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        saveAck(ack);
+        mutex->signal();
+    }
+    else
+    {
+        OSInterfaceLogError(this->tag, "Failed to acquire mutex for ACK storage of %s", ackResultToString(ack));
     }
 }
 
@@ -59,6 +74,42 @@ void CANMessageACKQueue::runAvailableAckCallbacks()
     while (callbackHasRun);
 }
 
+bool CANMessageACKQueue::hasAvailableAckCallbacks() const
+{
+    bool res = false;
+    if (mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        res = !messageQueue.empty() && messageQueue.front().second != ACK_NONE;
+        mutex->signal();
+    }
+    return res;
+}
+
+bool CANMessageACKQueue::isWaitingForAcks() const
+{
+    bool res = false;
+    if (mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        res = !messageQueue.empty();
+        mutex->signal();
+    }
+    return res;
+}
+
+uint32_t CANMessageACKQueue::getPendingAcks(const N_AI nAi) const
+{
+    uint32_t res = 0;
+    if (mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        for (const auto& listener : messageQueue | std::views::keys)
+        {
+            res += listener->getN_AI().N_AI == nAi.N_AI ? 1 : 0;
+        }
+        mutex->signal();
+    }
+    return res;
+}
+
 bool CANMessageACKQueue::runNextAvailableAckCallback()
 {
     bool callbackHasRun = false;
@@ -95,14 +146,26 @@ bool CANMessageACKQueue::runNextAvailableAckCallback()
     return callbackHasRun;
 }
 
-bool CANMessageACKQueue::writeFrame(N_USData_Runner& runner, CANFrame& frame)
+bool CANMessageACKQueue::writeFrame(CANMessageACKListener& listener, CANFrame& frame)
 {
     OSInterfaceLogDebug(this->tag, "Writing frame with N_AI=%s", nAiToString(frame.identifier));
     OSInterfaceLogVerbose(this->tag, "Writing frame: %s", frameToString(frame));
     bool res = canInterface->writeFrame(&frame);
+    if (ISOTP_TraceBuffer* buffer = traceBuffer.load(std::memory_order_acquire); buffer != nullptr)
+    {
+        buffer->record(res ? ISOTP_TraceFrameWritten : ISOTP_TraceWriteFailed, frame);
+    }
+    if (res && statistics != nullptr)
+    {
+        statistics->onFrameWritten(frame);
+    }
     if (res && mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
     {
-        messageQueue.emplace_back(&runner, ACK_NONE);
+        messageQueue.emplace_back(&listener, ACK_NONE);
+        if (statistics != nullptr)
+        {
+            statistics->recordACKQueueDepth(messageQueue.size());
+        }
         mutex->signal();
     }
     return res;
@@ -127,3 +190,8 @@ bool CANMessageACKQueue::removeFromQueue(const N_AI runnerNAi)
     }
     return res > 0;
 }
+
+void CANMessageACKQueue::setTraceBuffer(ISOTP_TraceBuffer* buffer)
+{
+    traceBuffer.store(buffer, std::memory_order_release);
+}
@@ -2,35 +2,73 @@
 
 #include "ISOTP.h"
 
+#include <algorithm>
+#include <cstring>
 #include <ranges>
 
+#include "ISOTP_InstrumentedMutex.h"
 #include "N_USData_Indication_Runner.h"
 #include "N_USData_Request_Runner.h"
 
 ISOTP::ISOTP(const typeof(N_AI::N_SA) nSA, const uint32_t totalAvailableMemoryForRunners,
              const N_USData_confirm_cb_t N_USData_confirm_cb, const N_USData_indication_cb_t N_USData_indication_cb,
              const N_USData_FF_indication_cb_t N_USData_FF_indication_cb, OSInterface& osInterface,
-             CANInterface& canInterface, const uint8_t blockSize, const STmin stMin, const char* tag) :
+             CANInterface& canInterface, const uint8_t blockSize, const STmin stMin, const char* tag,
+             const ISOTP_PayloadAllocation payloadAllocation) :
     osInterface(osInterface), canInterface(canInterface),
-    availableMemoryForRunners(totalAvailableMemoryForRunners, osInterface)
+    availableMemoryForRunners(totalAvailableMemoryForRunners, osInterface),
+    slabAllocator(osInterface, payloadAllocation == ISOTP_SlabPayloads ? totalAvailableMemoryForRunners : 0),
+    chunkPool(osInterface, payloadAllocation == ISOTP_ChunkedPayloads ? ISOTP_DefaultChunkSize : 0),
+    runnerPool(osInterface)
 {
     this->tag = tag;
 
     this->queueTag = nullptr;
     ASSERT_SAFE(populateQueueTag(), == true);
 
-    this->canMessageAckQueue = new CANMessageACKQueue(canInterface, osInterface, this->queueTag);
+    this->canMessageAckQueue = new CANMessageACKQueue(canInterface, osInterface, this->queueTag, &this->statistics);
     this->nSA                = nSA;
+    this->localN_SAs.set(nSA);
     this->availableMemoryForRunners.set(totalAvailableMemoryForRunners);
+    if (payloadAllocation == ISOTP_SlabPayloads)
+    {
+        if (this->slabAllocator.isEnabled())
+        {
+            this->availableMemoryForRunners.set(this->slabAllocator.getCapacity()); // Rounded down to whole blocks.
+            OSInterfaceLogInfo(this->tag, "Payload region of %" PRIu32 " bytes, largest message %" PRIu32 " bytes",
+                               this->slabAllocator.getCapacity(), this->slabAllocator.getLargestBlockSize());
+        }
+        else
+        {
+            OSInterfaceLogError(this->tag, "Failed to allocate the payload region, payloads are taken from the heap");
+        }
+    }
+    if (payloadAllocation == ISOTP_ChunkedPayloads && !this->chunkPool.isEnabled())
+    {
+        OSInterfaceLogError(this->tag, "Failed to create the chunk pool, payloads are stored contiguously");
+    }
+    int64_t memoryForRunners = totalAvailableMemoryForRunners;
+    this->availableMemoryForRunners.get(&memoryForRunners);
+    this->statistics.setMemoryForRunners(memoryForRunners);
     this->N_USData_confirm_cb       = N_USData_confirm_cb;
     this->N_USData_indication_cb    = N_USData_indication_cb;
     this->N_USData_FF_indication_cb = N_USData_FF_indication_cb;
+    this->acceptanceFilters_cb      = nullptr;
     this->blockSize                 = blockSize;
     this->lastRunTime               = 0;
+    this->ackLastRunTime            = 0;
+    this->nextRunTime               = ISOTP_NoNextRunTime;
+    this->pushMode                  = false;
+    this->wakeUp_cb                 = nullptr;
 
-    this->configMutex            = this->osInterface.osCreateMutex();
-    this->notStartedRunnersMutex = this->osInterface.osCreateMutex();
-    this->runnersMutex           = this->osInterface.osCreateMutex();
+    this->N_USData_indication_segments_cb = nullptr;
+
+    this->configMutex = ISOTP_InstrumentedMutex::wrap(this->osInterface.osCreateMutex(), ISOTP_ConfigLock,
+                                                      this->osInterface, &this->statistics);
+    this->notStartedRunnersMutex = ISOTP_InstrumentedMutex::wrap(
+        this->osInterface.osCreateMutex(), ISOTP_NotStartedRunnersLock, this->osInterface, &this->statistics);
+    this->runnersMutex = ISOTP_InstrumentedMutex::wrap(this->osInterface.osCreateMutex(), ISOTP_RunnersLock,
+                                                       this->osInterface, &this->statistics);
 
     assert(this->configMutex != nullptr && this->notStartedRunnersMutex != nullptr && "Mutex creation failed");
 
@@ -62,23 +100,108 @@ ISOTP::~ISOTP()
         this->osInterface.osFree(this->queueTag);
     }
     delete this->canMessageAckQueue;
+    // The runners are destroyed with runnerPool.
+
+    delete this->configMutex;
+    delete this->notStartedRunnersMutex;
+    delete this->runnersMutex;
+    delete this->sessionTable.load();
+}
+
+ISOTP_SlabAllocator* ISOTP::getPayloadAllocator()
+{
+    return this->slabAllocator.isEnabled() ? &this->slabAllocator : nullptr;
+}
+
+ISOTP_ChunkPool* ISOTP::getChunkPool()
+{
+    return this->chunkPool.isEnabled() ? &this->chunkPool : nullptr;
+}
+
+void ISOTP::publishSessions()
+{
+    // Must be called with runnersMutex taken, from runStep.
+    SessionTable* table = this->sessionTable.load(std::memory_order_acquire);
+    if (table == nullptr)
+    {
+        return; // Nobody asked for the sessions yet.
+    }
 
-    for (auto& runner : this->notStartedRunners)
+    uint32_t count = 0;
+    this->notStartedRunnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
+    for (const auto runner : this->notStartedRunners | std::views::values | std::views::join)
     {
-        delete runner;
+        if (count < ISOTP_SessionTableSize)
+        {
+            ISOTP_SessionInfo& info = table->sessions[count];
+            runner->getSessionInfo(info, this->lastRunTime);
+            info.state       = ISOTP_SessionPending;
+            info.pendingACKs = 0; // Nothing is written before the runner starts.
+        }
+        count++;
     }
-    for (auto& runner : this->activeRunners | std::views::values)
+    this->notStartedRunnersMutex->signal();
+
+    for (const auto runner : this->activeRunners | std::views::values)
     {
-        delete runner;
+        if (count < ISOTP_SessionTableSize)
+        {
+            ISOTP_SessionInfo& info = table->sessions[count];
+            runner->getSessionInfo(info, this->lastRunTime);
+            const bool allTransferred = info.bytesTransferred >= info.messageLength;
+            info.state                = allTransferred ? ISOTP_SessionFinishing : ISOTP_SessionActive;
+            info.pendingACKs          = this->canMessageAckQueue->getPendingAcks(info.nAi);
+        }
+        count++;
     }
-    for (auto& runner : this->finishedRunners)
+
+    for (const auto& request : this->directSFRequests)
     {
-        delete runner;
+        if (!request.inUse)
+        {
+            continue;
+        }
+        if (count < ISOTP_SessionTableSize)
+        {
+            const uint32_t     deadline = request.sendTime + N_USData_Runner::N_As_TIMEOUT_MS;
+            ISOTP_SessionInfo& info     = table->sessions[count];
+
+            info                  = {};
+            info.nAi              = request.nAi;
+            info.direction        = N_USData_Runner::RunnerRequestType;
+            info.state            = ISOTP_SessionFinishing;
+            info.internalStatus   = "AWAITING_SF_ACK";
+            info.bytesTransferred = request.length;
+            info.messageLength    = request.length;
+            info.armedTimer       = ISOTP_N_AsPhase;
+            info.remainingTime_ms = static_cast<int32_t>(deadline - this->lastRunTime);
+            info.pendingACKs      = request.ack == ACK_NONE ? 1 : 0;
+        }
+        count++;
     }
 
-    delete this->configMutex;
-    delete this->notStartedRunnersMutex;
-    delete this->runnersMutex;
+    table->published.publish(table->sessions, count, this->lastRunTime);
+}
+
+uint32_t ISOTP::recordRunStepDuration(const ISOTP_RunStepPhase phase, const uint32_t start)
+{
+    if (!this->statistics.isRunStepTimingEnabled())
+    {
+        return start; // No clock sample is taken.
+    }
+    const uint32_t now = this->osInterface.osMillis();
+    this->statistics.recordRunStepDuration(phase, now - start);
+    return now;
+}
+
+void ISOTP::recordAvailableMemory()
+{
+    // Only called after a payload is charged, as the memory in use can only reach a new high-water there.
+    int64_t availableMemory;
+    if (this->availableMemoryForRunners.get(&availableMemory))
+    {
+        this->statistics.recordAvailableMemory(availableMemory);
+    }
 }
 
 bool ISOTP::populateQueueTag()
@@ -102,25 +225,113 @@ typeof(N_AI::N_SA) ISOTP::getN_SA() const
     return NSA;
 }
 
+void ISOTP::addLocalN_SA(const typeof(N_AI::N_SA) nSA)
+{
+    configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
+    bool changed = !this->localN_SAs.test(nSA);
+    this->localN_SAs.set(nSA);
+    configMutex->signal();
+
+    if (changed)
+    {
+        notifyAcceptanceFiltersChanged();
+    }
+}
+
+bool ISOTP::removeLocalN_SA(const typeof(N_AI::N_SA) nSA)
+{
+    configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
+    bool res = nSA != this->nSA && this->localN_SAs.test(nSA);
+    if (res)
+    {
+        this->localN_SAs.reset(nSA);
+    }
+    configMutex->signal();
+
+    if (res)
+    {
+        notifyAcceptanceFiltersChanged();
+    }
+    return res;
+}
+
+bool ISOTP::hasLocalN_SA(const typeof(N_AI::N_SA) nSA) const
+{
+    configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
+    bool res = this->localN_SAs.test(nSA);
+    configMutex->signal();
+    return res;
+}
+
 void ISOTP::addAcceptedFunctionalN_TA(const typeof(N_AI::N_TA) nTA)
 {
     configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
-    this->acceptedFunctionalN_TAs.insert(nTA);
+    bool changed = !this->acceptedFunctionalN_TAs.test(nTA);
+    this->acceptedFunctionalN_TAs.set(nTA);
     configMutex->signal();
+
+    if (changed)
+    {
+        notifyAcceptanceFiltersChanged();
+    }
 }
 
 bool ISOTP::removeAcceptedFunctionalN_TA(const typeof(N_AI::N_TA) nTA)
 {
     configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
-    bool res = this->acceptedFunctionalN_TAs.erase(nTA) == 1;
+    bool res = this->acceptedFunctionalN_TAs.test(nTA);
+    this->acceptedFunctionalN_TAs.reset(nTA);
     configMutex->signal();
+
+    if (res)
+    {
+        notifyAcceptanceFiltersChanged();
+    }
     return res;
 }
 
+std::vector<ISOTP_AcceptanceFilter> ISOTP::getAcceptanceFilters(const uint32_t maxFilters) const
+{
+    configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
+    ISOTP_N_AddressTable physicalN_TAs   = this->localN_SAs;
+    ISOTP_N_AddressTable functionalN_TAs = this->acceptedFunctionalN_TAs;
+    configMutex->signal();
+
+    return ISOTP_computeAcceptanceFilters(physicalN_TAs, functionalN_TAs, maxFilters);
+}
+
+void ISOTP::setAcceptanceFiltersCallback(const ISOTP_AcceptanceFilters_cb_t acceptanceFilters_cb)
+{
+    configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
+    this->acceptanceFilters_cb = acceptanceFilters_cb;
+    configMutex->signal();
+
+    notifyAcceptanceFiltersChanged();
+}
+
+void ISOTP::setIndicationSegmentsCallback(const N_USData_indication_segments_cb_t N_USData_indication_segments_cb)
+{
+    this->N_USData_indication_segments_cb = N_USData_indication_segments_cb;
+}
+
+void ISOTP::notifyAcceptanceFiltersChanged()
+{
+    // Called without configMutex taken, so the callback can call getAcceptanceFilters().
+    configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
+    ISOTP_AcceptanceFilters_cb_t cb = this->acceptanceFilters_cb;
+    configMutex->signal();
+
+    if (cb != nullptr)
+    {
+        OSInterfaceLogDebug(this->tag, "Acceptance filters changed");
+        cb(*this);
+    }
+}
+
 bool ISOTP::hasAcceptedFunctionalN_TA(const typeof(N_AI::N_TA) nTA)
 {
     configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
-    bool res = this->acceptedFunctionalN_TAs.contains(nTA);
+    bool res = this->acceptedFunctionalN_TAs.test(nTA);
     configMutex->signal();
     return res;
 }
@@ -164,28 +375,266 @@ bool ISOTP::setSTmin(const STmin stMin)
     return updateRunners();
 }
 
+bool ISOTP::setPeerQuota(const typeof(N_AI::N_SA) nSa, const ISOTP_PeerQuota& quota)
+{
+    if (!this->peerQuotas.setQuota(nSa, quota))
+    {
+        OSInterfaceLogError(this->tag, "Failed to set the quota of N_SA %" PRIu8, nSa);
+        return false;
+    }
+    return true;
+}
+
+ISOTP_PeerQuota ISOTP::getPeerQuota(const typeof(N_AI::N_SA) nSa) const
+{
+    return this->peerQuotas.getQuota(nSa);
+}
+
+ISOTP_StatisticsSnapshot ISOTP::getStatistics() const
+{
+    return this->statistics.getSnapshot();
+}
+
+bool ISOTP::enablePeerStatistics()
+{
+    const int64_t tableSize = ISOTP_Statistics::getPeerTableSize();
+
+    // Taken so the table is only charged once.
+    configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
+    bool res = this->statistics.arePeerStatisticsEnabled();
+    if (!res && this->availableMemoryForRunners.subIfResIsGreaterThanZero(tableSize))
+    {
+        res = this->statistics.enablePeerStatistics();
+        if (!res)
+        {
+            this->availableMemoryForRunners.add(tableSize);
+        }
+    }
+    configMutex->signal();
+
+    if (!res)
+    {
+        OSInterfaceLogError(this->tag, "Failed to enable the statistics of the peers, they need %" PRId64 " bytes",
+                            tableSize);
+    }
+    return res;
+}
+
+ISOTP_PeerStatistics ISOTP::getPeerStatistics(const typeof(N_AI::N_SA) nSa) const
+{
+    return this->statistics.getPeerStatistics(nSa);
+}
+
+ISOTP_LatencyHistogramSnapshot ISOTP::getLatencyHistogram(const ISOTP_TimingPhase phase) const
+{
+    return this->statistics.getLatencyHistogram(phase);
+}
+
+bool ISOTP::enablePeerLatencyHistograms(const typeof(N_AI::N_SA) nSa)
+{
+    return enablePeerStatistics() && this->statistics.enablePeerLatencyHistograms(nSa);
+}
+
+bool ISOTP::getPeerLatencyHistogram(const typeof(N_AI::N_SA) nSa, const ISOTP_TimingPhase phase,
+                                    ISOTP_LatencyHistogramSnapshot& histogram) const
+{
+    return this->statistics.getPeerLatencyHistogram(nSa, phase, histogram);
+}
+
+void ISOTP::resetLatencyHistograms()
+{
+    this->statistics.resetLatencyHistograms();
+}
+
+bool ISOTP::getSessions(ISOTP_SessionSnapshot& snapshot)
+{
+    const SessionTable* table = ISOTP_LoadOrAllocate<SessionTable>(this->sessionTable);
+    if (table == nullptr)
+    {
+        OSInterfaceLogError(this->tag, "Failed to allocate the session table");
+        return false;
+    }
+    return table->published.read(snapshot);
+}
+
+ISOTP_LockStatistics ISOTP::getLockStatistics(const ISOTP_Lock lock) const
+{
+    return this->statistics.getLockStatistics(lock);
+}
+
+ISOTP_LatencyHistogramSnapshot ISOTP::getRunStepHistogram(const ISOTP_RunStepPhase phase) const
+{
+    return this->statistics.getRunStepHistogram(phase);
+}
+
+void ISOTP::setRunStepTimingEnabled(const bool enabled)
+{
+    this->statistics.setRunStepTimingEnabled(enabled);
+}
+
+void ISOTP::setTraceBuffer(ISOTP_TraceBuffer* buffer)
+{
+    this->traceBuffer.store(buffer, std::memory_order_release);
+    this->canMessageAckQueue->setTraceBuffer(buffer);
+}
+
 bool ISOTP::N_USData_request(const typeof(N_AI::N_TA) nTa, const N_TAtype_t nTaType, const uint8_t* messageData,
                              const uint32_t length, const Mtype mType)
 {
-    bool             result;
-    N_AI             nAI    = ISOTP_N_AI_CONFIG(nTaType, nTa, getN_SA());
-    N_USData_Runner* runner = new N_USData_Request_Runner(result, nAI, availableMemoryForRunners, mType, messageData,
-                                                          length, osInterface, *canMessageAckQueue);
-    if (!result)
+    return N_USData_request(getN_SA(), nTa, nTaType, messageData, length, mType);
+}
+
+bool ISOTP::N_USData_request(const typeof(N_AI::N_SA) nSa, const typeof(N_AI::N_TA) nTa, const N_TAtype_t nTaType,
+                             const uint8_t* messageData, const uint32_t length, const Mtype mType)
+{
+    if (!hasLocalN_SA(nSa))
+    {
+        OSInterfaceLogError(this->tag, "N_SA %" PRIu8 " is not a local N_SA", nSa);
+        return false;
+    }
+    if (messageData == nullptr)
+    {
+        OSInterfaceLogError(this->tag, "The message data is nullptr");
+        return false;
+    }
+
+    N_AI nAI = ISOTP_N_AI_CONFIG(nTaType, nTa, nSa);
+    if (length > 0 && length <= N_USData_Runner::MAX_SF_MESSAGE_LENGTH &&
+        requestDirectSF(nAI, mType, messageData, length))
+    {
+        statistics.onSessionStarted(ISOTP_Statistics::getTargetPeer(nAI));
+        nextRunTime = 0; // Wake up the runStep to track the ACK.
+        return true;
+    }
+
+    // Runners are only touched with runnersMutex taken, so they do not need their own mutex.
+    bool                 result;
+    N_USData_RunnerSlot* runner = runnerPool.create<N_USData_Request_Runner>(
+        result, nAI, availableMemoryForRunners, mType, messageData, length, osInterface, *canMessageAckQueue,
+        N_USData_Runner::SingleThreadedRunner, getPayloadAllocator(), &statistics);
+    if (runner == nullptr)
     {
-        delete runner;
         return false;
     }
     if (notStartedRunnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
     {
-        notStartedRunners.push_back(runner);
+        std::list<N_USData_RunnerSlot*>& pendingRunners = notStartedRunners[nAI.N_AI];
+        if (pendingRunners.empty())
+        {
+            // The first pending request of an N_AI may start right away, the following ones wait for their turn.
+            readyN_AIs.push_back(nAI.N_AI);
+        }
+        pendingRunners.push_back(runner);
         notStartedRunnersMutex->signal();
+        statistics.onSessionStarted(ISOTP_Statistics::getTargetPeer(nAI));
+        recordAvailableMemory();
+        nextRunTime = 0; // Wake up the runStep as soon as possible.
         return true;
     }
-    delete runner;
+    runnerPool.release(runner);
     return false;
 }
 
+bool ISOTP::requestDirectSF(const N_AI nAi, const Mtype mType, const uint8_t* messageData, const uint32_t length)
+{
+    // Only done if runStep is not busy, otherwise the request takes the usual path through a runner.
+    if (!this->canInterface.active() || !this->runnersMutex->wait(0))
+    {
+        return false;
+    }
+
+    bool       res  = false;
+    const auto slot = std::ranges::find_if(this->directSFRequests, [](const auto& request) { return !request.inUse; });
+    if (slot != this->directSFRequests.end() && !this->activeRunners.contains(nAi.N_AI) &&
+        !hasDirectSFRequest(nAi.N_AI) && this->notStartedRunnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        const bool idle = !this->notStartedRunners.contains(nAi.N_AI); // Earlier requests go first.
+        this->notStartedRunnersMutex->signal();
+
+        if (idle)
+        {
+            CANFrame sfFrame   = NewCANFrameISOTP();
+            sfFrame.identifier = nAi;
+            sfFrame.data[0]    = length; // N_PCI_SF (0b0000xxxx) | messageLength (0bxxxxllll)
+            memcpy(&sfFrame.data[1], messageData, length);
+            sfFrame.data_length_code = length + 1; // 1 byte for N_PCI_SF
+
+            slot->nAi      = nAi;
+            slot->mType    = mType;
+            slot->length   = length;
+            slot->ack      = ACK_NONE;
+            slot->sendTime = this->osInterface.osMillis();
+            slot->inUse    = this->canMessageAckQueue->writeFrame(*slot, sfFrame);
+            res            = slot->inUse;
+            OSInterfaceLogDebug(this->tag, "Direct SF with N_AI=%s and length %" PRIu32 " %s", nAiToString(nAi), length,
+                                res ? "written" : "could not be written");
+        }
+    }
+
+    this->runnersMutex->signal();
+    return res;
+}
+
+void ISOTP::runDirectSFRequests(const bool canActive)
+{
+    // Must be called with runnersMutex taken, from runStep.
+    const uint32_t now = this->lastRunTime;
+    for (auto& request : this->directSFRequests)
+    {
+        if (!request.inUse)
+        {
+            continue;
+        }
+
+        N_Result result;
+        if (request.ack == ACK_SUCCESS)
+        {
+            result = N_OK;
+        }
+        else if (request.ack == ACK_ERROR)
+        {
+            result = N_ERROR;
+        }
+        else if (!canActive || static_cast<int32_t>(now - request.sendTime) > N_USData_Runner::N_As_TIMEOUT_MS)
+        {
+            result = canActive ? N_TIMEOUT_A : N_ERROR;
+            this->canMessageAckQueue->removeFromQueue(request.nAi); // Its ACK will not be waited for anymore.
+        }
+        else
+        {
+            continue; // Still waiting for the ACK.
+        }
+
+        OSInterfaceLogInfo(this->tag, "Direct SF with N_AI=%s finished with result %s", nAiToString(request.nAi),
+                           N_ResultToString(result));
+        const uint32_t peer = ISOTP_Statistics::getTargetPeer(request.nAi);
+        this->statistics.onRequestFinished(peer, result);
+        this->statistics.recordLatency(ISOTP_RequestPhase, peer, now - request.sendTime);
+        if (this->N_USData_confirm_cb != nullptr)
+        {
+            this->N_USData_confirm_cb(request.nAi, result, request.mType);
+        }
+        request.inUse = false;
+        this->releasedN_AIs.push_back(request.nAi.N_AI);
+    }
+}
+
+bool ISOTP::hasDirectSFRequest(const typeof(N_AI::N_AI) nAi) const
+{
+    return std::ranges::any_of(this->directSFRequests,
+                               [nAi](const auto& request) { return request.inUse && request.nAi.N_AI == nAi; });
+}
+
+void ISOTP::DirectSFRequest::messageACKReceivedCallback(const ACKResult success)
+{
+    this->ack = success;
+}
+
+N_AI ISOTP::DirectSFRequest::getN_AI() const
+{
+    return this->nAi;
+}
+
 void ISOTP::runFinishedRunnerCallbacks()
 {
     for (const auto runner : this->finishedRunners)
@@ -195,6 +644,9 @@ void ISOTP::runFinishedRunnerCallbacks()
         // Call the callbacks.
         if (runner->getRunnerType() == N_USData_Runner::RunnerRequestType)
         {
+            const uint32_t peer = ISOTP_Statistics::getTargetPeer(runner->getN_AI());
+            this->statistics.onRequestFinished(peer, runner->getResult());
+            this->statistics.recordLatency(ISOTP_RequestPhase, peer, this->lastRunTime - runner->getStartTime());
             if (this->N_USData_confirm_cb != nullptr)
             {
                 OSInterfaceLogInfo(this->tag, "Calling N_USData_confirm_cb of runner %s", runner->getTAG());
@@ -203,27 +655,66 @@ void ISOTP::runFinishedRunnerCallbacks()
         }
         else if (runner->getRunnerType() == N_USData_Runner::RunnerIndicationType)
         {
-            if (this->N_USData_indication_cb != nullptr)
-            {
-                OSInterfaceLogInfo(this->tag, "Calling N_USData_indication_cb of runner %s", runner->getTAG());
-                const uint8_t* messageData = runner->getMessageData();
-                this->N_USData_indication_cb(runner->getN_AI(), messageData, runner->getMessageLength(),
-                                             runner->getResult(), runner->getMtype());
-            }
+            this->statistics.onIndicationFinished(runner->getN_AI().N_SA, runner->getResult());
+            this->statistics.recordLatency(ISOTP_IndicationPhase, runner->getN_AI().N_SA,
+                                           this->lastRunTime - runner->getStartTime());
+            indicateMessage(runner);
         }
         else
         {
             OSInterfaceLogError(this->tag, "Runner type is unknown");
         }
 
-        // Remove the runner from activeRunners.
+        // Remove the runner from activeRunners and let startRunners know that its N_AI is free again.
         this->activeRunners.erase(runner->getN_AI().N_AI);
+        this->releasedN_AIs.push_back(runner->getN_AI().N_AI);
         canMessageAckQueue->removeFromQueue(runner->getN_AI());
-        delete runner;
+        this->runnerPool.release(runner);
     }
     this->finishedRunners.clear();
 }
 
+void ISOTP::indicateMessage(N_USData_RunnerSlot* runner)
+{
+    const N_USData_Indication_Runner* indicationRunner = runner->getIndicationRunner();
+    const ISOTP_MessageView           message          = indicationRunner->getMessageView();
+
+    if (const N_USData_indication_segments_cb_t cb = this->N_USData_indication_segments_cb; cb != nullptr)
+    {
+        OSInterfaceLogInfo(this->tag, "Calling N_USData_indication_segments_cb of runner %s", runner->getTAG());
+        cb(runner->getN_AI(), message, runner->getResult(), runner->getMtype());
+        return;
+    }
+
+    if (this->N_USData_indication_cb == nullptr)
+    {
+        return;
+    }
+
+    OSInterfaceLogInfo(this->tag, "Calling N_USData_indication_cb of runner %s", runner->getTAG());
+    if (runner->getMessageData() != nullptr || message.segmentCount == 0)
+    {
+        this->N_USData_indication_cb(runner->getN_AI(), runner->getMessageData(), runner->getMessageLength(),
+                                     runner->getResult(), runner->getMtype());
+        return;
+    }
+
+    // The message was reassembled in chunks, the callback needs a contiguous copy.
+    uint8_t* messageData = static_cast<uint8_t*>(this->osInterface.osMalloc(message.length));
+    if (messageData == nullptr || !message.copyTo(messageData, message.length))
+    {
+        OSInterfaceLogError(this->tag, "Failed to allocate the contiguous copy of length %" PRIu32 " of runner %s",
+                            message.length, runner->getTAG());
+        this->N_USData_indication_cb(runner->getN_AI(), nullptr, 0, N_ERROR, runner->getMtype());
+    }
+    else
+    {
+        this->N_USData_indication_cb(runner->getN_AI(), messageData, message.length, runner->getResult(),
+                                     runner->getMtype());
+    }
+    this->osInterface.osFree(messageData);
+}
+
 template <std::ranges::input_range R> void ISOTP::runErrorCallbacks(R&& runners)
 {
     for (const auto runner : runners)
@@ -231,6 +722,7 @@ template <std::ranges::input_range R> void ISOTP::runErrorCallbacks(R&& runners)
         // Call the callbacks.
         if (runner->getRunnerType() == N_USData_Runner::RunnerRequestType)
         {
+            this->statistics.onRequestFinished(ISOTP_Statistics::getTargetPeer(runner->getN_AI()), N_ERROR);
             if (this->N_USData_confirm_cb != nullptr)
             {
                 this->N_USData_confirm_cb(runner->getN_AI(), N_ERROR, runner->getMtype());
@@ -238,7 +730,12 @@ template <std::ranges::input_range R> void ISOTP::runErrorCallbacks(R&& runners)
         }
         else if (runner->getRunnerType() == N_USData_Runner::RunnerIndicationType)
         {
-            if (this->N_USData_indication_cb != nullptr)
+            this->statistics.onIndicationFinished(runner->getN_AI().N_SA, N_ERROR);
+            if (const N_USData_indication_segments_cb_t cb = this->N_USData_indication_segments_cb; cb != nullptr)
+            {
+                cb(runner->getN_AI(), {nullptr, 0, 0}, N_ERROR, Mtype_Unknown);
+            }
+            else if (this->N_USData_indication_cb != nullptr)
             {
                 this->N_USData_indication_cb(runner->getN_AI(), nullptr, 0, N_ERROR, Mtype_Unknown);
             }
@@ -248,7 +745,7 @@ template <std::ranges::input_range R> void ISOTP::runErrorCallbacks(R&& runners)
             OSInterfaceLogError(this->tag, "Runner type is unknown");
         }
 
-        delete runner;
+        this->runnerPool.release(runner);
     }
 }
 
@@ -256,50 +753,101 @@ void ISOTP::startRunners()
 {
     // The second part of the runStep is to check if there are any runners in notStartedRunners, and move them
     // to activeRunners. ISO 15765-2 specifies that there should not be more than one message with the same N_AI
-    // being transmitted or received at the same time. If that happens, leave the message in the
-    // notStartedRunners queue until the current message with this N_AI is processed.
+    // being transmitted or received at the same time. If that happens, leave the message in its N_AI queue of
+    // notStartedRunners until the current message with this N_AI is processed. Only the N_AIs in readyN_AIs are
+    // checked, so requests blocked behind an active runner are not scanned on every step.
     this->runnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
     this->notStartedRunnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
 
-    auto it = this->notStartedRunners.begin();
-    while (it != this->notStartedRunners.end())
+    for (const auto nAi : this->releasedN_AIs)
     {
-        if (!this->activeRunners.contains((*it)->getN_AI().N_AI))
+        if (this->notStartedRunners.contains(nAi))
         {
-            this->activeRunners.insert(std::make_pair((*it)->getN_AI().N_AI, *it));
-            it = this->notStartedRunners.erase(it); // Returns the next iterator if the current one is erased.
+            this->readyN_AIs.push_back(nAi);
         }
-        else
+    }
+    this->releasedN_AIs.clear();
+
+    // The N_AIs are started in the order they became ready. If an N_AI is busy, it will be marked as ready again
+    // once its active runner finishes.
+    for (const auto nAi : this->readyN_AIs)
+    {
+        if (this->activeRunners.contains(nAi) || hasDirectSFRequest(nAi))
+        {
+            continue;
+        }
+
+        if (auto pendingRunnersIt = this->notStartedRunners.find(nAi);
+            pendingRunnersIt != this->notStartedRunners.end())
         {
-            ++it; // Move to the next iterator.
+            this->activeRunners.emplace(nAi, pendingRunnersIt->second.front());
+            pendingRunnersIt->second.pop_front();
+            if (pendingRunnersIt->second.empty())
+            {
+                this->notStartedRunners.erase(pendingRunnersIt);
+            }
         }
     }
+    this->readyN_AIs.clear();
 
     this->notStartedRunnersMutex->signal();
     this->runnersMutex->signal();
 }
 
-void ISOTP::getFrameIfAvailable(FrameStatus& frameStatus, CANFrame& frame) const
+void ISOTP::getFrameIfAvailable(FrameStatus& frameStatus, CANFrame& frame, const ISOTP_N_AddressTable& physicalN_TAs,
+                                const ISOTP_N_AddressTable& functionalN_TAs)
 {
     frameStatus = frameNotAvailable;
-    if (this->canInterface.frameAvailable())
+    if (readFrame(frame))
     {
-        this->canInterface.readFrame(&frame);
+        if (ISOTP_TraceBuffer* buffer = this->traceBuffer.load(std::memory_order_acquire); buffer != nullptr)
+        {
+            buffer->record(ISOTP_TraceFrameRead, frame);
+        }
         if (frame.extd == 1 && frame.data_length_code > 0 && frame.data_length_code <= CAN_FRAME_MAX_DLC)
         {
             OSInterfaceLogVerbose(this->tag, "Received frame: %s", frameToString(frame));
             if ((frame.identifier.N_TAtype == N_TATYPE_5_CAN_CLASSIC_29bit_Physical &&
-                 frame.identifier.N_TA == this->nSA) ||
+                 physicalN_TAs.test(frame.identifier.N_TA)) ||
                 (frame.identifier.N_TAtype == N_TATYPE_6_CAN_CLASSIC_29bit_Functional &&
-                 this->acceptedFunctionalN_TAs.contains(frame.identifier.N_TA)))
+                 functionalN_TAs.test(frame.identifier.N_TA)))
             {
                 OSInterfaceLogDebug(this->tag, "Received frame for this ISOTP instance: %s", frameToString(frame));
+                this->statistics.onFrameReceived(frame);
                 frameStatus = frameAvailable;
             }
         }
     }
 }
 
+bool ISOTP::readFrame(CANFrame& frame)
+{
+    // The inbox is drained in both modes, it can keep frames pushed before push mode was disabled.
+    if (this->frameInbox.pop(frame))
+    {
+        return true;
+    }
+    return !this->pushMode && this->canInterface.frameAvailable() && this->canInterface.readFrame(&frame);
+}
+
+void ISOTP::processPushedACKs()
+{
+    ACKResult ack;
+    while (this->ackInbox.pop(ack))
+    {
+        this->canMessageAckQueue->onWriteAck(ack);
+    }
+}
+
+void ISOTP::wakeUp()
+{
+    this->nextRunTime = 0;
+    if (const ISOTP_WakeUp_cb_t cb = this->wakeUp_cb; cb != nullptr)
+    {
+        cb(*this);
+    }
+}
+
 void ISOTP::runRunners(FrameStatus& frameStatus, CANFrame& frame)
 {
     for (auto runner : this->activeRunners | std::views::values)
@@ -311,14 +859,16 @@ void ISOTP::runRunners(FrameStatus& frameStatus, CANFrame& frame)
         {
             OSInterfaceLogDebug(this->tag, "Runner %s is processing frame: %s", runner->getTAG(), frameToString(frame));
             // Run the runner with the frame.
-            result      = runner->runStep(&frame);
+            result      = runner->runStep(&frame, this->lastRunTime);
             frameStatus = frameProcessed;
         }
-        else if (this->lastRunTime > runner->getNextRunTime()) // If the runner is ready to run, do it.
+        // If the runner is ready to run, do it. The signed difference keeps working when osMillis() wraps.
+        else if (const uint32_t runTime = runner->getNextRunTime();
+                 runTime == 0 || static_cast<int32_t>(this->lastRunTime - runTime) > 0)
         {
             OSInterfaceLogDebug(this->tag, "Runner %s is running without frame", runner->getTAG());
             // Run the runner without the frame.
-            result = runner->runStep(nullptr);
+            result = runner->runStep(nullptr, this->lastRunTime);
         }
 
         // Check if the runner has finished
@@ -336,27 +886,66 @@ void ISOTP::runRunners(FrameStatus& frameStatus, CANFrame& frame)
     }
 }
 
+void ISOTP::indicateSF(const CANFrame& frame)
+{
+    // An SF holds the whole message, so it is delivered straight from the frame without a runner nor a copy.
+    const uint8_t messageLength = frame.data[0] & 0b00001111;
+    const bool    valid         = messageLength <= N_USData_Runner::MAX_SF_MESSAGE_LENGTH &&
+                         messageLength < frame.data_length_code; // The payload must fit in the frame after the N_PCI.
+    if (valid)
+    {
+        OSInterfaceLogInfo(this->tag, "Received message with N_AI=%s and length %" PRIu8 " (SF)",
+                           nAiToString(frame.identifier), messageLength);
+    }
+    else
+    {
+        OSInterfaceLogError(this->tag, "Received SF with N_AI=%s and invalid length %" PRIu8 " (DLC %" PRIu8 ")",
+                            nAiToString(frame.identifier), messageLength, frame.data_length_code);
+    }
+    this->statistics.onSessionStarted(frame.identifier.N_SA);
+    this->statistics.onIndicationFinished(frame.identifier.N_SA, valid ? N_OK : N_ERROR);
+
+    if (const N_USData_indication_segments_cb_t cb = this->N_USData_indication_segments_cb; cb != nullptr)
+    {
+        uint8_t                    payload[N_USData_Runner::MAX_SF_MESSAGE_LENGTH];
+        const ISOTP_MessageSegment segment = {payload, messageLength};
+        if (valid)
+        {
+            memcpy(payload, &frame.data[1], messageLength); // A segment points to writable data.
+        }
+        cb(frame.identifier, valid ? ISOTP_MessageView{&segment, 1, messageLength} : ISOTP_MessageView{nullptr, 0, 0},
+           valid ? N_OK : N_ERROR, Mtype_Diagnostics);
+    }
+    else if (this->N_USData_indication_cb != nullptr)
+    {
+        this->N_USData_indication_cb(frame.identifier, valid ? &frame.data[1] : nullptr, messageLength,
+                                     valid ? N_OK : N_ERROR, Mtype_Diagnostics);
+    }
+}
+
 void ISOTP::createRunnerForMessage(const STmin stM, const uint8_t bs, const FrameStatus frameStatus, CANFrame& frame)
 {
-    if (frameStatus == frameAvailable)
+    if (frameStatus == frameAvailable &&
+        static_cast<N_USData_Runner::FrameCode>(frame.data[0] >> 4) == N_USData_Runner::SF_CODE)
+    {
+        indicateSF(frame);
+    }
+    else if (frameStatus == frameAvailable)
     {
         bool result;
 
-        N_USData_Runner* runner =
-            new N_USData_Indication_Runner(result, frame.identifier, this->availableMemoryForRunners, bs, stM,
-                                           this->osInterface, *this->canMessageAckQueue);
+        N_USData_RunnerSlot* runner = this->runnerPool.create<N_USData_Indication_Runner>(
+            result, frame.identifier, this->availableMemoryForRunners, bs, stM, this->osInterface,
+            *this->canMessageAckQueue, N_USData_Runner::SingleThreadedRunner, &this->peerQuotas,
+            getPayloadAllocator(), getChunkPool(), &this->statistics);
         if (runner == nullptr)
         {
             OSInterfaceLogError(this->tag, "Failed to create a new runner");
         }
-        else if (!result)
-        {
-            OSInterfaceLogError(this->tag, "Failed to create a new runner");
-            delete runner;
-        }
         else
         {
-            switch (runner->runStep(&frame))
+            this->statistics.onSessionStarted(frame.identifier.N_SA);
+            switch (runner->runStep(&frame, this->lastRunTime))
             {
                 case IN_PROGRESS:
                     assert(false && "N_Result::IN_PROGRESS should not happen, as the runner was just created");
@@ -369,6 +958,7 @@ void ISOTP::createRunnerForMessage(const STmin stM, const uint8_t bs, const Fram
                                                         runner->getMtype());
                     }
                     this->activeRunners.emplace(runner->getN_AI().N_AI, runner);
+                    recordAvailableMemory();
                     break;
                 default: // Single frame or error
                     this->finishedRunners.push_front(runner);
@@ -377,26 +967,30 @@ void ISOTP::createRunnerForMessage(const STmin stM, const uint8_t bs, const Fram
         }
     }
 }
-void ISOTP::runStepCanActive()
+void ISOTP::runStepCanActive(const uint32_t millis)
 {
     // Get the configuration used in this runStep.
     this->configMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
-    std::unordered_set<typeof(N_AI::N_TA)> acceptedFunctionalN_TAs = this->acceptedFunctionalN_TAs;
-    STmin                                  stMin                   = this->stMin;
-    uint8_t                                blockSize               = this->blockSize;
+    ISOTP_N_AddressTable localN_SAs              = this->localN_SAs;
+    ISOTP_N_AddressTable acceptedFunctionalN_TAs = this->acceptedFunctionalN_TAs;
+    STmin                stMin                   = this->stMin;
+    uint8_t              blockSize               = this->blockSize;
     this->configMutex->signal();
 
     // The second part of the runStep is to check if there are any runners in notStartedRunners, and move them
     // to activeRunners. ISO 15765-2 specifies that there should not be more than one message with the same N_AI
     // being transmitted or received at the same time. If that happens, leave the message in the
     // notStartedRunners queue until the current message with this N_AI is processed.
+    uint32_t phaseStart = millis;
     startRunners();
+    phaseStart = recordRunStepDuration(ISOTP_StartRunnersStep, phaseStart);
 
     // The third part of the runStep is to check if a message is available, read it and check if this ISOTP
     // object is interested in it.
     FrameStatus frameStatus;
     CANFrame    frame;
-    getFrameIfAvailable(frameStatus, frame);
+    getFrameIfAvailable(frameStatus, frame, localN_SAs, acceptedFunctionalN_TAs);
+    phaseStart = recordRunStepDuration(ISOTP_GetFrameStep, phaseStart);
 
     this->runnersMutex->wait(ISOTP_MaxTimeToWaitForRunnersSync_MS);
 
@@ -407,13 +1001,25 @@ void ISOTP::runStepCanActive()
     // The fifth part of the runStep is to check if a runner processed a message, and if no one did, start a
     // new runner to handle it.
     createRunnerForMessage(stMin, blockSize, frameStatus, frame);
+    phaseStart = recordRunStepDuration(ISOTP_RunRunnersStep, phaseStart);
 
-    // The sixth part of the runStep is to run any ack callback.
+    // The sixth part of the runStep is to run any ack callback, including the ones of the ACKs pushed by onWriteAck.
+    processPushedACKs();
     canMessageAckQueue->runAvailableAckCallbacks();
+    runDirectSFRequests(true);
 
     // The seventh part of the runStep is to run the callbacks for the finished runners and remove them from
     // activeRunners and finishedRunners.
     runFinishedRunnerCallbacks();
+    recordRunStepDuration(ISOTP_CallbacksStep, phaseStart);
+
+    // Then the sessions that are left are published for getSessions.
+    publishSessions();
+
+    // The last part of the runStep is to publish when the next runStep is needed. If a request was queued during this
+    // runStep, nextRunTime is no longer ISOTP_NoNextRunTime and it must not be overwritten.
+    uint32_t expectedNextRunTime = ISOTP_NoNextRunTime;
+    this->nextRunTime.compare_exchange_strong(expectedNextRunTime, computeNextRunTime());
 
     this->runnersMutex->signal();
 }
@@ -422,16 +1028,27 @@ void ISOTP::runStepCanInactive()
 {
     this->notStartedRunnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
 
-    runErrorCallbacks(this->notStartedRunners);
+    runErrorCallbacks(this->notStartedRunners | std::views::values | std::views::join);
     this->notStartedRunners.clear();
+    this->readyN_AIs.clear();
 
     this->notStartedRunnersMutex->signal();
     this->runnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
 
     runErrorCallbacks(this->activeRunners | std::views::values);
     this->activeRunners.clear();
+    runDirectSFRequests(false);
+    this->releasedN_AIs.clear();
+
+    // Frames and ACKs pushed while the CAN is inactive belong to the aborted messages.
+    CANFrame  frame;
+    ACKResult ack;
+    while (this->frameInbox.pop(frame) || this->ackInbox.pop(ack))
+    {
+    }
 
     runFinishedRunnerCallbacks();
+    publishSessions();
 
     this->runnersMutex->signal();
 }
@@ -443,36 +1060,122 @@ void ISOTP::runStep()
     if (const uint32_t millis = this->osInterface.osMillis(); millis - this->lastRunTime > ISOTP_RunPeriod_MS)
     {
         this->lastRunTime = millis;
+        this->nextRunTime = ISOTP_NoNextRunTime; // Recomputed at the end of the runStep.
 
         if (this->canInterface.active())
         {
-            this->runStepCanActive();
+            this->runStepCanActive(millis);
         }
         else
         {
             this->runStepCanInactive(); // TODO: avoid calling this function always, do it only once until can is active
                                         // again.
         }
+        recordRunStepDuration(ISOTP_RunStepTotal, millis);
     }
 }
-void ISOTP::canMessageACKQueueRunStep() const
+void ISOTP::canMessageACKQueueRunStep()
 {
-    static uint32_t ACKlastRunTime = 0;
-    if (this->osInterface.osMillis() - ACKlastRunTime > ISOTP_RunPeriod_ACKQueue_MS)
+    if (const uint32_t millis = this->osInterface.osMillis();
+        !this->pushMode && millis - this->ackLastRunTime > ISOTP_RunPeriod_ACKQueue_MS)
     {
-        ACKlastRunTime = this->osInterface.osMillis();
+        this->ackLastRunTime = millis;
         if (canMessageAckQueue != nullptr)
         {
             canMessageAckQueue->runStep();
         }
+        recordRunStepDuration(ISOTP_ACKQueueRunStep, millis);
     }
 }
 
+void ISOTP::setPushMode(const bool enabled, const ISOTP_WakeUp_cb_t wakeUp_cb)
+{
+    this->wakeUp_cb = wakeUp_cb;
+    this->pushMode  = enabled;
+    OSInterfaceLogInfo(this->tag, "Push mode %s", enabled ? "enabled" : "disabled");
+}
+
+bool ISOTP::isPushModeEnabled() const
+{
+    return this->pushMode;
+}
+
+bool ISOTP::onFrameReceived(const CANFrame& frame)
+{
+    if (!this->pushMode || !this->frameInbox.push(frame))
+    {
+        return false;
+    }
+    wakeUp();
+    return true;
+}
+
+bool ISOTP::onWriteAck(const ACKResult ack)
+{
+    if (!this->pushMode || ack == ACK_NONE || !this->ackInbox.push(ack))
+    {
+        return false;
+    }
+    wakeUp();
+    return true;
+}
+
+uint32_t ISOTP::getNextRunTime() const
+{
+    return this->nextRunTime;
+}
+
+bool ISOTP::hasPendingCANEvents() const
+{
+    // The inboxes are checked in both modes, like readFrame drains them.
+    if (!this->frameInbox.empty() || !this->ackInbox.empty() || this->canMessageAckQueue->hasAvailableAckCallbacks())
+    {
+        return true;
+    }
+    return !this->pushMode && this->canInterface.frameAvailable();
+}
+
+bool ISOTP::isWaitingForACKs() const
+{
+    return !this->pushMode && this->canMessageAckQueue->isWaitingForAcks();
+}
+
+uint32_t ISOTP::computeNextRunTime() const
+{
+    // Must be called with runnersMutex taken.
+    this->notStartedRunnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
+    bool requestsReady = !this->readyN_AIs.empty();
+    for (const auto nAi : this->releasedN_AIs)
+    {
+        requestsReady |= this->notStartedRunners.contains(nAi);
+    }
+    this->notStartedRunnersMutex->signal();
+
+    if (requestsReady || !this->frameInbox.empty() || !this->ackInbox.empty())
+    {
+        return 0;
+    }
+
+    uint32_t next = ISOTP_NoNextRunTime;
+    for (const auto runner : this->activeRunners | std::views::values)
+    {
+        next = ISOTP_EarliestRunTime(next, runner->getNextRunTime());
+    }
+    for (const auto& request : this->directSFRequests)
+    {
+        if (request.inUse)
+        {
+            next = ISOTP_EarliestRunTime(next, request.sendTime + N_USData_Runner::N_As_TIMEOUT_MS + 1);
+        }
+    }
+    return next;
+}
+
 bool ISOTP::updateRunners()
 {
     notStartedRunnersMutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
 
-    for (const auto runner : notStartedRunners)
+    for (const auto runner : notStartedRunners | std::views::values | std::views::join)
     {
         if (!updateRunner(runner))
         {
@@ -495,12 +1198,10 @@ bool ISOTP::updateRunners()
     return true;
 }
 
-bool ISOTP::updateRunner(N_USData_Runner* runner) const
+bool ISOTP::updateRunner(N_USData_RunnerSlot* runner) const
 {
-    if (runner->getRunnerType() == N_USData_Runner::RunnerIndicationType)
+    if (const auto indicationRunner = runner->getIndicationRunner(); indicationRunner != nullptr)
     {
-        const auto indicationRunner = static_cast<N_USData_Indication_Runner*>(runner);
-
         if (!indicationRunner->setBlockSize(blockSize))
         {
             return false;
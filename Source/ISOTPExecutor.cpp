@@ -0,0 +1,189 @@
+#include "ISOTPExecutor.h"
+
+#include <algorithm>
+#include <cassert>
+
+ISOTPExecutor::ISOTPExecutor(OSInterface& osInterface, const uint8_t workerCount, const char* tag) :
+    osInterface(osInterface)
+{
+    assert(workerCount > 0 && "An ISOTPExecutor needs at least one worker");
+
+    this->tag               = tag;
+    this->registrationMutex = this->osInterface.osCreateMutex();
+    assert(this->registrationMutex != nullptr && "Mutex creation failed");
+
+    this->workers.resize(workerCount);
+    for (auto& worker : this->workers)
+    {
+        worker.mutex       = this->osInterface.osCreateMutex();
+        worker.nextRunTime = ISOTP_NoNextRunTime;
+        assert(worker.mutex != nullptr && "Mutex creation failed");
+    }
+}
+
+ISOTPExecutor::~ISOTPExecutor()
+{
+    for (const auto& worker : this->workers)
+    {
+        delete worker.mutex;
+    }
+    delete this->registrationMutex;
+}
+
+bool ISOTPExecutor::isRegistered(const ISOTP& isotp) const
+{
+    // Must be called with registrationMutex taken, the instance lists are only modified while holding it.
+    return std::ranges::any_of(this->workers, [&isotp](const Worker& worker)
+                               { return std::ranges::find(worker.instances, &isotp) != worker.instances.end(); });
+}
+
+bool ISOTPExecutor::addInstance(ISOTP& isotp)
+{
+    if (!this->registrationMutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        OSInterfaceLogError(this->tag, "Failed to acquire mutex for adding %s", isotp.getTag());
+        return false;
+    }
+
+    bool res = false;
+    if (isRegistered(isotp))
+    {
+        OSInterfaceLogWarning(this->tag, "%s is already registered", isotp.getTag());
+    }
+    else
+    {
+        auto& worker =
+            *std::ranges::min_element(this->workers, {}, [](const Worker& w) { return w.instances.size(); });
+        if (worker.mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+        {
+            worker.instances.push_back(&isotp);
+            worker.nextRunTime = 0; // Run the new instance as soon as possible.
+            worker.mutex->signal();
+            OSInterfaceLogInfo(this->tag, "Added %s to worker %" PRIu32, isotp.getTag(),
+                               static_cast<uint32_t>(&worker - this->workers.data()));
+            res = true;
+        }
+        else
+        {
+            OSInterfaceLogError(this->tag, "Failed to acquire worker mutex for adding %s", isotp.getTag());
+        }
+    }
+
+    this->registrationMutex->signal();
+    return res;
+}
+
+bool ISOTPExecutor::removeInstance(ISOTP& isotp)
+{
+    if (!this->registrationMutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        OSInterfaceLogError(this->tag, "Failed to acquire mutex for removing %s", isotp.getTag());
+        return false;
+    }
+
+    bool res = false;
+    for (auto& worker : this->workers)
+    {
+        if (const auto it = std::ranges::find(worker.instances, &isotp); it != worker.instances.end())
+        {
+            if (worker.mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+            {
+                worker.instances.erase(it);
+                worker.mutex->signal();
+                OSInterfaceLogInfo(this->tag, "Removed %s", isotp.getTag());
+                res = true;
+            }
+            else
+            {
+                OSInterfaceLogError(this->tag, "Failed to acquire worker mutex for removing %s", isotp.getTag());
+            }
+            break;
+        }
+    }
+
+    this->registrationMutex->signal();
+    return res;
+}
+
+uint32_t ISOTPExecutor::runStep(const uint8_t worker)
+{
+    if (worker >= this->workers.size())
+    {
+        OSInterfaceLogError(this->tag, "Invalid worker %" PRIu8, worker);
+        return ISOTP_NoNextRunTime;
+    }
+
+    Worker& w = this->workers[worker];
+    if (!w.mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        OSInterfaceLogError(this->tag, "Failed to acquire mutex of worker %" PRIu8, worker);
+        return 0;
+    }
+
+    const uint32_t now         = this->osInterface.osMillis();
+    uint32_t       nextRunTime = ISOTP_NoNextRunTime;
+    for (const auto isotp : w.instances)
+    {
+        // Only touch the channels that have something to do.
+        if (isotp->isWaitingForACKs())
+        {
+            isotp->canMessageACKQueueRunStep();
+        }
+        if (isotp->hasPendingCANEvents() || ISOTP_IsRunTimeReached(now, isotp->getNextRunTime()))
+        {
+            OSInterfaceLogVerbose(this->tag, "Running %s", isotp->getTag());
+            isotp->runStep();
+        }
+        // runStep reads one frame per call, and the deadline of a runner waiting for an ACK is its N_As timeout, so
+        // the worker must not sleep until getNextRunTime() while frames or ACKs are pending.
+        if (isotp->hasPendingCANEvents() || isotp->isWaitingForACKs())
+        {
+            nextRunTime = 0;
+        }
+        else
+        {
+            nextRunTime = ISOTP_EarliestRunTime(nextRunTime, isotp->getNextRunTime());
+        }
+    }
+    w.nextRunTime = nextRunTime;
+
+    w.mutex->signal();
+    return nextRunTime;
+}
+
+uint32_t ISOTPExecutor::getNextRunTime() const
+{
+    uint32_t nextRunTime = ISOTP_NoNextRunTime;
+    for (const auto& worker : this->workers)
+    {
+        if (worker.mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+        {
+            nextRunTime = ISOTP_EarliestRunTime(nextRunTime, worker.nextRunTime);
+            worker.mutex->signal();
+        }
+        else
+        {
+            nextRunTime = 0; // Unknown state, better to run as soon as possible.
+        }
+    }
+    return nextRunTime;
+}
+
+uint8_t ISOTPExecutor::getWorkerCount() const
+{
+    return static_cast<uint8_t>(this->workers.size());
+}
+
+uint32_t ISOTPExecutor::getInstanceCount() const
+{
+    uint32_t count = 0;
+    if (this->registrationMutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        for (const auto& worker : this->workers)
+        {
+            count += worker.instances.size();
+        }
+        this->registrationMutex->signal();
+    }
+    return count;
+}
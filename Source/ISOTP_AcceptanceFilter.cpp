@@ -0,0 +1,206 @@
+#include "ISOTP_AcceptanceFilter.h"
+
+#include <bit>
+#include <map>
+#include <set>
+
+namespace
+{
+    // The accepted frames are keys of 9 bits: the N_TA in the low byte and whether it is functional in the 9th bit.
+    constexpr uint32_t FunctionalKeyBit = ISOTP_N_AddressCount;
+    constexpr uint32_t KeyCount         = ISOTP_N_AddressCount * 2;
+    constexpr uint32_t KeyBits          = std::countr_zero(KeyCount);
+
+    using KeyTable = std::bitset<KeyCount>;
+
+    // Set of keys that share the bits of value outside dontCare.
+    struct Cube
+    {
+        uint32_t value;
+        uint32_t dontCare;
+
+        [[nodiscard]] bool covers(const uint32_t key) const
+        {
+            return (key & ~this->dontCare) == this->value;
+        }
+
+        [[nodiscard]] bool contains(const Cube& other) const
+        {
+            return (other.dontCare & ~this->dontCare) == 0 && covers(other.value);
+        }
+
+        [[nodiscard]] uint32_t code() const
+        {
+            return this->dontCare << KeyBits | this->value;
+        }
+    };
+
+    std::vector<Cube> getPrimeImplicants(const KeyTable& keys)
+    {
+        std::vector<Cube> primes;
+        std::vector<Cube> level;
+        for (uint32_t key = 0; key < KeyCount; key++)
+        {
+            if (keys.test(key))
+            {
+                level.push_back({key, 0});
+            }
+        }
+
+        while (!level.empty())
+        {
+            std::map<uint32_t, size_t> indexes;
+            for (size_t i = 0; i < level.size(); i++)
+            {
+                indexes[level[i].code()] = i;
+            }
+
+            std::vector<bool>  merged(level.size(), false);
+            std::set<uint32_t> nextLevel; // Ordered and without duplicates, so the result is deterministic.
+            for (size_t i = 0; i < level.size(); i++)
+            {
+                const Cube& cube = level[i];
+                for (uint32_t bit = 1; bit < KeyCount; bit <<= 1)
+                {
+                    // Merge each pair once, from the cube with the bit cleared.
+                    if ((cube.dontCare & bit) == 0 && (cube.value & bit) == 0)
+                    {
+                        const Cube neighbour = {cube.value | bit, cube.dontCare};
+                        if (const auto it = indexes.find(neighbour.code()); it != indexes.end())
+                        {
+                            merged[i]          = true;
+                            merged[it->second] = true;
+                            nextLevel.insert(Cube{cube.value, cube.dontCare | bit}.code());
+                        }
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < level.size(); i++)
+            {
+                if (!merged[i])
+                {
+                    primes.push_back(level[i]);
+                }
+            }
+
+            level.clear();
+            for (const uint32_t code : nextLevel)
+            {
+                level.push_back({code & (KeyCount - 1), code >> KeyBits});
+            }
+        }
+        return primes;
+    }
+
+    std::vector<Cube> getCover(const KeyTable& keys, const std::vector<Cube>& primes)
+    {
+        std::vector<Cube> cover;
+        KeyTable          uncoveredKeys = keys;
+        while (uncoveredKeys.any())
+        {
+            const Cube* bestCube     = nullptr;
+            uint32_t    bestCoverage = 0;
+            for (const Cube& prime : primes)
+            {
+                uint32_t coverage = 0;
+                for (uint32_t key = 0; key < KeyCount; key++)
+                {
+                    coverage += uncoveredKeys.test(key) && prime.covers(key);
+                }
+                if (coverage > bestCoverage)
+                {
+                    bestCube     = &prime;
+                    bestCoverage = coverage;
+                }
+            }
+
+            cover.push_back(*bestCube);
+            for (uint32_t key = 0; key < KeyCount; key++)
+            {
+                if (bestCube->covers(key))
+                {
+                    uncoveredKeys.reset(key);
+                }
+            }
+        }
+        return cover;
+    }
+
+    void mergeCubes(std::vector<Cube>& cubes, const uint32_t maxCubes)
+    {
+        while (cubes.size() > maxCubes)
+        {
+            // Merge the pair of cubes whose union lets through the fewest extra keys.
+            size_t   bestI        = 0;
+            uint32_t bestDontCare = UINT32_MAX;
+            for (size_t i = 0; i < cubes.size(); i++)
+            {
+                for (size_t j = i + 1; j < cubes.size(); j++)
+                {
+                    const uint32_t dontCare =
+                        cubes[i].dontCare | cubes[j].dontCare | (cubes[i].value ^ cubes[j].value);
+                    if (std::popcount(dontCare) < std::popcount(bestDontCare))
+                    {
+                        bestI        = i;
+                        bestDontCare = dontCare;
+                    }
+                }
+            }
+
+            // The merged cube contains both cubes of the pair, and maybe others.
+            const Cube mergedCube = {cubes[bestI].value & ~bestDontCare, bestDontCare};
+            std::erase_if(cubes, [&mergedCube](const Cube& cube) { return mergedCube.contains(cube); });
+            cubes.push_back(mergedCube);
+        }
+    }
+
+    ISOTP_AcceptanceFilter cubeToFilter(const Cube& cube)
+    {
+        // Physical and functional frames only differ in these N_TAtype bits.
+        constexpr uint8_t typeDifference =
+            N_TATYPE_5_CAN_CLASSIC_29bit_Physical ^ N_TATYPE_6_CAN_CLASSIC_29bit_Functional;
+
+        const uint8_t typeMask =
+            (cube.dontCare & FunctionalKeyBit) != 0 ? static_cast<uint8_t>(~typeDifference) : UINT8_MAX;
+
+        const N_TAtype_t type = (cube.value & FunctionalKeyBit) != 0 ? N_TATYPE_6_CAN_CLASSIC_29bit_Functional
+                                                                     : N_TATYPE_5_CAN_CLASSIC_29bit_Physical;
+
+        // The priority and the padding are not checked by ISOTP, so they are left out of the mask like the N_SA.
+        ISOTP_AcceptanceFilter filter = {.id   = {.N_NFA_Header  = N_NFA_Header_Value,
+                                                  .N_NFA_Padding = N_NFA_Padding_Value,
+                                                  .N_TAtype      = static_cast<N_TAtype_t>(type & typeMask),
+                                                  .N_TA          = static_cast<uint8_t>(cube.value),
+                                                  .N_SA          = 0},
+                                         .mask = {.N_NFA_Header  = 0,
+                                                  .N_NFA_Padding = 0,
+                                                  .N_TAtype      = static_cast<N_TAtype_t>(typeMask),
+                                                  .N_TA          = static_cast<uint8_t>(~cube.dontCare),
+                                                  .N_SA          = 0}};
+        return filter;
+    }
+} // namespace
+
+std::vector<ISOTP_AcceptanceFilter> ISOTP_computeAcceptanceFilters(const ISOTP_N_AddressTable& physicalN_TAs,
+                                                                   const ISOTP_N_AddressTable& functionalN_TAs,
+                                                                   const uint32_t maxFilters)
+{
+    KeyTable keys;
+    for (uint32_t nTa = 0; nTa < ISOTP_N_AddressCount; nTa++)
+    {
+        keys[nTa]                    = physicalN_TAs.test(nTa);
+        keys[nTa | FunctionalKeyBit] = functionalN_TAs.test(nTa);
+    }
+
+    std::vector<Cube> cubes = getCover(keys, getPrimeImplicants(keys));
+    mergeCubes(cubes, maxFilters > 0 ? maxFilters : 1);
+
+    std::vector<ISOTP_AcceptanceFilter> filters;
+    filters.reserve(cubes.size());
+    for (const Cube& cube : cubes)
+    {
+        filters.push_back(cubeToFilter(cube));
+    }
+    return filters;
+}
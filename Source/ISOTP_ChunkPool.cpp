@@ -0,0 +1,132 @@
+#include "ISOTP_ChunkPool.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "ISOTP_Common.h"
+
+bool ISOTP_MessageView::copyTo(uint8_t* buffer, const uint32_t size) const
+{
+    if (size < this->length)
+    {
+        return false;
+    }
+
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < this->segmentCount; i++)
+    {
+        memcpy(buffer + offset, this->segments[i].data, this->segments[i].length);
+        offset += this->segments[i].length;
+    }
+    return true;
+}
+
+ISOTP_ChunkPool::ISOTP_ChunkPool(OSInterface& osInterface, const uint32_t chunkSize, const uint32_t maxFreeBytes)
+{
+    this->osInterface    = &osInterface;
+    this->mutex          = nullptr;
+    this->chunkSize      = 0;
+    this->freeChunks     = nullptr;
+    this->freeChunkCount = 0;
+    this->maxFreeChunks  = 0;
+
+    if (chunkSize == 0)
+    {
+        return;
+    }
+
+    this->mutex = osInterface.osCreateMutex();
+    if (this->mutex != nullptr)
+    {
+        // A free chunk holds the link of its list.
+        this->chunkSize     = std::max<uint32_t>(chunkSize, sizeof(FreeChunk));
+        this->maxFreeChunks = maxFreeBytes == 0 ? 0 : getChunkCount(maxFreeBytes);
+    }
+}
+
+ISOTP_ChunkPool::~ISOTP_ChunkPool()
+{
+    while (this->freeChunks != nullptr)
+    {
+        FreeChunk* chunk = this->freeChunks;
+        this->freeChunks = chunk->next;
+        this->osInterface->osFree(chunk);
+    }
+    delete this->mutex;
+}
+
+bool ISOTP_ChunkPool::isEnabled() const
+{
+    return this->chunkSize > 0;
+}
+
+uint32_t ISOTP_ChunkPool::getChunkSize() const
+{
+    return this->chunkSize;
+}
+
+uint32_t ISOTP_ChunkPool::getChunkCount(const uint32_t length) const
+{
+    return length == 0 ? 1 : (length - 1) / this->chunkSize + 1;
+}
+
+uint8_t* ISOTP_ChunkPool::allocate()
+{
+    if (!isEnabled() || !this->mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        return nullptr;
+    }
+
+    FreeChunk* chunk = this->freeChunks;
+    if (chunk != nullptr)
+    {
+        this->freeChunks = chunk->next;
+        this->freeChunkCount--;
+    }
+    this->mutex->signal();
+
+    if (chunk == nullptr)
+    {
+        return static_cast<uint8_t*>(this->osInterface->osMalloc(this->chunkSize));
+    }
+    return reinterpret_cast<uint8_t*>(chunk);
+}
+
+void ISOTP_ChunkPool::release(uint8_t* chunk)
+{
+    if (chunk == nullptr)
+    {
+        return;
+    }
+
+    if (!this->mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        this->osInterface->osFree(chunk); // Not lost, only not reused.
+        return;
+    }
+
+    if (this->freeChunkCount >= this->maxFreeChunks)
+    {
+        this->mutex->signal();
+        this->osInterface->osFree(chunk);
+        return;
+    }
+
+    FreeChunk* freeChunk = reinterpret_cast<FreeChunk*>(chunk);
+    freeChunk->next      = this->freeChunks;
+    this->freeChunks     = freeChunk;
+    this->freeChunkCount++;
+
+    this->mutex->signal();
+}
+
+uint32_t ISOTP_ChunkPool::getFreeChunkCount() const
+{
+    uint32_t count = 0;
+    if (this->mutex != nullptr && this->mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        count = this->freeChunkCount;
+        this->mutex->signal();
+    }
+    return count;
+}
@@ -52,3 +52,21 @@ uint32_t getStMinInMs(const STmin stMin)
     }
     return stMin.unit == usX100 ? 1 : stMin.value; // 1 ms is the smallest resolution we can get in our implementation.
 }
+
+bool ISOTP_IsRunTimeReached(const uint32_t now, const uint32_t runTime)
+{
+    return runTime != ISOTP_NoNextRunTime && (runTime == 0 || static_cast<int32_t>(now - runTime) >= 0);
+}
+
+uint32_t ISOTP_EarliestRunTime(const uint32_t a, const uint32_t b)
+{
+    if (a == ISOTP_NoNextRunTime || b == ISOTP_NoNextRunTime)
+    {
+        return MIN(a, b);
+    }
+    if (a == 0 || b == 0)
+    {
+        return 0;
+    }
+    return static_cast<int32_t>(a - b) <= 0 ? a : b;
+}
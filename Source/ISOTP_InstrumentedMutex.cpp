@@ -0,0 +1,61 @@
+#include "ISOTP_InstrumentedMutex.h"
+
+#include <cinttypes>
+#include <new>
+
+OSInterface_Mutex* ISOTP_InstrumentedMutex::wrap(OSInterface_Mutex* mutex, const ISOTP_Lock lock,
+                                                 OSInterface& osInterface, ISOTP_Statistics* statistics)
+{
+    if (mutex == nullptr || statistics == nullptr)
+    {
+        return mutex;
+    }
+
+    OSInterface_Mutex* instrumented = new (std::nothrow) ISOTP_InstrumentedMutex(mutex, lock, osInterface, *statistics);
+    if (instrumented == nullptr)
+    {
+        OSInterfaceLogWarning(TAG, "Failed to allocate the wrapper of %s, it is not counted", ISOTP_LockToString(lock));
+        return mutex;
+    }
+    return instrumented;
+}
+
+ISOTP_InstrumentedMutex::ISOTP_InstrumentedMutex(OSInterface_Mutex* mutex, const ISOTP_Lock lock,
+                                                 OSInterface& osInterface, ISOTP_Statistics& statistics) :
+    mutex(mutex), lock(lock), osInterface(osInterface), statistics(statistics)
+{
+}
+
+ISOTP_InstrumentedMutex::~ISOTP_InstrumentedMutex()
+{
+    delete this->mutex;
+}
+
+bool ISOTP_InstrumentedMutex::signal()
+{
+    return this->mutex->signal();
+}
+
+bool ISOTP_InstrumentedMutex::wait(const uint32_t max_time_to_wait_ms)
+{
+    if (this->mutex->wait(0))
+    {
+        this->statistics.onLockAcquired(this->lock, false, 0);
+        return true;
+    }
+
+    const uint32_t start = this->osInterface.osMillis();
+    if (max_time_to_wait_ms > 0 && this->mutex->wait(max_time_to_wait_ms))
+    {
+        this->statistics.onLockAcquired(this->lock, true, this->osInterface.osMillis() - start);
+        return true;
+    }
+
+    this->statistics.onLockTimeout(this->lock, this->osInterface.osMillis() - start);
+    if (max_time_to_wait_ms > 0) // A failed try is expected by its caller.
+    {
+        OSInterfaceLogWarning(TAG, "Timed out after %" PRIu32 " ms waiting for %s", max_time_to_wait_ms,
+                              ISOTP_LockToString(this->lock));
+    }
+    return false;
+}
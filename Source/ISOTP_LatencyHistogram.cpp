@@ -0,0 +1,147 @@
+#include "ISOTP_LatencyHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cinttypes>
+#include <cstdio>
+
+namespace
+{
+constexpr uint32_t LinearBits = std::countr_zero(ISOTP_LatencyHistogramLinearBuckets);
+constexpr uint32_t SubBits    = std::countr_zero(ISOTP_LatencyHistogramSubBuckets);
+
+static_assert(std::has_single_bit(ISOTP_LatencyHistogramLinearBuckets) &&
+                  std::has_single_bit(ISOTP_LatencyHistogramSubBuckets) &&
+                  ISOTP_LatencyHistogramSubBuckets <= ISOTP_LatencyHistogramLinearBuckets &&
+                  LinearBits + ISOTP_LatencyHistogramPowers <= 32,
+              "Invalid latency histogram layout");
+} // namespace
+
+void ISOTP_LatencyHistogram::record(const uint32_t value_ms)
+{
+    this->buckets[getBucketIndex(value_ms)].fetch_add(1, std::memory_order_relaxed);
+    this->count.fetch_add(1, std::memory_order_relaxed);
+    this->sum.fetch_add(value_ms, std::memory_order_relaxed);
+
+    uint32_t currentMax = this->max.load(std::memory_order_relaxed);
+    while (value_ms > currentMax && !this->max.compare_exchange_weak(currentMax, value_ms, std::memory_order_relaxed))
+    {
+    }
+}
+
+void ISOTP_LatencyHistogram::reset()
+{
+    for (auto& bucket : this->buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    this->count.store(0, std::memory_order_relaxed);
+    this->sum.store(0, std::memory_order_relaxed);
+    this->max.store(0, std::memory_order_relaxed);
+}
+
+ISOTP_LatencyHistogramSnapshot ISOTP_LatencyHistogram::getSnapshot() const
+{
+    ISOTP_LatencyHistogramSnapshot snapshot{};
+    for (uint32_t i = 0; i < ISOTP_LatencyHistogramBucketCount; i++)
+    {
+        snapshot.buckets[i] = this->buckets[i].load(std::memory_order_relaxed);
+    }
+    snapshot.count  = this->count.load(std::memory_order_relaxed);
+    snapshot.sum_ms = this->sum.load(std::memory_order_relaxed);
+    snapshot.max_ms = this->max.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+uint32_t ISOTP_LatencyHistogram::getBucketIndex(const uint32_t value_ms)
+{
+    if (value_ms < ISOTP_LatencyHistogramLinearBuckets)
+    {
+        return value_ms;
+    }
+
+    const uint32_t power = std::bit_width(value_ms) - 1; // At least LinearBits.
+    if (power >= LinearBits + ISOTP_LatencyHistogramPowers)
+    {
+        return ISOTP_LatencyHistogramBucketCount - 1;
+    }
+    const uint32_t subBucket = (value_ms >> (power - SubBits)) & (ISOTP_LatencyHistogramSubBuckets - 1);
+    return ISOTP_LatencyHistogramLinearBuckets + (power - LinearBits) * ISOTP_LatencyHistogramSubBuckets + subBucket;
+}
+
+uint32_t ISOTP_LatencyHistogram::getBucketLowerBound(const uint32_t index)
+{
+    if (index < ISOTP_LatencyHistogramLinearBuckets)
+    {
+        return index;
+    }
+
+    const uint32_t logIndex  = index - ISOTP_LatencyHistogramLinearBuckets;
+    const uint32_t power     = LinearBits + logIndex / ISOTP_LatencyHistogramSubBuckets;
+    const uint32_t subBucket = logIndex % ISOTP_LatencyHistogramSubBuckets;
+    return (1u << power) + (subBucket << (power - SubBits));
+}
+
+uint32_t ISOTP_LatencyHistogram::getBucketUpperBound(const uint32_t index)
+{
+    if (index >= ISOTP_LatencyHistogramBucketCount - 1)
+    {
+        return UINT32_MAX;
+    }
+    return getBucketLowerBound(index + 1) - 1;
+}
+
+uint32_t ISOTP_LatencyHistogramSnapshot::getPercentile(const uint8_t percent) const
+{
+    if (this->count == 0)
+    {
+        return 0;
+    }
+
+    // Smallest bucket that holds at least percent of the values.
+    const uint64_t rank       = std::max<uint64_t>((static_cast<uint64_t>(this->count) * percent + 99) / 100, 1);
+    uint64_t       cumulative = 0;
+    for (uint32_t i = 0; i < ISOTP_LatencyHistogramBucketCount; i++)
+    {
+        cumulative += this->buckets[i];
+        if (cumulative >= rank)
+        {
+            return std::min(ISOTP_LatencyHistogram::getBucketUpperBound(i), this->max_ms);
+        }
+    }
+    return this->max_ms; // The counters were read while values were recorded.
+}
+
+size_t ISOTP_LatencyHistogramSnapshot::print(char* buffer, const size_t size) const
+{
+    size_t length = 0;
+    auto   append = [&](const char* format, auto... args)
+    {
+        const int written = snprintf(length < size ? buffer + length : nullptr, length < size ? size - length : 0,
+                                     format, args...);
+        length += written > 0 ? written : 0;
+    };
+
+    if (size > 0)
+    {
+        buffer[0] = '\0';
+    }
+    for (uint32_t i = 0; i < ISOTP_LatencyHistogramBucketCount; i++)
+    {
+        if (this->buckets[i] == 0)
+        {
+            continue;
+        }
+        if (i == ISOTP_LatencyHistogramBucketCount - 1)
+        {
+            append("%" PRIu32 "+ ms: %" PRIu32 "\n", ISOTP_LatencyHistogram::getBucketLowerBound(i), this->buckets[i]);
+        }
+        else
+        {
+            append("%" PRIu32 "-%" PRIu32 " ms: %" PRIu32 "\n", ISOTP_LatencyHistogram::getBucketLowerBound(i),
+                   ISOTP_LatencyHistogram::getBucketUpperBound(i), this->buckets[i]);
+        }
+    }
+    append("count: %" PRIu32 ", sum: %" PRIu32 " ms, max: %" PRIu32 " ms\n", this->count, this->sum_ms, this->max_ms);
+    return length;
+}
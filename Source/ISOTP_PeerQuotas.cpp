@@ -0,0 +1,110 @@
+#include "ISOTP_PeerQuotas.h"
+
+#include <algorithm>
+
+#include "ISOTP_Common.h"
+
+ISOTP_PeerQuotas::~ISOTP_PeerQuotas()
+{
+    delete[] this->peers.load();
+}
+
+int64_t ISOTP_PeerQuotas::getUnusedReserve(const int64_t reservedMemory, const int64_t usedMemory)
+{
+    return std::max<int64_t>(reservedMemory - usedMemory, 0);
+}
+
+bool ISOTP_PeerQuotas::setQuota(const typeof(N_AI::N_SA) nSa, const ISOTP_PeerQuota& quota)
+{
+    Peer* peers = ISOTP_LoadOrAllocate<Peer[ISOTP_N_AddressCount]>(this->peers);
+    if (peers == nullptr)
+    {
+        return false;
+    }
+
+    Peer& peer = peers[nSa];
+    peer.maxMemory.store(quota.maxMemory);
+    peer.maxReceptions.store(quota.maxReceptions);
+
+    const int64_t oldReservedMemory = peer.reservedMemory.exchange(quota.reservedMemory);
+    const int64_t usedMemory        = peer.usedMemory.load();
+    this->unusedReservedMemory.fetch_add(getUnusedReserve(quota.reservedMemory, usedMemory) -
+                                         getUnusedReserve(oldReservedMemory, usedMemory));
+    return true;
+}
+
+ISOTP_PeerQuota ISOTP_PeerQuotas::getQuota(const typeof(N_AI::N_SA) nSa) const
+{
+    const Peer* peers = this->peers.load(std::memory_order_acquire);
+    if (peers == nullptr)
+    {
+        return ISOTP_DefaultPeerQuota;
+    }
+
+    return {peers[nSa].maxMemory.load(), peers[nSa].reservedMemory.load(), peers[nSa].maxReceptions.load()};
+}
+
+bool ISOTP_PeerQuotas::admit(const typeof(N_AI::N_SA) nSa, const int64_t length, const int64_t availableMemory,
+                             bool& charged)
+{
+    charged     = false;
+    Peer* peers = this->peers.load(std::memory_order_acquire);
+    if (peers == nullptr)
+    {
+        return true;
+    }
+    Peer& peer = peers[nSa];
+
+    uint32_t receptions = peer.receptions.load();
+    do
+    {
+        if (receptions >= peer.maxReceptions.load())
+        {
+            return false;
+        }
+    }
+    while (!peer.receptions.compare_exchange_weak(receptions, receptions + 1));
+
+    const int64_t maxMemory      = peer.maxMemory.load();
+    const int64_t reservedMemory = peer.reservedMemory.load();
+    int64_t       usedMemory     = peer.usedMemory.load();
+    do
+    {
+        // The peer can take its own unused reserve and the memory that is not reserved for anyone.
+        const int64_t othersUnusedReserve =
+            this->unusedReservedMemory.load() - getUnusedReserve(reservedMemory, usedMemory);
+        if (length > maxMemory - usedMemory || length > availableMemory - othersUnusedReserve)
+        {
+            peer.receptions.fetch_sub(1);
+            return false;
+        }
+    }
+    while (!peer.usedMemory.compare_exchange_weak(usedMemory, usedMemory + length));
+
+    this->unusedReservedMemory.fetch_sub(getUnusedReserve(reservedMemory, usedMemory) -
+                                         getUnusedReserve(reservedMemory, usedMemory + length));
+    charged = true;
+    return true;
+}
+
+void ISOTP_PeerQuotas::release(const typeof(N_AI::N_SA) nSa, const int64_t length)
+{
+    Peer* peers = this->peers.load(std::memory_order_acquire);
+    if (peers == nullptr)
+    {
+        return;
+    }
+    Peer& peer = peers[nSa];
+
+    const int64_t reservedMemory = peer.reservedMemory.load();
+    const int64_t usedMemory     = peer.usedMemory.fetch_sub(length);
+    this->unusedReservedMemory.fetch_add(getUnusedReserve(reservedMemory, usedMemory - length) -
+                                         getUnusedReserve(reservedMemory, usedMemory));
+    peer.receptions.fetch_sub(1);
+}
+
+int64_t ISOTP_PeerQuotas::getUsedMemory(const typeof(N_AI::N_SA) nSa) const
+{
+    const Peer* peers = this->peers.load(std::memory_order_acquire);
+    return peers == nullptr ? 0 : peers[nSa].usedMemory.load();
+}
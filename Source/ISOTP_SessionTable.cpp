@@ -0,0 +1,90 @@
+#include "ISOTP_SessionTable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable_v<ISOTP_SessionInfo> && sizeof(ISOTP_SessionInfo) % sizeof(uint32_t) == 0,
+              "ISOTP_SessionInfo must be copyable as words");
+
+const char* ISOTP_SessionStateToString(const ISOTP_SessionState state)
+{
+    switch (state)
+    {
+        case ISOTP_SessionPending:
+            return "PENDING";
+        case ISOTP_SessionActive:
+            return "ACTIVE";
+        case ISOTP_SessionFinishing:
+            return "FINISHING";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+void ISOTP_SessionInfo::armTimer(const ISOTP_TimingPhase phase, const Timer_N& timer, const uint32_t timeout_ms,
+                                 const uint32_t now)
+{
+    if (!timer.isTimerRunning())
+    {
+        return;
+    }
+    if (const int32_t remaining = static_cast<int32_t>(timer.getDeadline(timeout_ms) - now);
+        this->armedTimer == ISOTP_TimingPhaseCount || remaining < this->remainingTime_ms)
+    {
+        this->armedTimer       = phase;
+        this->remainingTime_ms = remaining;
+    }
+}
+
+void ISOTP_SessionTable::publish(const ISOTP_SessionInfo* sessions, const uint32_t totalSessions,
+                                 const uint32_t timestamp)
+{
+    const auto*    source   = reinterpret_cast<const uint8_t*>(sessions);
+    const uint32_t sequence = this->sequence.load(std::memory_order_relaxed);
+
+    this->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    this->timestamp.store(timestamp, std::memory_order_relaxed);
+    this->totalSessions.store(totalSessions, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < std::min(totalSessions, ISOTP_SessionTableSize) * SessionWords; i++)
+    {
+        uint32_t word;
+        memcpy(&word, source + i * sizeof(uint32_t), sizeof(uint32_t));
+        this->sessions[i].store(word, std::memory_order_relaxed);
+    }
+    this->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool ISOTP_SessionTable::read(ISOTP_SessionSnapshot& snapshot) const
+{
+    for (uint32_t tries = 0; tries < ReadTries; tries++)
+    {
+        const uint32_t sequence = this->sequence.load(std::memory_order_acquire);
+        if (sequence == 0)
+        {
+            return false; // Never published.
+        }
+        if (sequence % 2 != 0)
+        {
+            continue; // A publish is in progress.
+        }
+
+        snapshot.timestamp     = this->timestamp.load(std::memory_order_relaxed);
+        snapshot.totalSessions = this->totalSessions.load(std::memory_order_relaxed);
+        snapshot.sessionCount  = std::min(snapshot.totalSessions, ISOTP_SessionTableSize);
+        auto* destination      = reinterpret_cast<uint8_t*>(snapshot.sessions);
+        for (uint32_t i = 0; i < snapshot.sessionCount * SessionWords; i++)
+        {
+            const uint32_t word = this->sessions[i].load(std::memory_order_relaxed);
+            memcpy(destination + i * sizeof(uint32_t), &word, sizeof(uint32_t));
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (this->sequence.load(std::memory_order_relaxed) == sequence)
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,199 @@
+#include "ISOTP_SlabAllocator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstring>
+
+#include "ISOTP_Common.h"
+
+ISOTP_SlabAllocator::ISOTP_SlabAllocator(OSInterface& osInterface, const uint32_t regionSize)
+{
+    this->osInterface = &osInterface;
+    this->mutex       = nullptr;
+    this->region      = nullptr;
+    this->blockInfo   = nullptr;
+    this->capacity    = 0;
+    this->usedMemory  = 0;
+
+    const uint32_t capacity = regionSize / MinBlockSize * MinBlockSize;
+    if (capacity == 0)
+    {
+        return;
+    }
+
+    this->mutex     = osInterface.osCreateMutex();
+    this->region    = static_cast<uint8_t*>(osInterface.osMalloc(capacity));
+    this->blockInfo = static_cast<uint8_t*>(osInterface.osMalloc(capacity / MinBlockSize));
+    if (this->mutex == nullptr || this->region == nullptr || this->blockInfo == nullptr)
+    {
+        return; // Not enabled, the destructor frees what was allocated.
+    }
+    this->capacity = capacity;
+    memset(this->blockInfo, 0, capacity / MinBlockSize);
+
+    // Split the region in the largest blocks that fit. Each block starts at a multiple of its size, so it is aligned
+    // like the blocks split from it, and its buddy would end past the region, so it is never merged with its neighbour.
+    uint32_t offset = 0;
+    for (uint8_t order = OrderCount; order-- > 0;)
+    {
+        if (capacity - offset >= MinBlockSize << order)
+        {
+            pushFreeBlock(offset, order);
+            offset += MinBlockSize << order;
+        }
+    }
+}
+
+ISOTP_SlabAllocator::~ISOTP_SlabAllocator()
+{
+    if (this->region != nullptr)
+    {
+        this->osInterface->osFree(this->region);
+    }
+    if (this->blockInfo != nullptr)
+    {
+        this->osInterface->osFree(this->blockInfo);
+    }
+    delete this->mutex;
+}
+
+bool ISOTP_SlabAllocator::isEnabled() const
+{
+    return this->capacity > 0;
+}
+
+uint32_t ISOTP_SlabAllocator::getCapacity() const
+{
+    return this->capacity;
+}
+
+uint32_t ISOTP_SlabAllocator::getLargestBlockSize() const
+{
+    return std::bit_floor(this->capacity);
+}
+
+int64_t ISOTP_SlabAllocator::getBlockSize(const uint32_t size)
+{
+    return static_cast<int64_t>(std::bit_ceil(std::max<uint64_t>(size, MinBlockSize)));
+}
+
+uint32_t ISOTP_SlabAllocator::getOffset(const void* block) const
+{
+    return static_cast<const uint8_t*>(block) - this->region;
+}
+
+void ISOTP_SlabAllocator::pushFreeBlock(const uint32_t offset, const uint8_t order)
+{
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(this->region + offset);
+    block->previous  = nullptr;
+    block->next      = this->freeLists[order];
+    if (block->next != nullptr)
+    {
+        block->next->previous = block;
+    }
+    this->freeLists[order] = block;
+
+    this->blockInfo[offset / MinBlockSize] = (order + 1) | FreeFlag;
+}
+
+void ISOTP_SlabAllocator::removeFreeBlock(const uint32_t offset, const uint8_t order)
+{
+    const FreeBlock* block = reinterpret_cast<FreeBlock*>(this->region + offset);
+    if (block->previous != nullptr)
+    {
+        block->previous->next = block->next;
+    }
+    else
+    {
+        this->freeLists[order] = block->next;
+    }
+    if (block->next != nullptr)
+    {
+        block->next->previous = block->previous;
+    }
+
+    this->blockInfo[offset / MinBlockSize] = 0;
+}
+
+void* ISOTP_SlabAllocator::allocate(const uint32_t size)
+{
+    const int64_t blockSize = getBlockSize(size);
+    if (!isEnabled() || blockSize > getLargestBlockSize() || !this->mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        return nullptr;
+    }
+
+    const uint8_t order = std::countr_zero(static_cast<uint64_t>(blockSize / MinBlockSize));
+
+    // Take the smallest free block that fits and split it until it has the size of the class.
+    uint8_t freeOrder = order;
+    while (freeOrder < OrderCount && this->freeLists[freeOrder] == nullptr)
+    {
+        freeOrder++;
+    }
+    if (freeOrder == OrderCount)
+    {
+        this->mutex->signal();
+        return nullptr;
+    }
+
+    const uint32_t offset = getOffset(this->freeLists[freeOrder]);
+    removeFreeBlock(offset, freeOrder);
+    while (freeOrder > order)
+    {
+        freeOrder--;
+        pushFreeBlock(offset + (MinBlockSize << freeOrder), freeOrder); // The upper half stays free.
+    }
+
+    this->blockInfo[offset / MinBlockSize] = order + 1;
+    this->usedMemory += blockSize;
+
+    this->mutex->signal();
+    return this->region + offset;
+}
+
+void ISOTP_SlabAllocator::release(void* block)
+{
+    if (block == nullptr || !this->mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        return;
+    }
+
+    uint32_t offset = getOffset(block);
+    assert(offset < this->capacity && (this->blockInfo[offset / MinBlockSize] & FreeFlag) == 0 &&
+           this->blockInfo[offset / MinBlockSize] != 0 && "The block was not taken from this allocator");
+
+    uint8_t order = this->blockInfo[offset / MinBlockSize] - 1;
+    this->usedMemory -= MinBlockSize << order;
+
+    // Merge the block with its buddy while the buddy is free and has not been split.
+    while (order < OrderCount - 1)
+    {
+        const uint32_t buddyOffset = offset ^ (MinBlockSize << order);
+        if (static_cast<uint64_t>(buddyOffset) + (MinBlockSize << order) > this->capacity ||
+            this->blockInfo[buddyOffset / MinBlockSize] != ((order + 1) | FreeFlag))
+        {
+            break;
+        }
+
+        removeFreeBlock(buddyOffset, order);
+        this->blockInfo[offset / MinBlockSize] = 0;
+        offset                                 = std::min(offset, buddyOffset);
+        order++;
+    }
+    pushFreeBlock(offset, order);
+
+    this->mutex->signal();
+}
+
+uint32_t ISOTP_SlabAllocator::getUsedMemory() const
+{
+    uint32_t used = 0;
+    if (this->mutex != nullptr && this->mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        used = this->usedMemory;
+        this->mutex->signal();
+    }
+    return used;
+}
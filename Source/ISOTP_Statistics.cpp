@@ -0,0 +1,355 @@
+#include "ISOTP_Statistics.h"
+
+const char* ISOTP_TimingPhaseToString(const ISOTP_TimingPhase phase)
+{
+    switch (phase)
+    {
+        case ISOTP_N_AsPhase:
+            return "N_As";
+        case ISOTP_N_BsPhase:
+            return "N_Bs";
+        case ISOTP_N_CsPhase:
+            return "N_Cs";
+        case ISOTP_N_ArPhase:
+            return "N_Ar";
+        case ISOTP_N_BrPhase:
+            return "N_Br";
+        case ISOTP_N_CrPhase:
+            return "N_Cr";
+        case ISOTP_RequestPhase:
+            return "Request";
+        case ISOTP_IndicationPhase:
+            return "Indication";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+const char* ISOTP_LockToString(const ISOTP_Lock lock)
+{
+    switch (lock)
+    {
+        case ISOTP_ConfigLock:
+            return "configMutex";
+        case ISOTP_NotStartedRunnersLock:
+            return "notStartedRunnersMutex";
+        case ISOTP_RunnersLock:
+            return "runnersMutex";
+        case ISOTP_ACKQueueLock:
+            return "ACKQueueMutex";
+        case ISOTP_RunnerLock:
+            return "runnerMutex";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+const char* ISOTP_RunStepPhaseToString(const ISOTP_RunStepPhase phase)
+{
+    switch (phase)
+    {
+        case ISOTP_StartRunnersStep:
+            return "startRunners";
+        case ISOTP_GetFrameStep:
+            return "getFrame";
+        case ISOTP_RunRunnersStep:
+            return "runRunners";
+        case ISOTP_CallbacksStep:
+            return "callbacks";
+        case ISOTP_RunStepTotal:
+            return "runStep";
+        case ISOTP_ACKQueueRunStep:
+            return "canMessageACKQueueRunStep";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+ISOTP_Statistics::~ISOTP_Statistics()
+{
+    PeerCounters* peers = this->peers.load();
+    if (peers == nullptr)
+    {
+        return;
+    }
+    for (uint32_t peer = 0; peer < ISOTP_N_AddressCount; peer++)
+    {
+        delete peers[peer].histograms.load();
+    }
+    delete[] peers;
+}
+
+void ISOTP_Statistics::increment(std::atomic<uint32_t>& counter, const uint32_t amount)
+{
+    counter.fetch_add(amount, std::memory_order_relaxed);
+}
+
+void ISOTP_Statistics::raise(std::atomic<int64_t>& highWater, const int64_t value)
+{
+    int64_t current = highWater.load(std::memory_order_relaxed);
+    while (value > current && !highWater.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+ISOTP_PeerStatistics ISOTP_Statistics::load(const PeerCounters& counters)
+{
+    return {counters.framesTx.load(std::memory_order_relaxed),
+            counters.framesRx.load(std::memory_order_relaxed),
+            counters.bytesTx.load(std::memory_order_relaxed),
+            counters.bytesRx.load(std::memory_order_relaxed),
+            counters.sessionsStarted.load(std::memory_order_relaxed),
+            counters.sessionsCompleted.load(std::memory_order_relaxed),
+            counters.sessionsFailed.load(std::memory_order_relaxed)};
+}
+
+ISOTP_Statistics::PeerCounters* ISOTP_Statistics::getPeer(const uint32_t peer) const
+{
+    PeerCounters* peers = this->peers.load(std::memory_order_acquire);
+    return peers != nullptr && peer != NoPeer ? &peers[peer] : nullptr;
+}
+
+ISOTP_Statistics::PeerHistograms* ISOTP_Statistics::getPeerHistograms(const uint32_t peer) const
+{
+    const PeerCounters* counters = getPeer(peer);
+    return counters != nullptr ? counters->histograms.load(std::memory_order_acquire) : nullptr;
+}
+
+uint32_t ISOTP_Statistics::getTargetPeer(const N_AI nAi)
+{
+    return nAi.N_TAtype == N_TATYPE_6_CAN_CLASSIC_29bit_Functional ? NoPeer : nAi.N_TA;
+}
+
+void ISOTP_Statistics::onFrameWritten(const CANFrame& frame)
+{
+    increment(this->total.framesTx);
+    increment(this->total.bytesTx, frame.data_length_code);
+    if (PeerCounters* peer = getPeer(getTargetPeer(frame.identifier)); peer != nullptr)
+    {
+        increment(peer->framesTx);
+        increment(peer->bytesTx, frame.data_length_code);
+    }
+}
+
+void ISOTP_Statistics::onFrameReceived(const CANFrame& frame)
+{
+    increment(this->total.framesRx);
+    increment(this->total.bytesRx, frame.data_length_code);
+    if (PeerCounters* peer = getPeer(frame.identifier.N_SA); peer != nullptr)
+    {
+        increment(peer->framesRx);
+        increment(peer->bytesRx, frame.data_length_code);
+    }
+}
+
+void ISOTP_Statistics::onSessionStarted(const uint32_t peer)
+{
+    increment(this->total.sessionsStarted);
+    if (PeerCounters* counters = getPeer(peer); counters != nullptr)
+    {
+        increment(counters->sessionsStarted);
+    }
+}
+
+void ISOTP_Statistics::onRequestFinished(const uint32_t peer, const N_Result result)
+{
+    increment(this->requestResults[result]);
+    increment(result == N_OK ? this->total.sessionsCompleted : this->total.sessionsFailed);
+    if (PeerCounters* counters = getPeer(peer); counters != nullptr)
+    {
+        increment(result == N_OK ? counters->sessionsCompleted : counters->sessionsFailed);
+    }
+}
+
+void ISOTP_Statistics::onIndicationFinished(const uint32_t peer, const N_Result result)
+{
+    increment(this->indicationResults[result]);
+    increment(result == N_OK ? this->total.sessionsCompleted : this->total.sessionsFailed);
+    if (PeerCounters* counters = getPeer(peer); counters != nullptr)
+    {
+        increment(result == N_OK ? counters->sessionsCompleted : counters->sessionsFailed);
+    }
+}
+
+void ISOTP_Statistics::onFrameHeld()
+{
+    increment(this->heldFrames);
+}
+
+void ISOTP_Statistics::onOverflowFCSent()
+{
+    increment(this->overflowFCsSent);
+}
+
+void ISOTP_Statistics::onN_CsPerformanceMiss()
+{
+    increment(this->N_CsPerformanceMisses);
+}
+
+void ISOTP_Statistics::onN_BrPerformanceMiss()
+{
+    increment(this->N_BrPerformanceMisses);
+}
+
+void ISOTP_Statistics::setMemoryForRunners(const int64_t memoryForRunners)
+{
+    this->memoryForRunners.store(memoryForRunners, std::memory_order_relaxed);
+}
+
+void ISOTP_Statistics::recordAvailableMemory(const int64_t availableMemory)
+{
+    raise(this->memoryHighWater, this->memoryForRunners.load(std::memory_order_relaxed) - availableMemory);
+}
+
+void ISOTP_Statistics::recordACKQueueDepth(const uint32_t depth)
+{
+    raise(this->ackQueueDepthHighWater, depth);
+}
+
+void ISOTP_Statistics::recordLatency(const ISOTP_TimingPhase phase, const uint32_t peer, const uint32_t elapsed_ms)
+{
+    this->latencies[phase].record(elapsed_ms);
+
+    if (PeerHistograms* histograms = getPeerHistograms(peer); histograms != nullptr)
+    {
+        histograms->phases[phase].record(elapsed_ms);
+    }
+}
+
+void ISOTP_Statistics::onLockAcquired(const ISOTP_Lock lock, const bool contended, const uint32_t wait_ms)
+{
+    increment(this->locks[lock].acquisitions);
+    if (contended)
+    {
+        increment(this->locks[lock].contendedAcquisitions);
+        this->locks[lock].waits.record(wait_ms);
+    }
+}
+
+void ISOTP_Statistics::onLockTimeout(const ISOTP_Lock lock, const uint32_t wait_ms)
+{
+    increment(this->locks[lock].timeouts);
+    this->locks[lock].waits.record(wait_ms);
+}
+
+void ISOTP_Statistics::recordRunStepDuration(const ISOTP_RunStepPhase phase, const uint32_t elapsed_ms)
+{
+    this->runStepDurations[phase].record(elapsed_ms);
+}
+
+void ISOTP_Statistics::setRunStepTimingEnabled(const bool enabled)
+{
+    this->runStepTimingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool ISOTP_Statistics::isRunStepTimingEnabled() const
+{
+    return this->runStepTimingEnabled.load(std::memory_order_relaxed);
+}
+
+int64_t ISOTP_Statistics::getPeerTableSize()
+{
+    return sizeof(PeerCounters) * ISOTP_N_AddressCount;
+}
+
+bool ISOTP_Statistics::enablePeerStatistics()
+{
+    bool allocated = false;
+    if (ISOTP_LoadOrAllocate<PeerCounters[ISOTP_N_AddressCount]>(this->peers, &allocated) == nullptr)
+    {
+        return false;
+    }
+    if (allocated)
+    {
+        this->memoryForRunners.fetch_sub(getPeerTableSize(), std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool ISOTP_Statistics::arePeerStatisticsEnabled() const
+{
+    return this->peers.load(std::memory_order_acquire) != nullptr;
+}
+
+bool ISOTP_Statistics::enablePeerLatencyHistograms(const typeof(N_AI::N_SA) peer)
+{
+    PeerCounters* counters = getPeer(peer);
+    return counters != nullptr && ISOTP_LoadOrAllocate<PeerHistograms>(counters->histograms) != nullptr;
+}
+
+void ISOTP_Statistics::resetLatencyHistograms()
+{
+    for (auto& latency : this->latencies)
+    {
+        latency.reset();
+    }
+    for (auto& duration : this->runStepDurations)
+    {
+        duration.reset();
+    }
+
+    for (uint32_t peer = 0; peer < ISOTP_N_AddressCount; peer++)
+    {
+        if (PeerHistograms* histograms = getPeerHistograms(peer); histograms != nullptr)
+        {
+            for (auto& latency : histograms->phases)
+            {
+                latency.reset();
+            }
+        }
+    }
+}
+
+ISOTP_StatisticsSnapshot ISOTP_Statistics::getSnapshot() const
+{
+    ISOTP_StatisticsSnapshot snapshot{};
+    snapshot.total = load(this->total);
+    for (uint8_t result = 0; result < ISOTP_N_ResultCount; result++)
+    {
+        snapshot.requestResults[result]    = this->requestResults[result].load(std::memory_order_relaxed);
+        snapshot.indicationResults[result] = this->indicationResults[result].load(std::memory_order_relaxed);
+    }
+    snapshot.heldFrames                = this->heldFrames.load(std::memory_order_relaxed);
+    snapshot.overflowFCsSent           = this->overflowFCsSent.load(std::memory_order_relaxed);
+    snapshot.N_CsPerformanceMisses     = this->N_CsPerformanceMisses.load(std::memory_order_relaxed);
+    snapshot.N_BrPerformanceMisses     = this->N_BrPerformanceMisses.load(std::memory_order_relaxed);
+    snapshot.memoryForRunnersHighWater = this->memoryHighWater.load(std::memory_order_relaxed);
+    snapshot.ackQueueDepthHighWater    = this->ackQueueDepthHighWater.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+ISOTP_PeerStatistics ISOTP_Statistics::getPeerStatistics(const typeof(N_AI::N_SA) peer) const
+{
+    const PeerCounters* peers = this->peers.load(std::memory_order_acquire);
+    return peers != nullptr ? load(peers[peer]) : ISOTP_PeerStatistics{};
+}
+
+ISOTP_LatencyHistogramSnapshot ISOTP_Statistics::getLatencyHistogram(const ISOTP_TimingPhase phase) const
+{
+    return this->latencies[phase].getSnapshot();
+}
+
+bool ISOTP_Statistics::getPeerLatencyHistogram(const typeof(N_AI::N_SA) peer, const ISOTP_TimingPhase phase,
+                                               ISOTP_LatencyHistogramSnapshot& histogram) const
+{
+    const PeerHistograms* histograms = getPeerHistograms(peer);
+    if (histograms == nullptr)
+    {
+        return false;
+    }
+    histogram = histograms->phases[phase].getSnapshot();
+    return true;
+}
+
+ISOTP_LockStatistics ISOTP_Statistics::getLockStatistics(const ISOTP_Lock lock) const
+{
+    const LockCounters& counters = this->locks[lock];
+    return {counters.acquisitions.load(std::memory_order_relaxed),
+            counters.contendedAcquisitions.load(std::memory_order_relaxed),
+            counters.timeouts.load(std::memory_order_relaxed), counters.waits.getSnapshot()};
+}
+
+ISOTP_LatencyHistogramSnapshot ISOTP_Statistics::getRunStepHistogram(const ISOTP_RunStepPhase phase) const
+{
+    return this->runStepDurations[phase].getSnapshot();
+}
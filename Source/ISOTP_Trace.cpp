@@ -0,0 +1,394 @@
+#include "ISOTP_Trace.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace
+{
+constexpr uint8_t TraceMagic[8] = {'I', 'S', 'O', 'T', 'P', 'T', 'R', 'C'};
+
+void putUint16(uint8_t* buffer, const uint16_t value)
+{
+    buffer[0] = value & 0xFF;
+    buffer[1] = value >> 8;
+}
+
+void putUint32(uint8_t* buffer, const uint32_t value)
+{
+    putUint16(buffer, value & 0xFFFF);
+    putUint16(buffer + 2, value >> 16);
+}
+
+uint16_t getUint16(const uint8_t* buffer)
+{
+    return buffer[0] | buffer[1] << 8;
+}
+
+uint32_t getUint32(const uint8_t* buffer)
+{
+    return getUint16(buffer) | static_cast<uint32_t>(getUint16(buffer + 2)) << 16;
+}
+} // namespace
+
+const char* ISOTP_TraceEventToString(const ISOTP_TraceEvent event)
+{
+    switch (event)
+    {
+        case ISOTP_TraceFrameRead:
+            return "READ";
+        case ISOTP_TraceFrameWritten:
+            return "WRITTEN";
+        case ISOTP_TraceWriteFailed:
+            return "WRITE_FAILED";
+        case ISOTP_TraceACK:
+            return "ACK";
+        case ISOTP_TraceRecordsDropped:
+            return "DROPPED";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+uint32_t ISOTP_GetCANId(const N_AI nAi)
+{
+    return static_cast<uint32_t>(nAi.N_NFA_Header) << 26 | static_cast<uint32_t>(nAi.N_NFA_Padding) << 24 |
+           static_cast<uint32_t>(nAi.N_TAtype) << 16 | static_cast<uint32_t>(nAi.N_TA) << 8 | nAi.N_SA;
+}
+
+N_AI ISOTP_GetN_AI(const uint32_t canId)
+{
+    N_AI nAi{};
+    nAi.N_NFA_Header  = canId >> 26 & 0b111;
+    nAi.N_NFA_Padding = canId >> 24 & 0b11;
+    nAi.N_TAtype      = static_cast<N_TAtype_t>(canId >> 16 & 0xFF);
+    nAi.N_TA          = canId >> 8 & 0xFF;
+    nAi.N_SA          = canId & 0xFF;
+    return nAi;
+}
+
+ISOTP_TraceBuffer::ISOTP_TraceBuffer(OSInterface& osInterface, const uint32_t capacity) : osInterface(osInterface)
+{
+    this->head  = 0;
+    this->mask  = 0;
+    this->slots = nullptr;
+
+    if (capacity == 0)
+    {
+        return;
+    }
+
+    const uint32_t roundedCapacity = std::bit_floor(capacity);
+    this->slots                    = new (std::nothrow) Slot[roundedCapacity];
+    if (this->slots == nullptr)
+    {
+        return;
+    }
+    for (uint32_t i = 0; i < roundedCapacity; i++)
+    {
+        this->slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    this->mask = roundedCapacity - 1;
+}
+
+ISOTP_TraceBuffer::~ISOTP_TraceBuffer()
+{
+    delete[] this->slots;
+}
+
+bool ISOTP_TraceBuffer::isEnabled() const
+{
+    return this->slots != nullptr;
+}
+
+uint32_t ISOTP_TraceBuffer::getCapacity() const
+{
+    return isEnabled() ? this->mask + 1 : 0;
+}
+
+void ISOTP_TraceBuffer::record(const ISOTP_TraceEvent event, const CANFrame& frame)
+{
+    ISOTP_TraceRecord record{};
+    record.timestamp_ms = this->osInterface.osMillis();
+    record.canId        = ISOTP_GetCANId(frame.identifier);
+    record.event        = event;
+    record.ack          = ACK_NONE;
+    record.dlc          = std::min<uint8_t>(frame.data_length_code, CAN_FRAME_MAX_DLC);
+    memcpy(record.data, frame.data, record.dlc);
+    push(record);
+}
+
+void ISOTP_TraceBuffer::recordACK(const N_AI nAi, const ACKResult ack)
+{
+    ISOTP_TraceRecord record{};
+    record.timestamp_ms = this->osInterface.osMillis();
+    record.canId        = ISOTP_GetCANId(nAi);
+    record.event        = ISOTP_TraceACK;
+    record.ack          = ack;
+    push(record);
+}
+
+void ISOTP_TraceBuffer::push(const ISOTP_TraceRecord& record)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+
+    uint32_t position = this->tail.load(std::memory_order_relaxed);
+    Slot*    slot;
+    while (true)
+    {
+        slot = &this->slots[position & this->mask];
+
+        const uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const auto     distance = static_cast<int32_t>(sequence - position);
+        if (distance == 0)
+        {
+            if (this->tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break; // The slot is reserved.
+            }
+        }
+        else if (distance < 0)
+        {
+            this->dropped.fetch_add(1, std::memory_order_relaxed); // The slot was not popped yet, the ring is full.
+            return;
+        }
+        else
+        {
+            position = this->tail.load(std::memory_order_relaxed); // Another producer reserved it.
+        }
+    }
+
+    slot->record = record;
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+bool ISOTP_TraceBuffer::pop(ISOTP_TraceRecord& record)
+{
+    if (!isEnabled())
+    {
+        return false;
+    }
+
+    Slot* slot = &this->slots[this->head & this->mask];
+    if (slot->sequence.load(std::memory_order_acquire) != this->head + 1)
+    {
+        return false; // Empty, or the producer of the slot did not finish yet.
+    }
+    record = slot->record;
+    slot->sequence.store(this->head + this->mask + 1, std::memory_order_release); // Writable on the next lap.
+    this->head++;
+    return true;
+}
+
+uint32_t ISOTP_TraceBuffer::getDroppedRecords() const
+{
+    return this->dropped.load(std::memory_order_relaxed);
+}
+
+ISOTP_TraceWriter::ISOTP_TraceWriter(ISOTP_TraceBuffer& buffer, const ISOTP_TraceSink_cb_t binarySink,
+                                     void* binaryContext, const ISOTP_TraceSink_cb_t textSink, void* textContext,
+                                     const char* interfaceName) : buffer(buffer)
+{
+    this->binarySink        = binarySink;
+    this->binaryContext     = binaryContext;
+    this->textSink          = textSink;
+    this->textContext       = textContext;
+    this->interfaceName     = interfaceName;
+    this->headerWritten     = false;
+    this->droppedRecords    = 0;
+    this->lostRecords       = 0;
+    this->batchedRecords    = 0;
+    this->batchedTextLength = 0;
+}
+
+uint32_t ISOTP_TraceWriter::drain(const uint32_t maxRecords)
+{
+    if (!this->headerWritten)
+    {
+        uint8_t header[ISOTP_TraceHeaderSize];
+        encodeHeader(header);
+        this->headerWritten = this->binarySink == nullptr || this->binarySink(header, sizeof(header), binaryContext);
+        if (!this->headerWritten)
+        {
+            OSInterfaceLogError(TAG, "Failed to write the trace header");
+            return 0;
+        }
+    }
+
+    if (const uint32_t dropped = this->buffer.getDroppedRecords(); dropped != this->droppedRecords)
+    {
+        ISOTP_TraceRecord record{};
+        record.event         = ISOTP_TraceRecordsDropped;
+        record.canId         = dropped - this->droppedRecords;
+        this->droppedRecords = dropped;
+        OSInterfaceLogWarning(TAG, "%" PRIu32 " trace records were dropped, the ring is full", record.canId);
+        write(record);
+    }
+
+    uint32_t          count = 0;
+    ISOTP_TraceRecord record;
+    while (count < maxRecords && this->buffer.pop(record))
+    {
+        write(record);
+        count++;
+    }
+    flush();
+    return count;
+}
+
+uint32_t ISOTP_TraceWriter::getLostRecords() const
+{
+    return this->lostRecords;
+}
+
+void ISOTP_TraceWriter::write(const ISOTP_TraceRecord& record)
+{
+    if (this->batchedRecords == BatchRecords)
+    {
+        flush();
+    }
+
+    encode(record, &this->batch[this->batchedRecords * ISOTP_TraceRecordSize]);
+    if (this->textSink != nullptr)
+    {
+        // The lines are at most MaxLineLength long, so they always fit next to the ones of the other batched records.
+        char         line[MaxLineLength + 1];
+        const size_t length = std::min<size_t>(toCandump(record, interfaceName, line, sizeof(line)), MaxLineLength);
+        memcpy(&this->textBatch[this->batchedTextLength], line, length);
+        this->batchedTextLength += length;
+    }
+    this->batchedRecords++;
+}
+
+void ISOTP_TraceWriter::flush()
+{
+    if (this->batchedRecords == 0)
+    {
+        return;
+    }
+
+    bool written = true;
+    if (this->binarySink != nullptr)
+    {
+        written &= this->binarySink(this->batch, this->batchedRecords * ISOTP_TraceRecordSize, this->binaryContext);
+    }
+    if (this->textSink != nullptr && this->batchedTextLength > 0)
+    {
+        const auto* text = reinterpret_cast<const uint8_t*>(this->textBatch);
+        written &= this->textSink(text, this->batchedTextLength, this->textContext);
+    }
+    if (!written)
+    {
+        this->lostRecords += this->batchedRecords;
+    }
+    this->batchedRecords    = 0;
+    this->batchedTextLength = 0;
+}
+
+void ISOTP_TraceWriter::encodeHeader(uint8_t* buffer)
+{
+    memcpy(buffer, TraceMagic, sizeof(TraceMagic));
+    putUint16(buffer + 8, ISOTP_TraceVersion);
+    putUint16(buffer + 10, ISOTP_TraceRecordSize);
+    putUint32(buffer + 12, 0);
+}
+
+bool ISOTP_TraceWriter::decodeHeader(const uint8_t* buffer)
+{
+    return memcmp(buffer, TraceMagic, sizeof(TraceMagic)) == 0 && getUint16(buffer + 8) == ISOTP_TraceVersion &&
+           getUint16(buffer + 10) == ISOTP_TraceRecordSize;
+}
+
+void ISOTP_TraceWriter::encode(const ISOTP_TraceRecord& record, uint8_t* buffer)
+{
+    putUint32(buffer, record.timestamp_ms);
+    putUint32(buffer + 4, record.canId);
+    buffer[8]  = record.event;
+    buffer[9]  = record.ack;
+    buffer[10] = record.dlc;
+    buffer[11] = 0;
+    memcpy(buffer + 12, record.data, CAN_FRAME_MAX_DLC);
+}
+
+bool ISOTP_TraceWriter::decode(const uint8_t* buffer, ISOTP_TraceRecord& record)
+{
+    record.timestamp_ms = getUint32(buffer);
+    record.canId        = getUint32(buffer + 4);
+    record.event        = buffer[8];
+    record.ack          = buffer[9];
+    record.dlc          = buffer[10];
+    record.reserved     = 0;
+    memcpy(record.data, buffer + 12, CAN_FRAME_MAX_DLC);
+    return record.event < ISOTP_TraceEventCount && record.dlc <= CAN_FRAME_MAX_DLC;
+}
+
+size_t ISOTP_TraceWriter::toCandump(const ISOTP_TraceRecord& record, const char* interfaceName, char* buffer,
+                                    const size_t size)
+{
+    if (size > 0)
+    {
+        buffer[0] = '\0';
+    }
+    if (record.event != ISOTP_TraceFrameRead && record.event != ISOTP_TraceFrameWritten)
+    {
+        return 0;
+    }
+
+    char data[2 * CAN_FRAME_MAX_DLC + 1] = {};
+    for (uint8_t i = 0; i < std::min<uint8_t>(record.dlc, CAN_FRAME_MAX_DLC); i++)
+    {
+        snprintf(&data[2 * i], 3, "%02" PRIX8, record.data[i]);
+    }
+    const int written = snprintf(buffer, size, "(%010" PRIu32 ".%06" PRIu32 ") %.16s %08" PRIX32 "#%s\n",
+                                 record.timestamp_ms / 1000, record.timestamp_ms % 1000 * 1000, interfaceName,
+                                 record.canId, data);
+    return written > 0 ? written : 0;
+}
+
+bool ISOTP_TraceWriter::fromCandump(const char* line, ISOTP_TraceRecord& record)
+{
+    unsigned long seconds      = 0;
+    unsigned long microseconds = 0;
+    char          canId[16]    = {};
+    int           dataStart    = 0;
+    line += strspn(line, " \t"); // Not the new lines, so an empty line does not parse as the next one.
+    if (sscanf(line, "(%lu.%lu) %*s %15[0-9A-Fa-f]#%n", &seconds, &microseconds, canId, &dataStart) != 3 ||
+        dataStart == 0 || strlen(canId) != 8)
+    {
+        return false; // Not a frame, or a standard identifier.
+    }
+
+    // The data is hex digits up to the end of the line or a space, so "##" (CAN FD) and "R" (remote) are refused.
+    const char* data   = line + dataStart;
+    size_t      length = 0;
+    while (isxdigit(static_cast<unsigned char>(data[length])) && length <= 2 * CAN_FRAME_MAX_DLC)
+    {
+        length++;
+    }
+    if (length % 2 != 0 || length > 2 * CAN_FRAME_MAX_DLC ||
+        (data[length] != '\0' && data[length] != '\n' && data[length] != '\r' && data[length] != ' '))
+    {
+        return false;
+    }
+
+    record              = {};
+    record.timestamp_ms = seconds * 1000 + microseconds / 1000;
+    record.canId        = strtoul(canId, nullptr, 16);
+    record.event        = ISOTP_TraceFrameRead;
+    record.ack          = ACK_NONE;
+    record.dlc          = length / 2;
+    for (uint8_t i = 0; i < record.dlc; i++)
+    {
+        const char byte[3] = {data[2 * i], data[2 * i + 1], '\0'};
+        record.data[i]     = strtoul(byte, nullptr, 16);
+    }
+    return record.canId < 1u << 29;
+}
@@ -1,47 +1,54 @@
 #include "N_USData_Indication_Runner.h"
 #include <cassert>
 #include <cstring>
+#include <iterator>
+
+#include "ISOTP_InstrumentedMutex.h"
 
 N_USData_Indication_Runner::N_USData_Indication_Runner(bool& result, const N_AI nAi,
                                                        Atomic_int64_t& availableMemoryForRunners,
                                                        const uint8_t blockSize, const STmin stMin,
-                                                       OSInterface& osInterface, CANMessageACKQueue& canMessageACKQueue)
+                                                       OSInterface& osInterface,
+                                                       CANMessageACKQueue& canMessageACKQueue,
+                                                       const ThreadingPolicy threadingPolicy,
+                                                       ISOTP_PeerQuotas* peerQuotas,
+                                                       ISOTP_SlabAllocator* payloadAllocator,
+                                                       ISOTP_ChunkPool* chunkPool,
+                                                       ISOTP_Statistics* statistics) :
+    tag(N_USDATA_INDICATION_RUNNER_STATIC_TAG, nAi), timerN_Ar(osInterface), timerN_Br(osInterface),
+    timerN_Cr(osInterface)
 {
     result = false;
 
     this->availableMemoryForRunners = &availableMemoryForRunners;
+    this->peerQuotas                = peerQuotas;
+    this->payloadAllocator          = payloadAllocator;
+    this->chunkPool                 = chunkPool;
+    this->statistics                = statistics;
+    this->segmentCount              = 0;
+    this->quotaCharged              = false;
     this->osInterface               = &osInterface;
 
-    if (this->availableMemoryForRunners->subIfResIsGreaterThanZero(N_USDATA_INDICATION_RUNNER_TAG_SIZE))
-    {
-        this->tag = static_cast<char*>(this->osInterface->osMalloc(N_USDATA_INDICATION_RUNNER_TAG_SIZE));
-        if (this->tag == nullptr)
-        {
-            return;
-        }
-        snprintf(this->tag, N_USDATA_INDICATION_RUNNER_TAG_SIZE, "%s%s", N_USDATA_INDICATION_RUNNER_STATIC_TAG,
-                 nAiToString(nAi));
-    }
-    else
-    {
-        return;
-    }
-
-    OSInterfaceLogDebug(tag, "Creating N_USData_Indication_Runner with tag %s", this->tag);
+    OSInterfaceLogDebug(getTAG(), "Creating N_USData_Indication_Runner with tag %s", getTAG());
 
     this->mType              = Mtype_Unknown;
     this->CanMessageACKQueue = &canMessageACKQueue;
     this->messageData        = nullptr;
     this->messageLength      = 0;
     this->result             = NOT_STARTED;
-    this->lastRunTime        = 0;
+    this->stepTime           = 0;
+    this->startTime          = 0;
     this->sequenceNumber = 1; // The first sequence number that is being sent is 1. (0 is reserved for the first frame)
 
-    this->mutex = osInterface.osCreateMutex();
-    if (this->mutex == nullptr)
+    if (threadingPolicy == ThreadSafeRunner)
     {
-        OSInterfaceLogError(tag, AT "Failed to create mutex");
-        return;
+        this->mutex =
+            ISOTP_InstrumentedMutex::wrap(osInterface.osCreateMutex(), ISOTP_RunnerLock, osInterface, statistics);
+        if (this->mutex == nullptr)
+        {
+            OSInterfaceLogError(getTAG(), AT "Failed to create mutex");
+            return;
+        }
     }
 
     this->internalStatus            = NOT_RUNNING;
@@ -56,9 +63,6 @@ N_USData_Indication_Runner::N_USData_Indication_Runner(bool& result, const N_AI
     this->messageOffset             = 0;
     this->cfReceivedInThisBlock     = 0;
 
-    this->timerN_Ar = new Timer_N(osInterface);
-    this->timerN_Br = new Timer_N(osInterface);
-    this->timerN_Cr = new Timer_N(osInterface);
 
     result = true;
 }
@@ -67,50 +71,182 @@ N_USData_Indication_Runner::N_USData_Indication_Runner(bool& result, const N_AI
 // the destructor may attempt a free on an invalid pointer.
 N_USData_Indication_Runner::~N_USData_Indication_Runner()
 {
-    OSInterfaceLogDebug(tag, "Deleting runner");
+    OSInterfaceLogDebug(getTAG(), "Deleting runner");
 
-    if (this->messageData != nullptr)
+    if (hasPayload())
     {
-        osInterface->osFree(this->messageData);
-        availableMemoryForRunners->add(messageLength * static_cast<int64_t>(sizeof(uint8_t)));
+        freePayload();
+        availableMemoryForRunners->add(getPayloadCharge());
     }
 
-    if (this->tag != nullptr)
+    if (this->quotaCharged)
     {
-        osInterface->osFree(this->tag);
-        availableMemoryForRunners->add(N_USDATA_INDICATION_RUNNER_TAG_SIZE);
+        peerQuotas->release(nAi.N_SA, getPayloadCharge());
     }
 
-    delete timerN_Ar;
-    delete timerN_Br;
-    delete timerN_Cr;
     delete mutex;
 }
 
-bool N_USData_Indication_Runner::awaitingFrame(const CANFrame& frame) const
+int64_t N_USData_Indication_Runner::getPayloadCharge() const
 {
-    FrameCode frameCode = static_cast<FrameCode>(frame.data[0] >> 4);
-    switch (internalStatus)
+    if (this->chunkPool != nullptr)
     {
-        case NOT_RUNNING:
-            return frameCode == SF_CODE || frameCode == FF_CODE;
-        case AWAITING_FC_ACK: // Uses AWAITING_CF
-            [[fallthrough]];
-        case AWAITING_CF:
-            return frameCode == CF_CODE;
-        default:
-            return false;
+        // Whole chunks, plus the segment that points to each of them.
+        return static_cast<int64_t>(this->chunkPool->getChunkCount(this->messageLength)) *
+               (this->chunkPool->getChunkSize() + sizeof(ISOTP_MessageSegment));
+    }
+    // The slab allocator takes whole blocks, so the memory for runners is charged with the size of the block.
+    return this->payloadAllocator != nullptr ? ISOTP_SlabAllocator::getBlockSize(this->messageLength)
+                                             : this->messageLength * static_cast<int64_t>(sizeof(uint8_t));
+}
+
+bool N_USData_Indication_Runner::hasPayload() const
+{
+    return this->messageData != nullptr || this->segments != nullptr;
+}
+
+bool N_USData_Indication_Runner::allocatePayload()
+{
+    if (this->chunkPool != nullptr)
+    {
+        // Only the table of segments is allocated here, the chunks are taken as the message is received.
+        const uint32_t chunkCount = this->chunkPool->getChunkCount(this->messageLength);
+        this->segments =
+            static_cast<ISOTP_MessageSegment*>(this->osInterface->osMalloc(chunkCount * sizeof(ISOTP_MessageSegment)));
+        return this->segments != nullptr;
+    }
+
+    if (this->payloadAllocator != nullptr)
+    {
+        this->messageData = static_cast<uint8_t*>(this->payloadAllocator->allocate(this->messageLength));
+    }
+    else
+    {
+        this->messageData = static_cast<uint8_t*>(this->osInterface->osMalloc(this->messageLength * sizeof(uint8_t)));
+    }
+    this->payloadSegment = {this->messageData, static_cast<uint32_t>(this->messageLength)};
+    return this->messageData != nullptr;
+}
+
+bool N_USData_Indication_Runner::appendPayload(const uint8_t* data, uint32_t length)
+{
+    if (this->chunkPool == nullptr)
+    {
+        memcpy(&this->messageData[this->messageOffset], data, length);
+        this->messageOffset += length;
+        return true;
     }
+
+    const uint32_t chunkSize = this->chunkPool->getChunkSize();
+    while (length > 0)
+    {
+        if (this->messageOffset % chunkSize == 0) // The current chunk is full, or there is none yet.
+        {
+            uint8_t* chunk = this->chunkPool->allocate();
+            if (chunk == nullptr)
+            {
+                return false;
+            }
+            this->segments[this->segmentCount++] = {chunk, 0};
+        }
+
+        ISOTP_MessageSegment& segment = this->segments[this->segmentCount - 1];
+        const uint32_t        bytes   = MIN(length, chunkSize - segment.length);
+        memcpy(&segment.data[segment.length], data, bytes);
+        segment.length += bytes;
+        this->messageOffset += bytes;
+        data += bytes;
+        length -= bytes;
+    }
+    return true;
+}
+
+void N_USData_Indication_Runner::freePayload()
+{
+    if (this->chunkPool != nullptr)
+    {
+        for (uint32_t i = 0; i < this->segmentCount; i++)
+        {
+            this->chunkPool->release(this->segments[i].data); // Ready for the next message.
+        }
+        this->osInterface->osFree(this->segments);
+        this->segments     = nullptr;
+        this->segmentCount = 0;
+        return;
+    }
+
+    if (this->payloadAllocator != nullptr)
+    {
+        this->payloadAllocator->release(this->messageData);
+    }
+    else
+    {
+        this->osInterface->osFree(this->messageData);
+    }
+    this->messageData    = nullptr;
+    this->payloadSegment = {};
+}
+
+bool N_USData_Indication_Runner::lock() const
+{
+    return this->mutex == nullptr || this->mutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
+}
+
+void N_USData_Indication_Runner::unlock() const
+{
+    if (this->mutex != nullptr)
+    {
+        this->mutex->signal();
+    }
+}
+
+const N_USData_Indication_Runner::State& N_USData_Indication_Runner::getState(const InternalStatus_t status)
+{
+    using R               = N_USData_Indication_Runner;
+    constexpr uint16_t SF = N_USData_frameCodeBit(SF_CODE);
+    constexpr uint16_t FF = N_USData_frameCodeBit(FF_CODE);
+    constexpr uint16_t CF = N_USData_frameCodeBit(CF_CODE);
+
+    // clang-format off
+    // AWAITING_FC_ACK also awaits the CFs of AWAITING_CF, they are held until the ACK arrives.
+    static constexpr State stateTable[] = {
+        // status          step                         ackReceived                 awaited runNow
+        {NOT_RUNNING,      &R::runStep_notRunning,      nullptr,                    SF | FF, true},
+        {SEND_FC,          &R::runStep_FC_CTS,          nullptr,                    0,       true},
+        {AWAITING_FC_ACK,  &R::runStep_holdFrame,       &R::FC_ACKReceivedCallback, CF,      false},
+        {AWAITING_CF,      &R::runStep_CF,              nullptr,                    CF,      false},
+        {MESSAGE_RECEIVED, &R::runStep_messageReceived, nullptr,                    0,       true},
+        {ERROR,            &R::runStep_error,           nullptr,                    0,       true},
+    };
+    // clang-format on
+
+    static_assert(std::size(stateTable) == ERROR + 1, "There must be one row per internal status");
+    static_assert(N_USData_isStateTableComplete(stateTable), "The rows must be in order, with a step and valid frames");
+
+    return stateTable[status];
+}
+
+bool N_USData_Indication_Runner::awaitingFrame(const CANFrame& frame) const
+{
+    const FrameCode frameCode = static_cast<FrameCode>(frame.data[0] >> 4);
+    return (getState(internalStatus).awaitedFrames & N_USData_frameCodeBit(frameCode)) != 0;
 }
 
 N_Result N_USData_Indication_Runner::runStep(CANFrame* receivedFrame)
 {
-    if (!mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    return runStep(receivedFrame, osInterface->osMillis());
+}
+
+N_Result N_USData_Indication_Runner::runStep(CANFrame* receivedFrame, const uint32_t now)
+{
+    if (!lock())
     {
         returnErrorWithLog(N_ERROR, "Failed to acquire mutex");
     }
 
-    OSInterfaceLogVerbose(tag, "Running step with internalStatus = %s (%" PRIu8 ") and frame %s",
+    stepTime = now;
+
+    OSInterfaceLogVerbose(getTAG(), "Running step with internalStatus = %s (%" PRIu8 ") and frame %s",
                           internalStatusToString(internalStatus), internalStatus,
                           receivedFrame != nullptr ? frameToString(*receivedFrame) : "null");
 
@@ -118,54 +254,31 @@ N_Result N_USData_Indication_Runner::runStep(CANFrame* receivedFrame)
 
     if (res != N_OK)
     {
-        mutex->signal();
+        unlock();
         return res;
     }
 
     res = runStep_internal(receivedFrame);
 
-    mutex->signal();
+    unlock();
     return res;
 }
 
 N_Result N_USData_Indication_Runner::runStep_internal(const CANFrame* receivedFrame)
 {
-    N_Result res;
-
-    switch (internalStatus)
-    {
-        case NOT_RUNNING:
-            res = runStep_notRunning(receivedFrame);
-            break;
-        case SEND_FC:
-            res = runStep_FC_CTS(receivedFrame);
-            break;
-        case AWAITING_CF:
-            res = runStep_CF(receivedFrame);
-            break;
-        case AWAITING_FC_ACK:
-            res = runStep_holdFrame(receivedFrame);
-            break;
-        case MESSAGE_RECEIVED:
-            OSInterfaceLogDebug(tag, "Message received successfully");
-            result = N_OK; // If the message is successfully received, return N_OK to allow ISOTP to call the callback.
-            res    = result;
-            break;
-        case ERROR:
-            res = result;
-            break;
-        default:
-            OSInterfaceLogError(tag, "Invalid internalStatus %s (%" PRIu8 ")", internalStatusToString(internalStatus),
-                                internalStatus);
-            result = N_ERROR;
-            updateInternalStatus(ERROR);
-            res = result;
-            break;
-    }
+    return (this->*getState(internalStatus).step)(receivedFrame);
+}
 
-    lastRunTime = osInterface->osMillis();
+N_Result N_USData_Indication_Runner::runStep_messageReceived(const CANFrame*)
+{
+    OSInterfaceLogDebug(getTAG(), "Message received successfully");
+    result = N_OK; // If the message is successfully received, return N_OK to allow ISOTP to call the callback.
+    return result;
+}
 
-    return res;
+N_Result N_USData_Indication_Runner::runStep_error(const CANFrame*)
+{
+    return result;
 }
 
 N_Result N_USData_Indication_Runner::runStep_holdFrame(const CANFrame* receivedFrame)
@@ -175,7 +288,7 @@ N_Result N_USData_Indication_Runner::runStep_holdFrame(const CANFrame* receivedF
         returnErrorWithLog(N_ERROR, "Received frame is null");
     }
 
-    OSInterfaceLogWarning(tag,
+    OSInterfaceLogWarning(getTAG(),
                           "Received frame while waiting for ACK in %s (%" PRIu8 "). Storing it for later use Frame: %s",
                           internalStatusToString(internalStatus), internalStatus, frameToString(*receivedFrame));
 
@@ -186,6 +299,10 @@ N_Result N_USData_Indication_Runner::runStep_holdFrame(const CANFrame* receivedF
 
     frameToHold      = *receivedFrame; // Store the frame for later use.
     frameToHoldValid = true;           // Mark the frame as valid.
+    if (statistics != nullptr)
+    {
+        statistics->onFrameHeld();
+    }
 
     result = IN_PROGRESS; // Indicate that we are still waiting for the ACK.
     return result;
@@ -198,6 +315,8 @@ N_Result N_USData_Indication_Runner::runStep_notRunning(const CANFrame* received
         returnErrorWithLog(N_ERROR, "Received frame is null");
     }
 
+    startTime = stepTime;
+
     if (receivedFrame->identifier.N_TAtype != N_TATYPE_5_CAN_CLASSIC_29bit_Physical &&
         receivedFrame->identifier.N_TAtype != N_TATYPE_6_CAN_CLASSIC_29bit_Functional)
     {
@@ -214,13 +333,19 @@ N_Result N_USData_Indication_Runner::runStep_notRunning(const CANFrame* received
             messageLength = receivedFrame->data[0] & 0b00001111;
 
             if (messageLength <= MAX_SF_MESSAGE_LENGTH &&
-                this->availableMemoryForRunners->subIfResIsGreaterThanZero(this->messageLength *
-                                                                           static_cast<int64_t>(sizeof(uint8_t))))
+                this->availableMemoryForRunners->subIfResIsGreaterThanZero(getPayloadCharge()))
             {
-                messageData = static_cast<uint8_t*>(osInterface->osMalloc(this->messageLength * sizeof(uint8_t)));
-                memcpy(messageData, &receivedFrame->data[1], messageLength);
+                if (!allocatePayload() || !appendPayload(&receivedFrame->data[1], messageLength))
+                {
+                    if (hasPayload())
+                    {
+                        freePayload();
+                    }
+                    availableMemoryForRunners->add(getPayloadCharge());
+                    returnErrorWithLog(N_ERROR, "Failed to allocate message length %" PRId64, messageLength);
+                }
 
-                OSInterfaceLogInfo(tag, "Received message with length %" PRId64 " (SF)", messageLength);
+                OSInterfaceLogInfo(getTAG(), "Received message with length %" PRId64 " (SF)", messageLength);
                 result = N_OK;
                 return result;
             }
@@ -233,7 +358,7 @@ N_Result N_USData_Indication_Runner::runStep_notRunning(const CANFrame* received
         }
         case FF_CODE:
         {
-            timerN_Br->startTimer();
+            timerN_Br.startTimer(stepTime);
             if (nAi.N_TAtype == N_TATYPE_6_CAN_CLASSIC_29bit_Functional)
             {
                 returnErrorWithLog(N_UNEXP_PDU, "Received FF frame with N_TAtype %s", N_TAtypeToString(nAi.N_TAtype));
@@ -256,34 +381,40 @@ N_Result N_USData_Indication_Runner::runStep_notRunning(const CANFrame* received
                 returnErrorWithLog(N_ERROR, "FF frame with length %" PRId64 " is too small", messageLength);
             }
 
-            OSInterfaceLogDebug(tag, "Received FF frame with full message length = %" PRId64, messageLength);
+            OSInterfaceLogDebug(getTAG(), "Received FF frame with full message length = %" PRId64, messageLength);
 
             int64_t availableMemory;
             availableMemoryForRunners->get(&availableMemory);
 
-            if (availableMemoryForRunners->subIfResIsGreaterThanZero(
-                    this->messageLength * static_cast<int64_t>(sizeof(uint8_t)))) // Check if there is enough memory
+            if (peerQuotas != nullptr &&
+                !peerQuotas->admit(nAi.N_SA, getPayloadCharge(), availableMemory, quotaCharged))
             {
-                this->messageData = static_cast<uint8_t*>(osInterface->osMalloc(messageLength * sizeof(uint8_t)));
+                sendFCFrame(OVERFLOW);
+                returnErrorWithLog(N_ERROR,
+                                   "Message length %" PRId64 " exceeds the quota of N_SA %" PRIu8
+                                   ". OVERFLOW FC frame sent",
+                                   messageLength, nAi.N_SA);
+            }
 
-                if (this->messageData == nullptr)
+            if (availableMemoryForRunners->subIfResIsGreaterThanZero(
+                    getPayloadCharge())) // Check if there is enough memory
+            {
+                // The FF carries 6 bytes of the message, or 2 if its length needs the escape sequence.
+                const bool     escapeSequence = messageLength >= MIN_FF_DL_WITH_ESCAPE_SEQUENCE;
+                const uint8_t* firstBytes     = &receivedFrame->data[escapeSequence ? 6 : 2];
+                if (!allocatePayload() || !appendPayload(firstBytes, escapeSequence ? 2 : 6))
                 {
+                    if (hasPayload())
+                    {
+                        freePayload();
+                    }
+                    availableMemoryForRunners->add(getPayloadCharge()); // Only allocated payloads are given back later.
+                    sendFCFrame(OVERFLOW);
                     returnErrorWithLog(N_ERROR,
                                        "Not enough memory for message length %" PRId64 ". Available memory is %" PRId64,
                                        messageLength, availableMemory);
                 }
 
-                if (messageLength < MIN_FF_DL_WITH_ESCAPE_SEQUENCE)
-                {
-                    memcpy(messageData, &receivedFrame->data[2], 6);
-                    messageOffset = 6;
-                }
-                else
-                {
-                    memcpy(messageData, &receivedFrame->data[6], 2);
-                    messageOffset = 2;
-                }
-
                 updateInternalStatus(SEND_FC);
                 result = IN_PROGRESS_FF;
                 return result;
@@ -308,17 +439,26 @@ N_Result N_USData_Indication_Runner::runStep_FC_CTS(const CANFrame* receivedFram
         returnErrorWithLog(N_ERROR, "Received frame is not null");
     }
 
-    timerN_Br->stopTimer();
-    OSInterfaceLogVerbose(tag, "Timer N_Br stopped before sending FC frame in %" PRIu32 " ms",
-                          timerN_Br->getElapsedTime_ms());
+    const bool measured = timerN_Br.isTimerRunning();
+    timerN_Br.stopTimer(stepTime);
+    OSInterfaceLogVerbose(getTAG(), "Timer N_Br stopped before sending FC frame in %" PRIu32 " ms",
+                          timerN_Br.getElapsedTime_ms(stepTime));
+    if (measured)
+    {
+        recordLatency(ISOTP_N_BrPhase, timerN_Br);
+        if (statistics != nullptr && timerN_Br.getElapsedTime_ms(stepTime) > N_Br_TIMEOUT_MS)
+        {
+            statistics->onN_BrPerformanceMiss();
+        }
+    }
 
     if (sendFCFrame(CONTINUE_TO_SEND) != N_OK)
     {
         returnErrorWithLog(N_ERROR, "Flow control frame could not be sent");
     }
 
-    timerN_Ar->startTimer();
-    OSInterfaceLogVerbose(tag, "Timer N_Ar started after sending FC frame");
+    timerN_Ar.startTimer(stepTime);
+    OSInterfaceLogVerbose(getTAG(), "Timer N_Ar started after sending FC frame");
 
     result = IN_PROGRESS;
     return result;
@@ -349,7 +489,11 @@ N_Result N_USData_Indication_Runner::runStep_CF(const CANFrame* receivedFrame)
                            messageSequenceNumber, sequenceNumber);
     }
 
-    sequenceNumber++;
+    sequenceNumber = (sequenceNumber + 1) & 0b00001111; // The SN wraps around to 0 after 15.
+    if (timerN_Cr.isTimerRunning())
+    {
+        recordLatency(ISOTP_N_CrPhase, timerN_Cr);
+    }
 
     if (receivedFrame->data_length_code <= 1)
     {
@@ -362,20 +506,23 @@ N_Result N_USData_Indication_Runner::runStep_CF(const CANFrame* receivedFrame)
             messageLength - messageOffset); // Copy the minimum between the remaining bytes and the received bytes (1st
                                             // byte is used to transport metadata).
 
-    memcpy(&messageData[messageOffset], &receivedFrame->data[1], bytesToCopy);
+    if (!appendPayload(&receivedFrame->data[1], bytesToCopy))
+    {
+        returnErrorWithLog(N_ERROR, "Failed to allocate a chunk at offset %" PRIu32 " of message length %" PRId64,
+                           messageOffset, messageLength);
+    }
 
-    messageOffset += bytesToCopy;
     cfReceivedInThisBlock++;
 
-    OSInterfaceLogDebug(tag, "Received CF #%" PRId16 " in block with %" PRIu8 " data bytes", cfReceivedInThisBlock,
+    OSInterfaceLogDebug(getTAG(), "Received CF #%" PRId16 " in block with %" PRIu8 " data bytes", cfReceivedInThisBlock,
                         bytesToCopy);
 
     if (messageOffset == messageLength)
     {
-        timerN_Cr->stopTimer();
-        OSInterfaceLogVerbose(tag, "Timer N_Cr stopped after receiving CF frame in %" PRIu32 " ms",
-                              timerN_Cr->getElapsedTime_ms());
-        OSInterfaceLogInfo(tag, "Received message with length %" PRId64 " (MF)", messageLength);
+        timerN_Cr.stopTimer(stepTime);
+        OSInterfaceLogVerbose(getTAG(), "Timer N_Cr stopped after receiving CF frame in %" PRIu32 " ms",
+                              timerN_Cr.getElapsedTime_ms(stepTime));
+        OSInterfaceLogInfo(getTAG(), "Received message with length %" PRId64 " (MF)", messageLength);
         result = N_OK;
         updateInternalStatus(MESSAGE_RECEIVED);
     }
@@ -383,21 +530,21 @@ N_Result N_USData_Indication_Runner::runStep_CF(const CANFrame* receivedFrame)
     {
         if (effectiveBlockSize == cfReceivedInThisBlock)
         {
-            timerN_Cr->stopTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_Cr stopped after receiving CF frame in %" PRIu32 " ms",
-                                  timerN_Cr->getElapsedTime_ms());
-            timerN_Br->startTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_Br started after receiving CF frame");
+            timerN_Cr.stopTimer(stepTime);
+            OSInterfaceLogVerbose(getTAG(), "Timer N_Cr stopped after receiving CF frame in %" PRIu32 " ms",
+                                  timerN_Cr.getElapsedTime_ms(stepTime));
+            timerN_Br.startTimer(stepTime);
+            OSInterfaceLogVerbose(getTAG(), "Timer N_Br started after receiving CF frame");
 
             cfReceivedInThisBlock = 0;
-            OSInterfaceLogDebug(tag, "CF block size reached.");
+            OSInterfaceLogDebug(getTAG(), "CF block size reached.");
 
             updateInternalStatus(SEND_FC);
         }
         else
         {
-            timerN_Cr->startTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_Cr started after receiving CF frame");
+            timerN_Cr.startTimer(stepTime);
+            OSInterfaceLogVerbose(getTAG(), "Timer N_Cr started after receiving CF frame");
         }
         result = IN_PROGRESS;
     }
@@ -428,154 +575,159 @@ N_Result N_USData_Indication_Runner::sendFCFrame(const FlowStatus fs)
 
     fcFrame.data_length_code = FC_MESSAGE_LENGTH;
 
-    OSInterfaceLogDebug(tag, "Sending FC frame with flow status %" PRIu8 ", block size %" PRIu8 " and STmin %s", fs,
-                        effectiveBlockSize, STminToString(stMin));
+    OSInterfaceLogDebug(getTAG(), "Sending FC frame with flow status %" PRIu8 ", block size %" PRIu8 " and STmin %s",
+                        fs, effectiveBlockSize, STminToString(stMin));
 
     if (CanMessageACKQueue->writeFrame(*this, fcFrame))
     {
+        if (fs == OVERFLOW && statistics != nullptr)
+        {
+            statistics->onOverflowFCSent();
+        }
         updateInternalStatus(AWAITING_FC_ACK);
         return N_OK;
     }
 
-    OSInterfaceLogError(tag, "FC frame could not be sent");
+    OSInterfaceLogError(getTAG(), "FC frame could not be sent");
     return N_ERROR;
 }
 
+void N_USData_Indication_Runner::recordLatency(const ISOTP_TimingPhase phase, const Timer_N& timer) const
+{
+    if (statistics != nullptr)
+    {
+        statistics->recordLatency(phase, nAi.N_SA, timer.getElapsedTime_ms(stepTime));
+    }
+}
+
 N_Result N_USData_Indication_Runner::checkTimeouts()
 {
-    uint32_t N_Br_performance = timerN_Br->getElapsedTime_ms() + timerN_Ar->getElapsedTime_ms();
+    uint32_t N_Br_performance = timerN_Br.getElapsedTime_ms(stepTime) + timerN_Ar.getElapsedTime_ms(stepTime);
     if (N_Br_performance > N_Br_TIMEOUT_MS)
     {
-        OSInterfaceLogWarning(tag,
+        OSInterfaceLogWarning(getTAG(),
                               "N_Br performance not met. Elapsed time is %" PRIu32 " ms and required is %" PRId32 " ms",
                               N_Br_performance, N_Br_TIMEOUT_MS);
     }
-    if (timerN_Ar->getElapsedTime_ms() > N_Ar_TIMEOUT_MS)
+    if (timerN_Ar.getElapsedTime_ms(stepTime) > N_Ar_TIMEOUT_MS)
     {
         returnErrorWithLog(N_TIMEOUT_A, "Elapsed time is %" PRIu32 " ms and timeout is %" PRId32 " ms",
-                           timerN_Ar->getElapsedTime_ms(), N_Ar_TIMEOUT_MS);
+                           timerN_Ar.getElapsedTime_ms(stepTime), N_Ar_TIMEOUT_MS);
     }
-    if (timerN_Cr->getElapsedTime_ms() > N_Cr_TIMEOUT_MS)
+    if (timerN_Cr.getElapsedTime_ms(stepTime) > N_Cr_TIMEOUT_MS)
     {
         returnErrorWithLog(N_TIMEOUT_Cr, "Elapsed time is %" PRIu32 " ms and timeout is %" PRId32 " ms",
-                           timerN_Cr->getElapsedTime_ms(), N_Cr_TIMEOUT_MS);
+                           timerN_Cr.getElapsedTime_ms(stepTime), N_Cr_TIMEOUT_MS);
     }
     return N_OK;
 }
 
 uint32_t N_USData_Indication_Runner::getNextTimeoutTime() const
 {
-    int32_t timeoutAr = timerN_Ar->isTimerRunning()
-                            ? (N_Ar_TIMEOUT_MS - static_cast<int32_t>(timerN_Ar->getElapsedTime_ms()))
-                            : MAX_TIMEOUT_MS;
-    int32_t timeoutCr = timerN_Cr->isTimerRunning()
-                            ? (N_Cr_TIMEOUT_MS - static_cast<int32_t>(timerN_Cr->getElapsedTime_ms()))
-                            : MAX_TIMEOUT_MS;
+    // The timers keep their start timestamp, so their deadlines do not need a new clock sample.
+    const uint32_t noTimeout  = stepTime + MAX_TIMEOUT_MS;
+    const uint32_t deadlineAr = timerN_Ar.isTimerRunning() ? timerN_Ar.getDeadline(N_Ar_TIMEOUT_MS) : noTimeout;
+    const uint32_t deadlineCr = timerN_Cr.isTimerRunning() ? timerN_Cr.getDeadline(N_Cr_TIMEOUT_MS) : noTimeout;
 
-    int32_t minTimeout = MIN(timeoutAr, timeoutCr);
+    const uint32_t nextTimeout = ISOTP_EarliestRunTime(deadlineAr, deadlineCr);
+    const int32_t  remaining   = static_cast<int32_t>(nextTimeout - stepTime);
 
-    if (minTimeout == timeoutAr)
+    if (nextTimeout == deadlineAr)
     {
-        OSInterfaceLogVerbose(tag, "Next timeout is N_Ar with %" PRId32 " ms remaining", minTimeout);
+        OSInterfaceLogVerbose(getTAG(), "Next timeout is N_Ar with %" PRId32 " ms remaining", remaining);
     }
-    else if (minTimeout == timeoutCr)
+    else if (nextTimeout == deadlineCr)
     {
-        OSInterfaceLogVerbose(tag, "Next timeout is N_Cr with %" PRId32 " ms remaining", minTimeout);
+        OSInterfaceLogVerbose(getTAG(), "Next timeout is N_Cr with %" PRId32 " ms remaining", remaining);
     }
 
-    OSInterfaceLogVerbose(tag, "Next timeout is in %" PRId32 " ms", minTimeout);
-    return minTimeout + osInterface->osMillis();
+    OSInterfaceLogVerbose(getTAG(), "Next timeout is in %" PRId32 " ms", remaining);
+    return nextTimeout;
 }
 
 uint32_t N_USData_Indication_Runner::getNextRunTime()
 {
-    if (!mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    if (!lock())
     {
-        OSInterfaceLogError(tag, "Failed to acquire mutex");
+        OSInterfaceLogError(getTAG(), "Failed to acquire mutex");
         result = N_ERROR;
         updateInternalStatus(ERROR);
         return 0;
     }
 
     uint32_t nextRunTime = getNextTimeoutTime();
-    switch (internalStatus)
+    if (getState(internalStatus).runNow)
     {
-        case ERROR:
-            [[fallthrough]];
-        case MESSAGE_RECEIVED:
-            [[fallthrough]];
-        case NOT_RUNNING:
-            [[fallthrough]];
-        case SEND_FC:
-            nextRunTime = 0; // Execute as soon as possible
-            OSInterfaceLogDebug(tag, "Next run time is NOW because internalStatus is %s (%" PRIu8 ")",
-                                internalStatusToString(internalStatus), internalStatus);
-            break;
-        default:
-            OSInterfaceLogDebug(tag, "Next run time is in %" PRId64 " ms because of next timeout",
-                                static_cast<int64_t>(nextRunTime) - osInterface->osMillis());
-            break;
+        nextRunTime = 0; // Execute as soon as possible
+        OSInterfaceLogDebug(getTAG(), "Next run time is NOW because internalStatus is %s (%" PRIu8 ")",
+                            internalStatusToString(internalStatus), internalStatus);
+    }
+    else
+    {
+        OSInterfaceLogDebug(getTAG(), "Next run time is in %" PRId64 " ms because of next timeout",
+                            static_cast<int64_t>(nextRunTime) - stepTime);
     }
 
-    mutex->signal();
+    unlock();
 
     return nextRunTime;
 }
 
 void N_USData_Indication_Runner::messageACKReceivedCallback(const ACKResult success)
 {
-    if (!mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    if (!lock())
     {
-        OSInterfaceLogError(tag, "Failed to acquire mutex");
+        OSInterfaceLogError(getTAG(), "Failed to acquire mutex");
         result = N_ERROR;
         updateInternalStatus(ERROR);
         return;
     }
 
-    OSInterfaceLogDebug(tag,
+    stepTime = osInterface->osMillis();
+
+    OSInterfaceLogDebug(getTAG(),
                         "Running messageACKReceivedCallback with internalStatus = %s (%" PRIu8 ") and success = %s",
                         internalStatusToString(internalStatus), internalStatus, ackResultToString(success));
 
-    switch (internalStatus)
+    if (const State& state = getState(internalStatus); state.ackReceived != nullptr)
     {
-        case AWAITING_FC_ACK:
-        {
-            OSInterfaceLogDebug(tag, "Received FC ACK");
-            FC_ACKReceivedCallback(success);
-        }
-        break;
-        default:
-            OSInterfaceLogError(tag, "Invalid internalStatus %s (%" PRIu8 ")", internalStatusToString(internalStatus),
-                                internalStatus);
-            result = N_ERROR;
-            updateInternalStatus(ERROR);
-            break;
+        (this->*state.ackReceived)(success);
+    }
+    else
+    {
+        OSInterfaceLogError(getTAG(), "Invalid internalStatus %s (%" PRIu8 ")", internalStatusToString(internalStatus),
+                            internalStatus);
+        result = N_ERROR;
+        updateInternalStatus(ERROR);
     }
 
-    mutex->signal();
+    unlock();
 }
 
 void N_USData_Indication_Runner::FC_ACKReceivedCallback(const ACKResult success)
 {
+    OSInterfaceLogDebug(getTAG(), "Received FC ACK");
+
     if (success == ACK_SUCCESS)
     {
-        timerN_Ar->stopTimer();
-        timerN_Br->clearTimer();
-        timerN_Cr->startTimer();
-        OSInterfaceLogDebug(tag, "FC ACK received");
+        timerN_Ar.stopTimer(stepTime);
+        recordLatency(ISOTP_N_ArPhase, timerN_Ar);
+        timerN_Br.clearTimer();
+        timerN_Cr.startTimer(stepTime);
+        OSInterfaceLogDebug(getTAG(), "FC ACK received");
 
         updateInternalStatus(AWAITING_CF);
 
         if (frameToHoldValid)
         {
-            OSInterfaceLogDebug(tag, "Processing held frame: %s", frameToString(frameToHold));
+            OSInterfaceLogDebug(getTAG(), "Processing held frame: %s", frameToString(frameToHold));
             frameToHoldValid = false; // Reset the held frame after processing.
             runStep_internal(&frameToHold);
         }
     }
     else
     {
-        OSInterfaceLogError(tag, "FC ACK failed with result %s", ackResultToString(success));
+        OSInterfaceLogError(getTAG(), "FC ACK failed with result %s", ackResultToString(success));
         result = N_ERROR;
         updateInternalStatus(ERROR);
     }
@@ -583,11 +735,11 @@ void N_USData_Indication_Runner::FC_ACKReceivedCallback(const ACKResult success)
 
 bool N_USData_Indication_Runner::setBlockSize(const uint8_t blockSize)
 {
-    if (mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    if (lock())
     {
         this->blockSize = blockSize;
-        mutex->signal();
-        OSInterfaceLogInfo(tag, "Block size set to %" PRIu8, blockSize);
+        unlock();
+        OSInterfaceLogInfo(getTAG(), "Block size set to %" PRIu8, blockSize);
         return true;
     }
     return false;
@@ -595,11 +747,11 @@ bool N_USData_Indication_Runner::setBlockSize(const uint8_t blockSize)
 
 bool N_USData_Indication_Runner::setSTmin(const STmin stMin)
 {
-    if (mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    if (lock())
     {
         this->stMin = stMin;
-        mutex->signal();
-        OSInterfaceLogInfo(tag, "STmin set to %s", STminToString(stMin));
+        unlock();
+        OSInterfaceLogInfo(getTAG(), "STmin set to %s", STminToString(stMin));
         return true;
     }
     return false;
@@ -620,6 +772,15 @@ uint32_t N_USData_Indication_Runner::getMessageLength() const
     return messageLength;
 }
 
+ISOTP_MessageView N_USData_Indication_Runner::getMessageView() const
+{
+    if (this->chunkPool != nullptr)
+    {
+        return {this->segments, this->segmentCount, this->messageOffset};
+    }
+    return {&this->payloadSegment, this->messageData != nullptr ? 1u : 0u, this->payloadSegment.length};
+}
+
 N_Result N_USData_Indication_Runner::getResult() const
 {
     return result;
@@ -630,6 +791,27 @@ Mtype N_USData_Indication_Runner::getMtype() const
     return mType;
 }
 
+uint32_t N_USData_Indication_Runner::getStartTime() const
+{
+    return startTime;
+}
+
+void N_USData_Indication_Runner::getSessionInfo(ISOTP_SessionInfo& info, const uint32_t now) const
+{
+    info.nAi              = nAi;
+    info.direction        = RunnerIndicationType;
+    info.internalStatus   = internalStatusToString(internalStatus);
+    info.bytesTransferred = messageOffset;
+    info.messageLength    = messageLength;
+    info.blockSize        = blockSize;
+    info.stMin            = stMin;
+    info.armedTimer       = ISOTP_TimingPhaseCount;
+    info.remainingTime_ms = 0;
+    info.armTimer(ISOTP_N_ArPhase, timerN_Ar, N_Ar_TIMEOUT_MS, now);
+    info.armTimer(ISOTP_N_BrPhase, timerN_Br, N_Br_TIMEOUT_MS, now);
+    info.armTimer(ISOTP_N_CrPhase, timerN_Cr, N_Cr_TIMEOUT_MS, now);
+}
+
 N_USData_Indication_Runner::RunnerType N_USData_Indication_Runner::getRunnerType() const
 {
     return RunnerIndicationType;
@@ -637,7 +819,7 @@ N_USData_Indication_Runner::RunnerType N_USData_Indication_Runner::getRunnerType
 
 const char* N_USData_Indication_Runner::getTAG() const
 {
-    return this->tag;
+    return this->tag.get();
 }
 
 bool N_USData_Indication_Runner::isThisFrameForMe(const CANFrame& frame) const
@@ -645,7 +827,7 @@ bool N_USData_Indication_Runner::isThisFrameForMe(const CANFrame& frame) const
     bool res = getN_AI().N_AI == frame.identifier.N_AI;
     res &= awaitingFrame(frame);
 
-    OSInterfaceLogDebug(tag, "isThisFrameForMe() = %s for frame %s", res ? "true" : "false", frameToString(frame));
+    OSInterfaceLogDebug(getTAG(), "isThisFrameForMe() = %s for frame %s", res ? "true" : "false", frameToString(frame));
     return res;
 }
 
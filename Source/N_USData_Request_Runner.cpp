@@ -1,50 +1,47 @@
 #include "N_USData_Request_Runner.h"
 #include <cassert>
 #include <cstring>
+#include <iterator>
 
 #include "Atomic_int64_t.h"
 #include "CANMessageACKQueue.h"
+#include "ISOTP_InstrumentedMutex.h"
 
 N_USData_Request_Runner::N_USData_Request_Runner(bool& result, const N_AI nAi,
                                                  Atomic_int64_t& availableMemoryForRunners, const Mtype mType,
                                                  const uint8_t* messageData, const uint32_t messageLength,
-                                                 OSInterface& osInterface, CANMessageACKQueue& canMessageACKQueue)
+                                                 OSInterface& osInterface, CANMessageACKQueue& canMessageACKQueue,
+                                                 const ThreadingPolicy threadingPolicy,
+                                                 ISOTP_SlabAllocator* payloadAllocator, ISOTP_Statistics* statistics) :
+    tag(N_USDATA_REQUEST_RUNNER_STATIC_TAG, nAi), timerN_As(osInterface), timerN_Bs(osInterface), timerN_Cs(osInterface)
 {
     result = false;
 
     this->availableMemoryForRunners = &availableMemoryForRunners;
+    this->payloadAllocator          = payloadAllocator;
+    this->statistics                = statistics;
     this->osInterface               = &osInterface;
 
-    if (this->availableMemoryForRunners->subIfResIsGreaterThanZero(N_USDATA_REQUEST_RUNNER_TAG_SIZE))
-    {
-        this->tag = static_cast<char*>(this->osInterface->osMalloc(N_USDATA_REQUEST_RUNNER_TAG_SIZE));
-        if (this->tag == nullptr)
-        {
-            return;
-        }
-        snprintf(this->tag, N_USDATA_REQUEST_RUNNER_TAG_SIZE, "%s%s", N_USDATA_REQUEST_RUNNER_STATIC_TAG,
-                 nAiToString(nAi));
-    }
-    else
-    {
-        return;
-    }
-
-    OSInterfaceLogDebug(tag, "Creating N_USData_Request_Runner with tag %s", this->tag);
+    OSInterfaceLogDebug(getTAG(), "Creating N_USData_Request_Runner with tag %s", getTAG());
 
     this->nAi                = nAi;
     this->mType              = Mtype_Unknown;
     this->CanMessageACKQueue = &canMessageACKQueue;
     this->blockSize          = 0;
     this->stMin              = DEFAULT_STMIN;
-    this->lastRunTime        = 0;
+    this->stepTime           = 0;
+    this->startTime          = osInterface.osMillis();
     this->sequenceNumber = 1; // The first sequence number that is being sent is 1. (0 is reserved for the first frame)
 
-    this->mutex = osInterface.osCreateMutex();
-    if (this->mutex == nullptr)
+    if (threadingPolicy == ThreadSafeRunner)
     {
-        OSInterfaceLogError(tag, AT "Failed to create mutex");
-        return;
+        this->mutex =
+            ISOTP_InstrumentedMutex::wrap(osInterface.osCreateMutex(), ISOTP_RunnerLock, osInterface, statistics);
+        if (this->mutex == nullptr)
+        {
+            OSInterfaceLogError(getTAG(), AT "Failed to create mutex");
+            return;
+        }
     }
 
     this->internalStatus            = ERROR;
@@ -55,29 +52,23 @@ N_USData_Request_Runner::N_USData_Request_Runner(bool& result, const N_AI nAi,
     this->availableMemoryForRunners = &availableMemoryForRunners;
     this->cfSentInThisBlock         = 0;
 
-    this->timerN_As = new Timer_N(osInterface);
-    this->timerN_Bs = new Timer_N(osInterface);
-    this->timerN_Cs = new Timer_N(osInterface);
 
-    if (this->availableMemoryForRunners->subIfResIsGreaterThanZero(this->messageLength *
-                                                                   static_cast<int64_t>(sizeof(uint8_t))) &&
-        messageData != nullptr)
+    if (messageData != nullptr && this->availableMemoryForRunners->subIfResIsGreaterThanZero(getPayloadCharge()))
     {
-        this->messageData = static_cast<uint8_t*>(osInterface.osMalloc(this->messageLength * sizeof(uint8_t)));
+        this->messageData = allocatePayload(this->messageLength > 0 ? this->messageLength * sizeof(uint8_t) : 1);
 
-        if (this->messageLength == 0)
+        if (this->messageLength == 0 && this->messageData != nullptr)
         {
-            this->messageData = static_cast<uint8_t*>(osInterface.osMalloc(1 * sizeof(uint8_t)));
-            if (this->messageData != nullptr)
-            {
-                this->messageData[0] = '\0';
-            }
+            this->messageData[0] = '\0';
         }
         if (this->messageData == nullptr)
         {
+            availableMemoryForRunners.add(getPayloadCharge()); // The destructor only gives back allocated payloads.
+
             int64_t availableMemory;
             availableMemoryForRunners.get(&availableMemory);
-            OSInterfaceLogError(tag, "Not enough memory for message length %" PRIu32 ". Available memory is %" PRId64,
+            OSInterfaceLogError(getTAG(),
+                                "Not enough memory for message length %" PRIu32 ". Available memory is %" PRId64,
                                 messageLength, availableMemory);
         }
         else
@@ -88,7 +79,7 @@ N_USData_Request_Runner::N_USData_Request_Runner(bool& result, const N_AI nAi,
             if (this->nAi.N_TAtype == N_TATYPE_6_CAN_CLASSIC_29bit_Functional &&
                 this->messageLength > MAX_SF_MESSAGE_LENGTH)
             {
-                OSInterfaceLogError(tag, "Message length %" PRIu32 " is too long for N_TAtype %s", messageLength,
+                OSInterfaceLogError(getTAG(), "Message length %" PRIu32 " is too long for N_TAtype %s", messageLength,
                                     N_TAtypeToString(this->nAi.N_TAtype));
             }
             else
@@ -97,12 +88,12 @@ N_USData_Request_Runner::N_USData_Request_Runner(bool& result, const N_AI nAi,
 
                 if (messageLength <= MAX_SF_MESSAGE_LENGTH)
                 {
-                    OSInterfaceLogDebug(tag, "Message type is Single Frame");
+                    OSInterfaceLogDebug(getTAG(), "Message type is Single Frame");
                     internalStatus = NOT_RUNNING_SF;
                 }
                 else
                 {
-                    OSInterfaceLogDebug(tag, "Message type is Multiple Frame");
+                    OSInterfaceLogDebug(getTAG(), "Message type is Multiple Frame");
                     internalStatus = NOT_RUNNING_FF;
                 }
 
@@ -114,7 +105,7 @@ N_USData_Request_Runner::N_USData_Request_Runner(bool& result, const N_AI nAi,
     {
         int64_t availableMemory;
         availableMemoryForRunners.get(&availableMemory);
-        OSInterfaceLogError(tag, "Not enough memory for message length %" PRIu32 ". Available memory is %" PRId64,
+        OSInterfaceLogError(getTAG(), "Not enough memory for message length %" PRIu32 ". Available memory is %" PRId64,
                             messageLength, availableMemory);
     }
 }
@@ -123,24 +114,57 @@ N_USData_Request_Runner::N_USData_Request_Runner(bool& result, const N_AI nAi,
 // the destructor may attempt a free on an invalid pointer.
 N_USData_Request_Runner::~N_USData_Request_Runner()
 {
-    OSInterfaceLogDebug(tag, "Deleting runner");
+    OSInterfaceLogDebug(getTAG(), "Deleting runner");
 
     if (this->messageData != nullptr)
     {
-        osInterface->osFree(this->messageData);
-        availableMemoryForRunners->add(messageLength * static_cast<int64_t>(sizeof(uint8_t)));
+        freePayload();
+        availableMemoryForRunners->add(getPayloadCharge());
     }
 
-    if (this->tag != nullptr)
+    delete mutex;
+}
+
+int64_t N_USData_Request_Runner::getPayloadCharge() const
+{
+    // The slab allocator takes whole blocks, so the memory for runners is charged with the size of the block.
+    return this->payloadAllocator != nullptr ? ISOTP_SlabAllocator::getBlockSize(this->messageLength)
+                                             : this->messageLength * static_cast<int64_t>(sizeof(uint8_t));
+}
+
+uint8_t* N_USData_Request_Runner::allocatePayload(const uint32_t size)
+{
+    if (this->payloadAllocator != nullptr)
     {
-        osInterface->osFree(this->tag);
-        availableMemoryForRunners->add(N_USDATA_REQUEST_RUNNER_TAG_SIZE);
+        return static_cast<uint8_t*>(this->payloadAllocator->allocate(size));
     }
+    return static_cast<uint8_t*>(this->osInterface->osMalloc(size));
+}
 
-    delete timerN_As;
-    delete timerN_Bs;
-    delete timerN_Cs;
-    delete mutex;
+void N_USData_Request_Runner::freePayload()
+{
+    if (this->payloadAllocator != nullptr)
+    {
+        this->payloadAllocator->release(this->messageData);
+    }
+    else
+    {
+        this->osInterface->osFree(this->messageData);
+    }
+    this->messageData = nullptr;
+}
+
+bool N_USData_Request_Runner::lock() const
+{
+    return this->mutex == nullptr || this->mutex->wait(ISOTP_MaxTimeToWaitForSync_MS);
+}
+
+void N_USData_Request_Runner::unlock() const
+{
+    if (this->mutex != nullptr)
+    {
+        this->mutex->signal();
+    }
 }
 
 N_Result N_USData_Request_Runner::sendCFFrame()
@@ -157,74 +181,97 @@ N_Result N_USData_Request_Runner::sendCFFrame()
 
     cfFrame.data_length_code = frameDataLength + 1; // 1 byte for N_PCI_SF
 
-    OSInterfaceLogDebug(tag, "Sending CF #%" PRId16 " in block with %" PRIu8 " data bytes", cfSentInThisBlock + 1,
+    OSInterfaceLogDebug(getTAG(), "Sending CF #%" PRId16 " in block with %" PRIu8 " data bytes", cfSentInThisBlock + 1,
                         frameDataLength);
 
     if (CanMessageACKQueue->writeFrame(*this, cfFrame))
     {
         cfSentInThisBlock++;
         sequenceNumber++;
-        timerN_As->startTimer();
-        OSInterfaceLogVerbose(tag, "Timer N_As started after sending CF");
+        timerN_As.startTimer(stepTime);
+        OSInterfaceLogVerbose(getTAG(), "Timer N_As started after sending CF");
 
         updateInternalStatus(AWAITING_CF_ACK);
         result = IN_PROGRESS;
         return result;
     }
 
-    OSInterfaceLogError(tag, "CF frame could not be sent");
+    OSInterfaceLogError(getTAG(), "CF frame could not be sent");
     result = N_ERROR;
     return result;
 }
 
 N_Result N_USData_Request_Runner::checkTimeouts()
 {
-    uint32_t N_Cs_performance = timerN_Cs->getElapsedTime_ms() + timerN_As->getElapsedTime_ms();
+    uint32_t N_Cs_performance = timerN_Cs.getElapsedTime_ms(stepTime) + timerN_As.getElapsedTime_ms(stepTime);
     if (N_Cs_performance > N_Cs_TIMEOUT_MS)
     {
-        OSInterfaceLogWarning(tag,
+        OSInterfaceLogWarning(getTAG(),
                               "N_Cs performance not met. Elapsed time is %" PRIu32 " ms and required is %" PRId32 " ms",
                               N_Cs_performance, N_Cs_TIMEOUT_MS);
     }
-    if (timerN_As->getElapsedTime_ms() > N_As_TIMEOUT_MS)
+    if (timerN_As.getElapsedTime_ms(stepTime) > N_As_TIMEOUT_MS)
     {
         returnErrorWithLog(N_TIMEOUT_A, "Elapsed time is %" PRIu32 " ms and timeout is %" PRId32 " ms",
-                           timerN_As->getElapsedTime_ms(), N_As_TIMEOUT_MS);
+                           timerN_As.getElapsedTime_ms(stepTime), N_As_TIMEOUT_MS);
     }
-    if (timerN_Bs->getElapsedTime_ms() > N_Bs_TIMEOUT_MS)
+    if (timerN_Bs.getElapsedTime_ms(stepTime) > N_Bs_TIMEOUT_MS)
     {
         returnErrorWithLog(N_TIMEOUT_Bs, "Elapsed time is %" PRIu32 " ms and timeout is %" PRId32 " ms",
-                           timerN_Bs->getElapsedTime_ms(), N_Bs_TIMEOUT_MS);
+                           timerN_Bs.getElapsedTime_ms(stepTime), N_Bs_TIMEOUT_MS);
     }
     return N_OK;
 }
 
+const N_USData_Request_Runner::State& N_USData_Request_Runner::getState(const InternalStatus_t status)
+{
+    using R               = N_USData_Request_Runner;
+    constexpr uint16_t FC = N_USData_frameCodeBit(FC_CODE);
+
+    // clang-format off
+    // The ACK states also await the FC of the state they lead to, it is held until the ACK arrives.
+    static constexpr State stateTable[] = {
+        // status          step                       ackReceived                 awaited runNow
+        {NOT_RUNNING_SF,   &R::runStep_SF,            nullptr,                    0,      true},
+        {AWAITING_SF_ACK,  &R::runStep_invalidStatus, &R::SF_ACKReceivedCallback, 0,      false},
+        {NOT_RUNNING_FF,   &R::runStep_FF,            nullptr,                    0,      true},
+        {AWAITING_FF_ACK,  &R::runStep_holdFrame,     &R::FF_ACKReceivedCallback, FC,     false},
+        {AWAITING_FirstFC, &R::runStep_firstFC,       nullptr,                    FC,     false},
+        {AWAITING_FC,      &R::runStep_nextFC,        nullptr,                    FC,     false},
+        {SEND_CF,          &R::runStep_CF,            nullptr,                    0,      false},
+        {AWAITING_CF_ACK,  &R::runStep_holdFrame,     &R::CF_ACKReceivedCallback, FC,     false},
+        {MESSAGE_SENT,     &R::runStep_messageSent,   nullptr,                    0,      true},
+        {ERROR,            &R::runStep_error,         nullptr,                    0,      true},
+    };
+    // clang-format on
+
+    static_assert(std::size(stateTable) == ERROR + 1, "There must be one row per internal status");
+    static_assert(N_USData_isStateTableComplete(stateTable), "The rows must be in order, with a step and valid frames");
+
+    return stateTable[status];
+}
+
 bool N_USData_Request_Runner::awaitingFrame(const CANFrame& frame) const
 {
-    FrameCode frameCode = static_cast<FrameCode>(frame.data[0] >> 4);
-    switch (internalStatus)
-    {
-        case AWAITING_FF_ACK: // Uses AWAITING_FirstFC.
-            [[fallthrough]];
-        case AWAITING_CF_ACK: // Uses AWAITING_FC.
-            [[fallthrough]];
-        case AWAITING_FirstFC:
-            [[fallthrough]];
-        case AWAITING_FC:
-            return frameCode == FC_CODE;
-        default:
-            return false;
-    }
+    const FrameCode frameCode = static_cast<FrameCode>(frame.data[0] >> 4);
+    return (getState(internalStatus).awaitedFrames & N_USData_frameCodeBit(frameCode)) != 0;
 }
 
 N_Result N_USData_Request_Runner::runStep(CANFrame* receivedFrame)
 {
-    if (!mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    return runStep(receivedFrame, osInterface->osMillis());
+}
+
+N_Result N_USData_Request_Runner::runStep(CANFrame* receivedFrame, const uint32_t now)
+{
+    if (!lock())
     {
         returnErrorWithLog(N_ERROR, "Failed to acquire mutex");
     }
 
-    OSInterfaceLogVerbose(tag, "Running step with internalStatus = %s (%" PRIu8 ") and frame %s",
+    stepTime = now;
+
+    OSInterfaceLogVerbose(getTAG(), "Running step with internalStatus = %s (%" PRIu8 ") and frame %s",
                           internalStatusToString(internalStatus), internalStatus,
                           receivedFrame != nullptr ? frameToString(*receivedFrame) : "null");
 
@@ -232,63 +279,41 @@ N_Result N_USData_Request_Runner::runStep(CANFrame* receivedFrame)
 
     if (res != N_OK)
     {
-        mutex->signal();
-        OSInterfaceLogError(tag, "Timeout occurred: %s", N_ResultToString(res));
+        unlock();
+        OSInterfaceLogError(getTAG(), "Timeout occurred: %s", N_ResultToString(res));
         return res;
     }
 
     res = runStep_internal(receivedFrame);
 
-    mutex->signal();
+    unlock();
     return res;
 }
 
 N_Result N_USData_Request_Runner::runStep_internal(const CANFrame* receivedFrame)
 {
-    N_Result res;
+    return (this->*getState(internalStatus).step)(receivedFrame);
+}
 
-    switch (internalStatus)
-    {
-        case NOT_RUNNING_SF:
-            res = runStep_SF(receivedFrame);
-            break;
-        case NOT_RUNNING_FF:
-            res = runStep_FF(receivedFrame);
-            break;
-        case AWAITING_FirstFC:                     // We got the message or timeout.
-            res = runStep_FC(receivedFrame, true); // First FC
-            break;
-        case SEND_CF:
-            res = runStep_CF(receivedFrame);
-            break;
-        case AWAITING_FC:
-            res = runStep_FC(receivedFrame);
-            break;
-        case MESSAGE_SENT:
-            OSInterfaceLogDebug(tag, "Message sent successfully");
-            result = N_OK; // If the message is successfully sent, return N_OK to allow ISOTP to call the callback.
-            res    = result;
-            break;
-        case AWAITING_FF_ACK:
-            [[fallthrough]];
-        case AWAITING_CF_ACK:
-            res = runStep_holdFrame(receivedFrame); // Hold the frame for later processing.
-            break;
-        case ERROR:
-            res = result;
-            break;
-        default:
-            OSInterfaceLogError(tag, "Invalid internalStatus %s (%" PRIu8 ")", internalStatusToString(internalStatus),
-                                internalStatus);
-            result = N_ERROR;
-            updateInternalStatus(ERROR);
-            res = result;
-            break;
-    }
+N_Result N_USData_Request_Runner::runStep_messageSent(const CANFrame*)
+{
+    OSInterfaceLogDebug(getTAG(), "Message sent successfully");
+    result = N_OK; // If the message is successfully sent, return N_OK to allow ISOTP to call the callback.
+    return result;
+}
 
-    lastRunTime = osInterface->osMillis();
+N_Result N_USData_Request_Runner::runStep_error(const CANFrame*)
+{
+    return result;
+}
 
-    return res;
+N_Result N_USData_Request_Runner::runStep_invalidStatus(const CANFrame*)
+{
+    OSInterfaceLogError(getTAG(), "Invalid internalStatus %s (%" PRIu8 ")", internalStatusToString(internalStatus),
+                        internalStatus);
+    result = N_ERROR;
+    updateInternalStatus(ERROR);
+    return result;
 }
 
 N_Result N_USData_Request_Runner::runStep_holdFrame(const CANFrame* receivedFrame)
@@ -298,7 +323,7 @@ N_Result N_USData_Request_Runner::runStep_holdFrame(const CANFrame* receivedFram
         returnErrorWithLog(N_ERROR, "Received frame is null");
     }
 
-    OSInterfaceLogWarning(tag,
+    OSInterfaceLogWarning(getTAG(),
                           "Received frame while waiting for ACK in %s (%" PRIu8 "). Storing it for later use Frame: %s",
                           internalStatusToString(internalStatus), internalStatus, frameToString(*receivedFrame));
 
@@ -309,6 +334,10 @@ N_Result N_USData_Request_Runner::runStep_holdFrame(const CANFrame* receivedFram
 
     frameToHold      = *receivedFrame; // Store the frame for later use.
     frameToHoldValid = true;           // Mark the frame as valid.
+    if (statistics != nullptr)
+    {
+        statistics->onFrameHeld();
+    }
 
     result = IN_PROGRESS; // Indicate that we are still waiting for the ACK.
     return result;
@@ -316,9 +345,18 @@ N_Result N_USData_Request_Runner::runStep_holdFrame(const CANFrame* receivedFram
 
 N_Result N_USData_Request_Runner::runStep_CF(const CANFrame* receivedFrame)
 {
-    timerN_Cs->stopTimer();
-    OSInterfaceLogVerbose(tag, "Timer N_Cs stopped before sending CF in %" PRIu32 " ms",
-                          timerN_Cs->getElapsedTime_ms());
+    const bool measured = timerN_Cs.isTimerRunning();
+    timerN_Cs.stopTimer(stepTime);
+    OSInterfaceLogVerbose(getTAG(), "Timer N_Cs stopped before sending CF in %" PRIu32 " ms",
+                          timerN_Cs.getElapsedTime_ms(stepTime));
+    if (measured)
+    {
+        recordLatency(ISOTP_N_CsPhase, timerN_Cs);
+        if (statistics != nullptr && timerN_Cs.getElapsedTime_ms(stepTime) > N_Cs_TIMEOUT_MS)
+        {
+            statistics->onN_CsPerformanceMiss();
+        }
+    }
     if (receivedFrame != nullptr)
     {
         returnErrorWithLog(N_ERROR, "Received frame is not null");
@@ -362,14 +400,14 @@ N_Result N_USData_Request_Runner::runStep_FF(const CANFrame* receivedFrame)
         messageOffset = 2;
     }
 
-    OSInterfaceLogDebug(tag, "Sending FF frame with data length %" PRIu32, messageOffset);
+    OSInterfaceLogDebug(getTAG(), "Sending FF frame with data length %" PRIu32, messageOffset);
 
     ffFrame.data_length_code = CAN_FRAME_MAX_DLC;
 
     if (CanMessageACKQueue->writeFrame(*this, ffFrame))
     {
-        timerN_As->startTimer();
-        OSInterfaceLogVerbose(tag, "Timer N_As started after sending FF frame");
+        timerN_As.startTimer(stepTime);
+        OSInterfaceLogVerbose(getTAG(), "Timer N_As started after sending FF frame");
 
         updateInternalStatus(AWAITING_FF_ACK);
         result = IN_PROGRESS;
@@ -386,8 +424,8 @@ N_Result N_USData_Request_Runner::runStep_SF(const CANFrame* receivedFrame)
         returnErrorWithLog(N_ERROR, "received frame is not null");
     }
 
-    timerN_As->startTimer();
-    OSInterfaceLogVerbose(tag, "Timer N_As started before sending SF frame");
+    timerN_As.startTimer(stepTime);
+    OSInterfaceLogVerbose(getTAG(), "Timer N_As started before sending SF frame");
 
     CANFrame sfFrame   = NewCANFrameISOTP();
     sfFrame.identifier = nAi;
@@ -399,16 +437,26 @@ N_Result N_USData_Request_Runner::runStep_SF(const CANFrame* receivedFrame)
 
     if (CanMessageACKQueue->writeFrame(*this, sfFrame))
     {
-        OSInterfaceLogDebug(tag, "Sending SF frame with data length %" PRId64, messageLength);
+        OSInterfaceLogDebug(getTAG(), "Sending SF frame with data length %" PRId64, messageLength);
         updateInternalStatus(AWAITING_SF_ACK);
         result = IN_PROGRESS;
         return result;
     }
-    OSInterfaceLogError(tag, "SF frame could not be sent");
+    OSInterfaceLogError(getTAG(), "SF frame could not be sent");
     result = N_ERROR;
     return result;
 }
 
+N_Result N_USData_Request_Runner::runStep_firstFC(const CANFrame* receivedFrame)
+{
+    return runStep_FC(receivedFrame, true);
+}
+
+N_Result N_USData_Request_Runner::runStep_nextFC(const CANFrame* receivedFrame)
+{
+    return runStep_FC(receivedFrame, false);
+}
+
 N_Result N_USData_Request_Runner::runStep_FC(const CANFrame* receivedFrame, const bool firstFC)
 {
     FlowStatus fs;
@@ -418,21 +466,25 @@ N_Result N_USData_Request_Runner::runStep_FC(const CANFrame* receivedFrame, cons
     {
         return result; // All the other error parameters are already set.
     }
+    if (timerN_Bs.isTimerRunning())
+    {
+        recordLatency(ISOTP_N_BsPhase, timerN_Bs);
+    }
 
     switch (fs)
     {
         case CONTINUE_TO_SEND:
         {
-            OSInterfaceLogDebug(tag, "Received FC frame with flow status CONTINUE_TO_SEND");
+            OSInterfaceLogDebug(getTAG(), "Received FC frame with flow status CONTINUE_TO_SEND");
             blockSize         = bs;
             cfSentInThisBlock = 0;
             stMin             = stM;
 
-            timerN_Bs->stopTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_Bs stopped after receiving FC frame in %" PRIu32 " ms",
-                                  timerN_Bs->getElapsedTime_ms());
-            timerN_Cs->startTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_Cs started after receiving FC frame");
+            timerN_Bs.stopTimer(stepTime);
+            OSInterfaceLogVerbose(getTAG(), "Timer N_Bs stopped after receiving FC frame in %" PRIu32 " ms",
+                                  timerN_Bs.getElapsedTime_ms(stepTime));
+            timerN_Cs.startTimer(stepTime);
+            OSInterfaceLogVerbose(getTAG(), "Timer N_Cs started after receiving FC frame");
 
             result = IN_PROGRESS;
             updateInternalStatus(SEND_CF);
@@ -440,16 +492,16 @@ N_Result N_USData_Request_Runner::runStep_FC(const CANFrame* receivedFrame, cons
         }
         case WAIT:
         {
-            OSInterfaceLogDebug(tag, "Received FC frame with flow status WAIT");
+            OSInterfaceLogDebug(getTAG(), "Received FC frame with flow status WAIT");
             // Restart N_Bs timer
-            timerN_Bs->startTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_Bs started after receiving FC frame");
+            timerN_Bs.startTimer(stepTime);
+            OSInterfaceLogVerbose(getTAG(), "Timer N_Bs started after receiving FC frame");
             updateInternalStatus(AWAITING_FC);
             result = IN_PROGRESS;
             return result;
         }
         case OVERFLOW:
-            OSInterfaceLogDebug(tag, "Received FC frame with flow status OVERFLOW");
+            OSInterfaceLogDebug(getTAG(), "Received FC frame with flow status OVERFLOW");
             if (firstFC)
             {
                 returnError(N_BUFFER_OVFLW);
@@ -463,129 +515,107 @@ N_Result N_USData_Request_Runner::runStep_FC(const CANFrame* receivedFrame, cons
 
 uint32_t N_USData_Request_Runner::getNextTimeoutTime() const
 {
-    int32_t timeoutAs = timerN_As->isTimerRunning()
-                            ? (N_As_TIMEOUT_MS - static_cast<int32_t>(timerN_As->getElapsedTime_ms()))
-                            : MAX_TIMEOUT_MS;
-    int32_t timeoutBs = timerN_Bs->isTimerRunning()
-                            ? (N_Bs_TIMEOUT_MS - static_cast<int32_t>(timerN_Bs->getElapsedTime_ms()))
-                            : MAX_TIMEOUT_MS;
-    int32_t timeoutCs =
-        timerN_Cs->isTimerRunning()
-            ? (static_cast<int32_t>(getStMinInMs(stMin)) - static_cast<int32_t>(timerN_Cs->getElapsedTime_ms()))
-            : MAX_TIMEOUT_MS;
+    // The timers keep their start timestamp, so their deadlines do not need a new clock sample.
+    const uint32_t noTimeout  = stepTime + MAX_TIMEOUT_MS;
+    const uint32_t deadlineAs = timerN_As.isTimerRunning() ? timerN_As.getDeadline(N_As_TIMEOUT_MS) : noTimeout;
+    const uint32_t deadlineBs = timerN_Bs.isTimerRunning() ? timerN_Bs.getDeadline(N_Bs_TIMEOUT_MS) : noTimeout;
+    const uint32_t deadlineCs = timerN_Cs.isTimerRunning() ? timerN_Cs.getDeadline(getStMinInMs(stMin)) : noTimeout;
 
-    int32_t minTimeoutAsBs = MIN(timeoutAs, timeoutBs);
-    int32_t minTimeout     = MIN(minTimeoutAsBs, timeoutCs);
+    const uint32_t nextTimeoutAsBs = ISOTP_EarliestRunTime(deadlineAs, deadlineBs);
+    const uint32_t nextTimeout     = ISOTP_EarliestRunTime(nextTimeoutAsBs, deadlineCs);
+    const int32_t  remaining       = static_cast<int32_t>(nextTimeout - stepTime);
 
-    if (minTimeout == timeoutAs)
+    if (nextTimeout == deadlineAs)
     {
-        OSInterfaceLogVerbose(tag, "Next timeout is N_As with %" PRId32 " ms remaining", minTimeout);
+        OSInterfaceLogVerbose(getTAG(), "Next timeout is N_As with %" PRId32 " ms remaining", remaining);
     }
-    else if (minTimeout == timeoutBs)
+    else if (nextTimeout == deadlineBs)
     {
-        OSInterfaceLogVerbose(tag, "Next timeout is N_Bs with %" PRId32 " ms remaining", minTimeout);
+        OSInterfaceLogVerbose(getTAG(), "Next timeout is N_Bs with %" PRId32 " ms remaining", remaining);
     }
-    else if (minTimeout == timeoutCs)
+    else if (nextTimeout == deadlineCs)
     {
-        OSInterfaceLogVerbose(tag, "Next timeout is N_Cs with %" PRId32 " ms remaining", minTimeout);
+        OSInterfaceLogVerbose(getTAG(), "Next timeout is N_Cs with %" PRId32 " ms remaining", remaining);
     }
 
-    return minTimeout + osInterface->osMillis();
+    return nextTimeout;
 }
 
 uint32_t N_USData_Request_Runner::getNextRunTime()
 {
-    if (!mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    if (!lock())
     {
-        OSInterfaceLogError(tag, "Failed to acquire mutex");
+        OSInterfaceLogError(getTAG(), "Failed to acquire mutex");
         result = N_ERROR;
         updateInternalStatus(ERROR);
         return 0;
     }
 
     uint32_t nextRunTime = getNextTimeoutTime();
-    switch (internalStatus)
+    if (getState(internalStatus).runNow)
     {
-        case ERROR:
-            [[fallthrough]];
-        case MESSAGE_SENT:
-            [[fallthrough]];
-        case NOT_RUNNING_SF:
-            [[fallthrough]];
-        case NOT_RUNNING_FF:
-            nextRunTime = 0; // Execute as soon as possible
-            OSInterfaceLogDebug(tag, "Next run time is NOW because internalStatus is %s (%" PRIu8 ")",
-                                internalStatusToString(internalStatus), internalStatus);
-            break;
-        default:
-            OSInterfaceLogDebug(tag, "Next run time is in %" PRId64 " ms because of next timeout",
-                                static_cast<int64_t>(nextRunTime) - osInterface->osMillis());
-            break;
+        nextRunTime = 0; // Execute as soon as possible
+        OSInterfaceLogDebug(getTAG(), "Next run time is NOW because internalStatus is %s (%" PRIu8 ")",
+                            internalStatusToString(internalStatus), internalStatus);
+    }
+    else
+    {
+        OSInterfaceLogDebug(getTAG(), "Next run time is in %" PRId64 " ms because of next timeout",
+                            static_cast<int64_t>(nextRunTime) - stepTime);
     }
 
-    mutex->signal();
+    unlock();
 
     return nextRunTime;
 }
 
 void N_USData_Request_Runner::messageACKReceivedCallback(const ACKResult success)
 {
-    if (!mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    if (!lock())
     {
-        OSInterfaceLogError(tag, "Failed to acquire mutex");
+        OSInterfaceLogError(getTAG(), "Failed to acquire mutex");
         result = N_ERROR;
         updateInternalStatus(ERROR);
         return;
     }
 
-    OSInterfaceLogDebug(tag,
+    stepTime = osInterface->osMillis();
+
+    OSInterfaceLogDebug(getTAG(),
                         "Running messageACKReceivedCallback with internalStatus = %s (%" PRIu8 ") and success = %s",
                         internalStatusToString(internalStatus), internalStatus, ackResultToString(success));
 
-    switch (internalStatus)
+    if (const State& state = getState(internalStatus); state.ackReceived != nullptr)
     {
-        case AWAITING_SF_ACK:
-        {
-            OSInterfaceLogDebug(tag, "Received SF ACK");
-            SF_ACKReceivedCallback(success);
-            break;
-        }
-        case AWAITING_FF_ACK:
-        {
-            OSInterfaceLogDebug(tag, "Received FF ACK");
-            FF_ACKReceivedCallback(success);
-            break;
-        }
-        case AWAITING_CF_ACK:
-        {
-            OSInterfaceLogDebug(tag, "Received CF ACK");
-            CF_ACKReceivedCallback(success);
-            break;
-        }
-        default:
-            OSInterfaceLogError(tag, "Invalid internalStatus %s (%" PRIu8 ")", internalStatusToString(internalStatus),
-                                internalStatus);
-            result = N_ERROR;
-            updateInternalStatus(ERROR);
-            break;
+        (this->*state.ackReceived)(success);
+    }
+    else
+    {
+        OSInterfaceLogError(getTAG(), "Invalid internalStatus %s (%" PRIu8 ")", internalStatusToString(internalStatus),
+                            internalStatus);
+        result = N_ERROR;
+        updateInternalStatus(ERROR);
     }
 
-    mutex->signal();
+    unlock();
 }
 
 void N_USData_Request_Runner::SF_ACKReceivedCallback(const ACKResult success)
 {
+    OSInterfaceLogDebug(getTAG(), "Received SF ACK");
+
     if (success == ACK_SUCCESS)
     {
-        timerN_As->stopTimer();
-        timerN_Cs->clearTimer();
-        OSInterfaceLogVerbose(tag, "Timer N_As stopped after receiving SF ACK in %" PRIu32 " ms",
-                              timerN_As->getElapsedTime_ms());
+        timerN_As.stopTimer(stepTime);
+        timerN_Cs.clearTimer();
+        OSInterfaceLogVerbose(getTAG(), "Timer N_As stopped after receiving SF ACK in %" PRIu32 " ms",
+                              timerN_As.getElapsedTime_ms(stepTime));
+        recordLatency(ISOTP_N_AsPhase, timerN_As);
         updateInternalStatus(MESSAGE_SENT);
     }
     else
     {
-        OSInterfaceLogError(tag, "SF ACK failed with result %s", ackResultToString(success));
+        OSInterfaceLogError(getTAG(), "SF ACK failed with result %s", ackResultToString(success));
         result = N_ERROR;
         updateInternalStatus(ERROR);
     }
@@ -593,27 +623,30 @@ void N_USData_Request_Runner::SF_ACKReceivedCallback(const ACKResult success)
 
 void N_USData_Request_Runner::FF_ACKReceivedCallback(const ACKResult success)
 {
+    OSInterfaceLogDebug(getTAG(), "Received FF ACK");
+
     if (success == ACK_SUCCESS)
     {
-        timerN_As->stopTimer();
-        timerN_Cs->clearTimer();
-        OSInterfaceLogVerbose(tag, "Timer N_As stopped after receiving FF ACK in %" PRIu32 " ms",
-                              timerN_As->getElapsedTime_ms());
-        timerN_Bs->startTimer();
-        OSInterfaceLogVerbose(tag, "Timer N_Bs started after receiving FF ACK");
+        timerN_As.stopTimer(stepTime);
+        timerN_Cs.clearTimer();
+        OSInterfaceLogVerbose(getTAG(), "Timer N_As stopped after receiving FF ACK in %" PRIu32 " ms",
+                              timerN_As.getElapsedTime_ms(stepTime));
+        recordLatency(ISOTP_N_AsPhase, timerN_As);
+        timerN_Bs.startTimer(stepTime);
+        OSInterfaceLogVerbose(getTAG(), "Timer N_Bs started after receiving FF ACK");
 
         updateInternalStatus(AWAITING_FirstFC);
 
         if (frameToHoldValid)
         {
             frameToHoldValid = false; // Reset the held frame after processing.
-            OSInterfaceLogDebug(tag, "Processing held frame: %s", frameToString(frameToHold));
+            OSInterfaceLogDebug(getTAG(), "Processing held frame: %s", frameToString(frameToHold));
             runStep_internal(&frameToHold);
         }
     }
     else
     {
-        OSInterfaceLogError(tag, "FF ACK failed with result %s", ackResultToString(success));
+        OSInterfaceLogError(getTAG(), "FF ACK failed with result %s", ackResultToString(success));
         result = N_ERROR;
         updateInternalStatus(ERROR);
     }
@@ -621,50 +654,61 @@ void N_USData_Request_Runner::FF_ACKReceivedCallback(const ACKResult success)
 
 void N_USData_Request_Runner::CF_ACKReceivedCallback(const ACKResult success)
 {
+    OSInterfaceLogDebug(getTAG(), "Received CF ACK");
+
     if (success == ACK_SUCCESS)
     {
-        timerN_As->stopTimer();
-        timerN_Cs->clearTimer();
-        OSInterfaceLogVerbose(tag, "Timer N_As stopped after receiving CF ACK in %" PRIu32 " ms",
-                              timerN_As->getElapsedTime_ms());
+        timerN_As.stopTimer(stepTime);
+        timerN_Cs.clearTimer();
+        OSInterfaceLogVerbose(getTAG(), "Timer N_As stopped after receiving CF ACK in %" PRIu32 " ms",
+                              timerN_As.getElapsedTime_ms(stepTime));
+        recordLatency(ISOTP_N_AsPhase, timerN_As);
 
         if (messageOffset == messageLength)
         {
-            timerN_As->stopTimer();
-            timerN_Cs->clearTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_As stopped after receiving CF ACK in %" PRIu32 " ms",
-                                  timerN_As->getElapsedTime_ms());
+            timerN_As.stopTimer(stepTime);
+            timerN_Cs.clearTimer();
+            OSInterfaceLogVerbose(getTAG(), "Timer N_As stopped after receiving CF ACK in %" PRIu32 " ms",
+                                  timerN_As.getElapsedTime_ms(stepTime));
             updateInternalStatus(MESSAGE_SENT);
         }
         else if (cfSentInThisBlock == blockSize)
         {
-            timerN_Bs->startTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_Bs started after receiving CF ACK");
+            timerN_Bs.startTimer(stepTime);
+            OSInterfaceLogVerbose(getTAG(), "Timer N_Bs started after receiving CF ACK");
 
             updateInternalStatus(AWAITING_FC);
 
             if (frameToHoldValid)
             {
                 frameToHoldValid = false; // Reset the held frame after processing.
-                OSInterfaceLogDebug(tag, "Processing held frame: %s", frameToString(frameToHold));
+                OSInterfaceLogDebug(getTAG(), "Processing held frame: %s", frameToString(frameToHold));
                 runStep_internal(&frameToHold);
             }
         }
         else
         {
-            timerN_Cs->startTimer();
-            OSInterfaceLogVerbose(tag, "Timer N_Cs started after receiving CF ACK");
+            timerN_Cs.startTimer(stepTime);
+            OSInterfaceLogVerbose(getTAG(), "Timer N_Cs started after receiving CF ACK");
             updateInternalStatus(SEND_CF);
         }
     }
     else
     {
-        OSInterfaceLogError(tag, "CF ACK failed with result %s", ackResultToString(success));
+        OSInterfaceLogError(getTAG(), "CF ACK failed with result %s", ackResultToString(success));
         result = N_ERROR;
         updateInternalStatus(ERROR);
     }
 }
 
+void N_USData_Request_Runner::recordLatency(const ISOTP_TimingPhase phase, const Timer_N& timer) const
+{
+    if (statistics != nullptr)
+    {
+        statistics->recordLatency(phase, ISOTP_Statistics::getTargetPeer(nAi), timer.getElapsedTime_ms(stepTime));
+    }
+}
+
 N_Result N_USData_Request_Runner::parseFCFrame(const CANFrame* receivedFrame, FlowStatus& fs, uint8_t& blcksize,
                                                STmin& stM)
 {
@@ -711,7 +755,7 @@ N_Result N_USData_Request_Runner::parseFCFrame(const CANFrame* receivedFrame, Fl
     }
     else // Reserved values -> max stMin value
     {
-        OSInterfaceLogWarning(tag, "FC frame has reserved STmin value %" PRIu8 ". Defaulting to %" PRIu8 " ms",
+        OSInterfaceLogWarning(getTAG(), "FC frame has reserved STmin value %" PRIu8 ". Defaulting to %" PRIu8 " ms",
                               receivedFrame->data[2], DEFAULT_STMIN_VALUE_MS);
         stM.unit  = ms;
         stM.value = DEFAULT_STMIN_VALUE_MS;
@@ -745,6 +789,27 @@ Mtype N_USData_Request_Runner::getMtype() const
     return mType;
 }
 
+uint32_t N_USData_Request_Runner::getStartTime() const
+{
+    return startTime;
+}
+
+void N_USData_Request_Runner::getSessionInfo(ISOTP_SessionInfo& info, const uint32_t now) const
+{
+    info.nAi              = nAi;
+    info.direction        = RunnerRequestType;
+    info.internalStatus   = internalStatusToString(internalStatus);
+    info.bytesTransferred = messageOffset;
+    info.messageLength    = messageLength;
+    info.blockSize        = blockSize;
+    info.stMin            = stMin;
+    info.armedTimer       = ISOTP_TimingPhaseCount;
+    info.remainingTime_ms = 0;
+    info.armTimer(ISOTP_N_AsPhase, timerN_As, N_As_TIMEOUT_MS, now);
+    info.armTimer(ISOTP_N_BsPhase, timerN_Bs, N_Bs_TIMEOUT_MS, now);
+    info.armTimer(ISOTP_N_CsPhase, timerN_Cs, getStMinInMs(stMin), now); // The next CF is sent once STmin passes.
+}
+
 N_USData_Request_Runner::RunnerType N_USData_Request_Runner::getRunnerType() const
 {
     return RunnerRequestType;
@@ -752,7 +817,7 @@ N_USData_Request_Runner::RunnerType N_USData_Request_Runner::getRunnerType() con
 
 const char* N_USData_Request_Runner::getTAG() const
 {
-    return this->tag;
+    return this->tag.get();
 }
 
 bool N_USData_Request_Runner::isThisFrameForMe(const CANFrame& frame) const
@@ -767,7 +832,7 @@ bool N_USData_Request_Runner::isThisFrameForMe(const CANFrame& frame) const
     res &= runnerN_AI.N_SA == frameN_AI.N_TA;
     res &= awaitingFrame(frame);
 
-    OSInterfaceLogDebug(tag, "isThisFrameForMe() = %s for frame %s", res ? "true" : "false", frameToString(frame));
+    OSInterfaceLogDebug(getTAG(), "isThisFrameForMe() = %s for frame %s", res ? "true" : "false", frameToString(frame));
     return res;
 }
 
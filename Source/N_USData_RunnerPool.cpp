@@ -0,0 +1,62 @@
+#include "N_USData_RunnerPool.h"
+
+#include <cassert>
+
+#include "ISOTP_Common.h"
+
+N_USData_RunnerPool::N_USData_RunnerPool(OSInterface& osInterface)
+{
+    this->mutex = osInterface.osCreateMutex();
+    assert(this->mutex != nullptr && "Mutex creation failed");
+}
+
+N_USData_RunnerPool::~N_USData_RunnerPool()
+{
+    this->slots.clear(); // Destroy the runners before the mutex.
+    delete this->mutex;
+}
+
+N_USData_RunnerSlot* N_USData_RunnerPool::acquireSlot()
+{
+    if (!this->mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        return nullptr;
+    }
+
+    N_USData_RunnerSlot* slot;
+    if (this->freeSlots.empty())
+    {
+        slot = &this->slots.emplace_back();
+    }
+    else
+    {
+        slot = this->freeSlots.back();
+        this->freeSlots.pop_back();
+    }
+
+    this->mutex->signal();
+    return slot;
+}
+
+void N_USData_RunnerPool::release(N_USData_RunnerSlot* slot)
+{
+    slot->reset();
+
+    // The slot is destroyed with the pool even if the mutex can not be taken, it is just not reused.
+    if (this->mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        this->freeSlots.push_back(slot);
+        this->mutex->signal();
+    }
+}
+
+uint32_t N_USData_RunnerPool::getSlotCount() const
+{
+    uint32_t count = 0;
+    if (this->mutex->wait(ISOTP_MaxTimeToWaitForSync_MS))
+    {
+        count = this->slots.size();
+        this->mutex->signal();
+    }
+    return count;
+}
@@ -10,16 +10,30 @@ Timer_N::Timer_N(OSInterface& osInterface)
 
 void Timer_N::stopTimer()
 {
-    timerRunning = false;
-    elapsedTime += osInterface->osMillis() - startTime;
+    stopTimer(osInterface->osMillis());
+}
+
+void Timer_N::stopTimer(const uint32_t now)
+{
+    if (timerRunning)
+    {
+        elapsedTime += getElapsedTime_ms(now);
+        timerRunning = false;
+    }
 }
 
 void Timer_N::startTimer()
+{
+    startTimer(osInterface->osMillis());
+}
+
+void Timer_N::startTimer(const uint32_t now)
 {
     elapsedTime  = 0;
-    startTime    = osInterface->osMillis();
+    startTime    = now;
     timerRunning = true;
 }
+
 void Timer_N::clearTimer()
 {
     timerRunning = false;
@@ -38,5 +52,20 @@ uint32_t Timer_N::getStartTimeStamp() const
 
 uint32_t Timer_N::getElapsedTime_ms() const
 {
-    return timerRunning ? osInterface->osMillis() - startTime : elapsedTime;
+    return timerRunning ? getElapsedTime_ms(osInterface->osMillis()) : elapsedTime;
+}
+
+uint32_t Timer_N::getElapsedTime_ms(const uint32_t now) const
+{
+    if (!timerRunning)
+    {
+        return elapsedTime;
+    }
+    // The sample may have been taken before the timer was started from another context (e.g. an ACK callback).
+    return static_cast<int32_t>(now - startTime) > 0 ? now - startTime : 0;
+}
+
+uint32_t Timer_N::getDeadline(const uint32_t timeout_ms) const
+{
+    return startTime + timeout_ms;
 }
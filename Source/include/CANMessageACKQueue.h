@@ -1,36 +1,91 @@
 #ifndef CANMESSAGEACKQUEUE_H
 #define CANMESSAGEACKQUEUE_H
 
+#include <atomic>
 #include <list>
 #include "CANInterface.h"
+#include "ISOTP_Statistics.h"
+#include "ISOTP_Trace.h"
 #include "OSInterface.h"
 
-class N_USData_Runner;
+/**
+ * Interface of the objects that write frames through a CANMessageACKQueue and are notified of their ACKs.
+ */
+class CANMessageACKListener
+{
+public:
+    virtual ~CANMessageACKListener() = default;
+
+    /**
+     * @brief Callback for when the ACK of a frame written by this object is received.
+     * @param success The result of the write.
+     */
+    virtual void messageACKReceivedCallback(ACKResult success) = 0;
+
+    /**
+     * @brief Returns the N_AI of the frames written by this object.
+     * @return The N_AI of the frames written by this object.
+     */
+    [[nodiscard]] virtual N_AI getN_AI() const = 0;
+};
 
 class CANMessageACKQueue
 {
 public:
-    explicit CANMessageACKQueue(CANInterface& canInterface, OSInterface& osInterface, const char* tag = TAG);
+    /**
+     * @param canInterface The CANInterface the frames are written to.
+     * @param osInterface The OSInterface used to create the mutex.
+     * @param tag The logging tag.
+     * @param statistics Optional counters of the frames written, of the depth of the queue and of its mutex.
+     */
+    explicit CANMessageACKQueue(CANInterface& canInterface, OSInterface& osInterface, const char* tag = TAG,
+                                ISOTP_Statistics* statistics = nullptr);
     ~CANMessageACKQueue();
 
     void runStep();
 
+    /**
+     * This function is used to store the ACK of the oldest frame written that has no ACK yet. runStep does it for the
+     * ACKs read from the CANInterface, this function allows feeding ACKs obtained elsewhere.
+     * @param ack The ACK result to store.
+     */
+    void onWriteAck(ACKResult ack);
+
     void runAvailableAckCallbacks();
 
-    bool writeFrame(N_USData_Runner& runner, CANFrame& frame);
+    [[nodiscard]] bool hasAvailableAckCallbacks() const;
+
+    [[nodiscard]] bool isWaitingForAcks() const;
+
+    /**
+     * This function is used to count the frames of an N_AI that are waiting for their ACK or for their ACK callback.
+     * @param nAi The N_AI of the listener.
+     * @return The number of frames.
+     */
+    [[nodiscard]] uint32_t getPendingAcks(N_AI nAi) const;
+
+    bool writeFrame(CANMessageACKListener& listener, CANFrame& frame);
 
     bool removeFromQueue(N_AI runnerNAi);
 
+    /**
+     * This function is used to capture the frames written and their ACKs.
+     * @param buffer The ring the records are added to, nullptr to stop capturing. It must outlive this queue.
+     */
+    void setTraceBuffer(ISOTP_TraceBuffer* buffer);
+
     constexpr static const char* TAG = "ISOTP-CANMessageACKQueue";
 
 private:
     bool runNextAvailableAckCallback();
     void saveAck(ACKResult ack);
 
-    const char*                                       tag;
-    OSInterface_Mutex*                                mutex;
-    std::list<std::pair<N_USData_Runner*, ACKResult>> messageQueue;
-    CANInterface*                                     canInterface;
+    const char*                                             tag;
+    OSInterface_Mutex*                                      mutex;
+    std::list<std::pair<CANMessageACKListener*, ACKResult>> messageQueue;
+    CANInterface*                                           canInterface;
+    ISOTP_Statistics*                                       statistics;
+    std::atomic<ISOTP_TraceBuffer*>                         traceBuffer{nullptr};
 };
 
 #endif // CANMESSAGEACKQUEUE_H
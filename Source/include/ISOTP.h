@@ -1,14 +1,24 @@
 #ifndef ISOTP_H
 #define ISOTP_H
 
+#include <array>
+#include <atomic>
 #include <list>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 #include "Atomic_int64_t.h"
 #include "CANMessageACKQueue.h"
+#include "ISOTP_AcceptanceFilter.h"
+#include "ISOTP_ChunkPool.h"
 #include "ISOTP_Common.h"
-#include "N_USData_Runner.h"
+#include "ISOTP_PeerQuotas.h"
+#include "ISOTP_SessionTable.h"
+#include "ISOTP_SlabAllocator.h"
+#include "ISOTP_Statistics.h"
+#include "ISOTP_Trace.h"
+#include "LockFreeInbox.h"
+#include "N_USData_RunnerPool.h"
 
 #define ISOTP_N_AI_CONFIG(_N_TAtype, _N_TA, _N_SA)                                                                     \
     {.N_NFA_Header = 0b110, .N_NFA_Padding = 0b00, .N_TAtype = (_N_TAtype), .N_TA = (_N_TA), .N_SA = (_N_SA)}
@@ -18,6 +28,22 @@ constexpr uint32_t ISOTP_RunPeriod_MS                   = 0;
 constexpr uint32_t ISOTP_RunPeriod_ACKQueue_MS          = 0;
 constexpr STmin    ISOTP_DefaultSTmin                   = {20, ms};
 constexpr uint8_t  ISOTP_DefaultBlockSize               = 0; // 0 means that all CFs are sent without waiting for an FC.
+constexpr uint8_t  ISOTP_MaxDirectSFRequests            = 8; // SFs that can wait for their ACK without a runner.
+constexpr uint32_t ISOTP_FrameInboxSize                 = 32; // Frames that can wait for runStep in push mode.
+constexpr uint32_t ISOTP_ACKInboxSize                   = 32; // ACKs that can wait for runStep in push mode.
+
+// Where the payloads of the runners are allocated. ISOTP_HeapPayloads uses OSInterface::osMalloc() for each message.
+// ISOTP_SlabPayloads takes them from one region of totalAvailableMemoryForRunners bytes allocated by the constructor,
+// in power-of-two size classes, so long-running targets do not fragment their heap (see ISOTP_SlabAllocator). Its
+// limits: the largest message is the largest power of two not above the region size, so a power-of-two
+// totalAvailableMemoryForRunners is best, and a region split by smaller messages can refuse a message that fits in the
+// free memory left. Such a message is refused when its FF or request arrives, with an OVERFLOW FC for an FF.
+// ISOTP_ChunkedPayloads reassembles the received messages in chunks of ISOTP_DefaultChunkSize bytes instead of one
+// contiguous block, so large messages are received as long as there is enough memory in total (see ISOTP_ChunkPool).
+// Up to ISOTP_DefaultFreeChunkBytes of released chunks are kept for reuse on top of totalAvailableMemoryForRunners.
+// The sent messages are taken from the heap.
+using ISOTP_PayloadAllocation =
+    enum ISOTP_PayloadAllocation { ISOTP_HeapPayloads, ISOTP_SlabPayloads, ISOTP_ChunkedPayloads };
 
 /**
  * This function is used to confirm the sending of a message.
@@ -39,6 +65,17 @@ using N_USData_confirm_cb_t = void (*)(N_AI nAi, N_Result nResult, Mtype mtype);
 using N_USData_indication_cb_t = void (*)(N_AI nAi, const uint8_t* messageData, uint32_t messageLength,
                                           N_Result nResult, Mtype mtype);
 
+/**
+ * This function is used to indicate the reception of a message without copying it to a contiguous buffer.
+ * @warning The message is only valid during the callback, if you need to keep the data, copy it elsewhere.
+ * @param nAi The N_AI of the message.
+ * @param message The segments of the message, there are none if the reception failed.
+ * @param nResult The result of the reception.
+ * @param mtype The Mtype of the message.
+ */
+using N_USData_indication_segments_cb_t = void (*)(N_AI nAi, const ISOTP_MessageView& message, N_Result nResult,
+                                                   Mtype mtype);
+
 /**
  * This function is used to indicate the reception of the first frame of a multi-frame message.
  * @param nAi The N_AI of the message.
@@ -47,10 +84,29 @@ using N_USData_indication_cb_t = void (*)(N_AI nAi, const uint8_t* messageData,
  */
 using N_USData_FF_indication_cb_t = void (*)(N_AI nAi, uint32_t messageLength, Mtype mtype);
 
+class ISOTP;
+
+/**
+ * This function is used to notify that an ISOTP object in push mode has a frame or ACK waiting for runStep.
+ * @warning It is called from the context that calls onFrameReceived or onWriteAck (which may be an interrupt handler),
+ * it must not block nor call runStep directly.
+ * @param isotp The ISOTP object that needs to run.
+ */
+using ISOTP_WakeUp_cb_t = void (*)(ISOTP& isotp);
+
+/**
+ * This function is used to notify that the acceptance filters of an ISOTP object changed, so the CAN backend can get
+ * them with ISOTP::getAcceptanceFilters() and install them.
+ * @param isotp The ISOTP object whose acceptance filters changed.
+ */
+using ISOTP_AcceptanceFilters_cb_t = void (*)(ISOTP& isotp);
+
 /**
  * This class provides a C++ implementation of the DoCAN protocol aka ISO-TP, it currently only supports N_TAtype #5 &
  * #6 (Standard CAN, 29bit ID Physical & Functional address modes using normal fixed addressing (See ISO 15765-2 for
  * more details)).
+ * A single object can own several local N_SAs (see addLocalN_SA()), sharing its runners, memory and ACK queue between
+ * them.
  */
 class ISOTP
 {
@@ -62,6 +118,7 @@ public:
      * The message will be sent as soon as possible, but there is no guarantee on the timing.
      * @note If the request is issued to an N_AI that is currently being processed, the message will be queued and
      * processed once the conflicting message is processed.
+     * @note A message that fits in an SF and whose N_AI is idle is written immediately, without allocating memory.
      * @param nTa The N_TA to send the message to.
      * @param nTaType The N_TAtype of the N_TA.
      * @param messageData The message data to send.
@@ -73,6 +130,23 @@ public:
     bool N_USData_request(typeof(N_AI::N_TA) nTa, N_TAtype_t nTaType, const uint8_t* messageData, uint32_t length,
                           Mtype mType = Mtype_Diagnostics);
 
+    /**
+     * This function is used to queue a message to be sent to an N_TA from one of the local N_SAs of this ISOTP object.
+     * It behaves like N_USData_request(nTa, nTaType, messageData, length, mType), but allows selecting the N_SA.
+     * @param nSa The local N_SA to send the message from. It must have been added with addLocalN_SA() or be the N_SA
+     * given in the constructor.
+     * @param nTa The N_TA to send the message to.
+     * @param nTaType The N_TAtype of the N_TA.
+     * @param messageData The message data to send.
+     * @param length The length of the message data.
+     * @param mType The Mtype of the message.
+     *
+     * @returns true if the request was queued successfully and false if it failed to enqueue the message or nSa is not
+     * a local N_SA.
+     */
+    bool N_USData_request(typeof(N_AI::N_SA) nSa, typeof(N_AI::N_TA) nTa, N_TAtype_t nTaType,
+                          const uint8_t* messageData, uint32_t length, Mtype mType = Mtype_Diagnostics);
+
     /**
      * This function is used to run the DoCAN service.
      * It needs to be called periodically to allow the DoCAN service to run.
@@ -84,8 +158,66 @@ public:
      * This function is used to run the DoCAN service.
      * It needs to be called periodically to allow the DoCAN service to run.
      * There are no limitations on the frequency of this function, timing is handled internally.
+     * @note In push mode it does nothing, the ACKs given to onWriteAck are processed by runStep.
      */
-    void canMessageACKQueueRunStep() const;
+    void canMessageACKQueueRunStep();
+
+    /**
+     * This function is used to select where runStep gets the received frames and write ACKs from.
+     * By default (polling mode) they are read from the CANInterface. In push mode, they are only taken from the ones
+     * given to onFrameReceived and onWriteAck, so the application must deliver all of them.
+     * @note Frames and ACKs already pushed are kept when push mode is disabled, the following runSteps process them
+     * before polling the CANInterface again.
+     * @param enabled True to enable the push mode, false to go back to polling mode.
+     * @param wakeUp_cb Optional function called after each frame or ACK pushed.
+     */
+    void setPushMode(bool enabled, ISOTP_WakeUp_cb_t wakeUp_cb = nullptr);
+
+    /**
+     * This function is used to check if the push mode is enabled.
+     * @return True if the frames and ACKs are taken from onFrameReceived and onWriteAck, false if they are polled.
+     */
+    bool isPushModeEnabled() const;
+
+    /**
+     * This function is used to deliver a frame received from the CAN bus to this ISOTP object in push mode.
+     * It does not lock nor allocate memory, so it can be called from a driver thread or an interrupt handler.
+     * @note Only one context can call this function at the same time.
+     * @param frame The received frame, it is copied.
+     * @return True if the frame was queued for the next runStep, false if push mode is disabled or the inbox is full.
+     */
+    bool onFrameReceived(const CANFrame& frame);
+
+    /**
+     * This function is used to deliver the ACK of the oldest frame written by this ISOTP object in push mode.
+     * It does not lock nor allocate memory, so it can be called from a driver thread or an interrupt handler.
+     * @note Only one context can call this function at the same time.
+     * @param ack The result of the write.
+     * @return True if the ACK was queued for the next runStep, false if push mode is disabled, the ACK is ACK_NONE or
+     * the inbox is full.
+     */
+    bool onWriteAck(ACKResult ack);
+
+    /**
+     * This function is used to get the timestamp at which runStep needs to be called again, assuming that no frame or
+     * ACK is received before that. The timestamp is derived from OSInterface::osMillis().
+     * @return The next timestamp runStep needs to be called at, 0 if it needs to be called as soon as possible or
+     * ISOTP_NoNextRunTime if there is nothing scheduled.
+     */
+    uint32_t getNextRunTime() const;
+
+    /**
+     * This function is used to check if a received frame or ACK is waiting to be processed by runStep.
+     * @return True if runStep needs to be called to process a frame or an ACK, false otherwise.
+     */
+    bool hasPendingCANEvents() const;
+
+    /**
+     * This function is used to check if any frame written by this object is still waiting for its ACK.
+     * @return True if canMessageACKQueueRunStep needs to be called to collect ACKs, false otherwise (always false in
+     * push mode).
+     */
+    bool isWaitingForACKs() const;
 
     /**
      * This function is used to get the N_SA for this ISOTP object.
@@ -93,6 +225,30 @@ public:
      */
     typeof(N_AI::N_SA) getN_SA() const;
 
+    /**
+     * This function is used to add a local N_SA to this ISOTP object.
+     * From this point on, physical messages addressed to this N_SA will be received by this object, and messages can be
+     * sent from it. All the local N_SAs share the same runners, memory and ACK queue.
+     * @param nSA The N_SA to add to this ISOTP object.
+     */
+    void addLocalN_SA(typeof(N_AI::N_SA) nSA);
+
+    /**
+     * This function is used to remove a local N_SA from this ISOTP object.
+     * Messages that are being received or sent before removing the N_SA will not be affected.
+     * @note The N_SA given in the constructor cannot be removed.
+     * @param nSA The N_SA to remove from this ISOTP object.
+     * @return True if the N_SA was removed, false otherwise.
+     */
+    bool removeLocalN_SA(typeof(N_AI::N_SA) nSA);
+
+    /**
+     * This function is used to check if a N_SA is one of the local N_SAs of this ISOTP object.
+     * @param nSA The N_SA to check for in this ISOTP object.
+     * @return True if the N_SA is a local N_SA, false otherwise.
+     */
+    bool hasLocalN_SA(typeof(N_AI::N_SA) nSA) const;
+
     /**
      * This function is used to add a N_TA into the functional accepted N_TAs for this ISOTP object.
      * From this point on, all messages sent or received by this object will have this N_TA.
@@ -117,6 +273,33 @@ public:
      */
     bool hasAcceptedFunctionalN_TA(typeof(N_AI::N_TA) nTA);
 
+    /**
+     * This function is used to get the acceptance filters that let through all the frames this ISOTP object can
+     * receive: physical frames addressed to its local N_SAs and functional frames addressed to its accepted functional
+     * N_TAs. Installing them in the CAN controller (or in a software pre-filter) avoids reading foreign frames.
+     * @param maxFilters The number of filters the backend can install. If fewer than needed, some filters are merged
+     * and let through extra frames, which are still discarded by this object.
+     * @return The acceptance filters, see ISOTP_computeAcceptanceFilters().
+     */
+    std::vector<ISOTP_AcceptanceFilter> getAcceptanceFilters(uint32_t maxFilters = ISOTP_NoAcceptanceFilterLimit) const;
+
+    /**
+     * This function is used to set the function called when the acceptance filters of this ISOTP object change, i.e.
+     * when a local N_SA or an accepted functional N_TA is added or removed. It is also called once when it is set, so
+     * the initial filters can be installed.
+     * @param acceptanceFilters_cb The function to call, nullptr to disable the notifications.
+     */
+    void setAcceptanceFiltersCallback(ISOTP_AcceptanceFilters_cb_t acceptanceFilters_cb);
+
+    /**
+     * This function is used to receive the messages as segments instead of through N_USData_indication_cb. While it is
+     * set, it is called instead of N_USData_indication_cb.
+     * @note With ISOTP_ChunkedPayloads, N_USData_indication_cb gets a contiguous copy of each message reassembled in
+     * chunks, which needs a temporary allocation of its length. This callback avoids the copy.
+     * @param N_USData_indication_segments_cb The function to call, nullptr to go back to N_USData_indication_cb.
+     */
+    void setIndicationSegmentsCallback(N_USData_indication_segments_cb_t N_USData_indication_segments_cb);
+
     /**
      * This function is used to get the block size for this ISOTP object.
      * @return The block size for this ISOTP object.
@@ -146,10 +329,132 @@ public:
      */
     bool setSTmin(STmin stMin);
 
+    /**
+     * This function is used to limit the memory for runners and the simultaneous receptions that a remote N_SA can take
+     * when sending segmented messages to this object. An FF that does not fit in the quota of its N_SA is answered with
+     * an OVERFLOW FC, like the ones that do not fit in the memory for runners.
+     * The reserved memory of a peer is not given to the messages of other peers, so the sum of the reserves should not
+     * exceed the memory for runners.
+     * @param nSa The remote N_SA to limit.
+     * @param quota The quota of the N_SA, ISOTP_DefaultPeerQuota to remove the limits.
+     * @return True if the quota was set, false otherwise.
+     */
+    bool setPeerQuota(typeof(N_AI::N_SA) nSa, const ISOTP_PeerQuota& quota);
+
+    /**
+     * This function is used to get the quota of a remote N_SA.
+     * @param nSa The remote N_SA.
+     * @return The quota of the N_SA, ISOTP_DefaultPeerQuota if none was set.
+     */
+    ISOTP_PeerQuota getPeerQuota(typeof(N_AI::N_SA) nSa) const;
+
+    /**
+     * This function is used to get the counters of the protocol events of this ISOTP object: frames and bytes sent and
+     * received, sessions by N_Result, frames held while waiting for an ACK, OVERFLOW FCs sent, N_Cs/N_Br performance
+     * misses and the high-water of the memory for runners and of the ACK queue.
+     * The counters are always enabled, they are relaxed atomics so reading them does not block the runStep.
+     * @return The counters, added over all the peers.
+     */
+    ISOTP_StatisticsSnapshot getStatistics() const;
+
+    /**
+     * This function is used to also count the frames, bytes and sessions of each remote N_SA. Their table takes
+     * ISOTP_Statistics::getPeerTableSize() bytes, which are taken out of the memory for runners and kept until the
+     * ISOTP object is destroyed. Functional requests are only counted in the totals, as they have no single peer.
+     * @return True if the counters of the N_SAs are enabled, false if there is not enough memory for runners left or
+     * the table could not be allocated.
+     */
+    bool enablePeerStatistics();
+
+    /**
+     * This function is used to get the frames, bytes and sessions exchanged with one remote N_SA.
+     * @param nSa The remote N_SA.
+     * @return The counters of the N_SA, all 0 if enablePeerStatistics was not called.
+     */
+    ISOTP_PeerStatistics getPeerStatistics(typeof(N_AI::N_SA) nSa) const;
+
+    /**
+     * This function is used to get the distribution of the durations of a timing phase, for all the peers. The N_
+     * phases are measured by the runners with their ISO 15765-2 timers, the request and indication phases from the
+     * N_USData_request or the FF until the callback.
+     * @param phase The phase.
+     * @return The histogram, see ISOTP_LatencyHistogramSnapshot for its percentiles and text export.
+     */
+    ISOTP_LatencyHistogramSnapshot getLatencyHistogram(ISOTP_TimingPhase phase) const;
+
+    /**
+     * This function is used to also record the latency histograms of one remote N_SA. It allocates
+     * ISOTP_TimingPhaseCount histograms, which are kept until the ISOTP object is destroyed, and calls
+     * enablePeerStatistics as the histograms are kept with the counters of the N_SA.
+     * @param nSa The remote N_SA.
+     * @return True if the histograms are recorded, false if they or the counters could not be allocated.
+     */
+    bool enablePeerLatencyHistograms(typeof(N_AI::N_SA) nSa);
+
+    /**
+     * This function is used to get the distribution of the durations of a timing phase for one remote N_SA.
+     * @param nSa The remote N_SA.
+     * @param phase The phase.
+     * @param histogram Set to the histogram of the N_SA.
+     * @return True if enablePeerLatencyHistograms was called for the N_SA, false otherwise.
+     */
+    bool getPeerLatencyHistogram(typeof(N_AI::N_SA) nSa, ISOTP_TimingPhase phase,
+                                 ISOTP_LatencyHistogramSnapshot& histogram) const;
+
+    /**
+     * This function is used to clear all the latency histograms, for example at the start of a measurement.
+     */
+    void resetLatencyHistograms();
+
+    /**
+     * This function is used to get how often a mutex of this ISOTP object (or of its ACK queue and runners) was found
+     * taken, how long it was waited for and how often the wait timed out.
+     * @param lock The mutex.
+     * @return The counters of the mutex.
+     */
+    ISOTP_LockStatistics getLockStatistics(ISOTP_Lock lock) const;
+
+    /**
+     * This function is used to list the sessions of this ISOTP object: the requests waiting for their N_AI, the active
+     * requests and receptions and the ones that only wait for their last ACK (direct SFs included), with their
+     * internalStatus, progress, BS/STmin, armed timer and frames waiting for an ACK.
+     * The list is published by every runStep into a table that is read without locking, so calling this function
+     * never stops the runStep. The table is only kept once this function is called for the first time, so that first
+     * call returns false and the list is available after the next runStep.
+     * @param snapshot Set to the sessions at the end of the last runStep.
+     * @return True if the snapshot was set, false if there is no list yet or it kept changing while it was copied.
+     */
+    bool getSessions(ISOTP_SessionSnapshot& snapshot);
+
+    /**
+     * This function is used to get the distribution of the durations of a part of runStep or
+     * canMessageACKQueueRunStep. resetLatencyHistograms also clears it.
+     * @param phase The part of the runStep.
+     * @return The histogram, in ms. Empty unless setRunStepTimingEnabled was called.
+     */
+    ISOTP_LatencyHistogramSnapshot getRunStepHistogram(ISOTP_RunStepPhase phase) const;
+
+    /**
+     * This function is used to time the parts of runStep and canMessageACKQueueRunStep for getRunStepHistogram.
+     * It is disabled by default, as it reads the clock 5 more times per runStep.
+     * @param enabled True to record the durations, false to stop.
+     */
+    void setRunStepTimingEnabled(bool enabled);
+
+    /**
+     * This function is used to capture the frames read (before they are filtered), the frames written and their ACKs.
+     * Recording only copies the frame into the ring, the records are written out by an ISOTP_TraceWriter the
+     * application drains from another thread or task.
+     * @param buffer The ring the records are added to, nullptr to stop capturing. It can be shared by several ISOTP
+     * objects and must outlive this one.
+     */
+    void setTraceBuffer(ISOTP_TraceBuffer* buffer);
+
     ISOTP(typeof(N_AI::N_SA) nSA, uint32_t totalAvailableMemoryForRunners, N_USData_confirm_cb_t N_USData_confirm_cb,
           N_USData_indication_cb_t N_USData_indication_cb, N_USData_FF_indication_cb_t N_USData_FF_indication_cb,
           OSInterface& osInterface, CANInterface& canInterface, uint8_t blockSize = ISOTP_DefaultBlockSize,
-          STmin stMin = ISOTP_DefaultSTmin, const char* tag = TAG);
+          STmin stMin = ISOTP_DefaultSTmin, const char* tag = TAG,
+          ISOTP_PayloadAllocation payloadAllocation = ISOTP_HeapPayloads);
 
     const char* getTag() const;
 
@@ -180,33 +485,107 @@ private:
     N_USData_indication_cb_t    N_USData_indication_cb;
     N_USData_FF_indication_cb_t N_USData_FF_indication_cb;
 
+    std::atomic<N_USData_indication_segments_cb_t> N_USData_indication_segments_cb;
+
     // Internal configuration (mutable)
-    typeof(N_AI::N_SA)                     nSA;
-    std::unordered_set<typeof(N_AI::N_TA)> acceptedFunctionalN_TAs;
-    uint8_t                                blockSize;
-    STmin                                  stMin{};
+    typeof(N_AI::N_SA)           nSA;
+    ISOTP_N_AddressTable         localN_SAs;              // Physical N_TAs received by this object, indexed by N_TA.
+    ISOTP_N_AddressTable         acceptedFunctionalN_TAs; // Functional N_TAs received by this object, indexed by N_TA.
+    ISOTP_AcceptanceFilters_cb_t acceptanceFilters_cb;
+    uint8_t                      blockSize;
+    STmin                        stMin{};
 
     // Internal data
-    Atomic_int64_t                                           availableMemoryForRunners;
-    uint32_t                                                 lastRunTime;
-    std::list<N_USData_Runner*>                              notStartedRunners;
-    std::unordered_map<typeof(N_AI::N_AI), N_USData_Runner*> activeRunners;
-    std::list<N_USData_Runner*>                              finishedRunners;
-    CANMessageACKQueue*                                      canMessageAckQueue;
+    Atomic_int64_t                                                          availableMemoryForRunners;
+    ISOTP_PeerQuotas                                                        peerQuotas;    // Outlives the runners.
+    ISOTP_SlabAllocator                                                     slabAllocator; // Outlives the runners.
+    ISOTP_ChunkPool                                                         chunkPool;     // Outlives the runners.
+    ISOTP_Statistics                                                        statistics;    // Outlives the runners.
+    N_USData_RunnerPool                                                     runnerPool; // Owns all the runners below.
+    uint32_t                                                                lastRunTime; // Clock sample of the step.
+    uint32_t                                                                ackLastRunTime;
+    std::atomic<uint32_t>                                                   nextRunTime;
+    std::unordered_map<typeof(N_AI::N_AI), std::list<N_USData_RunnerSlot*>> notStartedRunners; // FIFO per N_AI.
+    std::vector<typeof(N_AI::N_AI)>                                         readyN_AIs;    // N_AIs that may start.
+    std::unordered_map<typeof(N_AI::N_AI), N_USData_RunnerSlot*>            activeRunners;
+    std::vector<typeof(N_AI::N_AI)>                                         releasedN_AIs; // N_AIs that became free.
+    std::list<N_USData_RunnerSlot*>                                         finishedRunners;
+    CANMessageACKQueue*                                                     canMessageAckQueue;
+
+    // SF written directly by N_USData_request, waiting for its ACK without a runner.
+    class DirectSFRequest final : public CANMessageACKListener
+    {
+    public:
+        void               messageACKReceivedCallback(ACKResult success) override;
+        [[nodiscard]] N_AI getN_AI() const override;
+
+        N_AI      nAi{};
+        Mtype     mType{};
+        uint8_t   length{};
+        uint32_t  sendTime{}; // Start of N_As.
+        ACKResult ack{ACK_NONE};
+        bool      inUse{false};
+    };
+
+    std::array<DirectSFRequest, ISOTP_MaxDirectSFRequests> directSFRequests; // Protected by runnersMutex.
+
+    // Sessions published by the runStep for getSessions.
+    struct SessionTable
+    {
+        ISOTP_SessionTable published;
+        ISOTP_SessionInfo  sessions[ISOTP_SessionTableSize]; // Filled by the runStep, then copied to published.
+    };
+
+    std::atomic<SessionTable*> sessionTable{nullptr}; // Allocated once, by the first getSessions.
+
+    std::atomic<ISOTP_TraceBuffer*> traceBuffer{nullptr}; // Set by setTraceBuffer, not owned.
+
+    // Push mode, filled by onFrameReceived and onWriteAck and emptied by runStep.
+    std::atomic<bool>                             pushMode;
+    std::atomic<ISOTP_WakeUp_cb_t>                wakeUp_cb;
+    LockFreeInbox<CANFrame, ISOTP_FrameInboxSize> frameInbox;
+    LockFreeInbox<ACKResult, ISOTP_ACKInboxSize>  ackInbox;
 
     // Functions
     bool populateQueueTag();
+    void recordAvailableMemory();
+
+    // Writes the pending, active and finishing sessions to sessionTable, if getSessions was called. Must be called
+    // after runFinishedRunnerCallbacks, so the finished runners are not listed.
+    void publishSessions();
+
+    // Records the time since start in the histogram of a part of the runStep, and returns the current time. Returns
+    // start without reading the clock if the runStep timing is not enabled.
+    uint32_t recordRunStepDuration(ISOTP_RunStepPhase phase, uint32_t start);
+
+    // Allocator given to the runners for their payloads, nullptr if they take them from the heap.
+    ISOTP_SlabAllocator* getPayloadAllocator();
+    // Pool given to the indication runners for their payloads, nullptr if they store them contiguously.
+    ISOTP_ChunkPool* getChunkPool();
 
     bool updateRunners();
-    bool updateRunner(N_USData_Runner* runner) const;
+    bool updateRunner(N_USData_RunnerSlot* runner) const;
 
     void runRunners(FrameStatus& frameStatus, CANFrame& frame);
     void createRunnerForMessage(STmin stM, uint8_t bs, FrameStatus frameStatus, CANFrame& frame);
-    void runStepCanActive();
+    void indicateSF(const CANFrame& frame);
+    void runStepCanActive(uint32_t millis);
     void runStepCanInactive();
     void startRunners();
-    void getFrameIfAvailable(FrameStatus& frameStatus, CANFrame& frame) const;
+    void getFrameIfAvailable(FrameStatus& frameStatus, CANFrame& frame, const ISOTP_N_AddressTable& physicalN_TAs,
+                             const ISOTP_N_AddressTable& functionalN_TAs);
+    bool readFrame(CANFrame& frame);
+    void processPushedACKs();
+    void wakeUp();
+    void notifyAcceptanceFiltersChanged();
     void runFinishedRunnerCallbacks();
+    void indicateMessage(N_USData_RunnerSlot* runner);
+    bool requestDirectSF(N_AI nAi, Mtype mType, const uint8_t* messageData, uint32_t length);
+    void runDirectSFRequests(bool canActive);
+
+    [[nodiscard]] bool hasDirectSFRequest(typeof(N_AI::N_AI) nAi) const;
+
+    [[nodiscard]] uint32_t computeNextRunTime() const;
 
     template <std::ranges::input_range R> void runErrorCallbacks(R&& runners);
 };
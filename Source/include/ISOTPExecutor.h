@@ -0,0 +1,85 @@
+#ifndef ISOTPEXECUTOR_H
+#define ISOTPEXECUTOR_H
+
+#include <vector>
+
+#include "ISOTP.h"
+#include "OSInterface.h"
+
+constexpr uint8_t ISOTPExecutor_DefaultWorkerCount = 1;
+
+/**
+ * This class drives many ISOTP objects (and therefore their CAN channels) from a small, fixed number of loops.
+ * Every registered ISOTP object is assigned to a worker. Each worker loop calls runStep(worker), which only runs the
+ * objects that have a received frame or ACK pending, or whose next deadline has been reached, and returns the next
+ * deadline of all the objects of that worker.
+ * @note The executor does not create threads, the application calls runStep(worker) for each worker, from one thread
+ * or from one thread per worker.
+ */
+class ISOTPExecutor
+{
+public:
+    constexpr static const char* TAG = "ISOTPExecutor";
+
+    /**
+     * @param osInterface The OSInterface used to get the time and the mutexes.
+     * @param workerCount The number of workers the ISOTP objects are spread across. It must be greater than 0.
+     * @param tag The logging tag of the executor.
+     */
+    explicit ISOTPExecutor(OSInterface& osInterface, uint8_t workerCount = ISOTPExecutor_DefaultWorkerCount,
+                           const char* tag = TAG);
+
+    ~ISOTPExecutor();
+
+    /**
+     * This function is used to register an ISOTP object in the worker with fewer objects.
+     * @param isotp The ISOTP object to register. It must outlive its registration.
+     * @return True if the object was registered, false if it was already registered or the registration failed.
+     */
+    bool addInstance(ISOTP& isotp);
+
+    /**
+     * This function is used to unregister an ISOTP object.
+     * @param isotp The ISOTP object to unregister.
+     * @return True if the object was unregistered, false if it was not registered.
+     */
+    bool removeInstance(ISOTP& isotp);
+
+    /**
+     * This function is used to run one step of a worker. Only the ISOTP objects of the worker with pending events or
+     * an expired deadline are run.
+     * @param worker The worker to run.
+     * @return The next timestamp (derived from OSInterface::osMillis()) at which this worker needs to run if no frame
+     * or ACK is received before, 0 if it needs to run as soon as possible (a frame or ACK is pending, or a frame
+     * written is still waiting for its ACK) or ISOTP_NoNextRunTime if nothing is scheduled. The caller can sleep until
+     * the returned timestamp.
+     */
+    uint32_t runStep(uint8_t worker = 0);
+
+    /**
+     * This function is used to get the next deadline of all the workers.
+     * @return The earliest next run time returned by the last runStep of every worker.
+     */
+    [[nodiscard]] uint32_t getNextRunTime() const;
+
+    [[nodiscard]] uint8_t getWorkerCount() const;
+
+    [[nodiscard]] uint32_t getInstanceCount() const;
+
+private:
+    struct Worker
+    {
+        OSInterface_Mutex*  mutex;
+        std::vector<ISOTP*> instances;
+        uint32_t            nextRunTime;
+    };
+
+    [[nodiscard]] bool isRegistered(const ISOTP& isotp) const;
+
+    const char*         tag;
+    OSInterface&        osInterface;
+    OSInterface_Mutex*  registrationMutex; // Taken to add or remove instances.
+    std::vector<Worker> workers;
+};
+
+#endif // ISOTPEXECUTOR_H
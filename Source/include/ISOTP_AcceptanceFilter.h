@@ -0,0 +1,51 @@
+#ifndef ISOTP_ACCEPTANCEFILTER_H
+#define ISOTP_ACCEPTANCEFILTER_H
+
+#include <bitset>
+#include <limits>
+#include <vector>
+
+#include "CANInterface.h"
+
+constexpr uint32_t ISOTP_N_AddressCount = std::numeric_limits<typeof(N_AI::N_TA)>::max() + 1; // Possible N_TA/N_SA.
+constexpr uint32_t ISOTP_NoAcceptanceFilterLimit = UINT32_MAX; // Used when any number of filters can be installed.
+
+// Flat lookup table indexed by an N_TA or N_SA value.
+using ISOTP_N_AddressTable = std::bitset<ISOTP_N_AddressCount>;
+
+/**
+ * ID/mask pair that a CAN controller (or a software pre-filter) can use to drop the frames that an ISOTP object would
+ * discard anyway. A frame passes the filter if its identifier bits selected by mask are equal to the ones of id.
+ */
+struct ISOTP_AcceptanceFilter
+{
+    N_AI id;
+    N_AI mask;
+
+    /**
+     * This function is used to check if a frame identifier passes this filter.
+     * @param identifier The identifier to check.
+     * @return True if the identifier passes this filter, false otherwise.
+     */
+    [[nodiscard]] bool matches(const N_AI identifier) const
+    {
+        return (identifier.N_AI & this->mask.N_AI) == (this->id.N_AI & this->mask.N_AI);
+    }
+};
+
+/**
+ * This function is used to compute a small set of acceptance filters that let through every physical frame addressed
+ * to physicalN_TAs and every functional frame addressed to functionalN_TAs, whatever their N_SA, priority or padding.
+ * The filters are the prime implicants of the accepted (N_TAtype, N_TA) pairs, chosen greedily to cover all of them.
+ * If more than maxFilters are needed, the most similar filters are merged, so the result accepts some extra frames
+ * that the ISOTP object still drops in software.
+ * @param physicalN_TAs The N_TAs accepted for N_TATYPE_5_CAN_CLASSIC_29bit_Physical frames.
+ * @param functionalN_TAs The N_TAs accepted for N_TATYPE_6_CAN_CLASSIC_29bit_Functional frames.
+ * @param maxFilters The maximum number of filters to return, it must be greater than 0.
+ * @return The acceptance filters, empty if no frame is accepted.
+ */
+std::vector<ISOTP_AcceptanceFilter> ISOTP_computeAcceptanceFilters(const ISOTP_N_AddressTable& physicalN_TAs,
+                                                                   const ISOTP_N_AddressTable& functionalN_TAs,
+                                                                   uint32_t maxFilters = ISOTP_NoAcceptanceFilterLimit);
+
+#endif // ISOTP_ACCEPTANCEFILTER_H
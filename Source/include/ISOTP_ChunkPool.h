@@ -0,0 +1,112 @@
+#ifndef ISOTP_CHUNKPOOL_H
+#define ISOTP_CHUNKPOOL_H
+
+#include <cstdint>
+
+#include "OSInterface.h"
+
+constexpr uint32_t ISOTP_DefaultChunkSize     = 256;  // Bytes of payload per chunk of a reassembled message.
+constexpr uint32_t ISOTP_DefaultFreeChunkBytes = 4095; // Free chunks kept for reuse, a message without escape sequence.
+
+/**
+ * Contiguous part of a message, like a struct iovec.
+ */
+struct ISOTP_MessageSegment
+{
+    uint8_t* data;
+    uint32_t length;
+};
+
+/**
+ * View of a message stored in one or more segments, in order. It does not own the segments.
+ */
+struct ISOTP_MessageView
+{
+    const ISOTP_MessageSegment* segments;
+    uint32_t                    segmentCount;
+    uint32_t                    length; // Sum of the lengths of the segments.
+
+    /**
+     * This function is used to copy the message to a contiguous buffer.
+     * @param buffer The buffer to copy the message to.
+     * @param size The size of the buffer.
+     * @return True if the message was copied, false if it does not fit in the buffer.
+     */
+    bool copyTo(uint8_t* buffer, uint32_t size) const;
+};
+
+/**
+ * Pool of fixed-size chunks used to reassemble received messages without a contiguous block per message, so a large
+ * message can be received on a fragmented heap as long as there is enough memory in total.
+ * Chunks are taken from the heap the first time they are needed and kept in a free list when released, so the next
+ * message reuses them right away. The free list is not charged to the memory for runners, so it is capped, the chunks
+ * released beyond the cap are given back to the heap. The rest are given back when the pool is destroyed.
+ */
+class ISOTP_ChunkPool
+{
+public:
+    /**
+     * @param osInterface The OSInterface used to allocate the chunks.
+     * @param chunkSize The size of the chunks, at least the size of a pointer. 0 disables the pool.
+     * @param maxFreeBytes The free list keeps up to the chunks needed to store a message of this length.
+     */
+    ISOTP_ChunkPool(OSInterface& osInterface, uint32_t chunkSize, uint32_t maxFreeBytes = ISOTP_DefaultFreeChunkBytes);
+
+    ~ISOTP_ChunkPool();
+
+    ISOTP_ChunkPool(const ISOTP_ChunkPool&)            = delete;
+    ISOTP_ChunkPool& operator=(const ISOTP_ChunkPool&) = delete;
+
+    /**
+     * This function is used to check if the pool can give chunks.
+     * @return True if the pool has a chunk size and a mutex, false otherwise.
+     */
+    [[nodiscard]] bool isEnabled() const;
+
+    /**
+     * This function is used to get the size of the chunks.
+     * @return The size of the chunks, 0 if the pool is not enabled.
+     */
+    [[nodiscard]] uint32_t getChunkSize() const;
+
+    /**
+     * This function is used to get the number of chunks needed to store a message.
+     * @param length The length of the message.
+     * @return The number of chunks, at least 1.
+     */
+    [[nodiscard]] uint32_t getChunkCount(uint32_t length) const;
+
+    /**
+     * This function is used to take a chunk, from the free list if possible.
+     * @return The chunk, or nullptr if the heap is out of memory.
+     */
+    uint8_t* allocate();
+
+    /**
+     * This function is used to give back a chunk taken with allocate(), it is kept in the free list unless the list is
+     * full, then it is given back to the heap.
+     * @param chunk The chunk, nullptr is ignored.
+     */
+    void release(uint8_t* chunk);
+
+    /**
+     * This function is used to get the number of chunks waiting in the free list.
+     * @return The number of free chunks.
+     */
+    [[nodiscard]] uint32_t getFreeChunkCount() const;
+
+private:
+    struct FreeChunk
+    {
+        FreeChunk* next;
+    };
+
+    OSInterface*       osInterface;
+    OSInterface_Mutex* mutex;
+    uint32_t           chunkSize;
+    FreeChunk*         freeChunks; // Released chunks, linked through their first bytes.
+    uint32_t           freeChunkCount;
+    uint32_t           maxFreeChunks;
+};
+
+#endif // ISOTP_CHUNKPOOL_H
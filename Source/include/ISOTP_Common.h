@@ -5,9 +5,13 @@
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
+#include <atomic>
 #include <cinttypes>
+#include <new>
+#include <type_traits>
 
 constexpr uint32_t ISOTP_MaxTimeToWaitForSync_MS = 100;
+constexpr uint32_t ISOTP_NoNextRunTime           = UINT32_MAX; // Used when there is nothing scheduled to run.
 
 constexpr uint8_t MAX_STMIN_MS_VALUE = 0x7F;
 constexpr uint8_t MIN_STMIN_US_VALUE = 0xF1;
@@ -47,4 +51,71 @@ const char* STminToString(const STmin& stMin);
 
 uint32_t getStMinInMs(STmin stMin);
 
+/**
+ * This function is used to check if a run time has been reached. The timestamps are compared with their signed
+ * difference because OSInterface::osMillis() wraps after about 49 days.
+ * @param now The current timestamp.
+ * @param runTime A timestamp, 0 (as soon as possible) or ISOTP_NoNextRunTime (never).
+ * @return True if runTime is not after now.
+ */
+bool ISOTP_IsRunTimeReached(uint32_t now, uint32_t runTime);
+
+/**
+ * This function is used to get the earliest of two run times, compared like in ISOTP_IsRunTimeReached.
+ * @param a A timestamp, 0 (as soon as possible) or ISOTP_NoNextRunTime (never).
+ * @param b A timestamp, 0 (as soon as possible) or ISOTP_NoNextRunTime (never).
+ * @return The earliest of a and b.
+ */
+uint32_t ISOTP_EarliestRunTime(uint32_t a, uint32_t b);
+
+/**
+ * This function is used to get an object that is only allocated the first time it is needed, without taking a lock.
+ * If several threads allocate it at the same time, the first one to publish it wins and the others delete theirs.
+ * @tparam T The type of the object, it can be an array with a bound (allocated with new[], freed with delete[]).
+ * @param pointer The pointer to the object, nullptr until it is allocated. Its owner deletes the object.
+ * @param allocated If not nullptr, set to true if this call published the object, false otherwise.
+ * @return The object, nullptr if it could not be allocated.
+ */
+template <typename T>
+std::remove_extent_t<T>* ISOTP_LoadOrAllocate(std::atomic<std::remove_extent_t<T>*>& pointer,
+                                              bool*                                    allocated = nullptr)
+{
+    if (allocated != nullptr)
+    {
+        *allocated = false;
+    }
+
+    std::remove_extent_t<T>* object = pointer.load(std::memory_order_acquire);
+    if (object != nullptr)
+    {
+        return object;
+    }
+
+    std::remove_extent_t<T>* newObject = new (std::nothrow) T;
+    if (newObject == nullptr)
+    {
+        return nullptr;
+    }
+
+    if (pointer.compare_exchange_strong(object, newObject, std::memory_order_acq_rel))
+    {
+        if (allocated != nullptr)
+        {
+            *allocated = true;
+        }
+        return newObject;
+    }
+
+    // Another thread allocated the object first, object now points to it.
+    if constexpr (std::is_array_v<T>)
+    {
+        delete[] newObject;
+    }
+    else
+    {
+        delete newObject;
+    }
+    return object;
+}
+
 #endif // ISOTP_COMMON_H
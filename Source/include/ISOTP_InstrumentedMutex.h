@@ -0,0 +1,46 @@
+#ifndef ISOTP_INSTRUMENTEDMUTEX_H
+#define ISOTP_INSTRUMENTEDMUTEX_H
+
+#include "ISOTP_Statistics.h"
+#include "OSInterface.h"
+
+/**
+ * OSInterface_Mutex that counts the acquisitions, contentions, waits and timeouts of the mutex it wraps in an
+ * ISOTP_Statistics. A wait first tries the mutex without blocking, so an uncontended acquisition costs one more virtual
+ * call and a relaxed atomic addition. The clock is only read when the mutex is found taken.
+ */
+class ISOTP_InstrumentedMutex final : public OSInterface_Mutex
+{
+public:
+    constexpr static const char* TAG = "ISOTP-InstrumentedMutex";
+
+    /**
+     * This function is used to wrap a mutex so its acquisitions are counted.
+     * @param mutex The mutex to wrap, it is owned by the returned mutex.
+     * @param lock The counters the acquisitions are added to.
+     * @param osInterface The OSInterface used to measure the waits.
+     * @param statistics The counters, nullptr to not count anything.
+     * @return The wrapper, or mutex itself if mutex or statistics is nullptr or if the wrapper could not be allocated.
+     */
+    static OSInterface_Mutex* wrap(OSInterface_Mutex* mutex, ISOTP_Lock lock, OSInterface& osInterface,
+                                   ISOTP_Statistics* statistics);
+
+    ~ISOTP_InstrumentedMutex() override;
+
+    ISOTP_InstrumentedMutex(const ISOTP_InstrumentedMutex&)            = delete;
+    ISOTP_InstrumentedMutex& operator=(const ISOTP_InstrumentedMutex&) = delete;
+
+    bool signal() override;
+    bool wait(uint32_t max_time_to_wait_ms) override;
+
+private:
+    ISOTP_InstrumentedMutex(OSInterface_Mutex* mutex, ISOTP_Lock lock, OSInterface& osInterface,
+                            ISOTP_Statistics& statistics);
+
+    OSInterface_Mutex* mutex;
+    ISOTP_Lock         lock;
+    OSInterface&       osInterface;
+    ISOTP_Statistics&  statistics;
+};
+
+#endif // ISOTP_INSTRUMENTEDMUTEX_H
@@ -0,0 +1,101 @@
+#ifndef ISOTP_LATENCYHISTOGRAM_H
+#define ISOTP_LATENCYHISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Values below ISOTP_LatencyHistogramLinearBuckets ms have one bucket each. Above, each power of two is split in
+// ISOTP_LatencyHistogramSubBuckets buckets, so a bucket is at most 25% wide. Values past the last power of two (about
+// 17 minutes) are counted in the last bucket.
+constexpr uint32_t ISOTP_LatencyHistogramLinearBuckets = 8;  // Power of two.
+constexpr uint32_t ISOTP_LatencyHistogramSubBuckets    = 4;  // Power of two, not above the linear buckets.
+constexpr uint32_t ISOTP_LatencyHistogramPowers        = 17; // Powers of two split in sub-buckets.
+constexpr uint32_t ISOTP_LatencyHistogramBucketCount =
+    ISOTP_LatencyHistogramLinearBuckets + ISOTP_LatencyHistogramPowers * ISOTP_LatencyHistogramSubBuckets;
+
+/**
+ * Copy of an ISOTP_LatencyHistogram. The counters wrap around.
+ */
+struct ISOTP_LatencyHistogramSnapshot
+{
+    uint32_t buckets[ISOTP_LatencyHistogramBucketCount];
+    uint32_t count;  // Values recorded.
+    uint32_t sum_ms; // Sum of the values recorded.
+    uint32_t max_ms; // Largest value recorded.
+
+    /**
+     * This function is used to get a percentile of the values recorded.
+     * @param percent The percentile, from 0 to 100.
+     * @return The upper bound of the bucket the percentile falls in (capped to max_ms), 0 if there are no values.
+     */
+    [[nodiscard]] uint32_t getPercentile(uint8_t percent) const;
+
+    /**
+     * This function is used to export the histogram as text, one "lower-upper ms: count" line per bucket that is not
+     * empty, followed by the count, sum and max.
+     * @param buffer The buffer to write to, it is always null terminated if size is not 0.
+     * @param size The size of the buffer.
+     * @return The length of the whole text (like snprintf), so a return value of size or more means it was truncated.
+     */
+    size_t print(char* buffer, size_t size) const;
+};
+
+/**
+ * Fixed-bucket log-linear histogram of durations in ms. Recording is a few relaxed atomic additions, without locks nor
+ * allocations, so it can be done on every frame.
+ */
+class ISOTP_LatencyHistogram
+{
+public:
+    ISOTP_LatencyHistogram() = default;
+
+    ISOTP_LatencyHistogram(const ISOTP_LatencyHistogram&)            = delete;
+    ISOTP_LatencyHistogram& operator=(const ISOTP_LatencyHistogram&) = delete;
+
+    /**
+     * This function is used to record a duration.
+     * @param value_ms The duration in ms.
+     */
+    void record(uint32_t value_ms);
+
+    /**
+     * This function is used to clear the histogram. Values recorded at the same time may be kept or lost.
+     */
+    void reset();
+
+    /**
+     * This function is used to copy the histogram.
+     * @return The buckets and totals.
+     */
+    [[nodiscard]] ISOTP_LatencyHistogramSnapshot getSnapshot() const;
+
+    /**
+     * This function is used to get the bucket that counts a duration.
+     * @param value_ms The duration in ms.
+     * @return The index of the bucket.
+     */
+    [[nodiscard]] static uint32_t getBucketIndex(uint32_t value_ms);
+
+    /**
+     * This function is used to get the smallest duration counted in a bucket.
+     * @param index The index of the bucket.
+     * @return The duration in ms.
+     */
+    [[nodiscard]] static uint32_t getBucketLowerBound(uint32_t index);
+
+    /**
+     * This function is used to get the largest duration counted in a bucket.
+     * @param index The index of the bucket.
+     * @return The duration in ms, UINT32_MAX for the last bucket.
+     */
+    [[nodiscard]] static uint32_t getBucketUpperBound(uint32_t index);
+
+private:
+    std::atomic<uint32_t> buckets[ISOTP_LatencyHistogramBucketCount]{};
+    std::atomic<uint32_t> count{0};
+    std::atomic<uint32_t> sum{0};
+    std::atomic<uint32_t> max{0};
+};
+
+#endif // ISOTP_LATENCYHISTOGRAM_H
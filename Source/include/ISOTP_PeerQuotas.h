@@ -0,0 +1,100 @@
+#ifndef ISOTP_PEERQUOTAS_H
+#define ISOTP_PEERQUOTAS_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "ISOTP_AcceptanceFilter.h"
+
+/**
+ * Limits on the resources that a remote N_SA can take when sending segmented messages to an ISOTP object.
+ */
+struct ISOTP_PeerQuota
+{
+    int64_t  maxMemory;      // Bytes of the messages being received from the peer at the same time.
+    int64_t  reservedMemory; // Bytes of the memory for runners that the other peers can not take.
+    uint32_t maxReceptions;  // Messages being received from the peer at the same time (at most one per N_AI).
+};
+
+constexpr ISOTP_PeerQuota ISOTP_DefaultPeerQuota = {INT64_MAX, 0, UINT32_MAX}; // Only the global limit applies.
+
+/**
+ * Per N_SA quotas of the memory for runners, checked when an FF is received.
+ * The memory for runners of the ISOTP object is the global cap. On top of it, each peer can have its own cap, a
+ * maximum number of simultaneous receptions and a reserved amount that is kept free for it, so a peer that sends large
+ * messages can not starve the others.
+ * The quotas are only counters updated with atomic operations, so admission does not take any lock. It is exact as long
+ * as the receptions are admitted from one thread at a time, which is what ISOTP does.
+ * The table of peers is only allocated when the first quota is set, so objects without quotas do not pay for it.
+ */
+class ISOTP_PeerQuotas
+{
+public:
+    ISOTP_PeerQuotas() = default;
+
+    ~ISOTP_PeerQuotas();
+
+    ISOTP_PeerQuotas(const ISOTP_PeerQuotas&)            = delete;
+    ISOTP_PeerQuotas& operator=(const ISOTP_PeerQuotas&) = delete;
+
+    /**
+     * This function is used to set the quota of a peer.
+     * @note Changing the reserved memory of a peer while it is sending messages is allowed, but the reserve is only
+     * exact if the peer is idle.
+     * @param nSa The N_SA of the peer.
+     * @param quota The quota of the peer.
+     * @return True if the quota was set, false if the table of peers could not be allocated.
+     */
+    bool setQuota(typeof(N_AI::N_SA) nSa, const ISOTP_PeerQuota& quota);
+
+    /**
+     * This function is used to get the quota of a peer.
+     * @param nSa The N_SA of the peer.
+     * @return The quota of the peer, ISOTP_DefaultPeerQuota if none was set.
+     */
+    [[nodiscard]] ISOTP_PeerQuota getQuota(typeof(N_AI::N_SA) nSa) const;
+
+    /**
+     * This function is used to admit a message from a peer, charging it to the quota of the peer.
+     * @param nSa The N_SA of the peer.
+     * @param length The length of the message.
+     * @param availableMemory The memory for runners that is currently available.
+     * @param charged Set to true if the message was charged to the peer and must be given back with release(). It is
+     * false when no quota has been set yet.
+     * @return True if the message fits in the quota of the peer without taking the memory reserved for other peers,
+     * false otherwise.
+     */
+    bool admit(typeof(N_AI::N_SA) nSa, int64_t length, int64_t availableMemory, bool& charged);
+
+    /**
+     * This function is used to give back a message charged by admit().
+     * @param nSa The N_SA of the peer.
+     * @param length The length of the message.
+     */
+    void release(typeof(N_AI::N_SA) nSa, int64_t length);
+
+    /**
+     * This function is used to get the memory that a peer is using.
+     * @param nSa The N_SA of the peer.
+     * @return The length of the messages admitted from the peer and not released yet.
+     */
+    [[nodiscard]] int64_t getUsedMemory(typeof(N_AI::N_SA) nSa) const;
+
+private:
+    struct Peer
+    {
+        std::atomic<int64_t>  maxMemory{ISOTP_DefaultPeerQuota.maxMemory};
+        std::atomic<int64_t>  reservedMemory{ISOTP_DefaultPeerQuota.reservedMemory};
+        std::atomic<int64_t>  usedMemory{0};
+        std::atomic<uint32_t> maxReceptions{ISOTP_DefaultPeerQuota.maxReceptions};
+        std::atomic<uint32_t> receptions{0};
+    };
+
+    // Part of the reserve of a peer that it is not using.
+    static int64_t getUnusedReserve(int64_t reservedMemory, int64_t usedMemory);
+
+    std::atomic<Peer*>   peers{nullptr}; // Indexed by N_SA. Allocated once, by the first setQuota.
+    std::atomic<int64_t> unusedReservedMemory{0};
+};
+
+#endif // ISOTP_PEERQUOTAS_H
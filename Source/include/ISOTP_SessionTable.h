@@ -0,0 +1,101 @@
+#ifndef ISOTP_SESSIONTABLE_H
+#define ISOTP_SESSIONTABLE_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "CANInterface.h"
+#include "ISOTP_Common.h"
+#include "ISOTP_Statistics.h"
+#include "N_USData_Runner.h"
+#include "Timer_N.h"
+
+constexpr uint32_t ISOTP_SessionTableSize = 64; // Sessions listed in an ISOTP_SessionSnapshot.
+
+using ISOTP_SessionState = enum ISOTP_SessionState {
+    ISOTP_SessionPending,  // Request queued behind another message with the same N_AI.
+    ISOTP_SessionActive,   // Frames are being exchanged.
+    ISOTP_SessionFinishing // All the data is sent or received, the last ACK or runStep is awaited.
+};
+
+const char* ISOTP_SessionStateToString(ISOTP_SessionState state);
+
+/**
+ * State of one message being sent or received.
+ */
+struct ISOTP_SessionInfo
+{
+    N_AI                        nAi;
+    N_USData_Runner::RunnerType direction; // RunnerRequestType or RunnerIndicationType.
+    ISOTP_SessionState          state;
+    const char*                 internalStatus;   // Name of the internalStatus of the runner, it is a static string.
+    uint32_t                    bytesTransferred; // Bytes of the message sent or received so far.
+    uint32_t                    messageLength;
+    uint8_t                     blockSize;        // BS of the FC sent or received, 0 if there is no FC yet.
+    STmin                       stMin;            // STmin of the FC sent or received.
+    ISOTP_TimingPhase           armedTimer;       // Timer with the nearest deadline, ISOTP_TimingPhaseCount if none.
+    int32_t                     remainingTime_ms; // Until the deadline of armedTimer, negative if it is already late.
+    uint32_t                    pendingACKs;      // Frames of the session waiting for their ACK.
+
+    /**
+     * This function is used to set armedTimer to a timer if it is running and its deadline is nearer than the one of
+     * the current armedTimer.
+     * @param phase The phase the timer measures.
+     * @param timer The timer.
+     * @param timeout_ms The timeout of the timer.
+     * @param now The current timestamp, derived from OSInterface::osMillis().
+     */
+    void armTimer(ISOTP_TimingPhase phase, const Timer_N& timer, uint32_t timeout_ms, uint32_t now);
+};
+
+/**
+ * Sessions of an ISOTP object at the end of one of its runSteps, see ISOTP::getSessions().
+ */
+struct ISOTP_SessionSnapshot
+{
+    uint32_t          timestamp;     // lastRunTime of the runStep that published it.
+    uint32_t          totalSessions; // Sessions at that time, more than sessionCount if the table was full.
+    uint32_t          sessionCount;  // Valid entries of sessions.
+    ISOTP_SessionInfo sessions[ISOTP_SessionTableSize];
+};
+
+/**
+ * Table of the sessions published by the runStep and read by any other thread without locking, using a sequence lock:
+ * the writer makes the sequence odd while it copies, and a reader retries if the sequence was odd or changed while it
+ * copied. The table is stored as relaxed atomic words, so the copies are not data races.
+ * @note Only one thread can publish at the same time.
+ */
+class ISOTP_SessionTable
+{
+public:
+    ISOTP_SessionTable() = default;
+
+    ISOTP_SessionTable(const ISOTP_SessionTable&)            = delete;
+    ISOTP_SessionTable& operator=(const ISOTP_SessionTable&) = delete;
+
+    /**
+     * This function is used to replace the table.
+     * @param sessions The sessions, only the first ISOTP_SessionTableSize are copied.
+     * @param totalSessions The number of sessions.
+     * @param timestamp The timestamp of the table, derived from OSInterface::osMillis().
+     */
+    void publish(const ISOTP_SessionInfo* sessions, uint32_t totalSessions, uint32_t timestamp);
+
+    /**
+     * This function is used to copy the table. It never blocks, it gives up if every try overlaps a publish.
+     * @param snapshot Set to the table, only the first sessionCount sessions are written.
+     * @return True if the table was copied, false if it was never published or kept changing.
+     */
+    bool read(ISOTP_SessionSnapshot& snapshot) const;
+
+private:
+    constexpr static uint32_t ReadTries    = 8;
+    constexpr static uint32_t SessionWords = sizeof(ISOTP_SessionInfo) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> sequence{0}; // Odd while a publish is in progress, 0 until the first publish.
+    std::atomic<uint32_t> timestamp{0};
+    std::atomic<uint32_t> totalSessions{0};
+    std::atomic<uint32_t> sessions[ISOTP_SessionTableSize * SessionWords]{};
+};
+
+#endif // ISOTP_SESSIONTABLE_H
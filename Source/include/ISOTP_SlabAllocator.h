@@ -0,0 +1,106 @@
+#ifndef ISOTP_SLABALLOCATOR_H
+#define ISOTP_SLABALLOCATOR_H
+
+#include <cstdint>
+
+#include "OSInterface.h"
+
+/**
+ * Allocator for the payloads of the runners of an ISOTP object. It takes one region from the heap when it is created
+ * and serves blocks of power-of-two size classes from it, so mixed message sizes do not fragment the heap.
+ * Blocks are split in halves to serve smaller classes and merged back with their other half (their buddy) when both
+ * are free, so a released block is available for any class again. Allocating and releasing take a bounded number of
+ * steps (one per size class).
+ * The blocks are never larger than the largest power of two that fits in the region (getLargestBlockSize), and a
+ * region split for smaller blocks can have enough free memory in total for a block but no free block of its class, so
+ * an allocation can fail before getUsedMemory() reaches the capacity.
+ * Besides the region, it uses one byte per MinBlockSize bytes to track the blocks.
+ */
+class ISOTP_SlabAllocator
+{
+public:
+    constexpr static uint32_t MinBlockSize = 16; // Smallest size class. A free block holds the links of its list.
+
+    /**
+     * @param osInterface The OSInterface used to allocate the region.
+     * @param regionSize The size of the region, rounded down to a multiple of MinBlockSize. 0 disables the allocator.
+     */
+    ISOTP_SlabAllocator(OSInterface& osInterface, uint32_t regionSize);
+
+    ~ISOTP_SlabAllocator();
+
+    ISOTP_SlabAllocator(const ISOTP_SlabAllocator&)            = delete;
+    ISOTP_SlabAllocator& operator=(const ISOTP_SlabAllocator&) = delete;
+
+    /**
+     * This function is used to check if the allocator has a region to allocate from.
+     * @return True if the region was allocated, false if the allocator is disabled or the region could not be
+     * allocated.
+     */
+    [[nodiscard]] bool isEnabled() const;
+
+    /**
+     * This function is used to get the size of the region.
+     * @return The bytes that can be allocated, 0 if the allocator is not enabled.
+     */
+    [[nodiscard]] uint32_t getCapacity() const;
+
+    /**
+     * This function is used to get the size of the largest block, which bounds the size of an allocation.
+     * @return The largest power of two not above the capacity, 0 if the allocator is not enabled.
+     */
+    [[nodiscard]] uint32_t getLargestBlockSize() const;
+
+    /**
+     * This function is used to get the size class that serves an allocation.
+     * @param size The size of the allocation.
+     * @return The size of the block that allocate(size) takes from the region.
+     */
+    [[nodiscard]] static int64_t getBlockSize(uint32_t size);
+
+    /**
+     * This function is used to allocate a block.
+     * @param size The size of the block.
+     * @return The block, or nullptr if its size class is larger than getLargestBlockSize() or no free block of its
+     * size class is left.
+     */
+    void* allocate(uint32_t size);
+
+    /**
+     * This function is used to give back a block taken with allocate().
+     * @param block The block, nullptr is ignored.
+     */
+    void release(void* block);
+
+    /**
+     * This function is used to get the memory taken by the allocated blocks.
+     * @return The sum of the sizes of the allocated blocks.
+     */
+    [[nodiscard]] uint32_t getUsedMemory() const;
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* previous;
+        FreeBlock* next;
+    };
+
+    constexpr static uint8_t OrderCount = 28;   // Size classes from MinBlockSize to MinBlockSize << (OrderCount - 1).
+    constexpr static uint8_t FreeFlag   = 0x80; // Set in the blockInfo of free blocks.
+
+    [[nodiscard]] uint32_t getOffset(const void* block) const;
+    void                   pushFreeBlock(uint32_t offset, uint8_t order);
+    void                   removeFreeBlock(uint32_t offset, uint8_t order);
+
+    OSInterface*       osInterface;
+    OSInterface_Mutex* mutex;
+    uint8_t*           region;
+    uint32_t           capacity;
+    uint32_t           usedMemory;
+    FreeBlock*         freeLists[OrderCount]{}; // Free blocks of each order.
+    // One byte per MinBlockSize unit of the region: 0 if no block starts there, the order of the block plus 1 (with
+    // FreeFlag if it is free) otherwise.
+    uint8_t* blockInfo;
+};
+
+#endif // ISOTP_SLABALLOCATOR_H
@@ -0,0 +1,354 @@
+#ifndef ISOTP_STATISTICS_H
+#define ISOTP_STATISTICS_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "CANInterface.h"
+#include "ISOTP_AcceptanceFilter.h"
+#include "ISOTP_Common.h"
+#include "ISOTP_LatencyHistogram.h"
+
+constexpr uint8_t ISOTP_N_ResultCount = N_ERROR + 1; // Size of the arrays indexed by N_Result.
+
+// Durations recorded in the latency histograms. The N_ ones are measured with the timers of the runners (see ISO
+// 15765-2), so the histograms of both sides tell which one makes a transfer slow.
+using ISOTP_TimingPhase = enum ISOTP_TimingPhase {
+    ISOTP_N_AsPhase,       // Frame written by a request until its ACK.
+    ISOTP_N_BsPhase,       // FF or last CF of a block ACKed until the FC is received.
+    ISOTP_N_CsPhase,       // FC received or CF ACKed until the next CF is written (CF spacing).
+    ISOTP_N_ArPhase,       // FC written by an indication until its ACK.
+    ISOTP_N_BrPhase,       // FF or last CF of a block received until the FC is written.
+    ISOTP_N_CrPhase,       // FC ACKed or CF received until the next CF is received.
+    ISOTP_RequestPhase,    // N_USData_request until N_USData_confirm_cb.
+    ISOTP_IndicationPhase, // FF received until the indication callback.
+    ISOTP_TimingPhaseCount
+};
+
+const char* ISOTP_TimingPhaseToString(ISOTP_TimingPhase phase);
+
+// Mutexes whose acquisitions are counted, see ISOTP_InstrumentedMutex.
+using ISOTP_Lock = enum ISOTP_Lock {
+    ISOTP_ConfigLock,            // ISOTP::configMutex.
+    ISOTP_NotStartedRunnersLock, // ISOTP::notStartedRunnersMutex.
+    ISOTP_RunnersLock,           // ISOTP::runnersMutex.
+    ISOTP_ACKQueueLock,          // Mutex of the CANMessageACKQueue.
+    ISOTP_RunnerLock,            // Mutexes of the ThreadSafeRunner runners, added together.
+    ISOTP_LockCount
+};
+
+const char* ISOTP_LockToString(ISOTP_Lock lock);
+
+// Parts of ISOTP::runStep and ISOTP::canMessageACKQueueRunStep whose durations are recorded.
+using ISOTP_RunStepPhase = enum ISOTP_RunStepPhase {
+    ISOTP_StartRunnersStep, // Queued requests moved to the active runners, waits for the locks included.
+    ISOTP_GetFrameStep,     // Frame read and filtered.
+    ISOTP_RunRunnersStep,   // Active runners run and runner created for the frame, wait for runnersMutex included.
+    ISOTP_CallbacksStep,    // ACK callbacks, direct SFs and callbacks of the finished runners.
+    ISOTP_RunStepTotal,     // Whole runStep, when it is not skipped by ISOTP_RunPeriod_MS.
+    ISOTP_ACKQueueRunStep,  // Whole canMessageACKQueueRunStep, when it is not skipped.
+    ISOTP_RunStepPhaseCount
+};
+
+const char* ISOTP_RunStepPhaseToString(ISOTP_RunStepPhase phase);
+
+/**
+ * Traffic exchanged with one remote N_SA, or with all of them. The counters wrap around.
+ */
+struct ISOTP_PeerStatistics
+{
+    uint32_t framesTx;
+    uint32_t framesRx;
+    uint32_t bytesTx;           // Data bytes of the frames, N_PCI included.
+    uint32_t bytesRx;
+    uint32_t sessionsStarted;   // Requests queued and receptions started (SF or FF).
+    uint32_t sessionsCompleted; // Sessions finished with N_OK.
+    uint32_t sessionsFailed;    // Sessions finished with any other N_Result.
+};
+
+/**
+ * Copy of the counters of an ISOTP object, see ISOTP::getStatistics(). The counters wrap around.
+ */
+struct ISOTP_StatisticsSnapshot
+{
+    ISOTP_PeerStatistics total;
+    uint32_t             requestResults[ISOTP_N_ResultCount];    // Finished requests by N_Result.
+    uint32_t             indicationResults[ISOTP_N_ResultCount]; // Finished receptions by N_Result.
+    uint32_t             heldFrames;                             // Frames received while waiting for an ACK.
+    uint32_t             overflowFCsSent;                        // Receptions refused for memory or quota.
+    uint32_t             N_CsPerformanceMisses;                  // CFs sent more than N_Cs late.
+    uint32_t             N_BrPerformanceMisses;                  // FCs sent more than N_Br late.
+    int64_t              memoryForRunnersHighWater;              // Most memory for runners in use.
+    uint32_t             ackQueueDepthHighWater;                 // Most frames waiting for an ACK.
+};
+
+/**
+ * Acquisitions of one ISOTP_Lock. The counters wrap around.
+ */
+struct ISOTP_LockStatistics
+{
+    uint32_t                       acquisitions;          // Successful waits.
+    uint32_t                       contendedAcquisitions; // Successful waits that found the mutex taken.
+    uint32_t                       timeouts;              // Waits that gave up, failed tries (timeout 0) included.
+    ISOTP_LatencyHistogramSnapshot waits;                 // Time spent waiting, by contended acquisitions and timeouts.
+};
+
+/**
+ * Counters of the protocol events of an ISOTP object. They are relaxed atomics updated where the events happen, so
+ * they do not take any lock and can be left enabled in production. A snapshot is not taken atomically as a whole, each
+ * counter is only consistent with itself.
+ * The counters of each peer are only kept once enablePeerStatistics is called, as their table takes
+ * getPeerTableSize() bytes. Until then, only the totals are counted. Functional requests have no single peer, they are
+ * only counted in the totals.
+ * The latency histograms of each phase are always recorded for all the peers together. Those of a single peer are only
+ * recorded once enabled, as each peer takes ISOTP_TimingPhaseCount more histograms.
+ * The mutexes of the object are counted through ISOTP_InstrumentedMutex. Once enabled, the parts of the runStep are
+ * timed with OSInterface::osMillis(), so anything shorter than 1 ms is recorded as 0 ms.
+ */
+class ISOTP_Statistics
+{
+public:
+    static constexpr uint32_t NoPeer = ISOTP_N_AddressCount; // Peer of a functional request, only counted in totals.
+
+    ISOTP_Statistics() = default;
+
+    ~ISOTP_Statistics();
+
+    ISOTP_Statistics(const ISOTP_Statistics&)            = delete;
+    ISOTP_Statistics& operator=(const ISOTP_Statistics&) = delete;
+
+    /**
+     * This function is used to get the peer that a frame or a request is sent to.
+     * @param nAi The N_AI of the frame or the request.
+     * @return Its N_TA if it is physical, NoPeer if it is functional.
+     */
+    static uint32_t getTargetPeer(N_AI nAi);
+
+    /**
+     * This function is used to count a frame written to the CAN bus.
+     * @param frame The frame, its N_TA is the peer if it is physical.
+     */
+    void onFrameWritten(const CANFrame& frame);
+
+    /**
+     * This function is used to count a frame received from the CAN bus for this object.
+     * @param frame The frame, its N_SA is the peer.
+     */
+    void onFrameReceived(const CANFrame& frame);
+
+    /**
+     * This function is used to count the start of a session.
+     * @param peer The remote N_SA of the session, or NoPeer.
+     */
+    void onSessionStarted(uint32_t peer);
+
+    /**
+     * This function is used to count the end of a request.
+     * @param peer The remote N_SA the message was sent to, or NoPeer.
+     * @param result The result given to N_USData_confirm_cb.
+     */
+    void onRequestFinished(uint32_t peer, N_Result result);
+
+    /**
+     * This function is used to count the end of a reception.
+     * @param peer The remote N_SA the message was received from.
+     * @param result The result given to the indication callback.
+     */
+    void onIndicationFinished(uint32_t peer, N_Result result);
+
+    void onFrameHeld();
+    void onOverflowFCSent();
+    void onN_CsPerformanceMiss();
+    void onN_BrPerformanceMiss();
+
+    /**
+     * This function is used to set the memory for runners that the memory in use is computed from.
+     * @param memoryForRunners The total memory for runners.
+     */
+    void setMemoryForRunners(int64_t memoryForRunners);
+
+    /**
+     * This function is used to update the high-water of the memory for runners.
+     * @param availableMemory The memory for runners that is currently available.
+     */
+    void recordAvailableMemory(int64_t availableMemory);
+
+    /**
+     * This function is used to update the high-water of the frames waiting for their ACK.
+     * @param depth The frames currently waiting for their ACK.
+     */
+    void recordACKQueueDepth(uint32_t depth);
+
+    /**
+     * This function is used to record the duration of a phase in its histogram, and in the one of the peer if enabled.
+     * @param phase The phase.
+     * @param peer The remote N_SA of the session, or NoPeer.
+     * @param elapsed_ms The duration in ms.
+     */
+    void recordLatency(ISOTP_TimingPhase phase, uint32_t peer, uint32_t elapsed_ms);
+
+    /**
+     * This function is used to count the acquisition of a mutex.
+     * @param lock The mutex.
+     * @param contended True if the mutex was taken when the wait started.
+     * @param wait_ms The time waited for the mutex, only recorded if contended.
+     */
+    void onLockAcquired(ISOTP_Lock lock, bool contended, uint32_t wait_ms);
+
+    /**
+     * This function is used to count a wait for a mutex that timed out.
+     * @param lock The mutex.
+     * @param wait_ms The time waited for the mutex.
+     */
+    void onLockTimeout(ISOTP_Lock lock, uint32_t wait_ms);
+
+    /**
+     * This function is used to record the duration of a part of the runStep.
+     * @param phase The part of the runStep.
+     * @param elapsed_ms The duration in ms.
+     */
+    void recordRunStepDuration(ISOTP_RunStepPhase phase, uint32_t elapsed_ms);
+
+    /**
+     * This function is used to select if the parts of the runStep are timed. It is disabled by default.
+     * @param enabled True to time them, false otherwise.
+     */
+    void setRunStepTimingEnabled(bool enabled);
+
+    /**
+     * This function is used to check if the parts of the runStep are timed.
+     * @return True if recordRunStepDuration needs to be called, false otherwise.
+     */
+    [[nodiscard]] bool isRunStepTimingEnabled() const;
+
+    /**
+     * This function is used to get the memory taken by the counters of the peers.
+     * @return The size of the table allocated by enablePeerStatistics.
+     */
+    static int64_t getPeerTableSize();
+
+    /**
+     * This function is used to start counting the events of each peer. They can not be disabled. The table is taken out
+     * of the memory for runners given to setMemoryForRunners, so the high-water only counts the runners.
+     * @return True if the counters of the peers are enabled, false if the table could not be allocated.
+     */
+    bool enablePeerStatistics();
+
+    /**
+     * This function is used to check if the events of each peer are counted.
+     * @return True if enablePeerStatistics succeeded, false otherwise.
+     */
+    [[nodiscard]] bool arePeerStatisticsEnabled() const;
+
+    /**
+     * This function is used to start recording the latency histograms of a peer. They can not be disabled, only reset.
+     * @param peer The remote N_SA.
+     * @return True if the histograms are enabled, false if they could not be allocated or the counters of the peers are
+     * not enabled.
+     */
+    bool enablePeerLatencyHistograms(typeof(N_AI::N_SA) peer);
+
+    /**
+     * This function is used to clear the latency histograms, the ones of the peers and of the runStep included.
+     */
+    void resetLatencyHistograms();
+
+    /**
+     * This function is used to copy the counters.
+     * @return The counters.
+     */
+    [[nodiscard]] ISOTP_StatisticsSnapshot getSnapshot() const;
+
+    /**
+     * This function is used to copy the counters of a peer.
+     * @param peer The remote N_SA.
+     * @return The counters of the peer, all 0 if it never exchanged anything with this object or the counters of the
+     * peers are not enabled.
+     */
+    [[nodiscard]] ISOTP_PeerStatistics getPeerStatistics(typeof(N_AI::N_SA) peer) const;
+
+    /**
+     * This function is used to copy the latency histogram of a phase.
+     * @param phase The phase.
+     * @return The histogram of the phase for all the peers.
+     */
+    [[nodiscard]] ISOTP_LatencyHistogramSnapshot getLatencyHistogram(ISOTP_TimingPhase phase) const;
+
+    /**
+     * This function is used to copy the latency histogram of a phase for one peer.
+     * @param peer The remote N_SA.
+     * @param phase The phase.
+     * @param histogram Set to the histogram of the peer.
+     * @return True if the histograms of the peer are enabled, false otherwise.
+     */
+    bool getPeerLatencyHistogram(typeof(N_AI::N_SA) peer, ISOTP_TimingPhase phase,
+                                 ISOTP_LatencyHistogramSnapshot& histogram) const;
+
+    /**
+     * This function is used to copy the counters of a mutex.
+     * @param lock The mutex.
+     * @return The acquisitions, timeouts and waits of the mutex.
+     */
+    [[nodiscard]] ISOTP_LockStatistics getLockStatistics(ISOTP_Lock lock) const;
+
+    /**
+     * This function is used to copy the histogram of the durations of a part of the runStep.
+     * @param phase The part of the runStep.
+     * @return The histogram.
+     */
+    [[nodiscard]] ISOTP_LatencyHistogramSnapshot getRunStepHistogram(ISOTP_RunStepPhase phase) const;
+
+private:
+    struct PeerHistograms
+    {
+        ISOTP_LatencyHistogram phases[ISOTP_TimingPhaseCount];
+    };
+
+    struct PeerCounters
+    {
+        std::atomic<uint32_t> framesTx{0};
+        std::atomic<uint32_t> framesRx{0};
+        std::atomic<uint32_t> bytesTx{0};
+        std::atomic<uint32_t> bytesRx{0};
+        std::atomic<uint32_t> sessionsStarted{0};
+        std::atomic<uint32_t> sessionsCompleted{0};
+        std::atomic<uint32_t> sessionsFailed{0};
+
+        std::atomic<PeerHistograms*> histograms{nullptr}; // Allocated once, by enablePeerLatencyHistograms.
+    };
+
+    struct LockCounters
+    {
+        std::atomic<uint32_t>  acquisitions{0};
+        std::atomic<uint32_t>  contendedAcquisitions{0};
+        std::atomic<uint32_t>  timeouts{0};
+        ISOTP_LatencyHistogram waits;
+    };
+
+    static void                 increment(std::atomic<uint32_t>& counter, uint32_t amount = 1);
+    static void                 raise(std::atomic<int64_t>& highWater, int64_t value);
+    static ISOTP_PeerStatistics load(const PeerCounters& counters);
+
+    // Counters of a peer, nullptr if the counters of the peers are not enabled or peer is NoPeer.
+    [[nodiscard]] PeerCounters* getPeer(uint32_t peer) const;
+    // Histograms of a peer, nullptr if they are not enabled.
+    [[nodiscard]] PeerHistograms* getPeerHistograms(uint32_t peer) const;
+
+    PeerCounters               total;
+    std::atomic<PeerCounters*> peers{nullptr}; // Indexed by N_SA. Allocated once, by enablePeerStatistics.
+    std::atomic<uint32_t>      requestResults[ISOTP_N_ResultCount]{};
+    std::atomic<uint32_t>      indicationResults[ISOTP_N_ResultCount]{};
+    std::atomic<uint32_t>      heldFrames{0};
+    std::atomic<uint32_t>      overflowFCsSent{0};
+    std::atomic<uint32_t>      N_CsPerformanceMisses{0};
+    std::atomic<uint32_t>      N_BrPerformanceMisses{0};
+    std::atomic<int64_t>       memoryForRunners{0};
+    std::atomic<int64_t>       memoryHighWater{0};
+    std::atomic<int64_t>       ackQueueDepthHighWater{0};
+    ISOTP_LatencyHistogram     latencies[ISOTP_TimingPhaseCount];
+    LockCounters               locks[ISOTP_LockCount];
+    ISOTP_LatencyHistogram     runStepDurations[ISOTP_RunStepPhaseCount];
+    std::atomic<bool>          runStepTimingEnabled{false};
+};
+
+#endif // ISOTP_STATISTICS_H
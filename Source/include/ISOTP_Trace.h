@@ -0,0 +1,237 @@
+#ifndef ISOTP_TRACE_H
+#define ISOTP_TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "CANInterface.h"
+#include "OSInterface.h"
+
+constexpr uint32_t ISOTP_DefaultTraceCapacity = 4096; // Records, about 100 KiB.
+constexpr uint32_t ISOTP_TraceRecordSize      = 20;   // Bytes of an encoded record.
+constexpr uint32_t ISOTP_TraceHeaderSize      = 16;   // Bytes of the header of a binary trace.
+constexpr uint16_t ISOTP_TraceVersion         = 1;
+
+using ISOTP_TraceEvent = enum ISOTP_TraceEvent {
+    ISOTP_TraceFrameRead,      // Frame read from the CANInterface or pushed with onFrameReceived, before filtering.
+    ISOTP_TraceFrameWritten,   // Frame accepted by CANInterface::writeFrame.
+    ISOTP_TraceWriteFailed,    // Frame refused by CANInterface::writeFrame.
+    ISOTP_TraceACK,            // ACK of the oldest written frame without one, canId is the one of that frame.
+    ISOTP_TraceRecordsDropped, // Added by ISOTP_TraceWriter, canId holds the records lost since the previous one.
+    ISOTP_TraceEventCount
+};
+
+const char* ISOTP_TraceEventToString(ISOTP_TraceEvent event);
+
+/**
+ * One captured frame or ACK.
+ */
+struct ISOTP_TraceRecord
+{
+    uint32_t timestamp_ms;           // Derived from OSInterface::osMillis().
+    uint32_t canId;                  // 29 bit identifier of the frame.
+    uint8_t  event;                  // ISOTP_TraceEvent.
+    uint8_t  ack;                    // ACKResult of ISOTP_TraceACK records, ACK_NONE otherwise.
+    uint8_t  dlc;                    // 0 for the records without a frame.
+    uint8_t  reserved;
+    uint8_t  data[CAN_FRAME_MAX_DLC]; // Only the first dlc bytes are meaningful.
+};
+
+/**
+ * This function is used to build the 29 bit CAN identifier of a frame that uses normal fixed addressing.
+ * @param nAi The N_AI of the frame.
+ * @return The identifier, as written on the bus.
+ */
+uint32_t ISOTP_GetCANId(N_AI nAi);
+
+/**
+ * This function is used to split a 29 bit CAN identifier into the N_AI of normal fixed addressing.
+ * @param canId The identifier, as written on the bus.
+ * @return The N_AI of the frame.
+ */
+N_AI ISOTP_GetN_AI(uint32_t canId);
+
+/**
+ * Fixed size ring of trace records, filled by the ISOTP objects and CANMessageACKQueues it is given to and emptied by
+ * an ISOTP_TraceWriter. Recording does not lock nor allocate: it reserves a slot with a compare and swap and publishes
+ * it with a release store, so any number of threads can record while one thread pops. If the ring is full the record is
+ * dropped and counted.
+ */
+class ISOTP_TraceBuffer
+{
+public:
+    /**
+     * @param osInterface The OSInterface the timestamps are taken from.
+     * @param capacity The records the ring holds, rounded down to a power of 2. If it can not be allocated, nothing is
+     * recorded, see isEnabled().
+     */
+    explicit ISOTP_TraceBuffer(OSInterface& osInterface, uint32_t capacity = ISOTP_DefaultTraceCapacity);
+
+    ~ISOTP_TraceBuffer();
+
+    ISOTP_TraceBuffer(const ISOTP_TraceBuffer&)            = delete;
+    ISOTP_TraceBuffer& operator=(const ISOTP_TraceBuffer&) = delete;
+
+    [[nodiscard]] bool isEnabled() const;
+
+    [[nodiscard]] uint32_t getCapacity() const;
+
+    /**
+     * This function is used to record a frame. It can be called from any thread.
+     * @param event The event, ISOTP_TraceFrameRead, ISOTP_TraceFrameWritten or ISOTP_TraceWriteFailed.
+     * @param frame The frame.
+     */
+    void record(ISOTP_TraceEvent event, const CANFrame& frame);
+
+    /**
+     * This function is used to record an ACK. It can be called from any thread.
+     * @param nAi The N_AI of the frame that was ACKed.
+     * @param ack The ACK.
+     */
+    void recordACK(N_AI nAi, ACKResult ack);
+
+    /**
+     * This function is used to take the oldest record. Only one thread can pop at the same time.
+     * @param record Set to the oldest record.
+     * @return True if a record was taken, false if the ring is empty.
+     */
+    bool pop(ISOTP_TraceRecord& record);
+
+    /**
+     * This function is used to get the records dropped because the ring was full.
+     * @return The number of dropped records since the ring was created, it wraps around.
+     */
+    [[nodiscard]] uint32_t getDroppedRecords() const;
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence; // Position that can be written when equal to it, read when one more.
+        ISOTP_TraceRecord     record;
+    };
+
+    void push(const ISOTP_TraceRecord& record);
+
+    OSInterface&          osInterface;
+    Slot*                 slots;
+    uint32_t              mask;    // Capacity - 1.
+    std::atomic<uint32_t> tail{0}; // Next position to reserve.
+    uint32_t              head;    // Next position to pop, only used by the consumer.
+    std::atomic<uint32_t> dropped{0};
+};
+
+// Called with encoded bytes by ISOTP_TraceWriter. It returns false if the bytes could not be stored.
+using ISOTP_TraceSink_cb_t = bool (*)(const uint8_t* data, uint32_t length, void* context);
+
+/**
+ * Moves the records of an ISOTP_TraceBuffer to a binary trace, and optionally to a candump log (the format of
+ * candump -L, which canplayer and most CAN tools read).
+ * The binary trace is a header (the "ISOTPTRC" magic, then the version, the record size and 4 reserved bytes, all
+ * little endian) followed by fixed size little endian records.
+ * @note The writer does not create threads, the application calls drain() from a low priority thread or task, so the
+ * sinks (files, sockets, flash...) never delay the runStep.
+ */
+class ISOTP_TraceWriter
+{
+public:
+    constexpr static const char* TAG = "ISOTP-TraceWriter";
+
+    /**
+     * @param buffer The ring to drain. It must outlive the writer.
+     * @param binarySink Where the binary trace is written, nullptr to not write it.
+     * @param binaryContext Given to binarySink.
+     * @param textSink Where the candump log is written, nullptr to not write it.
+     * @param textContext Given to textSink.
+     * @param interfaceName The interface name of the candump lines.
+     */
+    ISOTP_TraceWriter(ISOTP_TraceBuffer& buffer, ISOTP_TraceSink_cb_t binarySink, void* binaryContext,
+                      ISOTP_TraceSink_cb_t textSink = nullptr, void* textContext = nullptr,
+                      const char* interfaceName = "can0");
+
+    /**
+     * This function is used to write the available records to the sinks. The binary header is written by the first
+     * call. If records were dropped since the previous call, an ISOTP_TraceRecordsDropped record is written first.
+     * @param maxRecords The maximum number of records to take from the ring.
+     * @return The number of records taken from the ring.
+     */
+    uint32_t drain(uint32_t maxRecords = UINT32_MAX);
+
+    /**
+     * This function is used to get the records that were taken from the ring but refused by a sink.
+     * @return The number of records.
+     */
+    [[nodiscard]] uint32_t getLostRecords() const;
+
+    /**
+     * This function is used to write the header of a binary trace.
+     * @param buffer The buffer, at least ISOTP_TraceHeaderSize bytes.
+     */
+    static void encodeHeader(uint8_t* buffer);
+
+    /**
+     * This function is used to check the header of a binary trace.
+     * @param buffer The header, ISOTP_TraceHeaderSize bytes.
+     * @return True if it is the header of a binary trace this version can read.
+     */
+    static bool decodeHeader(const uint8_t* buffer);
+
+    /**
+     * This function is used to encode a record of a binary trace.
+     * @param record The record.
+     * @param buffer The buffer, at least ISOTP_TraceRecordSize bytes.
+     */
+    static void encode(const ISOTP_TraceRecord& record, uint8_t* buffer);
+
+    /**
+     * This function is used to decode a record of a binary trace.
+     * @param buffer The encoded record, ISOTP_TraceRecordSize bytes.
+     * @param record Set to the record.
+     * @return True if the record is valid, false otherwise.
+     */
+    static bool decode(const uint8_t* buffer, ISOTP_TraceRecord& record);
+
+    /**
+     * This function is used to format a record as a candump -L line, for example "(0000000001.250000) can0
+     * 18DA0201#0210". Only the frames read and written have a line.
+     * @param record The record.
+     * @param interfaceName The interface name of the line, only its first 16 characters are used.
+     * @param buffer The buffer the line and its new line are written to, it is null terminated if size is not 0.
+     * @param size The size of the buffer.
+     * @return The length of the line (like snprintf), 0 if the record has no line.
+     */
+    static size_t toCandump(const ISOTP_TraceRecord& record, const char* interfaceName, char* buffer, size_t size);
+
+    /**
+     * This function is used to parse a line of a candump -L log into an ISOTP_TraceFrameRead record. The text after
+     * the data (such as the direction flag of candump -x) is ignored.
+     * @param line The line, with or without its new line.
+     * @param record Set to the frame of the line.
+     * @return True if the line is a classic CAN frame with a 29 bit identifier, false otherwise (standard identifiers,
+     * CAN FD and remote frames included).
+     */
+    static bool fromCandump(const char* line, ISOTP_TraceRecord& record);
+
+private:
+    constexpr static uint32_t BatchRecords  = 32;
+    constexpr static uint32_t MaxLineLength = 64; // "(" + 10 + "." + 6 + ") " + 16 + " " + 8 + "#" + 16 + "\n".
+
+    void write(const ISOTP_TraceRecord& record);
+    void flush();
+
+    ISOTP_TraceBuffer&   buffer;
+    ISOTP_TraceSink_cb_t binarySink;
+    void*                binaryContext;
+    ISOTP_TraceSink_cb_t textSink;
+    void*                textContext;
+    const char*          interfaceName;
+    bool                 headerWritten;
+    uint32_t             droppedRecords; // Dropped records already reported.
+    uint32_t             lostRecords;
+    uint32_t             batchedRecords;
+    uint32_t             batchedTextLength;
+    uint8_t              batch[BatchRecords * ISOTP_TraceRecordSize];
+    char                 textBatch[BatchRecords * MaxLineLength];
+};
+
+#endif // ISOTP_TRACE_H
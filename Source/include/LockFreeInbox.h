@@ -0,0 +1,65 @@
+#ifndef LOCKFREEINBOX_H
+#define LOCKFREEINBOX_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Fixed size single-producer single-consumer queue that does not lock nor allocate memory, so push can be called from
+ * an interrupt handler or a driver thread while another thread pops.
+ * @note Only one context can push and only one context can pop at the same time.
+ * @tparam T The type of the stored elements, it must be trivially copyable.
+ * @tparam Capacity The maximum number of stored elements, it must be a power of 2.
+ */
+template <typename T, uint32_t Capacity> class LockFreeInbox
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+public:
+    /**
+     * This function is used to store an element at the end of the queue. It must only be called by the producer.
+     * @param element The element to store.
+     * @return True if the element was stored, false if the queue is full.
+     */
+    bool push(const T& element)
+    {
+        const uint32_t currentTail = this->tail.load(std::memory_order_relaxed);
+        if (currentTail - this->head.load(std::memory_order_acquire) == Capacity)
+        {
+            return false;
+        }
+        this->elements[currentTail & (Capacity - 1)] = element;
+        this->tail.store(currentTail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * This function is used to take the first element of the queue. It must only be called by the consumer.
+     * @param element Where the element is stored.
+     * @return True if an element was taken, false if the queue is empty.
+     */
+    bool pop(T& element)
+    {
+        const uint32_t currentHead = this->head.load(std::memory_order_relaxed);
+        if (currentHead == this->tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        element = this->elements[currentHead & (Capacity - 1)];
+        this->head.store(currentHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return this->head.load(std::memory_order_acquire) == this->tail.load(std::memory_order_acquire);
+    }
+
+private:
+    std::array<T, Capacity> elements{};
+    std::atomic<uint32_t>   head{0}; // Next element to pop, only written by the consumer.
+    std::atomic<uint32_t>   tail{0}; // Next free slot, only written by the producer.
+};
+
+#endif // LOCKFREEINBOX_H
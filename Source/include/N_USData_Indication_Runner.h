@@ -3,6 +3,11 @@
 
 #include "Atomic_int64_t.h"
 #include "CANMessageACKQueue.h"
+#include "ISOTP_ChunkPool.h"
+#include "ISOTP_PeerQuotas.h"
+#include "ISOTP_SlabAllocator.h"
+#include "ISOTP_SessionTable.h"
+#include "ISOTP_Statistics.h"
 #include "N_USData_Runner.h"
 #include "Timer_N.h"
 
@@ -11,16 +16,21 @@ constexpr int32_t N_USDATA_INDICATION_RUNNER_TAG_SIZE =
     MAX_N_AI_STR_SIZE + sizeof(N_USDATA_INDICATION_RUNNER_STATIC_TAG);
 
 // Class that handles the indication aka reception of a message
-class N_USData_Indication_Runner : public N_USData_Runner
+class N_USData_Indication_Runner final : public N_USData_Runner
 {
 public:
     N_USData_Indication_Runner(bool& result, N_AI nAi, Atomic_int64_t& availableMemoryForRunners, uint8_t blockSize,
-                               STmin stMin, OSInterface& osInterface, CANMessageACKQueue& canMessageACKQueue);
+                               STmin stMin, OSInterface& osInterface, CANMessageACKQueue& canMessageACKQueue,
+                               ThreadingPolicy threadingPolicy = ThreadSafeRunner,
+                               ISOTP_PeerQuotas* peerQuotas = nullptr, ISOTP_SlabAllocator* payloadAllocator = nullptr,
+                               ISOTP_ChunkPool* chunkPool = nullptr, ISOTP_Statistics* statistics = nullptr);
 
     ~N_USData_Indication_Runner() override;
 
     N_Result runStep(CANFrame* receivedFrame) override;
 
+    N_Result runStep(CANFrame* receivedFrame, uint32_t now) override;
+
     [[nodiscard]] uint32_t getNextRunTime() override;
 
     void messageACKReceivedCallback(ACKResult success) override;
@@ -35,10 +45,31 @@ public:
 
     [[nodiscard]] uint32_t getMessageLength() const override;
 
+    /**
+     * This function is used to get the received message, split in the chunks it was reassembled in.
+     * @note getMessageData() returns nullptr when the message is stored in chunks, this function works in both cases.
+     * @return The view of the message, valid until the runner is destroyed. It has no segments if there is no message.
+     */
+    [[nodiscard]] ISOTP_MessageView getMessageView() const;
+
     [[nodiscard]] N_Result getResult() const override;
 
     [[nodiscard]] Mtype getMtype() const override;
 
+    /**
+     * This function is used to get when the reception started.
+     * @return The timestamp of the step the first frame was received in, derived from OSInterface::osMillis().
+     */
+    [[nodiscard]] uint32_t getStartTime() const;
+
+    /**
+     * This function is used to describe the indication for ISOTP::getSessions(). It must be called from the thread that
+     * runs the runner. The state and pendingACKs are not set, they are known by the caller.
+     * @param info Set to the N_AI, progress, flow control parameters and armed timer of the indication.
+     * @param now The current timestamp, derived from OSInterface::osMillis().
+     */
+    void getSessionInfo(ISOTP_SessionInfo& info, uint32_t now) const;
+
     [[nodiscard]] RunnerType getRunnerType() const override;
 
     [[nodiscard]] const char* getTAG() const override;
@@ -46,21 +77,37 @@ public:
     [[nodiscard]] bool isThisFrameForMe(const CANFrame& frame) const override;
 
 private:
+    [[nodiscard]] bool lock() const;
+    void               unlock() const;
+
+    [[nodiscard]] int64_t getPayloadCharge() const;
+    [[nodiscard]] bool    hasPayload() const;
+    bool                  allocatePayload();
+    bool                  appendPayload(const uint8_t* data, uint32_t length);
+    void                  freePayload();
+
     N_Result runStep_internal(const CANFrame* receivedFrame);
     N_Result runStep_notRunning(const CANFrame* receivedFrame);
     N_Result runStep_holdFrame(const CANFrame* receivedFrame);
     N_Result runStep_CF(const CANFrame* receivedFrame);
     N_Result runStep_FC_CTS(const CANFrame* receivedFrame);
+    N_Result runStep_messageReceived(const CANFrame* receivedFrame);
+    N_Result runStep_error(const CANFrame* receivedFrame);
 
     void FC_ACKReceivedCallback(ACKResult success);
 
     N_Result               sendFCFrame(FlowStatus fs);
     [[nodiscard]] uint32_t getNextTimeoutTime() const;
     N_Result               checkTimeouts();
+    void                   recordLatency(ISOTP_TimingPhase phase, const Timer_N& timer) const;
     [[nodiscard]] bool     awaitingFrame(const CANFrame& frame) const;
 
     using InternalStatus_t = enum { NOT_RUNNING, SEND_FC, AWAITING_FC_ACK, AWAITING_CF, MESSAGE_RECEIVED, ERROR };
 
+    using State = N_USData_RunnerState<N_USData_Indication_Runner>;
+
+    [[nodiscard]] static const State& getState(InternalStatus_t status);
+
     [[nodiscard]] static const char* internalStatusToString(InternalStatus_t status);
 
     N_AI     nAi;
@@ -73,19 +120,29 @@ private:
     STmin    effectiveStMin{};
 
     N_Result result;
-    uint32_t lastRunTime;
+    uint32_t stepTime;  // Clock sample the timers of the current step are evaluated against.
+    uint32_t startTime; // Clock sample of the step the first frame was received in.
     uint8_t  sequenceNumber;
-    char*    tag{};
-
-    OSInterface_Mutex* mutex{};
-    InternalStatus_t   internalStatus;
-    Atomic_int64_t*    availableMemoryForRunners;
-    uint32_t           messageOffset;
-    int16_t            cfReceivedInThisBlock;
 
-    Timer_N* timerN_Ar{}; // Timer for sending a frame
-    Timer_N* timerN_Br{}; // Timer that holds the time since the last FF or CF to the next FC.
-    Timer_N* timerN_Cr{}; // Timer that holds the time since the last FC to the next FC.
+    OSInterface_Mutex*    mutex{};
+    InternalStatus_t      internalStatus;
+    Atomic_int64_t*       availableMemoryForRunners;
+    ISOTP_PeerQuotas*     peerQuotas;       // Quotas of the sender, the message is charged to them at the FF.
+    bool                  quotaCharged;     // The message is charged to peerQuotas and must be given back.
+    ISOTP_SlabAllocator*  payloadAllocator; // Allocator of messageData, nullptr to take it from the heap.
+    ISOTP_ChunkPool*      chunkPool;        // Pool of the chunks of the message, nullptr to use messageData.
+    ISOTP_Statistics*     statistics;       // Counters of the ISOTP object, nullptr if not counted.
+    ISOTP_MessageSegment  payloadSegment{}; // The whole messageData, for getMessageView().
+    ISOTP_MessageSegment* segments{};       // One per chunk, filled as the message is received.
+    uint32_t              segmentCount;
+    uint32_t              messageOffset;
+    int16_t               cfReceivedInThisBlock;
+
+    N_USData_RunnerTag<N_USDATA_INDICATION_RUNNER_TAG_SIZE> tag;
+
+    Timer_N timerN_Ar; // Timer for sending a frame
+    Timer_N timerN_Br; // Timer that holds the time since the last FF or CF to the next FC.
+    Timer_N timerN_Cr; // Timer that holds the time since the last FC to the next FC.
 
     OSInterface*        osInterface;
     CANMessageACKQueue* CanMessageACKQueue{};
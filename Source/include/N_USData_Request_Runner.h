@@ -3,6 +3,9 @@
 
 #include "Atomic_int64_t.h"
 #include "CANMessageACKQueue.h"
+#include "ISOTP_SlabAllocator.h"
+#include "ISOTP_SessionTable.h"
+#include "ISOTP_Statistics.h"
 #include "N_USData_Runner.h"
 #include "Timer_N.h"
 
@@ -12,17 +15,20 @@ constexpr uint8_t DEFAULT_STMIN_VALUE_MS =
     127; // 127 ms is the maximum value for STmin in ms unit and is used if an invalid value is selected.
 
 // Class that handles the request aka transmission of a message
-class N_USData_Request_Runner : public N_USData_Runner
+class N_USData_Request_Runner final : public N_USData_Runner
 {
 public:
     N_USData_Request_Runner(bool& result, N_AI nAi, Atomic_int64_t& availableMemoryForRunners, Mtype mType,
                             const uint8_t* messageData, uint32_t messageLength, OSInterface& osInterface,
-                            CANMessageACKQueue& canMessageACKQueue);
+                            CANMessageACKQueue& canMessageACKQueue, ThreadingPolicy threadingPolicy = ThreadSafeRunner,
+                            ISOTP_SlabAllocator* payloadAllocator = nullptr, ISOTP_Statistics* statistics = nullptr);
 
     ~N_USData_Request_Runner() override;
 
     N_Result runStep(CANFrame* receivedFrame) override;
 
+    N_Result runStep(CANFrame* receivedFrame, uint32_t now) override;
+
     [[nodiscard]] uint32_t getNextRunTime() override;
 
     void messageACKReceivedCallback(ACKResult success) override;
@@ -37,6 +43,20 @@ public:
 
     [[nodiscard]] Mtype getMtype() const override;
 
+    /**
+     * This function is used to get when the message was requested.
+     * @return The timestamp the runner was created at, derived from OSInterface::osMillis().
+     */
+    [[nodiscard]] uint32_t getStartTime() const;
+
+    /**
+     * This function is used to describe the request for ISOTP::getSessions(). It must be called from the thread that
+     * runs the runner. The state and pendingACKs are not set, they are known by the caller.
+     * @param info Set to the N_AI, progress, flow control parameters and armed timer of the request.
+     * @param now The current timestamp, derived from OSInterface::osMillis().
+     */
+    void getSessionInfo(ISOTP_SessionInfo& info, uint32_t now) const;
+
     [[nodiscard]] RunnerType getRunnerType() const override;
 
     [[nodiscard]] const char* getTAG() const override;
@@ -44,23 +64,35 @@ public:
     [[nodiscard]] bool isThisFrameForMe(const CANFrame& frame) const override;
 
 private:
+    [[nodiscard]] bool lock() const;
+    void               unlock() const;
+
+    [[nodiscard]] int64_t getPayloadCharge() const;
+    uint8_t*              allocatePayload(uint32_t size);
+    void                  freePayload();
+
     N_Result runStep_holdFrame(const CANFrame* receivedFrame);
     N_Result runStep_internal(const CANFrame* receivedFrame);
     N_Result runStep_SF(const CANFrame* receivedFrame);
     N_Result runStep_FF(const CANFrame* receivedFrame);
     N_Result runStep_CF(const CANFrame* receivedFrame);
-    N_Result runStep_FC(const CANFrame* receivedFrame, bool firstFc = false);
+    N_Result runStep_FC(const CANFrame* receivedFrame, bool firstFc);
+    N_Result runStep_firstFC(const CANFrame* receivedFrame);
+    N_Result runStep_nextFC(const CANFrame* receivedFrame);
+    N_Result runStep_messageSent(const CANFrame* receivedFrame);
+    N_Result runStep_error(const CANFrame* receivedFrame);
+    N_Result runStep_invalidStatus(const CANFrame* receivedFrame);
 
     void SF_ACKReceivedCallback(ACKResult success);
     void FF_ACKReceivedCallback(ACKResult success);
     void CF_ACKReceivedCallback(ACKResult success);
 
     N_Result               parseFCFrame(const CANFrame* receivedFrame, FlowStatus& fs, uint8_t& blcksize, STmin& stM);
+    void                   recordLatency(ISOTP_TimingPhase phase, const Timer_N& timer) const;
     [[nodiscard]] uint32_t getNextTimeoutTime() const;
     N_Result               checkTimeouts();
     N_Result               sendCFFrame();
     [[nodiscard]] bool     awaitingFrame(const CANFrame& frame) const;
-
     using InternalStatus_t = enum {
         NOT_RUNNING_SF,
         AWAITING_SF_ACK,
@@ -74,6 +106,10 @@ private:
         ERROR
     };
 
+    using State = N_USData_RunnerState<N_USData_Request_Runner>;
+
+    [[nodiscard]] static const State& getState(InternalStatus_t status);
+
     [[nodiscard]] static const char* internalStatusToString(InternalStatus_t status);
 
     N_AI     nAi;
@@ -83,20 +119,24 @@ private:
     uint8_t  blockSize;
     STmin    stMin{};
 
-    N_Result        result;
-    uint32_t        lastRunTime;
-    uint8_t         sequenceNumber;
-    Atomic_int64_t* availableMemoryForRunners;
-    uint32_t        messageOffset;
-    char*           tag{};
+    N_Result             result;
+    uint32_t             stepTime;  // Clock sample the timers of the current step are evaluated against.
+    uint32_t             startTime; // Clock sample of the creation of the runner.
+    uint8_t              sequenceNumber;
+    Atomic_int64_t*      availableMemoryForRunners;
+    ISOTP_SlabAllocator* payloadAllocator; // Allocator of messageData, nullptr to take it from the heap.
+    ISOTP_Statistics*    statistics;       // Counters of the ISOTP object, nullptr if not counted.
+    uint32_t             messageOffset;
 
     OSInterface_Mutex* mutex{};
     InternalStatus_t   internalStatus;
     int16_t            cfSentInThisBlock;
 
-    Timer_N* timerN_As{}; // Timer for sending a frame
-    Timer_N* timerN_Bs{}; // Timer that holds the time since the last FF or CF to the next CF.
-    Timer_N* timerN_Cs{}; // Timer that calls out once STmin has passed.
+    N_USData_RunnerTag<N_USDATA_REQUEST_RUNNER_TAG_SIZE> tag;
+
+    Timer_N timerN_As; // Timer for sending a frame
+    Timer_N timerN_Bs; // Timer that holds the time since the last FF or CF to the next CF.
+    Timer_N timerN_Cs; // Timer that calls out once STmin has passed.
 
     OSInterface*        osInterface;
     CANMessageACKQueue* CanMessageACKQueue;
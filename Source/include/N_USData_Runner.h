@@ -1,7 +1,11 @@
 #ifndef N_USDATA_RUNNER_H
 #define N_USDATA_RUNNER_H
 
+#include <atomic>
+#include <cstdio>
+
 #include "CANInterface.h"
+#include "CANMessageACKQueue.h"
 #include "ISOTP_Common.h"
 
 #define NewCANFrameISOTP()                                                                                             \
@@ -24,7 +28,7 @@
     {                                                                                                                  \
         auto oldStatus = internalStatus;                                                                               \
         internalStatus = newStatus;                                                                                    \
-        OSInterfaceLogDebug(tag, "internalStatus changed from %s (%" PRIu8 ") to %s (%" PRIu8 ")",                     \
+        OSInterfaceLogDebug(getTAG(), "internalStatus changed from %s (%" PRIu8 ") to %s (%" PRIu8 ")",                \
                             internalStatusToString(oldStatus), oldStatus, internalStatusToString(internalStatus),      \
                             internalStatus);                                                                           \
     }                                                                                                                  \
@@ -35,7 +39,7 @@
     {                                                                                                                  \
         updateInternalStatus(ERROR);                                                                                   \
         result = errorCode;                                                                                            \
-        OSInterfaceLogError(tag, "Returning error %s.", N_ResultToString(errorCode));                                  \
+        OSInterfaceLogError(getTAG(), "Returning error %s.", N_ResultToString(errorCode));                             \
         return result;                                                                                                 \
     }                                                                                                                  \
     while (false)
@@ -45,17 +49,63 @@
     {                                                                                                                  \
         updateInternalStatus(ERROR);                                                                                   \
         result = errorCode;                                                                                            \
-        OSInterfaceLogError(tag, "Returning error %s. " fmt, N_ResultToString(errorCode), ##__VA_ARGS__);              \
+        OSInterfaceLogError(getTAG(), "Returning error %s. " fmt, N_ResultToString(errorCode), ##__VA_ARGS__);         \
         return result;                                                                                                 \
     }                                                                                                                  \
     while (false)
 
-class N_USData_Runner
+/**
+ * Logging tag of a runner: its static tag followed by its N_AI. The tag is only formatted the first time it is used,
+ * which only happens when a log message passes the level filter, so runners do not spend time nor memory on it when
+ * logging is disabled.
+ * If ISOTP_USE_STATIC_RUNNER_TAGS is set, the N_AI is dropped and the tag is just the static tag.
+ * @tparam Size The size of the formatted tag, including the null terminator.
+ */
+template <size_t Size> class N_USData_RunnerTag
+{
+public:
+    N_USData_RunnerTag(const char* staticTag, const N_AI nAi) : staticTag(staticTag), nAi(nAi) {}
+
+    /**
+     * This function is used to get the tag, formatting it if it is the first time.
+     * @return The tag, or the static tag while another thread is formatting it.
+     */
+    [[nodiscard]] const char* get() const
+    {
+#if ISOTP_USE_STATIC_RUNNER_TAGS
+        return this->staticTag;
+#else
+        uint8_t expected = NotFormatted;
+        if (this->state.compare_exchange_strong(expected, Formatting, std::memory_order_acquire))
+        {
+            snprintf(this->formattedTag, Size, "%s%s", this->staticTag, nAiToString(this->nAi));
+            this->state.store(Formatted, std::memory_order_release);
+            return this->formattedTag;
+        }
+        return expected == Formatted ? this->formattedTag : this->staticTag;
+#endif
+    }
+
+private:
+    const char* staticTag;
+    N_AI        nAi;
+#if !ISOTP_USE_STATIC_RUNNER_TAGS
+    enum : uint8_t { NotFormatted, Formatting, Formatted };
+
+    mutable std::atomic<uint8_t> state{NotFormatted};
+    mutable char                 formattedTag[Size]{};
+#endif
+};
+
+class N_USData_Runner : public CANMessageACKListener
 {
 public:
     using RunnerType = enum { RunnerUnknownType, RunnerRequestType, RunnerIndicationType };
     using FrameCode  = enum { SF_CODE = 0b0000, FF_CODE = 0b0001, CF_CODE = 0b0010, FC_CODE = 0b0011 };
     using FlowStatus = enum { CONTINUE_TO_SEND = 0, WAIT = 1, OVERFLOW = 2, INVALID_FS };
+    // ThreadSafeRunner runners take their own mutex in every call. SingleThreadedRunner runners do not have a mutex, so
+    // they must only be used from one thread at a time (ISOTP only touches its runners with runnersMutex taken).
+    using ThreadingPolicy = enum { ThreadSafeRunner, SingleThreadedRunner };
 
     constexpr static uint8_t  MAX_SF_MESSAGE_LENGTH          = 7;
     constexpr static uint8_t  MAX_CF_MESSAGE_LENGTH          = 7;
@@ -82,8 +132,8 @@ public:
 
     constexpr static STmin DEFAULT_STMIN = {20, ms};
 
-    N_USData_Runner()          = default;
-    virtual ~N_USData_Runner() = default;
+    N_USData_Runner()           = default;
+    ~N_USData_Runner() override = default;
 
     static const char* runnerTypeToString(RunnerType type);
     static const char* frameCodeToString(FrameCode code);
@@ -100,6 +150,15 @@ public:
      */
     virtual N_Result runStep(CANFrame* receivedFrame) = 0;
 
+    /**
+     * @brief Same as runStep(CANFrame*), but the timers are evaluated against the given timestamp instead of sampling
+     * the clock, so the caller can share one clock sample between all its runners.
+     * @param receivedFrame Pointer to the received frame. If nullptr, no frame is received.
+     * @param now The current timestamp, derived from OsInterface::millis().
+     * @return The result of the run.
+     */
+    virtual N_Result runStep(CANFrame* receivedFrame, uint32_t now) = 0;
+
     /**
      * @brief Returns the next timestamp the runner will run. The timestamp is derived from OsInterface::millis().
      * @return The next timestamp the runner will run.
@@ -110,7 +169,7 @@ public:
      * @brief Returns the N_AI of the runner.
      * @return The N_AI of the runner.
      */
-    [[nodiscard]] virtual N_AI getN_AI() const = 0;
+    [[nodiscard]] N_AI getN_AI() const override = 0;
 
     /**
      * @brief Returns the message data of the runner.
@@ -146,7 +205,7 @@ public:
      * @brief Callback for when a message is received.
      * @param success True if the message was received successfully, false otherwise.
      */
-    virtual void messageACKReceivedCallback(ACKResult success) = 0;
+    void messageACKReceivedCallback(ACKResult success) override = 0;
 
     /**
      * @brief Returns the logging tag of the runner.
@@ -163,4 +222,51 @@ public:
     [[nodiscard]] virtual bool isThisFrameForMe(const CANFrame& frame) const = 0;
 };
 
+/**
+ * Row of the constexpr state table of a runner, that says what the runner does in one of its internal statuses.
+ * The table is indexed by the internal status, so each event (a step, an incoming frame, an ACK or a next run time
+ * query) is dispatched with one lookup instead of a switch. Timer operations depend on the frame contents, so they stay
+ * in the handlers.
+ * @tparam Runner The runner the handlers belong to.
+ */
+template <typename Runner> struct N_USData_RunnerState
+{
+    uint32_t status;                                         // Internal status of the row, equal to its index.
+    N_Result (Runner::*step)(const CANFrame* receivedFrame); // Run by runStep.
+    void (Runner::*ackReceived)(ACKResult success);          // Run when the sent frame is ACKed, nullptr if none is.
+    uint16_t awaitedFrames; // Bit per FrameCode accepted by isThisFrameForMe, the other frames are not for the runner.
+    bool     runNow;        // The runner has work to do without waiting for a frame or a timeout.
+};
+
+constexpr uint16_t N_USData_frameCodeBit(const N_USData_Runner::FrameCode code)
+{
+    return 1 << code;
+}
+
+/**
+ * This function is used to check at compile time that a state table has one row per internal status, in order, that
+ * every row has a step, and that the awaited frames are SF, FF, CF or FC. The frames that are not awaited are rejected
+ * by isThisFrameForMe, but it does not check that the step of a status handles each of its awaited frames, the steps
+ * dispatch on the frame contents themselves.
+ * @param table The state table, indexed by the internal status.
+ * @return True if the table is well formed, false otherwise.
+ */
+template <typename Runner, size_t StatusCount>
+constexpr bool N_USData_isStateTableComplete(const N_USData_RunnerState<Runner> (&table)[StatusCount])
+{
+    constexpr uint16_t frameCodes =
+        N_USData_frameCodeBit(N_USData_Runner::SF_CODE) | N_USData_frameCodeBit(N_USData_Runner::FF_CODE) |
+        N_USData_frameCodeBit(N_USData_Runner::CF_CODE) | N_USData_frameCodeBit(N_USData_Runner::FC_CODE);
+
+    for (uint32_t status = 0; status < StatusCount; status++)
+    {
+        if (table[status].status != status || table[status].step == nullptr ||
+            (table[status].awaitedFrames & ~frameCodes) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 #endif // N_USDATA_RUNNER_H
@@ -0,0 +1,192 @@
+#ifndef N_USDATA_RUNNERPOOL_H
+#define N_USDATA_RUNNERPOOL_H
+
+#include <deque>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "N_USData_Indication_Runner.h"
+#include "N_USData_Request_Runner.h"
+#include "OSInterface.h"
+
+/**
+ * Slot of an N_USData_RunnerPool that holds one runner by value, or nothing while it is free.
+ * The runner functions used by ISOTP are forwarded to the concrete runner type, so they are dispatched with a branch
+ * on the stored type instead of a virtual call.
+ */
+class N_USData_RunnerSlot
+{
+public:
+    template <typename Runner, typename... Args> Runner& emplace(Args&&... args)
+    {
+        return this->runner.emplace<Runner>(std::forward<Args>(args)...);
+    }
+
+    // Destroys the stored runner, if any.
+    void reset()
+    {
+        this->runner.emplace<std::monostate>();
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return std::holds_alternative<std::monostate>(this->runner);
+    }
+
+    /**
+     * This function is used to get the stored runner as an indication runner.
+     * @return The stored runner, or nullptr if it is not an indication runner.
+     */
+    [[nodiscard]] N_USData_Indication_Runner* getIndicationRunner()
+    {
+        return std::get_if<N_USData_Indication_Runner>(&this->runner);
+    }
+
+    N_Result runStep(CANFrame* receivedFrame, const uint32_t now)
+    {
+        return visit([receivedFrame, now](auto& r) -> N_Result { return r.runStep(receivedFrame, now); });
+    }
+
+    [[nodiscard]] uint32_t getNextRunTime()
+    {
+        return visit([](auto& r) -> uint32_t { return r.getNextRunTime(); });
+    }
+
+    [[nodiscard]] bool isThisFrameForMe(const CANFrame& frame) const
+    {
+        return visit([&frame](const auto& r) { return r.isThisFrameForMe(frame); });
+    }
+
+    [[nodiscard]] N_AI getN_AI() const
+    {
+        return visit([](const auto& r) { return r.getN_AI(); });
+    }
+
+    [[nodiscard]] N_USData_Runner::RunnerType getRunnerType() const
+    {
+        return std::holds_alternative<N_USData_Request_Runner>(this->runner) ? N_USData_Runner::RunnerRequestType
+                                                                             : N_USData_Runner::RunnerIndicationType;
+    }
+
+    [[nodiscard]] uint8_t* getMessageData() const
+    {
+        return visit([](const auto& r) { return r.getMessageData(); });
+    }
+
+    [[nodiscard]] uint32_t getMessageLength() const
+    {
+        return visit([](const auto& r) { return r.getMessageLength(); });
+    }
+
+    [[nodiscard]] N_Result getResult() const
+    {
+        return visit([](const auto& r) { return r.getResult(); });
+    }
+
+    [[nodiscard]] Mtype getMtype() const
+    {
+        return visit([](const auto& r) { return r.getMtype(); });
+    }
+
+    [[nodiscard]] const char* getTAG() const
+    {
+        return visit([](const auto& r) { return r.getTAG(); });
+    }
+
+    [[nodiscard]] uint32_t getStartTime() const
+    {
+        return visit([](const auto& r) { return r.getStartTime(); });
+    }
+
+    void getSessionInfo(ISOTP_SessionInfo& info, const uint32_t now) const
+    {
+        visit([&info, now](const auto& r) { r.getSessionInfo(info, now); });
+    }
+
+private:
+    // Must only be called while a runner is stored.
+    template <typename Function> std::invoke_result_t<Function, N_USData_Request_Runner&> visit(Function&& function)
+    {
+        if (auto* request = std::get_if<N_USData_Request_Runner>(&this->runner))
+        {
+            return function(*request);
+        }
+        return function(*std::get_if<N_USData_Indication_Runner>(&this->runner));
+    }
+
+    template <typename Function>
+    std::invoke_result_t<Function, const N_USData_Request_Runner&> visit(Function&& function) const
+    {
+        if (const auto* request = std::get_if<N_USData_Request_Runner>(&this->runner))
+        {
+            return function(*request);
+        }
+        return function(*std::get_if<N_USData_Indication_Runner>(&this->runner));
+    }
+
+    std::variant<std::monostate, N_USData_Request_Runner, N_USData_Indication_Runner> runner;
+};
+
+/**
+ * Storage for the runners of an ISOTP object. The runners are stored by value in chunks of contiguous slots, so a
+ * runner keeps its address while it is alive (CANMessageACKQueue points to it), there is no heap allocation per
+ * runner, and the runners scanned on every tick sit next to each other. Released slots are reused by the next runner.
+ */
+class N_USData_RunnerPool
+{
+public:
+    explicit N_USData_RunnerPool(OSInterface& osInterface);
+
+    ~N_USData_RunnerPool();
+
+    N_USData_RunnerPool(const N_USData_RunnerPool&)            = delete;
+    N_USData_RunnerPool& operator=(const N_USData_RunnerPool&) = delete;
+
+    /**
+     * This function is used to construct a runner in a free slot.
+     * @param result Set to the result reported by the runner constructor.
+     * @param args The rest of the arguments of the runner constructor.
+     * @tparam Runner N_USData_Request_Runner or N_USData_Indication_Runner.
+     * @return The slot that holds the runner, or nullptr if the runner could not be created.
+     */
+    template <typename Runner, typename... Args> N_USData_RunnerSlot* create(bool& result, Args&&... args)
+    {
+        result                    = false;
+        N_USData_RunnerSlot* slot = acquireSlot();
+        if (slot == nullptr)
+        {
+            return nullptr;
+        }
+
+        // The slot belongs to the caller now, so the runner is constructed without holding the mutex.
+        slot->emplace<Runner>(result, std::forward<Args>(args)...);
+        if (!result)
+        {
+            release(slot);
+            return nullptr;
+        }
+        return slot;
+    }
+
+    /**
+     * This function is used to destroy the runner of a slot and make the slot available again.
+     * @param slot The slot returned by create.
+     */
+    void release(N_USData_RunnerSlot* slot);
+
+    /**
+     * This function is used to get the number of slots, used or not, that the pool has created.
+     * @return The number of slots.
+     */
+    [[nodiscard]] uint32_t getSlotCount() const;
+
+private:
+    N_USData_RunnerSlot* acquireSlot();
+
+    OSInterface_Mutex*                mutex;
+    std::deque<N_USData_RunnerSlot>   slots;     // Never shrinks, so the slots keep their address.
+    std::vector<N_USData_RunnerSlot*> freeSlots; // Released slots, reused before creating new ones.
+};
+
+#endif // N_USDATA_RUNNERPOOL_H
@@ -3,17 +3,32 @@
 
 #include "OSInterface.h"
 
+/**
+ * Timer used for the N_A, N_B and N_C timeouts. It is small enough to be stored inline in the runners.
+ * Every function has an overload that takes the current timestamp (derived from OSInterface::osMillis()), so the caller
+ * can sample the clock once and evaluate all its timers against that sample.
+ */
 class Timer_N
 {
 public:
     explicit Timer_N(OSInterface& osInterface);
     void stopTimer();
+    void stopTimer(uint32_t now);
     void startTimer();
+    void startTimer(uint32_t now);
     void clearTimer();
 
     [[nodiscard]] bool     isTimerRunning() const;
     [[nodiscard]] uint32_t getStartTimeStamp() const;
     [[nodiscard]] uint32_t getElapsedTime_ms() const;
+    [[nodiscard]] uint32_t getElapsedTime_ms(uint32_t now) const;
+
+    /**
+     * This function is used to get the absolute timestamp at which a running timer reaches a timeout.
+     * @param timeout_ms The timeout in ms.
+     * @return The timestamp (derived from OSInterface::osMillis()) at which the timeout expires.
+     */
+    [[nodiscard]] uint32_t getDeadline(uint32_t timeout_ms) const;
 
 private:
     OSInterface* osInterface;
@@ -0,0 +1,504 @@
+// End-to-end throughput and latency of ISOTP over LocalCANNetwork, without gtest nor any network.
+// Usage: ISOTPLib_Benchmarks [--messages N] [--filter TEXT] [--json FILE]
+//        ISOTPLib_Benchmarks --replay FILE [--n-sa N] [--recorded-timing] [--json FILE]
+//   --messages N        Messages sent by each sender in every scenario, instead of the default of the scenario.
+//   --filter TEXT       Only run the scenarios whose name contains TEXT.
+//   --json FILE         Also write the results as JSON to FILE ("-" for stdout).
+//   --replay FILE       Instead of the scenarios, replay a binary trace or candump -L log into one ISOTP object.
+//   --n-sa N            N_SA of the ISOTP object the trace is replayed into (default 1), 0x prefix for hex.
+//   --recorded-timing   Give the frames at their recorded time instead of as fast as possible.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "ISOTP.h"
+#include "LinuxOSInterface.h"
+#include "LocalCANNetwork.h"
+#include "TraceReplay.h"
+
+static LinuxOSInterface linuxOSInterface;
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t BENCHMARK_MEMORY_FOR_RUNNERS = 64 * 1024;
+constexpr uint32_t BENCHMARK_STALL_TIMEOUT_MS   = 2000; // A scenario stops if no frame is written for this long.
+constexpr uint8_t  BENCHMARK_RECEIVER_N_SA      = 1;
+constexpr uint8_t  BENCHMARK_FIRST_SENDER_N_SA  = 0x10;
+constexpr uint8_t  BENCHMARK_FUNCTIONAL_N_TA    = 0x33;
+
+using ScenarioType = enum ScenarioType { SingleFrame, MultiFrame, Functional, ManyToOne };
+
+struct Scenario
+{
+    const char*  name;
+    ScenarioType type;
+    uint32_t     messageSize;
+    uint8_t      blockSize;
+    STmin        stMin;
+    uint32_t     nodes;    // Receivers for Functional, senders for ManyToOne, 1 otherwise.
+    uint32_t     messages; // Messages sent by each sender.
+};
+
+// clang-format off
+constexpr Scenario SCENARIOS[] = {
+    // name                      type         size  bs  stMin         nodes messages
+    {"sf_1B",                    SingleFrame,    1, 0,  {0, ms},      1,    1000},
+    {"sf_7B",                    SingleFrame,    7, 0,  {0, ms},      1,    1000},
+    {"functional_7B_4rx",        Functional,     7, 0,  {0, ms},      4,    1000},
+    {"mf_8B_bs0",                MultiFrame,     8, 0,  {0, ms},      1,     500},
+    {"mf_64B_bs0",               MultiFrame,    64, 0,  {0, ms},      1,     200},
+    {"mf_512B_bs0",              MultiFrame,   512, 0,  {0, ms},      1,      20},
+    {"mf_512B_bs8",              MultiFrame,   512, 8,  {0, ms},      1,      20},
+    {"mf_512B_bs0_stmin100us",   MultiFrame,   512, 0,  {1, usX100},  1,      20},
+    {"mf_64B_bs2_stmin1ms",      MultiFrame,    64, 2,  {1, ms},      1,     100},
+    {"mf_4095B_bs0",             MultiFrame,  4095, 0,  {0, ms},      1,       5},
+    {"mf_4095B_bs16",            MultiFrame,  4095, 16, {0, ms},      1,       5},
+    {"many_to_one_512B_4tx",     ManyToOne,    512, 0,  {0, ms},      4,      10},
+    {"many_to_one_64B_16tx_bs8", ManyToOne,     64, 8,  {0, ms},      16,     20},
+};
+// clang-format on
+
+struct Result
+{
+    const Scenario* scenario;
+    uint32_t        messagesDelivered;
+    uint32_t        errors;
+    uint64_t        payloadBytes;
+    uint64_t        frames;
+    double          seconds;
+    double          messagesPerSecond;
+    double          bytesPerSecond;
+    double          framesPerSecond;
+    double          latencyP50_us;
+    double          latencyP99_us;
+    double          latencyP999_us;
+};
+
+// Counts the frames written to the network, including the FCs of the receivers.
+class CountingCANInterface final : public CANInterface
+{
+public:
+    explicit CountingCANInterface(CANInterface* canInterface) : canInterface(canInterface)
+    {
+    }
+
+    ~CountingCANInterface() override
+    {
+        delete canInterface;
+    }
+
+    bool frameAvailable() override
+    {
+        return canInterface->frameAvailable();
+    }
+
+    bool readFrame(CANFrame* frame) override
+    {
+        return canInterface->readFrame(frame);
+    }
+
+    bool writeFrame(CANFrame* frame) override
+    {
+        const bool written = canInterface->writeFrame(frame);
+        if (written)
+        {
+            framesWritten++;
+        }
+        return written;
+    }
+
+    ACKResult getWriteFrameACK() override
+    {
+        return canInterface->getWriteFrameACK();
+    }
+
+    bool active() override
+    {
+        return canInterface->active();
+    }
+
+    uint64_t framesWritten = 0;
+
+private:
+    CANInterface* canInterface;
+};
+
+// Message in flight from one sender. The ISOTP callbacks have no context, so they find it through its N_SA.
+struct InFlightMessage
+{
+    Clock::time_point sendTime;
+    uint32_t          deliveriesLeft;
+    bool              confirmed;
+    bool              active;
+};
+
+static std::array<InFlightMessage, 256> inFlight;
+static std::vector<uint64_t>            latencies_ns;
+static uint32_t                         deliveries;
+static uint32_t                         errors;
+static uint64_t                         payloadBytes;
+static uint32_t                         expectedMessageSize;
+
+static void benchmark_N_USData_confirm_cb(const N_AI nAi, const N_Result nResult, Mtype)
+{
+    if (nResult != N_OK)
+    {
+        errors++;
+    }
+    inFlight[nAi.N_SA].confirmed = true;
+}
+
+static void benchmark_N_USData_indication_cb(const N_AI nAi, const uint8_t*, const uint32_t messageLength,
+                                             const N_Result nResult, Mtype)
+{
+    InFlightMessage& message = inFlight[nAi.N_SA];
+    if (nResult != N_OK || messageLength != expectedMessageSize || !message.active || message.deliveriesLeft == 0)
+    {
+        errors++;
+        return;
+    }
+
+    const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - message.sendTime);
+    latencies_ns.push_back(latency.count());
+    payloadBytes += messageLength;
+    deliveries++;
+    message.deliveriesLeft--;
+}
+
+static double percentile_us(const std::vector<uint64_t>& sorted, const double p)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    const size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())));
+    return static_cast<double>(sorted[index]) / 1000.0;
+}
+
+static Result runScenario(const Scenario& scenario, const uint32_t messagesPerSender)
+{
+    const uint32_t senders   = scenario.type == ManyToOne ? scenario.nodes : 1;
+    const uint32_t receivers = scenario.type == Functional ? scenario.nodes : 1;
+
+    LocalCANNetwork                    network(linuxOSInterface);
+    std::vector<CountingCANInterface*> interfaces;
+    std::vector<ISOTP*>                senderISOTPs;
+    std::vector<ISOTP*>                receiverISOTPs;
+
+    for (uint32_t i = 0; i < senders; i++)
+    {
+        interfaces.push_back(new CountingCANInterface(network.newCANInterfaceConnection()));
+        senderISOTPs.push_back(new ISOTP(BENCHMARK_FIRST_SENDER_N_SA + i, BENCHMARK_MEMORY_FOR_RUNNERS,
+                                         benchmark_N_USData_confirm_cb, nullptr, nullptr, linuxOSInterface,
+                                         *interfaces.back(), scenario.blockSize, scenario.stMin, "sender"));
+    }
+    for (uint32_t i = 0; i < receivers; i++)
+    {
+        interfaces.push_back(new CountingCANInterface(network.newCANInterfaceConnection()));
+        receiverISOTPs.push_back(new ISOTP(BENCHMARK_RECEIVER_N_SA + i, BENCHMARK_MEMORY_FOR_RUNNERS, nullptr,
+                                           benchmark_N_USData_indication_cb, nullptr, linuxOSInterface,
+                                           *interfaces.back(), scenario.blockSize, scenario.stMin, "receiver"));
+        receiverISOTPs.back()->addAcceptedFunctionalN_TA(BENCHMARK_FUNCTIONAL_N_TA);
+    }
+
+    std::vector<uint8_t> message(scenario.messageSize);
+    for (uint32_t i = 0; i < scenario.messageSize; i++)
+    {
+        message[i] = static_cast<uint8_t>(i);
+    }
+
+    inFlight            = {};
+    deliveries          = 0;
+    errors              = 0;
+    payloadBytes        = 0;
+    expectedMessageSize = scenario.messageSize;
+    latencies_ns.clear();
+    latencies_ns.reserve(static_cast<size_t>(messagesPerSender) * senders * receivers);
+
+    std::vector<uint32_t> sent(senders, 0);
+    const uint32_t        expectedDeliveries = messagesPerSender * senders * receivers;
+    const N_TAtype_t      nTaType =
+        scenario.type == Functional ? N_TATYPE_6_CAN_CLASSIC_29bit_Functional : N_TATYPE_5_CAN_CLASSIC_29bit_Physical;
+    const uint8_t nTa = scenario.type == Functional ? BENCHMARK_FUNCTIONAL_N_TA : BENCHMARK_RECEIVER_N_SA;
+
+    const Clock::time_point start        = Clock::now();
+    Clock::time_point       lastProgress = start;
+    uint64_t                lastFrames   = 0;
+    while (deliveries < expectedDeliveries)
+    {
+        // Each sender keeps one message in flight, so the latency is not inflated by queueing.
+        for (uint32_t i = 0; i < senders; i++)
+        {
+            InFlightMessage& inFlightMessage = inFlight[BENCHMARK_FIRST_SENDER_N_SA + i];
+            if (inFlightMessage.active && (!inFlightMessage.confirmed || inFlightMessage.deliveriesLeft > 0))
+            {
+                continue;
+            }
+            if (sent[i] == messagesPerSender)
+            {
+                inFlightMessage.active = false;
+                continue;
+            }
+
+            inFlightMessage = {Clock::now(), receivers, false, true};
+            if (senderISOTPs[i]->N_USData_request(nTa, nTaType, message.data(), scenario.messageSize))
+            {
+                sent[i]++;
+            }
+            else
+            {
+                inFlightMessage.active = false;
+                errors++;
+            }
+        }
+
+        for (ISOTP* isotp : senderISOTPs)
+        {
+            isotp->runStep();
+            isotp->canMessageACKQueueRunStep();
+        }
+        for (ISOTP* isotp : receiverISOTPs)
+        {
+            isotp->runStep();
+            isotp->canMessageACKQueueRunStep();
+        }
+
+        uint64_t frames = 0;
+        for (const CountingCANInterface* canInterface : interfaces)
+        {
+            frames += canInterface->framesWritten;
+        }
+
+        const Clock::time_point now = Clock::now();
+        if (frames != lastFrames)
+        {
+            lastFrames   = frames;
+            lastProgress = now;
+        }
+        else if (now - lastProgress > std::chrono::milliseconds(BENCHMARK_STALL_TIMEOUT_MS))
+        {
+            fprintf(stderr, "%s: stalled after %u of %u deliveries\n", scenario.name, deliveries, expectedDeliveries);
+            errors += expectedDeliveries - deliveries;
+            break;
+        }
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    Result result{};
+    result.scenario          = &scenario;
+    result.messagesDelivered = deliveries;
+    result.errors            = errors;
+    result.payloadBytes      = payloadBytes;
+    for (const CountingCANInterface* canInterface : interfaces)
+    {
+        result.frames += canInterface->framesWritten;
+    }
+    result.seconds           = seconds;
+    result.messagesPerSecond = deliveries / seconds;
+    result.bytesPerSecond    = static_cast<double>(payloadBytes) / seconds;
+    result.framesPerSecond   = static_cast<double>(result.frames) / seconds;
+
+    std::sort(latencies_ns.begin(), latencies_ns.end());
+    result.latencyP50_us  = percentile_us(latencies_ns, 0.50);
+    result.latencyP99_us  = percentile_us(latencies_ns, 0.99);
+    result.latencyP999_us = percentile_us(latencies_ns, 0.999);
+
+    for (ISOTP* isotp : senderISOTPs)
+    {
+        delete isotp;
+    }
+    for (ISOTP* isotp : receiverISOTPs)
+    {
+        delete isotp;
+    }
+    for (CountingCANInterface* canInterface : interfaces)
+    {
+        delete canInterface;
+    }
+    return result;
+}
+
+static const char* scenarioTypeToString(const ScenarioType type)
+{
+    switch (type)
+    {
+        case SingleFrame:
+            return "sf";
+        case MultiFrame:
+            return "mf";
+        case Functional:
+            return "functional";
+        case ManyToOne:
+            return "many_to_one";
+        default:
+            return "unknown";
+    }
+}
+
+static void writeJson(FILE* file, const std::vector<Result>& results)
+{
+    fprintf(file, "{\n  \"benchmark\": \"ISOTPLib_Benchmarks\",\n  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result&   r = results[i];
+        const Scenario& s = *r.scenario;
+        fprintf(file,
+                "    {\"name\": \"%s\", \"type\": \"%s\", \"message_size\": %u, \"block_size\": %u, "
+                "\"st_min\": {\"value\": %u, \"unit\": \"%s\"}, \"nodes\": %u, \"messages\": %u, \"errors\": %u, "
+                "\"seconds\": %.6f, \"messages_per_s\": %.1f, \"payload_bytes_per_s\": %.1f, \"frames_per_s\": %.1f, "
+                "\"latency_us\": {\"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f}}%s\n",
+                s.name, scenarioTypeToString(s.type), s.messageSize, s.blockSize, s.stMin.value,
+                s.stMin.unit == ms ? "ms" : "usX100", s.nodes, r.messagesDelivered, r.errors, r.seconds,
+                r.messagesPerSecond, r.bytesPerSecond, r.framesPerSecond, r.latencyP50_us, r.latencyP99_us,
+                r.latencyP999_us, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+static void replay_N_USData_indication_cb(N_AI, const uint8_t*, uint32_t, N_Result, Mtype)
+{
+}
+
+static int runReplay(const char* path, const uint8_t nSa, const TraceReplayTiming timing, const char* jsonPath)
+{
+    TraceReplay replay;
+    if (!replay.loadFile(path))
+    {
+        fprintf(stderr, "Failed to load a trace from %s\n", path);
+        return 1;
+    }
+
+    ISOTP isotp(nSa, BENCHMARK_MEMORY_FOR_RUNNERS, nullptr, replay_N_USData_indication_cb, nullptr,
+                replay.getOSInterface(), replay.getCANInterface(), ISOTP_DefaultBlockSize, ISOTP_DefaultSTmin,
+                "replay");
+    const TraceReplayReport r = replay.run(isotp, timing);
+
+    const double framesPerSecond =
+        r.processingTotal_ns > 0 ? static_cast<double>(r.framesReplayed) * 1e9 / r.processingTotal_ns : 0;
+    FILE* table = jsonPath != nullptr && strcmp(jsonPath, "-") == 0 ? stderr : stdout;
+    fprintf(table, "%10s %8s %8s %8s %8s %12s %10s %10s %10s\n", "frames", "skipped", "written", "pdus", "errors",
+            "frames/s", "p50 us", "p99 us", "max us");
+    fprintf(table, "%10u %8u %8u %8u %8u %12.0f %10.1f %10.1f %10.1f\n", r.framesReplayed, r.recordsSkipped,
+            r.framesWritten, r.pdusReassembled, r.protocolErrors, framesPerSecond, r.processingP50_ns / 1000.0,
+            r.processingP99_ns / 1000.0, r.processingMax_ns / 1000.0);
+    for (uint8_t result = 0; result < ISOTP_N_ResultCount; result++)
+    {
+        if (result != N_OK && r.indicationResults[result] > 0)
+        {
+            fprintf(table, "  %s: %u\n", N_ResultToString(static_cast<N_Result>(result)), r.indicationResults[result]);
+        }
+    }
+
+    if (jsonPath != nullptr)
+    {
+        FILE* json = strcmp(jsonPath, "-") == 0 ? stdout : fopen(jsonPath, "w");
+        if (json == nullptr)
+        {
+            fprintf(stderr, "Failed to open %s\n", jsonPath);
+            return 1;
+        }
+        fprintf(json,
+                "{\n  \"benchmark\": \"ISOTPLib_Benchmarks\",\n  \"replay\": {\"trace\": \"%s\", \"timing\": \"%s\", "
+                "\"frames\": %u, \"skipped\": %u, \"written\": %u, \"pdus\": %u, \"errors\": %u, "
+                "\"frames_per_s\": %.1f, \"processing_us\": {\"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f}}\n}\n",
+                path, timing == TraceReplayRecordedTiming ? "recorded" : "fast", r.framesReplayed, r.recordsSkipped,
+                r.framesWritten, r.pdusReassembled, r.protocolErrors, framesPerSecond, r.processingP50_ns / 1000.0,
+                r.processingP99_ns / 1000.0, r.processingMax_ns / 1000.0);
+        if (json != stdout)
+        {
+            fclose(json);
+        }
+    }
+    return 0;
+}
+
+int main(const int argc, char** argv)
+{
+    uint32_t          messages   = 0; // 0 keeps the default of each scenario.
+    const char*       filter     = nullptr;
+    const char*       jsonPath   = nullptr;
+    const char*       replayPath = nullptr;
+    uint8_t           replayN_SA = BENCHMARK_RECEIVER_N_SA;
+    TraceReplayTiming timing     = TraceReplayAsFastAsPossible;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--messages") == 0 && i + 1 < argc)
+        {
+            messages = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            jsonPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            replayPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--n-sa") == 0 && i + 1 < argc)
+        {
+            replayN_SA = strtoul(argv[++i], nullptr, 0);
+        }
+        else if (strcmp(argv[i], "--recorded-timing") == 0)
+        {
+            timing = TraceReplayRecordedTiming;
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [--messages N] [--filter TEXT] [--json FILE]\n", argv[0]);
+            fprintf(stderr, "       %s --replay FILE [--n-sa N] [--recorded-timing] [--json FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (replayPath != nullptr)
+    {
+        return runReplay(replayPath, replayN_SA, timing, jsonPath);
+    }
+
+    // The human readable table goes to stderr when the JSON goes to stdout.
+    FILE* table = jsonPath != nullptr && strcmp(jsonPath, "-") == 0 ? stderr : stdout;
+    fprintf(table, "%-26s %10s %8s %12s %14s %12s %10s %10s %10s\n", "scenario", "messages", "errors", "msg/s",
+            "bytes/s", "frames/s", "p50 us", "p99 us", "p999 us");
+
+    std::vector<Result> results;
+    uint32_t            totalErrors = 0;
+    for (const Scenario& scenario : SCENARIOS)
+    {
+        if (filter != nullptr && strstr(scenario.name, filter) == nullptr)
+        {
+            continue;
+        }
+
+        const Result& r = results.emplace_back(runScenario(scenario, messages > 0 ? messages : scenario.messages));
+        totalErrors += r.errors;
+        fprintf(table, "%-26s %10u %8u %12.0f %14.0f %12.0f %10.1f %10.1f %10.1f\n", scenario.name,
+                r.messagesDelivered, r.errors, r.messagesPerSecond, r.bytesPerSecond, r.framesPerSecond,
+                r.latencyP50_us, r.latencyP99_us, r.latencyP999_us);
+    }
+
+    if (jsonPath != nullptr)
+    {
+        FILE* json = strcmp(jsonPath, "-") == 0 ? stdout : fopen(jsonPath, "w");
+        if (json == nullptr)
+        {
+            fprintf(stderr, "Failed to open %s\n", jsonPath);
+            return 1;
+        }
+        writeJson(json, results);
+        if (json != stdout)
+        {
+            fclose(json);
+        }
+    }
+
+    return totalErrors == 0 ? 0 : 1;
+}
@@ -0,0 +1,656 @@
+// Synthetic ISO-TP load between simulated peers and gateway ISOTP objects over LocalCANNetwork or a SimulatedCANBus, to
+// size totalAvailableMemoryForRunners and the executor workers of a deployment before its hardware is available.
+// Usage: ISOTPLib_LoadGenerator [options]
+//   --peers N            Simulated peers (default 4), spread across the gateways.
+//   --gateways N         Gateway ISOTP objects (default 1).
+//   --workers N          ISOTPExecutor workers running the gateways, each on its own thread (default 1).
+//   --memory BYTES       totalAvailableMemoryForRunners of each gateway (default 65536).
+//   --duration S         Seconds of load (default 5).
+//   --direction D        up (the peers send to their gateway), down (the gateways send to their peers) or both.
+//   --size DIST          Message sizes: N, MIN-MAX (uniform) or A,B,C (picked at random). Default 64.
+//   --functional PCT     Percentage of the messages of the peers sent as functional SFs (default 0).
+//   --closed-loop N      Keep N messages in flight per flow (default, with N = 1).
+//   --rate R             Open loop instead: R messages per second per flow, whether or not the previous ones ended.
+//   --bs LIST            BS of the peers, cycled over them, for example 0,8 (default 0).
+//   --stmin LIST         STmin of the peers, cycled over them: N ms or Nus (100 to 900 us), for example 0,1,500us.
+//   --gateway-bs N       BS of the gateways (default 0).
+//   --gateway-stmin V    STmin of the gateways (default 0).
+//   --ack-errors RATE    Fraction of the ACKs of every node turned into ACK_ERROR (default 0).
+//   --late-fc RATE       Fraction of the FCs read by every node that arrive late (default 0).
+//   --late-fc-delay MS   Delay of the late FCs (default 500).
+//   --wrong-sn RATE      Fraction of the CFs read by every node with a wrong SN (default 0).
+//   --bitrate N          Run the nodes on a SimulatedCANBus of N bit/s instead of LocalCANNetwork.
+//   --tx-queue N         TX queue depth of every node on the SimulatedCANBus (default 3).
+//   --seed N             Seed of the sizes and the faults (default 1).
+//   --json FILE          Also write the results as JSON to FILE ("-" for stdout).
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "FaultInjectionCANInterface.h"
+#include "ISOTP.h"
+#include "ISOTPExecutor.h"
+#include "LinuxOSInterface.h"
+#include "LocalCANNetwork.h"
+#include "SimulatedCANBus.h"
+
+static LinuxOSInterface linuxOSInterface;
+
+constexpr uint8_t  LOAD_FIRST_GATEWAY_N_SA = 0x01;
+constexpr uint8_t  LOAD_FIRST_PEER_N_SA    = 0x10;
+constexpr uint8_t  LOAD_FUNCTIONAL_N_TA    = 0x33;
+constexpr uint32_t LOAD_MAX_MESSAGE_SIZE   = 4095;
+constexpr uint32_t LOAD_PEER_MEMORY        = 64 * 1024;
+constexpr uint32_t LOAD_DRAIN_TIMEOUT_MS   = 5000; // Time given to the messages in flight once the load stops.
+constexpr uint32_t LOAD_MAX_PEERS          = 0x100 - LOAD_FIRST_PEER_N_SA;
+constexpr uint32_t LOAD_MAX_GATEWAYS       = LOAD_FIRST_PEER_N_SA - LOAD_FIRST_GATEWAY_N_SA;
+
+using Direction = enum Direction { Up, Down, DirectionCount };
+
+struct SizeDistribution
+{
+    std::vector<uint32_t> choices; // Picked at random if not empty.
+    uint32_t              min;
+    uint32_t              max;
+
+    uint32_t pick(std::mt19937& random) const
+    {
+        if (!choices.empty())
+        {
+            return choices[std::uniform_int_distribution<size_t>(0, choices.size() - 1)(random)];
+        }
+        return std::uniform_int_distribution(min, max)(random);
+    }
+};
+
+struct Options
+{
+    uint32_t              peers                      = 4;
+    uint32_t              gateways                   = 1;
+    uint32_t              workers                    = 1;
+    uint32_t              memory                     = 64 * 1024;
+    double                duration_s                 = 5;
+    bool                  directions[DirectionCount] = {true, false};
+    SizeDistribution      sizes                      = {{}, 64, 64};
+    uint32_t              functional                 = 0;
+    uint32_t              outstanding                = 1; // Closed loop when rate is 0.
+    double                rate                       = 0;
+    std::vector<uint8_t>  peerBS                     = {0};
+    std::vector<STmin>    peerSTmin                  = {{0, ms}};
+    uint8_t               gatewayBS                  = 0;
+    STmin                 gatewaySTmin               = {0, ms};
+    FaultInjectionConfig  faults                     = {.lateFCDelay_ms = 500};
+    SimulatedCANBusConfig bus                        = {.bitrate = 0}; // LocalCANNetwork when the bitrate is 0.
+    const char*           jsonPath                   = nullptr;
+};
+
+// Messages between a peer and its gateway in one direction. The ISOTP callbacks have no context, so they find it
+// through the N_AI.
+struct Flow
+{
+    ISOTP*                source;
+    uint8_t               nTa;
+    std::atomic<uint32_t> inFlight;
+    uint32_t              nextSendTime; // Open loop.
+};
+
+struct DirectionCounters
+{
+    std::atomic<uint32_t> sent;
+    std::atomic<uint32_t> rejected; // Refused by N_USData_request.
+    std::atomic<uint32_t> confirms[ISOTP_N_ResultCount];
+    std::atomic<uint32_t> indications[ISOTP_N_ResultCount];
+    std::atomic<uint64_t> payloadBytes; // Of the indications with N_OK.
+};
+
+static std::vector<Flow>  flows; // Up flow of peer i at i, down flow at peers + i.
+static DirectionCounters  counters[DirectionCount];
+static uint32_t           peerCount;
+static std::atomic<bool>  running;
+static constexpr uint8_t  message[LOAD_MAX_MESSAGE_SIZE] = {};
+
+static const char* directionToString(const Direction direction)
+{
+    return direction == Up ? "up" : "down";
+}
+
+static void load_N_USData_confirm_cb(const N_AI nAi, const N_Result nResult, Mtype)
+{
+    const bool fromPeer = nAi.N_SA >= LOAD_FIRST_PEER_N_SA;
+    counters[fromPeer ? Up : Down].confirms[nResult]++;
+    flows[fromPeer ? nAi.N_SA - LOAD_FIRST_PEER_N_SA : peerCount + nAi.N_TA - LOAD_FIRST_PEER_N_SA].inFlight--;
+}
+
+static void load_N_USData_indication_cb(const N_AI nAi, const uint8_t*, const uint32_t messageLength,
+                                        const N_Result nResult, Mtype)
+{
+    DirectionCounters& direction = counters[nAi.N_SA >= LOAD_FIRST_PEER_N_SA ? Up : Down];
+    direction.indications[nResult]++;
+    if (nResult == N_OK)
+    {
+        direction.payloadBytes += messageLength;
+    }
+}
+
+static bool parseSizes(const char* text, SizeDistribution& sizes)
+{
+    sizes = {};
+    if (const char* dash = strchr(text, '-'); dash != nullptr)
+    {
+        sizes.min = strtoul(text, nullptr, 10);
+        sizes.max = strtoul(dash + 1, nullptr, 10);
+    }
+    else
+    {
+        for (const char* value = text; value != nullptr; value = strchr(value, ','), value = value ? value + 1 : value)
+        {
+            sizes.choices.push_back(strtoul(value, nullptr, 10));
+        }
+        sizes.min = *std::ranges::min_element(sizes.choices);
+        sizes.max = *std::ranges::max_element(sizes.choices);
+    }
+    return sizes.min >= 1 && sizes.min <= sizes.max && sizes.max <= LOAD_MAX_MESSAGE_SIZE;
+}
+
+static bool parseBS(const char* text, uint8_t& bs)
+{
+    const unsigned long value = strtoul(text, nullptr, 10);
+    bs                        = static_cast<uint8_t>(value);
+    return value <= UINT8_MAX;
+}
+
+static bool parseSTmin(const char* text, STmin& stMin)
+{
+    char*               end   = nullptr;
+    const unsigned long value = strtoul(text, &end, 10);
+    if (strncmp(end, "us", 2) == 0)
+    {
+        stMin = {static_cast<uint8_t>(value / 100), usX100};
+        return value >= 100 && value <= 900 && value % 100 == 0;
+    }
+    stMin = {static_cast<uint8_t>(value), ms};
+    return value <= 127;
+}
+
+template <typename T, typename Parse> static bool parseList(const char* text, std::vector<T>& values, Parse parse)
+{
+    values.clear();
+    for (const char* value = text; value != nullptr; value = strchr(value, ','), value = value ? value + 1 : value)
+    {
+        if (!parse(value, values.emplace_back()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool parseOptions(const int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* option = argv[i];
+        if (i + 1 >= argc)
+        {
+            return false; // Every option has a value.
+        }
+        const char* value = argv[++i];
+
+        bool valid = true;
+        if (strcmp(option, "--peers") == 0)
+        {
+            options.peers = strtoul(value, nullptr, 10);
+            valid         = options.peers >= 1 && options.peers <= LOAD_MAX_PEERS;
+        }
+        else if (strcmp(option, "--gateways") == 0)
+        {
+            options.gateways = strtoul(value, nullptr, 10);
+            valid            = options.gateways >= 1 && options.gateways <= LOAD_MAX_GATEWAYS;
+        }
+        else if (strcmp(option, "--workers") == 0)
+        {
+            options.workers = strtoul(value, nullptr, 10);
+            valid           = options.workers >= 1 && options.workers <= UINT8_MAX;
+        }
+        else if (strcmp(option, "--memory") == 0)
+        {
+            options.memory = strtoul(value, nullptr, 10);
+        }
+        else if (strcmp(option, "--duration") == 0)
+        {
+            options.duration_s = strtod(value, nullptr);
+            valid              = options.duration_s > 0;
+        }
+        else if (strcmp(option, "--direction") == 0)
+        {
+            const bool both          = strcmp(value, "both") == 0;
+            options.directions[Up]   = both || strcmp(value, "up") == 0;
+            options.directions[Down] = both || strcmp(value, "down") == 0;
+            valid                    = options.directions[Up] || options.directions[Down];
+        }
+        else if (strcmp(option, "--size") == 0)
+        {
+            valid = parseSizes(value, options.sizes);
+        }
+        else if (strcmp(option, "--functional") == 0)
+        {
+            options.functional = strtoul(value, nullptr, 10);
+            valid              = options.functional <= 100;
+        }
+        else if (strcmp(option, "--closed-loop") == 0)
+        {
+            options.outstanding = strtoul(value, nullptr, 10);
+            options.rate        = 0;
+            valid               = options.outstanding >= 1;
+        }
+        else if (strcmp(option, "--rate") == 0)
+        {
+            options.rate = strtod(value, nullptr);
+            valid        = options.rate > 0;
+        }
+        else if (strcmp(option, "--bs") == 0)
+        {
+            valid = parseList(value, options.peerBS, parseBS);
+        }
+        else if (strcmp(option, "--stmin") == 0)
+        {
+            valid = parseList(value, options.peerSTmin, parseSTmin);
+        }
+        else if (strcmp(option, "--gateway-bs") == 0)
+        {
+            valid = parseBS(value, options.gatewayBS);
+        }
+        else if (strcmp(option, "--gateway-stmin") == 0)
+        {
+            valid = parseSTmin(value, options.gatewaySTmin);
+        }
+        else if (strcmp(option, "--ack-errors") == 0)
+        {
+            options.faults.ackErrorRate = strtod(value, nullptr);
+        }
+        else if (strcmp(option, "--late-fc") == 0)
+        {
+            options.faults.lateFCRate = strtod(value, nullptr);
+        }
+        else if (strcmp(option, "--late-fc-delay") == 0)
+        {
+            options.faults.lateFCDelay_ms = strtoul(value, nullptr, 10);
+        }
+        else if (strcmp(option, "--wrong-sn") == 0)
+        {
+            options.faults.wrongSNRate = strtod(value, nullptr);
+        }
+        else if (strcmp(option, "--bitrate") == 0)
+        {
+            options.bus.bitrate = strtoul(value, nullptr, 10);
+            valid               = options.bus.bitrate > 0;
+        }
+        else if (strcmp(option, "--tx-queue") == 0)
+        {
+            options.bus.txQueueDepth = strtoul(value, nullptr, 10);
+            valid                    = options.bus.txQueueDepth >= 1;
+        }
+        else if (strcmp(option, "--seed") == 0)
+        {
+            options.faults.seed = strtoul(value, nullptr, 10);
+            options.bus.seed    = options.faults.seed;
+        }
+        else if (strcmp(option, "--json") == 0)
+        {
+            options.jsonPath = value;
+        }
+        else
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            fprintf(stderr, "Invalid option %s %s\n", option, value);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void runWorker(ISOTPExecutor& executor, const uint8_t worker)
+{
+    while (running)
+    {
+        if (executor.runStep(worker) > linuxOSInterface.osMillis())
+        {
+            std::this_thread::yield(); // Nothing is due, the frames and ACKs are checked again on the next step.
+        }
+    }
+}
+
+static void send(Flow& flow, const Direction direction, const Options& options, std::mt19937& random)
+{
+    uint32_t   size    = options.sizes.pick(random);
+    N_TAtype_t nTaType = N_TATYPE_5_CAN_CLASSIC_29bit_Physical;
+    uint8_t    nTa     = flow.nTa;
+    if (direction == Up && std::uniform_int_distribution(1u, 100u)(random) <= options.functional)
+    {
+        nTaType = N_TATYPE_6_CAN_CLASSIC_29bit_Functional;
+        nTa     = LOAD_FUNCTIONAL_N_TA;
+        size    = std::min<uint32_t>(size, N_USData_Runner::MAX_SF_MESSAGE_LENGTH);
+    }
+
+    flow.inFlight++; // Before the request, the confirm can come from another thread right after it.
+    if (flow.source->N_USData_request(nTa, nTaType, message, size))
+    {
+        counters[direction].sent++;
+    }
+    else
+    {
+        flow.inFlight--;
+        counters[direction].rejected++;
+    }
+}
+
+template <typename Get>
+static ISOTP_LatencyHistogramSnapshot mergeHistograms(const std::vector<ISOTP*>& nodes, Get get)
+{
+    ISOTP_LatencyHistogramSnapshot merged{};
+    for (const ISOTP* isotp : nodes)
+    {
+        const ISOTP_LatencyHistogramSnapshot histogram = get(*isotp);
+        for (uint32_t i = 0; i < ISOTP_LatencyHistogramBucketCount; i++)
+        {
+            merged.buckets[i] += histogram.buckets[i];
+        }
+        merged.count += histogram.count;
+        merged.sum_ms += histogram.sum_ms;
+        merged.max_ms = std::max(merged.max_ms, histogram.max_ms);
+    }
+    return merged;
+}
+
+int main(const int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "Usage: %s [--peers N] [--gateways N] [--workers N] [--memory BYTES] [--duration S]\n"
+                        "       [--direction up|down|both] [--size N|MIN-MAX|A,B,C] [--functional PCT]\n"
+                        "       [--closed-loop N | --rate R] [--bs LIST] [--stmin LIST] [--gateway-bs N]\n"
+                        "       [--gateway-stmin V] [--ack-errors RATE] [--late-fc RATE] [--late-fc-delay MS]\n"
+                        "       [--wrong-sn RATE] [--bitrate N] [--tx-queue N] [--seed N] [--json FILE]\n",
+                argv[0]);
+        return 2;
+    }
+
+    LocalCANNetwork                          network(linuxOSInterface);
+    std::unique_ptr<SimulatedCANBus>         bus;
+    std::vector<FaultInjectionCANInterface*> interfaces;
+    std::vector<ISOTP*>                      gateways;
+    std::vector<ISOTP*>                      peers;
+    if (options.bus.bitrate > 0)
+    {
+        bus = std::make_unique<SimulatedCANBus>(linuxOSInterface, options.bus);
+    }
+    auto newInterface = [&]
+    {
+        FaultInjectionConfig faults = options.faults;
+        faults.seed += interfaces.size(); // Each node gets different faults.
+        CANInterface* connection = bus != nullptr ? bus->newCANInterfaceConnection()
+                                                  : network.newCANInterfaceConnection();
+        return interfaces.emplace_back(new FaultInjectionCANInterface(connection, linuxOSInterface, faults));
+    };
+
+    ISOTPExecutor gatewayExecutor(linuxOSInterface, options.workers, "gatewayExecutor");
+    ISOTPExecutor peerExecutor(linuxOSInterface, 1, "peerExecutor");
+    for (uint32_t i = 0; i < options.gateways; i++)
+    {
+        gateways.push_back(new ISOTP(LOAD_FIRST_GATEWAY_N_SA + i, options.memory, load_N_USData_confirm_cb,
+                                     load_N_USData_indication_cb, nullptr, linuxOSInterface, *newInterface(),
+                                     options.gatewayBS, options.gatewaySTmin, "gateway"));
+        gateways.back()->addAcceptedFunctionalN_TA(LOAD_FUNCTIONAL_N_TA);
+        gateways.back()->setRunStepTimingEnabled(true); // For the runStep histogram of the report.
+        gatewayExecutor.addInstance(*gateways.back());
+    }
+    for (uint32_t i = 0; i < options.peers; i++)
+    {
+        peers.push_back(new ISOTP(LOAD_FIRST_PEER_N_SA + i, LOAD_PEER_MEMORY, load_N_USData_confirm_cb,
+                                  load_N_USData_indication_cb, nullptr, linuxOSInterface, *newInterface(),
+                                  options.peerBS[i % options.peerBS.size()],
+                                  options.peerSTmin[i % options.peerSTmin.size()], "peer"));
+        peerExecutor.addInstance(*peers.back());
+    }
+
+    peerCount = options.peers;
+    flows     = std::vector<Flow>(2 * options.peers);
+    for (uint32_t i = 0; i < options.peers; i++)
+    {
+        flows[i].source         = peers[i];
+        flows[i].nTa            = LOAD_FIRST_GATEWAY_N_SA + i % options.gateways;
+        flows[peerCount + i].source = gateways[i % options.gateways];
+        flows[peerCount + i].nTa    = LOAD_FIRST_PEER_N_SA + i;
+    }
+
+    running = true;
+    std::vector<std::thread> threads;
+    for (uint32_t worker = 0; worker < options.workers; worker++)
+    {
+        threads.emplace_back(runWorker, std::ref(gatewayExecutor), worker);
+    }
+    threads.emplace_back(runWorker, std::ref(peerExecutor), 0);
+
+    // The requests are made from this thread, every 100 us at most.
+    std::mt19937   random(options.faults.seed);
+    const uint32_t interval_ms = options.rate > 0 ? std::max<uint32_t>(1000 / options.rate, 1) : 0;
+    const auto     start       = std::chrono::steady_clock::now();
+    const auto     end         = start + std::chrono::duration<double>(options.duration_s);
+    for (Flow& flow : flows)
+    {
+        flow.nextSendTime = linuxOSInterface.osMillis() + std::uniform_int_distribution(0u, interval_ms)(random);
+    }
+    while (std::chrono::steady_clock::now() < end)
+    {
+        const uint32_t now = linuxOSInterface.osMillis();
+        for (uint32_t i = 0; i < flows.size(); i++)
+        {
+            const auto direction = static_cast<Direction>(i / peerCount);
+            if (!options.directions[direction])
+            {
+                continue;
+            }
+            if (options.rate > 0)
+            {
+                for (; static_cast<int32_t>(now - flows[i].nextSendTime) >= 0; flows[i].nextSendTime += interval_ms)
+                {
+                    send(flows[i], direction, options, random);
+                }
+            }
+            else
+            {
+                while (flows[i].inFlight < options.outstanding)
+                {
+                    send(flows[i], direction, options, random);
+                }
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // The messages in flight are given time to end, they are counted but not in the rates.
+    const auto drainEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds(LOAD_DRAIN_TIMEOUT_MS);
+    while (std::ranges::any_of(flows, [](const Flow& flow) { return flow.inFlight > 0; }) &&
+           std::chrono::steady_clock::now() < drainEnd)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    running = false;
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    // Report.
+    FILE* table = options.jsonPath != nullptr && strcmp(options.jsonPath, "-") == 0 ? stderr : stdout;
+    fprintf(table, "%-9s %10s %9s %10s %9s %10s %9s %10s %12s\n", "direction", "sent", "rejected", "confirmed",
+            "conf err", "indicated", "ind err", "msg/s", "bytes/s");
+    struct DirectionResult
+    {
+        uint32_t confirmErrors;
+        uint32_t indicationErrors;
+        double   messagesPerSecond;
+        double   bytesPerSecond;
+    } results[DirectionCount]{};
+    for (uint8_t direction = 0; direction < DirectionCount; direction++)
+    {
+        const DirectionCounters& c = counters[direction];
+        DirectionResult&         r = results[direction];
+        for (uint8_t result = 0; result < ISOTP_N_ResultCount; result++)
+        {
+            r.confirmErrors += result != N_OK ? c.confirms[result].load() : 0;
+            r.indicationErrors += result != N_OK ? c.indications[result].load() : 0;
+        }
+        r.messagesPerSecond = c.indications[N_OK] / seconds;
+        r.bytesPerSecond    = static_cast<double>(c.payloadBytes) / seconds;
+        fprintf(table, "%-9s %10u %9u %10u %9u %10u %9u %10.0f %12.0f\n",
+                directionToString(static_cast<Direction>(direction)), c.sent.load(), c.rejected.load(),
+                c.confirms[N_OK].load(), r.confirmErrors, c.indications[N_OK].load(), r.indicationErrors,
+                r.messagesPerSecond, r.bytesPerSecond);
+        for (uint8_t result = 0; result < ISOTP_N_ResultCount; result++)
+        {
+            if (result != N_OK && c.confirms[result] + c.indications[result] > 0)
+            {
+                fprintf(table, "  %-16s confirms: %u, indications: %u\n",
+                        N_ResultToString(static_cast<N_Result>(result)), c.confirms[result].load(),
+                        c.indications[result].load());
+            }
+        }
+    }
+
+    uint64_t frames = 0;
+    for (const auto* nodes : {&gateways, &peers})
+    {
+        for (const ISOTP* isotp : *nodes)
+        {
+            frames += isotp->getStatistics().total.framesTx;
+        }
+    }
+    int64_t  memoryHighWater   = 0;
+    uint32_t ackQueueHighWater = 0;
+    uint32_t contended         = 0;
+    uint32_t acquisitions      = 0;
+    for (const ISOTP* gateway : gateways)
+    {
+        const ISOTP_StatisticsSnapshot statistics = gateway->getStatistics();
+        memoryHighWater   = std::max(memoryHighWater, statistics.memoryForRunnersHighWater);
+        ackQueueHighWater = std::max(ackQueueHighWater, statistics.ackQueueDepthHighWater);
+        const ISOTP_LockStatistics runnersLock = gateway->getLockStatistics(ISOTP_RunnersLock);
+        contended += runnersLock.contendedAcquisitions;
+        acquisitions += runnersLock.acquisitions;
+    }
+    const auto runStep =
+        mergeHistograms(gateways, [](const ISOTP& isotp) { return isotp.getRunStepHistogram(ISOTP_RunStepTotal); });
+    const auto requests =
+        mergeHistograms(peers, [](const ISOTP& isotp) { return isotp.getLatencyHistogram(ISOTP_RequestPhase); });
+    FaultInjectionCounters faults{};
+    for (FaultInjectionCANInterface* canInterface : interfaces)
+    {
+        const FaultInjectionCounters injected = canInterface->getCounters();
+        faults.ackErrors += injected.ackErrors;
+        faults.lateFCs += injected.lateFCs;
+        faults.wrongSNs += injected.wrongSNs;
+    }
+
+    fprintf(table, "seconds: %.2f, frames/s: %.0f\n", seconds, frames / seconds);
+    fprintf(table, "gateway memory for runners high water: %lld of %u bytes, ACK queue high water: %u\n",
+            static_cast<long long>(memoryHighWater), options.memory, ackQueueHighWater);
+    fprintf(table, "gateway runStep p50/p99/max: %u/%u/%u ms, runnersMutex contended: %u of %u\n",
+            runStep.getPercentile(50), runStep.getPercentile(99), runStep.max_ms, contended, acquisitions);
+    fprintf(table, "peer request p50/p99/max: %u/%u/%u ms\n", requests.getPercentile(50),
+            requests.getPercentile(99), requests.max_ms);
+    fprintf(table, "injected faults: %u ACK errors, %u late FCs, %u wrong SNs\n", faults.ackErrors, faults.lateFCs,
+            faults.wrongSNs);
+    const SimulatedCANBusStatistics busStatistics = bus != nullptr ? bus->getStatistics() : SimulatedCANBusStatistics{};
+    const double busLoad = busStatistics.elapsedTime_ns > 0
+                               ? 100.0 * static_cast<double>(busStatistics.busyTime_ns) / busStatistics.elapsedTime_ns
+                               : 0;
+    if (bus != nullptr)
+    {
+        fprintf(table, "bus load: %.1f%% at %u bit/s, %.1f%% stuff bits, %u arbitration losses, %u TX queue full\n",
+                busLoad, options.bus.bitrate,
+                busStatistics.bitsTransmitted > 0 ? 100.0 * busStatistics.stuffBits / busStatistics.bitsTransmitted : 0,
+                busStatistics.arbitrationLosses, busStatistics.txQueueFull);
+    }
+
+    if (options.jsonPath != nullptr)
+    {
+        FILE* json = strcmp(options.jsonPath, "-") == 0 ? stdout : fopen(options.jsonPath, "w");
+        if (json == nullptr)
+        {
+            fprintf(stderr, "Failed to open %s\n", options.jsonPath);
+            return 1;
+        }
+        fprintf(json, "{\n  \"tool\": \"ISOTPLib_LoadGenerator\",\n  \"seconds\": %.3f,\n  \"directions\": [\n",
+                seconds);
+        for (uint8_t direction = 0; direction < DirectionCount; direction++)
+        {
+            const DirectionCounters& c = counters[direction];
+            const DirectionResult&   r = results[direction];
+            fprintf(json,
+                    "    {\"direction\": \"%s\", \"sent\": %u, \"rejected\": %u, \"confirmed\": %u, "
+                    "\"confirm_errors\": %u, \"indicated\": %u, \"indication_errors\": %u, \"messages_per_s\": %.1f, "
+                    "\"payload_bytes_per_s\": %.1f, \"errors\": {",
+                    directionToString(static_cast<Direction>(direction)), c.sent.load(), c.rejected.load(),
+                    c.confirms[N_OK].load(), r.confirmErrors, c.indications[N_OK].load(), r.indicationErrors,
+                    r.messagesPerSecond, r.bytesPerSecond);
+            const char* separator = "";
+            for (uint8_t result = 0; result < ISOTP_N_ResultCount; result++)
+            {
+                if (result != N_OK && c.confirms[result] + c.indications[result] > 0)
+                {
+                    fprintf(json, "%s\"%s\": {\"confirms\": %u, \"indications\": %u}", separator,
+                            N_ResultToString(static_cast<N_Result>(result)), c.confirms[result].load(),
+                            c.indications[result].load());
+                    separator = ", ";
+                }
+            }
+            fprintf(json, "}}%s\n", direction + 1 < DirectionCount ? "," : "");
+        }
+        fprintf(json,
+                "  ],\n  \"frames_per_s\": %.1f,\n  \"gateway\": {\"memory\": %u, \"memory_high_water\": %lld, "
+                "\"ack_queue_high_water\": %u, \"run_step_ms\": {\"p50\": %u, \"p99\": %u, \"max\": %u}, "
+                "\"runners_mutex\": {\"acquisitions\": %u, \"contended\": %u}},\n"
+                "  \"peer_request_ms\": {\"p50\": %u, \"p99\": %u, \"max\": %u},\n"
+                "  \"injected_faults\": {\"ack_errors\": %u, \"late_fcs\": %u, \"wrong_sns\": %u},\n"
+                "  \"bus\": {\"bitrate\": %u, \"load_percent\": %.1f, \"stuff_bits\": %llu, "
+                "\"arbitration_losses\": %u, \"tx_queue_full\": %u}\n}\n",
+                frames / seconds, options.memory, static_cast<long long>(memoryHighWater), ackQueueHighWater,
+                runStep.getPercentile(50), runStep.getPercentile(99), runStep.max_ms, acquisitions, contended,
+                requests.getPercentile(50), requests.getPercentile(99), requests.max_ms, faults.ackErrors,
+                faults.lateFCs, faults.wrongSNs, options.bus.bitrate, busLoad,
+                static_cast<unsigned long long>(busStatistics.stuffBits), busStatistics.arbitrationLosses,
+                busStatistics.txQueueFull);
+        if (json != stdout)
+        {
+            fclose(json);
+        }
+    }
+
+    for (ISOTP* isotp : gateways)
+    {
+        delete isotp;
+    }
+    for (ISOTP* isotp : peers)
+    {
+        delete isotp;
+    }
+    for (FaultInjectionCANInterface* canInterface : interfaces)
+    {
+        delete canInterface;
+    }
+    return 0;
+}
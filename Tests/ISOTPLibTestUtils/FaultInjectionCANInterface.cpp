@@ -0,0 +1,88 @@
+#include "FaultInjectionCANInterface.h"
+
+#include "N_USData_Runner.h"
+
+FaultInjectionCANInterface::FaultInjectionCANInterface(CANInterface* canInterface, OSInterface& osInterface,
+                                                       const FaultInjectionConfig& config) :
+    canInterface(canInterface), osInterface(osInterface), config(config), random(config.seed)
+{
+}
+
+FaultInjectionCANInterface::~FaultInjectionCANInterface()
+{
+    delete this->canInterface;
+}
+
+bool FaultInjectionCANInterface::roll(const double rate)
+{
+    return rate > 0 && std::uniform_real_distribution(0.0, 1.0)(this->random) < rate;
+}
+
+bool FaultInjectionCANInterface::isLateFCDue() const
+{
+    return !this->lateFCs.empty() &&
+           static_cast<int32_t>(this->osInterface.osMillis() - this->lateFCs.front().first) >= 0;
+}
+
+bool FaultInjectionCANInterface::frameAvailable()
+{
+    std::lock_guard lock(this->mutex);
+    return isLateFCDue() || this->canInterface->frameAvailable();
+}
+
+bool FaultInjectionCANInterface::readFrame(CANFrame* frame)
+{
+    std::lock_guard lock(this->mutex);
+    if (isLateFCDue())
+    {
+        *frame = this->lateFCs.front().second;
+        this->lateFCs.pop_front();
+        return true;
+    }
+
+    while (this->canInterface->frameAvailable() && this->canInterface->readFrame(frame))
+    {
+        const auto frameCode = static_cast<N_USData_Runner::FrameCode>(frame->data[0] >> 4);
+        if (frameCode == N_USData_Runner::FC_CODE && roll(this->config.lateFCRate))
+        {
+            this->lateFCs.emplace_back(this->osInterface.osMillis() + this->config.lateFCDelay_ms, *frame);
+            this->counters.lateFCs++;
+            continue;
+        }
+        if (frameCode == N_USData_Runner::CF_CODE && roll(this->config.wrongSNRate))
+        {
+            frame->data[0] = N_USData_Runner::CF_CODE << 4 | ((frame->data[0] + 1) & 0x0F);
+            this->counters.wrongSNs++;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool FaultInjectionCANInterface::writeFrame(CANFrame* frame)
+{
+    return this->canInterface->writeFrame(frame);
+}
+
+ACKResult FaultInjectionCANInterface::getWriteFrameACK()
+{
+    std::lock_guard lock(this->mutex);
+    const ACKResult ack = this->canInterface->getWriteFrameACK();
+    if (ack == ACK_SUCCESS && roll(this->config.ackErrorRate))
+    {
+        this->counters.ackErrors++;
+        return ACK_ERROR;
+    }
+    return ack;
+}
+
+bool FaultInjectionCANInterface::active()
+{
+    return this->canInterface->active();
+}
+
+FaultInjectionCounters FaultInjectionCANInterface::getCounters()
+{
+    std::lock_guard lock(this->mutex);
+    return this->counters;
+}
@@ -0,0 +1,79 @@
+#ifndef FAULTINJECTIONCANINTERFACE_H
+#define FAULTINJECTIONCANINTERFACE_H
+
+#include <deque>
+#include <mutex>
+#include <random>
+
+#include "CANInterface.h"
+#include "OSInterface.h"
+
+/**
+ * Faults injected by a FaultInjectionCANInterface. The rates are probabilities from 0 to 1.
+ */
+struct FaultInjectionConfig
+{
+    uint32_t seed           = 1; // Seed of the random choices, so a run can be reproduced.
+    double   ackErrorRate   = 0; // ACKs replaced by ACK_ERROR, as if no node acknowledged the frame.
+    double   lateFCRate     = 0; // FCs read that are held for lateFCDelay_ms.
+    uint32_t lateFCDelay_ms = 0;
+    double   wrongSNRate    = 0; // CFs read whose SN is incremented.
+};
+
+/**
+ * Faults injected so far by a FaultInjectionCANInterface.
+ */
+struct FaultInjectionCounters
+{
+    uint32_t ackErrors;
+    uint32_t lateFCs;
+    uint32_t wrongSNs;
+};
+
+/**
+ * CANInterface that wraps another one and injects faults in the frames read and the ACKs of the frames written, to
+ * test and load ISOTP with a misbehaving bus or peer. The delayed FCs are given back in order of release, while the
+ * other frames keep flowing.
+ */
+class FaultInjectionCANInterface final : public CANInterface
+{
+public:
+    /**
+     * @param canInterface The wrapped CANInterface, deleted with this object.
+     * @param osInterface The OSInterface the FC delays are measured with.
+     * @param config The faults to inject.
+     */
+    FaultInjectionCANInterface(CANInterface* canInterface, OSInterface& osInterface,
+                               const FaultInjectionConfig& config);
+
+    ~FaultInjectionCANInterface() override;
+
+    FaultInjectionCANInterface(const FaultInjectionCANInterface&)            = delete;
+    FaultInjectionCANInterface& operator=(const FaultInjectionCANInterface&) = delete;
+
+    bool frameAvailable() override;
+
+    bool readFrame(CANFrame* frame) override;
+
+    bool writeFrame(CANFrame* frame) override;
+
+    ACKResult getWriteFrameACK() override;
+
+    bool active() override;
+
+    [[nodiscard]] FaultInjectionCounters getCounters();
+
+private:
+    [[nodiscard]] bool roll(double rate);
+    [[nodiscard]] bool isLateFCDue() const;
+
+    CANInterface*                             canInterface;
+    OSInterface&                              osInterface;
+    FaultInjectionConfig                      config;
+    std::mutex                                mutex; // ISOTP reads frames and ACKs from different steps.
+    std::mt19937                              random;
+    std::deque<std::pair<uint32_t, CANFrame>> lateFCs; // Release time and frame.
+    FaultInjectionCounters                    counters{};
+};
+
+#endif // FAULTINJECTIONCANINTERFACE_H
@@ -0,0 +1,284 @@
+#include "SimulatedCANBus.h"
+
+#include <algorithm>
+
+#include "ISOTP_Trace.h"
+
+constexpr uint32_t SimulatedCANBus_StuffedBitsMax  = 1 + 32 + 6 + CAN_FRAME_MAX_DLC * 8 + 15; // SOF to CRC.
+constexpr uint32_t SimulatedCANBus_UnstuffedBits   = 1 + 2 + 7 + 3; // CRC and ACK delimiters, ACK, EOF, intermission.
+constexpr uint32_t SimulatedCANBus_ErrorFrameBits  = 6 + 8 + 3;     // Error flag, error delimiter and intermission.
+constexpr uint16_t SimulatedCANBus_CRC15Polynomial = 0x4599;
+
+SimulatedCANBusNode::SimulatedCANBusNode(SimulatedCANBus& bus, const char* name) : bus(bus), name(name)
+{
+}
+
+SimulatedCANBusNode::~SimulatedCANBusNode()
+{
+    this->bus.removeNode(this);
+}
+
+bool SimulatedCANBusNode::frameAvailable()
+{
+    std::lock_guard lock(this->bus.mutex);
+    this->bus.advance();
+    return !this->rxQueue.empty();
+}
+
+bool SimulatedCANBusNode::readFrame(CANFrame* frame)
+{
+    std::lock_guard lock(this->bus.mutex);
+    this->bus.advance();
+    if (this->rxQueue.empty())
+    {
+        return false;
+    }
+    *frame = this->rxQueue.front();
+    this->rxQueue.pop_front();
+    return true;
+}
+
+bool SimulatedCANBusNode::writeFrame(CANFrame* frame)
+{
+    std::lock_guard lock(this->bus.mutex);
+    this->bus.advance();
+    if (this->txQueue.size() >= this->bus.config.txQueueDepth)
+    {
+        this->bus.statistics.txQueueFull++;
+        return false;
+    }
+    this->txQueue.push_back({*frame, this->bus.now_ns});
+    this->bus.advance(); // The frame can start right away if the bus is idle.
+    return true;
+}
+
+ACKResult SimulatedCANBusNode::getWriteFrameACK()
+{
+    std::lock_guard lock(this->bus.mutex);
+    this->bus.advance();
+    if (this->acks.empty() || this->acks.front().time_ns > this->bus.now_ns)
+    {
+        return ACK_NONE;
+    }
+    const ACKResult ack = this->acks.front().ack;
+    this->acks.pop_front();
+    return ack;
+}
+
+bool SimulatedCANBusNode::active()
+{
+    return true;
+}
+
+const char* SimulatedCANBusNode::getName() const
+{
+    return this->name;
+}
+
+SimulatedCANBus::SimulatedCANBus(OSInterface& osInterface, const SimulatedCANBusConfig& config) :
+    osInterface(osInterface), config(config), random(config.seed), lastMillis(osInterface.osMillis()), now_ns(0),
+    busIdle_ns(0), transmitter(nullptr), transmissionStart_ns(0), transmissionBits(0), transmissionStuffBits(0),
+    transmissionCorrupted(false), statistics()
+{
+}
+
+SimulatedCANBusNode* SimulatedCANBus::newCANInterfaceConnection(const char* name)
+{
+    std::lock_guard lock(this->mutex);
+    auto*           node = new SimulatedCANBusNode(*this, name);
+    this->nodes.push_back(node);
+    return node;
+}
+
+void SimulatedCANBus::removeNode(SimulatedCANBusNode* node)
+{
+    std::lock_guard lock(this->mutex);
+    if (this->transmitter == node)
+    {
+        // The transmission is abandoned, the bus is idle when it would have ended.
+        this->busIdle_ns  = this->transmissionStart_ns + getBitsTime_ns(this->transmissionBits);
+        this->transmitter = nullptr;
+    }
+    this->nodes.remove(node);
+}
+
+SimulatedCANBusStatistics SimulatedCANBus::getStatistics()
+{
+    std::lock_guard lock(this->mutex);
+    advance();
+    this->statistics.elapsedTime_ns = this->now_ns;
+    return this->statistics;
+}
+
+uint64_t SimulatedCANBus::getBitsTime_ns(const uint32_t bits) const
+{
+    return static_cast<uint64_t>(bits) * 1000000000 / this->config.bitrate;
+}
+
+uint32_t SimulatedCANBus::getFrameBits(const CANFrame& frame, uint32_t& stuffBits)
+{
+    bool     bits[SimulatedCANBus_StuffedBitsMax];
+    uint32_t count = 0;
+    auto     push  = [&bits, &count](const uint32_t value, const uint8_t width)
+    {
+        for (uint8_t i = width; i > 0; i--)
+        {
+            bits[count++] = (value >> (i - 1) & 1) != 0;
+        }
+    };
+
+    const uint32_t canId = ISOTP_GetCANId(frame.identifier);
+    push(0, 1); // Start of frame.
+    if (frame.extd)
+    {
+        push(canId >> 18, 11);
+        push(0b11, 2); // SRR and IDE.
+        push(canId & 0x3FFFF, 18);
+        push(frame.rtr, 1);
+        push(0, 2); // r1 and r0.
+    }
+    else
+    {
+        push(canId & 0x7FF, 11);
+        push(frame.rtr, 1);
+        push(0, 2); // IDE and r0.
+    }
+    push(frame.data_length_code, 4);
+    const uint8_t dataLength = frame.rtr ? 0 : std::min<uint8_t>(frame.data_length_code, CAN_FRAME_MAX_DLC);
+    for (uint8_t i = 0; i < dataLength; i++)
+    {
+        push(frame.data[i], 8);
+    }
+
+    uint16_t crc = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const bool invert = bits[i] != ((crc >> 14 & 1) != 0);
+        crc               = crc << 1 & 0x7FFF;
+        crc ^= invert ? SimulatedCANBus_CRC15Polynomial : 0;
+    }
+    push(crc, 15);
+
+    // A bit of the opposite value is inserted after 5 equal bits, and counts as the first of the next run.
+    stuffBits     = 0;
+    uint8_t run   = 0;
+    bool    level = true; // The bus is recessive before the start of frame.
+    for (uint32_t i = 0; i < count; i++)
+    {
+        run   = bits[i] == level ? run + 1 : 1;
+        level = bits[i];
+        if (run == 5)
+        {
+            stuffBits++;
+            level = !level;
+            run   = 1;
+        }
+    }
+    return count + stuffBits + SimulatedCANBus_UnstuffedBits;
+}
+
+uint32_t SimulatedCANBus::getArbitrationKey(const CANFrame& frame)
+{
+    // The base identifier is sent first, then a dominant RTR bit for a base frame or a recessive SRR bit for an
+    // extended frame, so a base frame wins against an extended frame with the same base identifier.
+    const uint32_t canId = ISOTP_GetCANId(frame.identifier);
+    return frame.extd ? (canId >> 18) << 19 | 1 << 18 | (canId & 0x3FFFF) : (canId & 0x7FF) << 19;
+}
+
+void SimulatedCANBus::advance()
+{
+    const uint32_t millis = this->osInterface.osMillis();
+    this->now_ns += static_cast<uint64_t>(millis - this->lastMillis) * 1000000;
+    this->lastMillis = millis;
+
+    while ((this->transmitter != nullptr || startTransmission()) &&
+           this->transmissionStart_ns + getBitsTime_ns(this->transmissionBits) <= this->now_ns)
+    {
+        endTransmission();
+    }
+}
+
+bool SimulatedCANBus::startTransmission()
+{
+    // The bus is taken as soon as it is idle and a frame is waiting, by the lowest identifier waiting at that time.
+    uint64_t start_ns = UINT64_MAX;
+    for (const SimulatedCANBusNode* node : this->nodes)
+    {
+        if (!node->txQueue.empty())
+        {
+            start_ns = std::min(start_ns, std::max(this->busIdle_ns, node->txQueue.front().time_ns));
+        }
+    }
+    if (start_ns > this->now_ns)
+    {
+        return false;
+    }
+
+    uint32_t contenders = 0;
+    for (SimulatedCANBusNode* node : this->nodes)
+    {
+        if (node->txQueue.empty() || node->txQueue.front().time_ns > start_ns)
+        {
+            continue;
+        }
+        contenders++;
+        if (this->transmitter == nullptr || getArbitrationKey(node->txQueue.front().frame) <
+                                                getArbitrationKey(this->transmitter->txQueue.front().frame))
+        {
+            this->transmitter = node;
+        }
+    }
+    this->statistics.arbitrationLosses += contenders - 1;
+
+    this->transmissionStart_ns  = start_ns;
+    this->transmissionBits      = getFrameBits(this->transmitter->txQueue.front().frame, this->transmissionStuffBits);
+    this->transmissionCorrupted = this->config.errorRate > 0 &&
+                                  std::uniform_real_distribution(0.0, 1.0)(this->random) < this->config.errorRate;
+    if (this->transmissionCorrupted)
+    {
+        // The error is detected somewhere before the end of frame, then the error frame takes the bus.
+        const uint32_t errorBit = std::uniform_int_distribution<uint32_t>(
+            1, this->transmissionBits - SimulatedCANBus_UnstuffedBits)(this->random);
+        this->transmissionBits = errorBit + SimulatedCANBus_ErrorFrameBits;
+    }
+    return true;
+}
+
+void SimulatedCANBus::endTransmission()
+{
+    const uint64_t end_ns = this->transmissionStart_ns + getBitsTime_ns(this->transmissionBits);
+    this->statistics.busyTime_ns += end_ns - this->transmissionStart_ns;
+    this->busIdle_ns = end_ns;
+
+    SimulatedCANBusNode* node = this->transmitter;
+    this->transmitter         = nullptr;
+    if (this->transmissionCorrupted)
+    {
+        this->statistics.busErrors++; // The frame stays first in its queue, it is sent again like a controller does.
+        return;
+    }
+
+    const CANFrame frame = node->txQueue.front().frame;
+    node->txQueue.pop_front();
+    uint32_t receivers = 0;
+    for (SimulatedCANBusNode* receiver : this->nodes)
+    {
+        if (receiver != node)
+        {
+            receiver->rxQueue.push_back(frame);
+            receivers++;
+        }
+    }
+
+    const uint64_t ack_ns = end_ns + static_cast<uint64_t>(this->config.ackDelay_us) * 1000;
+    if (receivers == 0)
+    {
+        this->statistics.unacknowledged++;
+        node->acks.push_back({ACK_ERROR, ack_ns});
+        return;
+    }
+    this->statistics.framesTransmitted++;
+    this->statistics.bitsTransmitted += this->transmissionBits;
+    this->statistics.stuffBits += this->transmissionStuffBits;
+    node->acks.push_back({ACK_SUCCESS, ack_ns});
+}
@@ -0,0 +1,159 @@
+#ifndef SIMULATEDCANBUS_H
+#define SIMULATEDCANBUS_H
+
+#include <deque>
+#include <list>
+#include <mutex>
+#include <random>
+
+#include "CANInterface.h"
+#include "OSInterface.h"
+
+/**
+ * Parameters of a SimulatedCANBus.
+ */
+struct SimulatedCANBusConfig
+{
+    uint32_t bitrate      = 500000; // Bits per second.
+    uint8_t  txQueueDepth = 3;      // Frames a node can have queued or on the bus, like TX mailboxes.
+    uint32_t ackDelay_us  = 0;      // From the end of a frame until its writer gets the ACK (TX complete interrupt).
+    double   errorRate    = 0;      // Probability of a transmission being destroyed by a bus error and retried.
+    uint32_t seed         = 1;      // Seed of the errors, so a run can be reproduced.
+};
+
+/**
+ * Counters of a SimulatedCANBus since it was created.
+ */
+struct SimulatedCANBusStatistics
+{
+    uint64_t framesTransmitted; // Frames received by the other nodes.
+    uint64_t bitsTransmitted;   // Bits of those frames, stuff bits and interframe space included.
+    uint64_t stuffBits;         // Of the frames transmitted.
+    uint64_t busyTime_ns;       // Time the bus carried frames or error frames.
+    uint64_t elapsedTime_ns;    // Time since the bus was created.
+    uint32_t arbitrationLosses; // Transmissions that were ready but lost arbitration against a lower identifier.
+    uint32_t busErrors;         // Transmissions destroyed by an injected error, the frame is sent again.
+    uint32_t txQueueFull;       // Writes refused because the TX queue of the node was full.
+    uint32_t unacknowledged;    // Frames sent with no other node on the bus, their writer gets ACK_ERROR.
+};
+
+class SimulatedCANBus;
+
+/**
+ * Node of a SimulatedCANBus. It sends its frames in the order they were written (a TX FIFO), which is the order ISOTP
+ * matches the ACKs in, and receives the frames of every other node.
+ */
+class SimulatedCANBusNode final : public CANInterface
+{
+public:
+    ~SimulatedCANBusNode() override;
+
+    SimulatedCANBusNode(const SimulatedCANBusNode&)            = delete;
+    SimulatedCANBusNode& operator=(const SimulatedCANBusNode&) = delete;
+
+    bool frameAvailable() override;
+
+    bool readFrame(CANFrame* frame) override;
+
+    /**
+     * This function is used to queue a frame to be sent.
+     * @param frame The frame.
+     * @return False if the TX queue of the node is full.
+     */
+    bool writeFrame(CANFrame* frame) override;
+
+    ACKResult getWriteFrameACK() override;
+
+    bool active() override;
+
+    [[nodiscard]] const char* getName() const;
+
+private:
+    friend class SimulatedCANBus;
+
+    struct QueuedFrame
+    {
+        CANFrame frame;
+        uint64_t time_ns; // When it was written.
+    };
+
+    struct QueuedACK
+    {
+        ACKResult ack;
+        uint64_t  time_ns; // When it is given to the writer.
+    };
+
+    SimulatedCANBusNode(SimulatedCANBus& bus, const char* name);
+
+    SimulatedCANBus&        bus;
+    const char*             name;
+    std::deque<QueuedFrame> txQueue;
+    std::deque<CANFrame>    rxQueue;
+    std::deque<QueuedACK>   acks;
+};
+
+/**
+ * Discrete-event model of a classic CAN bus, to see the effect of the bitrate, the 29 bit identifiers, bit stuffing,
+ * arbitration and TX queue depth on ISO-TP without hardware.
+ * Every frame takes its exact length on the wire, computed with its CRC and stuff bits, plus the interframe space.
+ * When the bus becomes idle, the first frame of each node's TX queue takes part in the arbitration, and the lowest
+ * identifier is sent. The bus follows the clock of the OSInterface lazily, it runs the events up to the current time
+ * whenever a node is used, so it works with a VirtualClockOSInterface (deterministic) or with the wall clock.
+ */
+class SimulatedCANBus
+{
+public:
+    /**
+     * @param osInterface The OSInterface whose clock the bus follows. It must outlive the bus.
+     * @param config The parameters of the bus.
+     */
+    explicit SimulatedCANBus(OSInterface& osInterface, const SimulatedCANBusConfig& config = {});
+
+    SimulatedCANBus(const SimulatedCANBus&)            = delete;
+    SimulatedCANBus& operator=(const SimulatedCANBus&) = delete;
+
+    /**
+     * This function is used to connect a new node to the bus.
+     * @param name The name of the node, it must outlive the node.
+     * @return The node, owned by the caller. It must be deleted before the bus.
+     */
+    SimulatedCANBusNode* newCANInterfaceConnection(const char* name = "node");
+
+    [[nodiscard]] SimulatedCANBusStatistics getStatistics();
+
+    /**
+     * This function is used to get the number of bits a frame takes on the bus.
+     * @param frame The frame.
+     * @param stuffBits Set to the stuff bits included in the result.
+     * @return The bits from the start of frame to the end of the interframe space.
+     */
+    static uint32_t getFrameBits(const CANFrame& frame, uint32_t& stuffBits);
+
+private:
+    friend class SimulatedCANBusNode;
+
+    static uint32_t getArbitrationKey(const CANFrame& frame);
+
+    void     advance();
+    bool     startTransmission();
+    void     endTransmission();
+    void     removeNode(SimulatedCANBusNode* node);
+    uint64_t getBitsTime_ns(uint32_t bits) const;
+
+    OSInterface&                    osInterface;
+    SimulatedCANBusConfig           config;
+    std::mutex                      mutex; // The nodes can be run from different threads.
+    std::mt19937                    random;
+    std::list<SimulatedCANBusNode*> nodes;
+    uint32_t                        lastMillis;
+    uint64_t                        now_ns;
+    uint64_t                        busIdle_ns; // When the current or last transmission ends.
+    SimulatedCANBusNode*            transmitter;
+    uint64_t                        transmissionStart_ns;
+    uint32_t                        transmissionBits;
+    uint32_t                        transmissionStuffBits;
+    bool                            transmissionCorrupted;
+    SimulatedCANBusStatistics       statistics;
+};
+
+#endif // SIMULATEDCANBUS_H
@@ -0,0 +1,241 @@
+#include "TraceReplay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+CANFrame toFrame(const ISOTP_TraceRecord& record)
+{
+    CANFrame frame         = {};
+    frame.extd             = 1;
+    frame.identifier       = ISOTP_GetN_AI(record.canId);
+    frame.data_length_code = record.dlc;
+    memcpy(frame.data, record.data, record.dlc);
+    return frame;
+}
+
+uint64_t percentile(const std::vector<uint64_t>& sorted, const uint32_t percent)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    return sorted[std::min<size_t>(sorted.size() - 1, sorted.size() * percent / 100)];
+}
+} // namespace
+
+void ReplayCANInterface::push(const CANFrame& frame)
+{
+    this->frames.push_back(frame);
+}
+
+bool ReplayCANInterface::frameAvailable()
+{
+    return !this->frames.empty();
+}
+
+bool ReplayCANInterface::readFrame(CANFrame* frame)
+{
+    if (this->frames.empty())
+    {
+        return false;
+    }
+    *frame = this->frames.front();
+    this->frames.pop_front();
+    return true;
+}
+
+bool ReplayCANInterface::writeFrame(CANFrame*)
+{
+    this->acks.push_back(ACK_SUCCESS);
+    this->framesWritten++;
+    return true;
+}
+
+ACKResult ReplayCANInterface::getWriteFrameACK()
+{
+    if (this->acks.empty())
+    {
+        return ACK_NONE;
+    }
+    const ACKResult ack = this->acks.front();
+    this->acks.pop_front();
+    return ack;
+}
+
+bool ReplayCANInterface::active()
+{
+    return true;
+}
+
+uint32_t ReplayCANInterface::getFramesWritten() const
+{
+    return this->framesWritten;
+}
+
+TraceReplay::TraceReplay(const uint32_t startTime_ms) : clock(startTime_ms), recordsSkipped(0)
+{
+}
+
+VirtualClockOSInterface& TraceReplay::getOSInterface()
+{
+    return this->clock;
+}
+
+ReplayCANInterface& TraceReplay::getCANInterface()
+{
+    return this->canInterface;
+}
+
+bool TraceReplay::loadBinary(const uint8_t* data, const size_t length)
+{
+    if (length < ISOTP_TraceHeaderSize || !ISOTP_TraceWriter::decodeHeader(data))
+    {
+        return false;
+    }
+
+    std::vector<ISOTP_TraceRecord> records;
+    for (size_t offset = ISOTP_TraceHeaderSize; offset + ISOTP_TraceRecordSize <= length;
+         offset += ISOTP_TraceRecordSize)
+    {
+        if (!ISOTP_TraceWriter::decode(data + offset, records.emplace_back()))
+        {
+            return false;
+        }
+    }
+
+    for (const ISOTP_TraceRecord& record : records)
+    {
+        if (record.event == ISOTP_TraceFrameRead)
+        {
+            this->frames.push_back(record);
+        }
+        else
+        {
+            this->recordsSkipped++;
+        }
+    }
+    return true;
+}
+
+bool TraceReplay::loadCandump(const char* text)
+{
+    const size_t framesBefore = this->frames.size();
+    for (const char* line = text; *line != '\0';)
+    {
+        const char*  end    = strchr(line, '\n');
+        const size_t length = end != nullptr ? end - line : strlen(line);
+
+        ISOTP_TraceRecord record{};
+        if (ISOTP_TraceWriter::fromCandump(line, record))
+        {
+            this->frames.push_back(record);
+        }
+        else if (strspn(line, " \t\r") < length) // Blank lines are not records.
+        {
+            this->recordsSkipped++;
+        }
+        line += end != nullptr ? length + 1 : length;
+    }
+    return this->frames.size() > framesBefore;
+}
+
+bool TraceReplay::loadFile(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    std::vector<uint8_t> content;
+    uint8_t              chunk[4096];
+    size_t               read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        content.insert(content.end(), chunk, chunk + read);
+    }
+    fclose(file);
+
+    if (content.size() >= ISOTP_TraceHeaderSize && ISOTP_TraceWriter::decodeHeader(content.data()))
+    {
+        return loadBinary(content.data(), content.size());
+    }
+    content.push_back('\0');
+    return loadCandump(reinterpret_cast<const char*>(content.data()));
+}
+
+uint32_t TraceReplay::getFrameCount() const
+{
+    return this->frames.size();
+}
+
+TraceReplayReport TraceReplay::run(ISOTP& isotp, const TraceReplayTiming timing)
+{
+    TraceReplayReport report{};
+    report.recordsSkipped = this->recordsSkipped;
+
+    VirtualClockDriver driver(this->clock);
+    if (!driver.addInstance(isotp))
+    {
+        return report;
+    }
+
+    const ISOTP_StatisticsSnapshot before        = isotp.getStatistics();
+    const uint32_t                 framesWritten = this->canInterface.getFramesWritten();
+    const uint32_t                 start         = this->clock.osMillis();
+    std::vector<uint64_t>          processing_ns;
+    processing_ns.reserve(this->frames.size());
+
+    for (const ISOTP_TraceRecord& record : this->frames)
+    {
+        if (timing == TraceReplayRecordedTiming)
+        {
+            const uint32_t arrival = start + (record.timestamp_ms - this->frames.front().timestamp_ms);
+            if (const uint32_t now = this->clock.osMillis(); arrival > now)
+            {
+                driver.runFor(arrival - now);
+            }
+        }
+
+        // The frame is processed once it is read, nothing is due and the frames written in response are ACKed. The
+        // clock moves by at most 1 ms per step, so it does not jump to a deadline the next frame arrives before.
+        this->canInterface.push(toFrame(record));
+        const auto processingStart = std::chrono::steady_clock::now();
+        while (this->canInterface.frameAvailable() || isotp.hasPendingCANEvents() || isotp.isWaitingForACKs() ||
+               isotp.getNextRunTime() <= this->clock.osMillis())
+        {
+            driver.runStep(this->clock.osMillis() + 1);
+        }
+        const auto processingTime = std::chrono::steady_clock::now() - processingStart;
+        processing_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(processingTime).count());
+        report.framesReplayed++;
+    }
+    driver.runFor(TraceReplayDrainTime_ms);
+
+    const ISOTP_StatisticsSnapshot after = isotp.getStatistics();
+    for (uint8_t result = 0; result < ISOTP_N_ResultCount; result++)
+    {
+        report.indicationResults[result] = after.indicationResults[result] - before.indicationResults[result];
+        if (result != N_OK)
+        {
+            report.protocolErrors += report.indicationResults[result];
+            report.protocolErrors += after.requestResults[result] - before.requestResults[result];
+        }
+    }
+    report.pdusReassembled = report.indicationResults[N_OK];
+    report.framesWritten   = this->canInterface.getFramesWritten() - framesWritten;
+    report.duration_ms     = this->clock.osMillis() - start;
+
+    for (const uint64_t duration : processing_ns)
+    {
+        report.processingTotal_ns += duration;
+    }
+    std::ranges::sort(processing_ns);
+    report.processingP50_ns = percentile(processing_ns, 50);
+    report.processingP99_ns = percentile(processing_ns, 99);
+    report.processingMax_ns = processing_ns.empty() ? 0 : processing_ns.back();
+    return report;
+}
@@ -0,0 +1,127 @@
+#ifndef TRACEREPLAY_H
+#define TRACEREPLAY_H
+
+#include <deque>
+#include <vector>
+
+#include "ISOTP.h"
+#include "ISOTP_Trace.h"
+#include "VirtualClockOSInterface.h"
+
+constexpr uint32_t TraceReplayDrainTime_ms = 10000; // Virtual time the replay runs for after the last frame.
+
+using TraceReplayTiming = enum TraceReplayTiming {
+    TraceReplayRecordedTiming,  // The frames arrive at their recorded time, so STmin and Timer_N behave as recorded.
+    TraceReplayAsFastAsPossible // The frames arrive as soon as the previous one is processed.
+};
+
+/**
+ * CANInterface that serves the frames given to push() and ACKs every frame written.
+ */
+class ReplayCANInterface final : public CANInterface
+{
+public:
+    /**
+     * This function is used to queue a frame to be read.
+     * @param frame The frame.
+     */
+    void push(const CANFrame& frame);
+
+    bool frameAvailable() override;
+
+    bool readFrame(CANFrame* frame) override;
+
+    bool writeFrame(CANFrame* frame) override;
+
+    ACKResult getWriteFrameACK() override;
+
+    bool active() override;
+
+    [[nodiscard]] uint32_t getFramesWritten() const;
+
+private:
+    std::deque<CANFrame>  frames;
+    std::deque<ACKResult> acks;
+    uint32_t              framesWritten = 0;
+};
+
+/**
+ * Outcome of a TraceReplay run.
+ */
+struct TraceReplayReport
+{
+    uint32_t framesReplayed;     // Frames given to the ISOTP object.
+    uint32_t recordsSkipped;     // Records that are not frames read from the bus (frames written, ACKs, drops).
+    uint32_t framesWritten;      // Frames written by the ISOTP object, such as FCs.
+    uint32_t pdusReassembled;    // Indications with N_OK, SFs included.
+    uint32_t protocolErrors;     // Indications and requests finished with another N_Result.
+    uint32_t indicationResults[ISOTP_N_ResultCount];
+    uint32_t duration_ms;        // Virtual time of the replay, including TraceReplayDrainTime_ms.
+    uint64_t processingTotal_ns; // Wall clock time spent in the runSteps that read the frames.
+    uint64_t processingP50_ns;   // Per frame.
+    uint64_t processingP99_ns;   // Per frame.
+    uint64_t processingMax_ns;   // Per frame.
+};
+
+/**
+ * Feeds a recorded CAN trace (a binary trace of ISOTP_TraceWriter or a candump -L log) into an ISOTP object, to turn
+ * captures into reproducible regression tests and benchmarks of the reception path without hardware.
+ * The ISOTP object must be created with getOSInterface() and getCANInterface(), and its N_SA must be the one of the
+ * node the trace was captured on (or the N_TA of the frames to replay). Only the frames read from the bus are replayed,
+ * the frames the node wrote are generated again by the ISOTP object.
+ */
+class TraceReplay
+{
+public:
+    /**
+     * @param startTime_ms The time of the virtual clock when the first frame is replayed.
+     */
+    explicit TraceReplay(uint32_t startTime_ms = 0);
+
+    VirtualClockOSInterface& getOSInterface();
+
+    ReplayCANInterface& getCANInterface();
+
+    /**
+     * This function is used to add the records of a binary trace.
+     * @param data The trace, starting with its header.
+     * @param length The length of the trace.
+     * @return True if the trace was loaded, false if the header or a record is invalid (nothing is added). A last
+     * record cut by the end of the capture is ignored.
+     */
+    bool loadBinary(const uint8_t* data, size_t length);
+
+    /**
+     * This function is used to add the frames of a candump -L log. The lines without a 29 bit classic CAN frame are
+     * counted as skipped.
+     * @param text The log, null terminated.
+     * @return True if at least one frame was loaded.
+     */
+    bool loadCandump(const char* text);
+
+    /**
+     * This function is used to load a binary trace or candump -L log from a file, by checking its header.
+     * @param path The path of the file.
+     * @return True if the file was read and loaded.
+     */
+    bool loadFile(const char* path);
+
+    [[nodiscard]] uint32_t getFrameCount() const;
+
+    /**
+     * This function is used to replay the loaded frames and let the ISOTP object run TraceReplayDrainTime_ms more, so
+     * the receptions the trace does not complete time out.
+     * @param isotp The ISOTP object, it must not be run by anything else during the replay.
+     * @param timing When the frames are given to the ISOTP object.
+     * @return The outcome of the replay.
+     */
+    TraceReplayReport run(ISOTP& isotp, TraceReplayTiming timing);
+
+private:
+    VirtualClockOSInterface        clock;
+    ReplayCANInterface             canInterface;
+    std::vector<ISOTP_TraceRecord> frames;
+    uint32_t                       recordsSkipped;
+};
+
+#endif // TRACEREPLAY_H
@@ -0,0 +1,112 @@
+#include "TwoNodeTransfer.h"
+
+#include <cassert>
+
+TwoNodeTransfer* TwoNodeTransfer::current = nullptr;
+
+TwoNodeTransfer::TwoNodeTransfer(VirtualClockOSInterface& clock, const TwoNodeTransferConfig& config) :
+    network(std::make_unique<LocalCANNetwork>(clock)), senderConnection(network->newCANInterfaceConnection()),
+    receiverConnection(network->newCANInterfaceConnection()),
+    sender(1, config.senderMemory, N_USData_confirm_cb, nullptr, nullptr, clock, *senderConnection, 0, {0, ms},
+           "senderISOTP"),
+    receiver(2, config.receiverMemory, nullptr, N_USData_indication_cb, nullptr, clock, *receiverConnection,
+             config.receiverBlockSize, config.receiverSTmin, "receiverISOTP"),
+    driver(clock), confirms(0), indications(0), confirmResult(NOT_STARTED), indicationResult(NOT_STARTED)
+{
+    assert(current == nullptr && "Only one TwoNodeTransfer can exist at a time");
+    current = this;
+    this->driver.addInstance(this->sender);
+    this->driver.addInstance(this->receiver);
+}
+
+TwoNodeTransfer::TwoNodeTransfer(VirtualClockOSInterface& clock, CANInterface& senderInterface,
+                                 CANInterface& receiverInterface, const TwoNodeTransferConfig& config) :
+    sender(1, config.senderMemory, N_USData_confirm_cb, nullptr, nullptr, clock, senderInterface, 0, {0, ms},
+           "senderISOTP"),
+    receiver(2, config.receiverMemory, nullptr, N_USData_indication_cb, nullptr, clock, receiverInterface,
+             config.receiverBlockSize, config.receiverSTmin, "receiverISOTP"),
+    driver(clock), confirms(0), indications(0), confirmResult(NOT_STARTED), indicationResult(NOT_STARTED)
+{
+    assert(current == nullptr && "Only one TwoNodeTransfer can exist at a time");
+    current = this;
+    this->driver.addInstance(this->sender);
+    this->driver.addInstance(this->receiver);
+}
+
+TwoNodeTransfer::~TwoNodeTransfer()
+{
+    current = nullptr;
+}
+
+bool TwoNodeTransfer::send(const uint8_t* message, const uint32_t length)
+{
+    return this->sender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, length);
+}
+
+bool TwoNodeTransfer::runUntilDone(const uint32_t confirms, const uint32_t indications, const uint32_t timeout_ms)
+{
+    return this->driver.runUntil([this, confirms, indications]
+                                 { return this->confirms >= confirms && this->indications >= indications; },
+                                 timeout_ms);
+}
+
+ISOTP& TwoNodeTransfer::getSender()
+{
+    return this->sender;
+}
+
+ISOTP& TwoNodeTransfer::getReceiver()
+{
+    return this->receiver;
+}
+
+VirtualClockDriver& TwoNodeTransfer::getDriver()
+{
+    return this->driver;
+}
+
+uint32_t TwoNodeTransfer::getConfirms() const
+{
+    return this->confirms;
+}
+
+uint32_t TwoNodeTransfer::getIndications() const
+{
+    return this->indications;
+}
+
+N_Result TwoNodeTransfer::getConfirmResult() const
+{
+    return this->confirmResult;
+}
+
+N_Result TwoNodeTransfer::getIndicationResult() const
+{
+    return this->indicationResult;
+}
+
+const std::vector<uint8_t>& TwoNodeTransfer::getReceivedMessage() const
+{
+    return this->receivedMessage;
+}
+
+void TwoNodeTransfer::N_USData_confirm_cb(N_AI, const N_Result nResult, Mtype)
+{
+    current->confirms++;
+    current->confirmResult = nResult;
+}
+
+void TwoNodeTransfer::N_USData_indication_cb(N_AI, const uint8_t* messageData, const uint32_t messageLength,
+                                             const N_Result nResult, Mtype)
+{
+    current->indications++;
+    current->indicationResult = nResult;
+    if (messageData != nullptr)
+    {
+        current->receivedMessage.assign(messageData, messageData + messageLength);
+    }
+    else
+    {
+        current->receivedMessage.clear();
+    }
+}
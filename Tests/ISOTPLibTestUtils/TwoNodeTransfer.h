@@ -0,0 +1,101 @@
+#ifndef TWONODETRANSFER_H
+#define TWONODETRANSFER_H
+
+#include <memory>
+#include <vector>
+
+#include "ISOTP.h"
+#include "LocalCANNetwork.h"
+#include "VirtualClockOSInterface.h"
+
+/**
+ * Parameters of the ISOTP objects of a TwoNodeTransfer. Only the receiver sends FCs, so only its BS and STmin are used.
+ */
+struct TwoNodeTransferConfig
+{
+    uint32_t senderMemory      = 4096;    // totalAvailableMemoryForRunners of the sender.
+    uint32_t receiverMemory    = 4096;    // totalAvailableMemoryForRunners of the receiver.
+    uint8_t  receiverBlockSize = 0;       // BS sent in the FCs of the receiver.
+    STmin    receiverSTmin     = {0, ms}; // STmin sent in the FCs of the receiver.
+};
+
+/**
+ * A sender (N_SA 1) and a receiver (N_SA 2) run by a VirtualClockDriver, to test what a transfer between two ISOTP
+ * objects does without repeating their setup. The confirms and indications are counted, and the last indicated message
+ * is kept.
+ * The callbacks of ISOTP have no context, so only one TwoNodeTransfer can exist at a time.
+ */
+class TwoNodeTransfer
+{
+public:
+    /**
+     * This constructor connects the objects through a LocalCANNetwork owned by the transfer.
+     * @param clock The clock of the objects, it must outlive the transfer.
+     * @param config The parameters of the objects.
+     */
+    explicit TwoNodeTransfer(VirtualClockOSInterface& clock, const TwoNodeTransferConfig& config = {});
+
+    /**
+     * This constructor connects the objects through the given CANInterfaces, for a simulated bus or injected faults.
+     * @param clock The clock of the objects, it must outlive the transfer.
+     * @param senderInterface The CANInterface of the sender, it must outlive the transfer.
+     * @param receiverInterface The CANInterface of the receiver, it must outlive the transfer.
+     * @param config The parameters of the objects.
+     */
+    TwoNodeTransfer(VirtualClockOSInterface& clock, CANInterface& senderInterface, CANInterface& receiverInterface,
+                    const TwoNodeTransferConfig& config = {});
+
+    ~TwoNodeTransfer();
+
+    TwoNodeTransfer(const TwoNodeTransfer&)            = delete;
+    TwoNodeTransfer& operator=(const TwoNodeTransfer&) = delete;
+
+    /**
+     * This function is used to request a physical message from the sender to the receiver.
+     * @param message The message.
+     * @param length The length of the message.
+     * @return The result of N_USData_request.
+     */
+    bool send(const uint8_t* message, uint32_t length);
+
+    /**
+     * This function is used to run the objects until the counts of confirms and indications are reached.
+     * @param confirms The confirms to wait for, since the transfer was created.
+     * @param indications The indications to wait for, since the transfer was created.
+     * @param timeout_ms The virtual milliseconds to run for at most.
+     * @return True if both counts were reached, false on timeout.
+     */
+    bool runUntilDone(uint32_t confirms, uint32_t indications, uint32_t timeout_ms = 10000);
+
+    ISOTP&              getSender();
+    ISOTP&              getReceiver();
+    VirtualClockDriver& getDriver();
+
+    [[nodiscard]] uint32_t                    getConfirms() const;
+    [[nodiscard]] uint32_t                    getIndications() const;
+    [[nodiscard]] N_Result                    getConfirmResult() const;    // NOT_STARTED before the first confirm.
+    [[nodiscard]] N_Result                    getIndicationResult() const; // NOT_STARTED before the first indication.
+    [[nodiscard]] const std::vector<uint8_t>& getReceivedMessage() const;
+
+    // Callbacks of the sender and the receiver, also usable by other ISOTP objects that report to this transfer.
+    static void N_USData_confirm_cb(N_AI nAi, N_Result nResult, Mtype mtype);
+    static void N_USData_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength, N_Result nResult,
+                                       Mtype mtype);
+
+private:
+    static TwoNodeTransfer* current;
+
+    std::unique_ptr<LocalCANNetwork> network; // nullptr if the CANInterfaces were given.
+    std::unique_ptr<CANInterface>    senderConnection;
+    std::unique_ptr<CANInterface>    receiverConnection;
+    ISOTP                            sender;
+    ISOTP                            receiver;
+    VirtualClockDriver               driver;
+    uint32_t                         confirms;
+    uint32_t                         indications;
+    N_Result                         confirmResult;
+    N_Result                         indicationResult;
+    std::vector<uint8_t>             receivedMessage;
+};
+
+#endif // TWONODETRANSFER_H
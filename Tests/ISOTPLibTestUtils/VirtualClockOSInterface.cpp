@@ -0,0 +1,145 @@
+#include "VirtualClockOSInterface.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+
+namespace
+{
+class VirtualClockMutex final : public OSInterface_Mutex
+{
+public:
+    bool signal() override
+    {
+        mutex.unlock();
+        return true;
+    }
+
+    // Only other threads can hold the mutex, so the timeout is in real time.
+    bool wait(const uint32_t max_time_to_wait_ms) override
+    {
+        return mutex.try_lock_for(std::chrono::milliseconds(max_time_to_wait_ms));
+    }
+
+private:
+    std::timed_mutex mutex;
+};
+} // namespace
+
+VirtualClockOSInterface::VirtualClockOSInterface(const uint32_t startTime_ms) : now_ms(startTime_ms)
+{
+}
+
+uint32_t VirtualClockOSInterface::osMillis()
+{
+    return now_ms.load();
+}
+
+void VirtualClockOSInterface::osSleep(const uint32_t ms)
+{
+    advance(ms);
+}
+
+OSInterface_Mutex* VirtualClockOSInterface::osCreateMutex()
+{
+    return new VirtualClockMutex();
+}
+
+void* VirtualClockOSInterface::osMalloc(const uint32_t size)
+{
+    return malloc(size);
+}
+
+void VirtualClockOSInterface::osFree(void* ptr)
+{
+    free(ptr);
+}
+
+void VirtualClockOSInterface::advance(const uint32_t ms)
+{
+    now_ms.fetch_add(ms);
+}
+
+void VirtualClockOSInterface::advanceTo(const uint32_t timestamp_ms)
+{
+    uint32_t now = now_ms.load();
+    while (timestamp_ms > now && !now_ms.compare_exchange_weak(now, timestamp_ms))
+    {
+    }
+}
+
+VirtualClockDriver::VirtualClockDriver(VirtualClockOSInterface& clock) : clock(clock), executor(clock), stepCount(0)
+{
+}
+
+bool VirtualClockDriver::addInstance(ISOTP& isotp)
+{
+    if (!this->executor.addInstance(isotp))
+    {
+        return false;
+    }
+    this->instances.push_back(&isotp);
+    return true;
+}
+
+bool VirtualClockDriver::runStep(const uint32_t limit_ms)
+{
+    this->stepCount++;
+
+    const uint32_t nextRunTime = this->executor.runStep();
+    const uint32_t now         = this->clock.osMillis();
+
+    // The executor returns 0 while a frame or an ACK is pending.
+    if (nextRunTime <= now)
+    {
+        // ISOTP::runStep() runs at most once per millisecond, so the pending work needs the clock to move.
+        if (now < limit_ms)
+        {
+            this->clock.advance(1);
+        }
+        return true;
+    }
+
+    if (nextRunTime == ISOTP_NoNextRunTime)
+    {
+        return false;
+    }
+
+    this->clock.advanceTo(std::min(nextRunTime, limit_ms));
+    return true;
+}
+
+bool VirtualClockDriver::runUntil(const std::function<bool()>& condition, const uint32_t timeout_ms)
+{
+    const uint32_t deadline = this->clock.osMillis() + timeout_ms;
+    while (!condition())
+    {
+        if (this->clock.osMillis() >= deadline)
+        {
+            return false;
+        }
+        if (!runStep(deadline) && !condition())
+        {
+            this->clock.advanceTo(deadline); // Idle, nothing can happen before the deadline.
+        }
+    }
+    return true;
+}
+
+void VirtualClockDriver::runFor(const uint32_t duration_ms)
+{
+    const uint32_t deadline = this->clock.osMillis() + duration_ms;
+    while (this->clock.osMillis() < deadline)
+    {
+        if (!runStep(deadline))
+        {
+            this->clock.advanceTo(deadline);
+        }
+    }
+}
+
+uint64_t VirtualClockDriver::getStepCount() const
+{
+    return this->stepCount;
+}
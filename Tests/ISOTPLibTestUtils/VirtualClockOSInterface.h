@@ -0,0 +1,101 @@
+#ifndef VIRTUALCLOCKOSINTERFACE_H
+#define VIRTUALCLOCKOSINTERFACE_H
+
+#include <atomic>
+#include <functional>
+
+#include "ISOTPExecutor.h"
+#include "OSInterface.h"
+
+/**
+ * OSInterface whose clock only moves when it is told to, so the timing of ISOTP (Timer_N, STmin, runStep periods) is
+ * deterministic and does not depend on the load of the machine.
+ * osSleep() advances the clock instead of blocking. The mutexes and the heap are the ones of the host.
+ */
+class VirtualClockOSInterface final : public OSInterface
+{
+public:
+    explicit VirtualClockOSInterface(uint32_t startTime_ms = 0);
+
+    uint32_t osMillis() override;
+
+    void osSleep(uint32_t ms) override;
+
+    OSInterface_Mutex* osCreateMutex() override;
+
+    void* osMalloc(uint32_t size) override;
+
+    void osFree(void* ptr) override;
+
+    /**
+     * This function is used to move the clock forward.
+     * @param ms The milliseconds to add to the clock.
+     */
+    void advance(uint32_t ms);
+
+    /**
+     * This function is used to move the clock to a timestamp. The clock never goes backwards.
+     * @param timestamp_ms The timestamp to move the clock to, ignored if it is not after the current time.
+     */
+    void advanceTo(uint32_t timestamp_ms);
+
+private:
+    std::atomic<uint32_t> now_ms;
+};
+
+/**
+ * Runs ISOTP objects on a VirtualClockOSInterface, jumping the clock straight to the earliest deadline when there is
+ * nothing else to do, so timeouts and long transfers take as long as the work they need instead of their duration.
+ * The objects are run through an ISOTPExecutor. While any of them has a frame or an ACK pending, the clock advances by
+ * 1 ms per step, which is the shortest period ISOTP::runStep() runs with.
+ */
+class VirtualClockDriver
+{
+public:
+    /**
+     * @param clock The clock of the ISOTP objects, it must outlive the driver.
+     */
+    explicit VirtualClockDriver(VirtualClockOSInterface& clock);
+
+    /**
+     * This function is used to add an ISOTP object to be run by the driver.
+     * @param isotp The ISOTP object. It must use the clock of the driver and outlive its registration.
+     * @return True if the object was added, false if it was already added.
+     */
+    bool addInstance(ISOTP& isotp);
+
+    /**
+     * This function is used to run all the objects once and move the clock to the next time they need to run.
+     * @param limit_ms The clock does not move past this timestamp.
+     * @return False if nothing is scheduled nor pending, so only an external event (a request) can make progress.
+     */
+    bool runStep(uint32_t limit_ms = ISOTP_NoNextRunTime);
+
+    /**
+     * This function is used to run the objects until a condition is met or the clock reaches a timeout.
+     * @param condition Checked after every step, the driver stops when it returns true.
+     * @param timeout_ms The virtual milliseconds to run for at most, from the current time.
+     * @return True if the condition was met, false on timeout.
+     */
+    bool runUntil(const std::function<bool()>& condition, uint32_t timeout_ms);
+
+    /**
+     * This function is used to run the objects for a period of virtual time.
+     * @param duration_ms The virtual milliseconds to run for.
+     */
+    void runFor(uint32_t duration_ms);
+
+    /**
+     * This function is used to get the number of steps run so far.
+     * @return The number of calls to runStep().
+     */
+    [[nodiscard]] uint64_t getStepCount() const;
+
+private:
+    VirtualClockOSInterface& clock;
+    ISOTPExecutor            executor;
+    std::vector<ISOTP*>      instances;
+    uint64_t                 stepCount;
+};
+
+#endif // VIRTUALCLOCKOSINTERFACE_H
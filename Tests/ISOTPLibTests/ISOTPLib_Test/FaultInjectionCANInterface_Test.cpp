@@ -0,0 +1,109 @@
+#include "FaultInjectionCANInterface.h"
+
+#include "ISOTP.h"
+#include "LocalCANNetwork.h"
+#include "TraceReplay.h"
+#include "TwoNodeTransfer.h"
+#include "VirtualClockOSInterface.h"
+#include "gtest/gtest.h"
+
+static CANFrame FaultInjection_frame(const uint8_t pci)
+{
+    CANFrame frame         = {};
+    frame.extd             = 1;
+    frame.identifier       = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 2, 1);
+    frame.data_length_code = 3;
+    frame.data[0]          = pci;
+    return frame;
+}
+
+TEST(FaultInjectionCANInterface, passThrough)
+{
+    VirtualClockOSInterface    clock;
+    auto*                      inner = new ReplayCANInterface();
+    FaultInjectionCANInterface canInterface(inner, clock, {});
+
+    inner->push(FaultInjection_frame(0x21));
+    inner->push(FaultInjection_frame(0x30));
+    CANFrame frame = {};
+    ASSERT_TRUE(canInterface.frameAvailable());
+    ASSERT_TRUE(canInterface.readFrame(&frame));
+    EXPECT_EQ(0x21, frame.data[0]);
+    ASSERT_TRUE(canInterface.readFrame(&frame));
+    EXPECT_EQ(0x30, frame.data[0]);
+    EXPECT_FALSE(canInterface.frameAvailable());
+
+    EXPECT_TRUE(canInterface.writeFrame(&frame));
+    EXPECT_EQ(1, inner->getFramesWritten());
+    EXPECT_EQ(ACK_SUCCESS, canInterface.getWriteFrameACK());
+    EXPECT_EQ(ACK_NONE, canInterface.getWriteFrameACK());
+    EXPECT_TRUE(canInterface.active());
+
+    const FaultInjectionCounters counters = canInterface.getCounters();
+    EXPECT_EQ(0, counters.ackErrors + counters.lateFCs + counters.wrongSNs);
+}
+
+TEST(FaultInjectionCANInterface, faults)
+{
+    VirtualClockOSInterface    clock;
+    auto*                      inner = new ReplayCANInterface();
+    FaultInjectionConfig       config{.seed = 7, .ackErrorRate = 1, .lateFCRate = 1, .lateFCDelay_ms = 100,
+                                      .wrongSNRate = 1};
+    FaultInjectionCANInterface canInterface(inner, clock, config);
+
+    // The SN of the CFs is incremented, and wraps around.
+    CANFrame frame = {};
+    inner->push(FaultInjection_frame(0x2F));
+    ASSERT_TRUE(canInterface.readFrame(&frame));
+    EXPECT_EQ(0x20, frame.data[0]);
+
+    // The FC is held while the frames behind it are read.
+    inner->push(FaultInjection_frame(0x30));
+    inner->push(FaultInjection_frame(0x03));
+    ASSERT_TRUE(canInterface.readFrame(&frame));
+    EXPECT_EQ(0x03, frame.data[0]);
+    EXPECT_FALSE(canInterface.frameAvailable());
+    clock.advance(99);
+    EXPECT_FALSE(canInterface.frameAvailable());
+    clock.advance(1);
+    ASSERT_TRUE(canInterface.frameAvailable());
+    ASSERT_TRUE(canInterface.readFrame(&frame));
+    EXPECT_EQ(0x30, frame.data[0]);
+
+    EXPECT_TRUE(canInterface.writeFrame(&frame));
+    EXPECT_EQ(ACK_ERROR, canInterface.getWriteFrameACK());
+
+    const FaultInjectionCounters counters = canInterface.getCounters();
+    EXPECT_EQ(1, counters.ackErrors);
+    EXPECT_EQ(1, counters.lateFCs);
+    EXPECT_EQ(1, counters.wrongSNs);
+}
+
+TEST(FaultInjectionCANInterface, transfer)
+{
+    VirtualClockOSInterface clock;
+    LocalCANNetwork         network(clock);
+
+    // Every ACK of the sender is an error, and the receiver gets a wrong SN.
+    FaultInjectionCANInterface senderInterface(network.newCANInterfaceConnection(), clock, {.ackErrorRate = 1});
+    FaultInjectionCANInterface receiverInterface(network.newCANInterfaceConnection(), clock, {.wrongSNRate = 1});
+    TwoNodeTransfer            transfer(clock, senderInterface, receiverInterface);
+
+    // The sender gives up after the FF, so the receiver never gets a CF.
+    constexpr uint8_t message[20] = {};
+    ASSERT_TRUE(transfer.send(message, sizeof(message)));
+    ASSERT_TRUE(transfer.runUntilDone(1, 1));
+    EXPECT_NE(N_OK, transfer.getConfirmResult());
+    EXPECT_EQ(N_TIMEOUT_Cr, transfer.getIndicationResult());
+    EXPECT_EQ(1, senderInterface.getCounters().ackErrors);
+
+    // Without ACK errors, the transfer reaches the receiver, which refuses the first CF.
+    FaultInjectionCANInterface cleanInterface(network.newCANInterfaceConnection(), clock, {});
+    ISOTP cleanSender(3, 4096, TwoNodeTransfer::N_USData_confirm_cb, nullptr, nullptr, clock, cleanInterface, 0,
+                      {0, ms}, "cleanSenderISOTP");
+    ASSERT_TRUE(transfer.getDriver().addInstance(cleanSender));
+    ASSERT_TRUE(cleanSender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+    ASSERT_TRUE(transfer.runUntilDone(1, 2));
+    EXPECT_EQ(N_WRONG_SN, transfer.getIndicationResult());
+    EXPECT_EQ(1, receiverInterface.getCounters().wrongSNs);
+}
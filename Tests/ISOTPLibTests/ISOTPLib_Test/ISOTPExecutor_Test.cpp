@@ -0,0 +1,175 @@
+#include "ISOTPExecutor.h"
+
+#include <LocalCANNetwork.h>
+#include "ASSERT_MACROS.h"
+#include "LinuxOSInterface.h"
+#include "VirtualClockOSInterface.h"
+#include "gtest/gtest.h"
+
+static LinuxOSInterface linuxOSInterface;
+
+static uint32_t ISOTPExecutor_confirm_cb_calls = 0;
+void            ISOTPExecutor_confirm_cb(N_AI nAi, N_Result nResult, Mtype mtype)
+{
+    ISOTPExecutor_confirm_cb_calls++;
+    EXPECT_EQ(N_OK, nResult);
+}
+
+constexpr char     ISOTPExecutor_message[]     = "This message needs several consecutive frames to be sent.";
+constexpr uint32_t ISOTPExecutor_messageLength = sizeof(ISOTPExecutor_message);
+
+static uint32_t ISOTPExecutor_indication_cb_calls = 0;
+void ISOTPExecutor_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength, N_Result nResult,
+                                 Mtype mtype)
+{
+    ISOTPExecutor_indication_cb_calls++;
+    EXPECT_EQ(N_OK, nResult);
+    ASSERT_EQ(ISOTPExecutor_messageLength, messageLength);
+    EXPECT_EQ_ARRAY(ISOTPExecutor_message, messageData, ISOTPExecutor_messageLength);
+}
+
+void ISOTPExecutor_FF_indication_cb(const N_AI nAi, const uint32_t messageLength, const Mtype mtype) {}
+
+TEST(ISOTPExecutor, addRemoveInstance)
+{
+    LocalCANNetwork canNetwork(linuxOSInterface);
+    CANInterface*   canInterface1 = canNetwork.newCANInterfaceConnection();
+    CANInterface*   canInterface2 = canNetwork.newCANInterfaceConnection();
+
+    ISOTP isotp1(1, 2000, ISOTPExecutor_confirm_cb, ISOTPExecutor_indication_cb, ISOTPExecutor_FF_indication_cb,
+                 linuxOSInterface, *canInterface1, 2, ISOTP_DefaultSTmin);
+    ISOTP isotp2(2, 2000, ISOTPExecutor_confirm_cb, ISOTPExecutor_indication_cb, ISOTPExecutor_FF_indication_cb,
+                 linuxOSInterface, *canInterface2, 2, ISOTP_DefaultSTmin);
+
+    ISOTPExecutor executor(linuxOSInterface, 2);
+    EXPECT_EQ(2, executor.getWorkerCount());
+    EXPECT_EQ(0, executor.getInstanceCount());
+
+    EXPECT_TRUE(executor.addInstance(isotp1));
+    EXPECT_FALSE(executor.addInstance(isotp1));
+    EXPECT_TRUE(executor.addInstance(isotp2));
+    EXPECT_EQ(2, executor.getInstanceCount());
+
+    // One instance per worker, nothing to do once both have run.
+    EXPECT_EQ(ISOTP_NoNextRunTime, executor.runStep(0));
+    EXPECT_EQ(ISOTP_NoNextRunTime, executor.runStep(1));
+    EXPECT_EQ(ISOTP_NoNextRunTime, executor.getNextRunTime());
+    EXPECT_EQ(ISOTP_NoNextRunTime, executor.runStep(2));
+
+    EXPECT_TRUE(executor.removeInstance(isotp1));
+    EXPECT_FALSE(executor.removeInstance(isotp1));
+    EXPECT_EQ(1, executor.getInstanceCount());
+
+    delete canInterface1;
+    delete canInterface2;
+}
+
+TEST(ISOTPExecutor, nextRunTimeAfterRequest)
+{
+    LocalCANNetwork canNetwork(linuxOSInterface);
+    CANInterface*   canInterface = canNetwork.newCANInterfaceConnection();
+
+    ISOTP isotp(1, 2000, ISOTPExecutor_confirm_cb, ISOTPExecutor_indication_cb, ISOTPExecutor_FF_indication_cb,
+                linuxOSInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+
+    ISOTPExecutor executor(linuxOSInterface);
+    EXPECT_TRUE(executor.addInstance(isotp));
+    EXPECT_EQ(ISOTP_NoNextRunTime, executor.runStep());
+
+    EXPECT_TRUE(isotp.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                                       reinterpret_cast<const uint8_t*>(ISOTPExecutor_message),
+                                       ISOTPExecutor_messageLength));
+    EXPECT_EQ(0, isotp.getNextRunTime());
+
+    // The request is started and waits for its FF to be acknowledged, so the worker must run again right away.
+    EXPECT_EQ(0, executor.runStep());
+    EXPECT_TRUE(isotp.isWaitingForACKs());
+
+    delete canInterface;
+}
+
+TEST(ISOTPExecutor, SendReceiveMF)
+{
+    constexpr uint32_t TIMEOUT        = 10000; // 10 seconds
+    ISOTPExecutor_confirm_cb_calls    = 0;
+    ISOTPExecutor_indication_cb_calls = 0;
+
+    LocalCANNetwork network(linuxOSInterface);
+    CANInterface*   senderInterface   = network.newCANInterfaceConnection("senderInterface");
+    CANInterface*   receiverInterface = network.newCANInterfaceConnection("receiverInterface");
+    ISOTP senderISOTP(1, 2000, ISOTPExecutor_confirm_cb, ISOTPExecutor_indication_cb, ISOTPExecutor_FF_indication_cb,
+                      linuxOSInterface, *senderInterface, 2, ISOTP_DefaultSTmin, "senderISOTP");
+    ISOTP receiverISOTP(2, 2000, ISOTPExecutor_confirm_cb, ISOTPExecutor_indication_cb, ISOTPExecutor_FF_indication_cb,
+                        linuxOSInterface, *receiverInterface, 2, ISOTP_DefaultSTmin, "receiverISOTP");
+
+    ISOTPExecutor executor(linuxOSInterface, 2);
+    EXPECT_TRUE(executor.addInstance(senderISOTP));
+    EXPECT_TRUE(executor.addInstance(receiverISOTP));
+
+    EXPECT_TRUE(senderISOTP.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                                             reinterpret_cast<const uint8_t*>(ISOTPExecutor_message),
+                                             ISOTPExecutor_messageLength));
+
+    const uint32_t initialTime = linuxOSInterface.osMillis();
+    while ((ISOTPExecutor_confirm_cb_calls == 0 || ISOTPExecutor_indication_cb_calls == 0) &&
+           linuxOSInterface.osMillis() - initialTime < TIMEOUT)
+    {
+        for (uint8_t worker = 0; worker < executor.getWorkerCount(); worker++)
+        {
+            executor.runStep(worker);
+        }
+    }
+    const uint32_t elapsedTime = linuxOSInterface.osMillis() - initialTime;
+
+    EXPECT_EQ(1, ISOTPExecutor_confirm_cb_calls);
+    EXPECT_EQ(1, ISOTPExecutor_indication_cb_calls);
+    ASSERT_LT(elapsedTime, TIMEOUT) << "Test took too long: " << elapsedTime << " ms, Timeout was: " << TIMEOUT;
+
+    delete senderInterface;
+    delete receiverInterface;
+}
+
+TEST(ISOTPExecutor, sleepUntilNextRunTime)
+{
+    ISOTPExecutor_confirm_cb_calls    = 0;
+    ISOTPExecutor_indication_cb_calls = 0;
+
+    // The clock wraps around during the transfer.
+    VirtualClockOSInterface clock(UINT32_MAX - 20);
+    LocalCANNetwork         network(clock);
+    CANInterface*           senderInterface   = network.newCANInterfaceConnection("senderInterface");
+    CANInterface*           receiverInterface = network.newCANInterfaceConnection("receiverInterface");
+    ISOTP senderISOTP(1, 2000, ISOTPExecutor_confirm_cb, ISOTPExecutor_indication_cb, ISOTPExecutor_FF_indication_cb,
+                      clock, *senderInterface, 2, {5, ms}, "senderISOTP");
+    ISOTP receiverISOTP(2, 2000, ISOTPExecutor_confirm_cb, ISOTPExecutor_indication_cb, ISOTPExecutor_FF_indication_cb,
+                        clock, *receiverInterface, 2, {5, ms}, "receiverISOTP");
+
+    ISOTPExecutor executor(clock);
+    EXPECT_TRUE(executor.addInstance(senderISOTP));
+    EXPECT_TRUE(executor.addInstance(receiverISOTP));
+    EXPECT_TRUE(senderISOTP.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                                             reinterpret_cast<const uint8_t*>(ISOTPExecutor_message),
+                                             ISOTPExecutor_messageLength));
+
+    // The worker sleeps until the returned time, or for one tick when it must run as soon as possible, until nothing
+    // is scheduled.
+    const uint32_t initialTime = clock.osMillis();
+    for (uint32_t step = 0; step < 1000; step++)
+    {
+        const uint32_t nextRunTime = executor.runStep();
+        if (nextRunTime == ISOTP_NoNextRunTime)
+        {
+            break;
+        }
+        const auto sleep_ms = static_cast<int32_t>(nextRunTime - clock.osMillis());
+        clock.advance(nextRunTime == 0 || sleep_ms <= 0 ? 1 : sleep_ms);
+    }
+
+    EXPECT_EQ(1, ISOTPExecutor_confirm_cb_calls);
+    EXPECT_EQ(1, ISOTPExecutor_indication_cb_calls);
+    EXPECT_LT(clock.osMillis() - initialTime, 1000);
+    EXPECT_LT(clock.osMillis(), initialTime); // Wrapped.
+
+    delete senderInterface;
+    delete receiverInterface;
+}
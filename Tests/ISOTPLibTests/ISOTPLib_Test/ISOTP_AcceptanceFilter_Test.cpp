@@ -0,0 +1,138 @@
+#include "ISOTP_AcceptanceFilter.h"
+
+#include "gtest/gtest.h"
+
+static bool anyFilterMatches(const std::vector<ISOTP_AcceptanceFilter>& filters, const N_TAtype_t nTaType,
+                             const uint8_t nTa, const uint8_t nSa)
+{
+    const N_AI identifier = {.N_NFA_Header  = N_NFA_Header_Value,
+                             .N_NFA_Padding = N_NFA_Padding_Value,
+                             .N_TAtype      = nTaType,
+                             .N_TA          = nTa,
+                             .N_SA          = nSa};
+    for (const auto& filter : filters)
+    {
+        if (filter.matches(identifier))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Checks that the filters accept every frame this configuration accepts, and only those if exact is true.
+static void checkFilters(const std::vector<ISOTP_AcceptanceFilter>& filters, const ISOTP_N_AddressTable& physicalN_TAs,
+                         const ISOTP_N_AddressTable& functionalN_TAs, const bool exact)
+{
+    for (uint32_t nTa = 0; nTa < ISOTP_N_AddressCount; nTa++)
+    {
+        for (const uint8_t nSa : {0, 1, 0x55, 0xFF})
+        {
+            const bool physical   = anyFilterMatches(filters, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, nTa, nSa);
+            const bool functional = anyFilterMatches(filters, N_TATYPE_6_CAN_CLASSIC_29bit_Functional, nTa, nSa);
+            if (physicalN_TAs.test(nTa) || exact)
+            {
+                EXPECT_EQ(physicalN_TAs.test(nTa), physical) << "Physical N_TA " << nTa;
+            }
+            if (functionalN_TAs.test(nTa) || exact)
+            {
+                EXPECT_EQ(functionalN_TAs.test(nTa), functional) << "Functional N_TA " << nTa;
+            }
+        }
+    }
+}
+
+TEST(ISOTP_AcceptanceFilter, noAddresses)
+{
+    EXPECT_TRUE(ISOTP_computeAcceptanceFilters({}, {}).empty());
+}
+
+TEST(ISOTP_AcceptanceFilter, singleN_SA)
+{
+    ISOTP_N_AddressTable physicalN_TAs;
+    physicalN_TAs.set(1);
+
+    const auto filters = ISOTP_computeAcceptanceFilters(physicalN_TAs, {});
+    ASSERT_EQ(1, filters.size());
+    EXPECT_EQ(0, filters[0].mask.N_SA);
+    checkFilters(filters, physicalN_TAs, {}, true);
+}
+
+TEST(ISOTP_AcceptanceFilter, samePhysicalAndFunctionalN_TA)
+{
+    ISOTP_N_AddressTable n_TAs;
+    n_TAs.set(0x42);
+
+    const auto filters = ISOTP_computeAcceptanceFilters(n_TAs, n_TAs);
+    EXPECT_EQ(1, filters.size());
+    checkFilters(filters, n_TAs, n_TAs, true);
+}
+
+TEST(ISOTP_AcceptanceFilter, allN_TAs)
+{
+    ISOTP_N_AddressTable physicalN_TAs;
+    physicalN_TAs.set();
+
+    const auto filters = ISOTP_computeAcceptanceFilters(physicalN_TAs, {});
+    ASSERT_EQ(1, filters.size());
+    EXPECT_EQ(0, filters[0].mask.N_TA);
+    checkFilters(filters, physicalN_TAs, {}, true);
+}
+
+TEST(ISOTP_AcceptanceFilter, severalN_TAs)
+{
+    ISOTP_N_AddressTable physicalN_TAs;
+    ISOTP_N_AddressTable functionalN_TAs;
+    for (const uint8_t nTa : {1, 2, 3, 4, 5, 6, 7, 100, 200})
+    {
+        physicalN_TAs.set(nTa);
+    }
+    functionalN_TAs.set(0x33);
+    functionalN_TAs.set(0x7F);
+
+    const auto filters = ISOTP_computeAcceptanceFilters(physicalN_TAs, functionalN_TAs);
+    EXPECT_EQ(7, filters.size()); // 1-7 need 3 filters, the other 4 N_TAs one each.
+    checkFilters(filters, physicalN_TAs, functionalN_TAs, true);
+}
+
+TEST(ISOTP_AcceptanceFilter, maxFilters)
+{
+    ISOTP_N_AddressTable physicalN_TAs;
+    ISOTP_N_AddressTable functionalN_TAs;
+    for (const uint8_t nTa : {1, 2, 3, 4, 5, 6, 7, 100, 200})
+    {
+        physicalN_TAs.set(nTa);
+    }
+    functionalN_TAs.set(0x33);
+    functionalN_TAs.set(0x7F);
+
+    for (uint32_t maxFilters = 1; maxFilters < 7; maxFilters++)
+    {
+        const auto filters = ISOTP_computeAcceptanceFilters(physicalN_TAs, functionalN_TAs, maxFilters);
+        EXPECT_LE(filters.size(), maxFilters); // A merged filter may contain other filters too.
+        EXPECT_FALSE(filters.empty());
+        checkFilters(filters, physicalN_TAs, functionalN_TAs, false);
+    }
+}
+
+TEST(ISOTP_AcceptanceFilter, anyPriorityAndPadding)
+{
+    ISOTP_N_AddressTable physicalN_TAs;
+    physicalN_TAs.set(1);
+
+    // ISOTP accepts the frames whatever their priority and padding, so the filters must let them through too.
+    const auto filters = ISOTP_computeAcceptanceFilters(physicalN_TAs, {});
+    ASSERT_EQ(1, filters.size());
+    for (const uint8_t priority : {0b000, 0b011, 0b110, 0b111})
+    {
+        for (const uint8_t padding : {0b00, 0b01, 0b11})
+        {
+            const N_AI identifier = {.N_NFA_Header  = priority,
+                                     .N_NFA_Padding = padding,
+                                     .N_TAtype      = N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                                     .N_TA          = 1,
+                                     .N_SA          = 2};
+            EXPECT_TRUE(filters[0].matches(identifier)) << "Priority " << +priority << ", padding " << +padding;
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#include "ISOTP_ChunkPool.h"
+
+#include <cstring>
+#include "LinuxOSInterface.h"
+#include "gtest/gtest.h"
+
+static LinuxOSInterface linuxOSInterface;
+
+TEST(ISOTP_ChunkPool, disabled)
+{
+    ISOTP_ChunkPool pool(linuxOSInterface, 0);
+
+    EXPECT_FALSE(pool.isEnabled());
+    EXPECT_EQ(0, pool.getChunkSize());
+    EXPECT_EQ(nullptr, pool.allocate());
+}
+
+TEST(ISOTP_ChunkPool, chunkCount)
+{
+    ISOTP_ChunkPool pool(linuxOSInterface, 64);
+
+    ASSERT_TRUE(pool.isEnabled());
+    EXPECT_EQ(1, pool.getChunkCount(0));
+    EXPECT_EQ(1, pool.getChunkCount(64));
+    EXPECT_EQ(2, pool.getChunkCount(65));
+    EXPECT_EQ(1024, pool.getChunkCount(65536));
+
+    ISOTP_ChunkPool tinyPool(linuxOSInterface, 1);
+    EXPECT_EQ(sizeof(void*), tinyPool.getChunkSize()); // A free chunk holds a pointer.
+}
+
+TEST(ISOTP_ChunkPool, recycle)
+{
+    ISOTP_ChunkPool pool(linuxOSInterface, 64);
+
+    uint8_t* first  = pool.allocate();
+    uint8_t* second = pool.allocate();
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, second);
+    memset(first, 0xAA, 64);
+    memset(second, 0x55, 64);
+    EXPECT_EQ(0, pool.getFreeChunkCount());
+
+    pool.release(first);
+    pool.release(second);
+    pool.release(nullptr);
+    EXPECT_EQ(2, pool.getFreeChunkCount());
+
+    // The last released chunk is reused first.
+    EXPECT_EQ(second, pool.allocate());
+    EXPECT_EQ(first, pool.allocate());
+    EXPECT_EQ(0, pool.getFreeChunkCount());
+
+    pool.release(first);
+    pool.release(second);
+}
+
+TEST(ISOTP_ChunkPool, freeListIsCapped)
+{
+    ISOTP_ChunkPool pool(linuxOSInterface, 64, 100); // 2 chunks.
+
+    uint8_t* chunks[3];
+    for (uint8_t*& chunk : chunks)
+    {
+        chunk = pool.allocate();
+        ASSERT_NE(nullptr, chunk);
+    }
+
+    // The chunk released beyond the cap goes back to the heap.
+    for (uint8_t* chunk : chunks)
+    {
+        pool.release(chunk);
+    }
+    EXPECT_EQ(2, pool.getFreeChunkCount());
+
+    ISOTP_ChunkPool noReuse(linuxOSInterface, 64, 0);
+    noReuse.release(noReuse.allocate()); // Nothing is kept.
+    EXPECT_EQ(0, noReuse.getFreeChunkCount());
+}
+
+TEST(ISOTP_MessageView, copyTo)
+{
+    uint8_t              first[]    = {1, 2, 3};
+    uint8_t              second[]   = {4, 5};
+    ISOTP_MessageSegment segments[] = {{first, sizeof(first)}, {second, sizeof(second)}};
+    ISOTP_MessageView    message    = {segments, 2, 5};
+
+    uint8_t buffer[5] = {};
+    EXPECT_FALSE(message.copyTo(buffer, 4));
+    ASSERT_TRUE(message.copyTo(buffer, sizeof(buffer)));
+    constexpr uint8_t expected[] = {1, 2, 3, 4, 5};
+    EXPECT_EQ(0, memcmp(expected, buffer, sizeof(expected)));
+
+    ISOTP_MessageView empty = {nullptr, 0, 0};
+    EXPECT_TRUE(empty.copyTo(nullptr, 0));
+}
@@ -29,3 +29,26 @@ TEST(ISOTP_Common, getStMinInMs)
     STmin stMin3{.value = 0, .unit = usX100};
     EXPECT_EQ(0, getStMinInMs(stMin3));
 }
+
+TEST(ISOTP_Common, LoadOrAllocate)
+{
+    std::atomic<uint32_t*> object{nullptr};
+    bool                   allocated = false;
+
+    uint32_t* first = ISOTP_LoadOrAllocate<uint32_t>(object, &allocated);
+    ASSERT_NE(nullptr, first);
+    EXPECT_TRUE(allocated);
+    EXPECT_EQ(first, object.load());
+
+    // Once published, the same object is returned.
+    EXPECT_EQ(first, ISOTP_LoadOrAllocate<uint32_t>(object, &allocated));
+    EXPECT_FALSE(allocated);
+    delete object.load();
+
+    // Arrays with a bound are allocated with new[].
+    std::atomic<uint32_t*> array{nullptr};
+    uint32_t*              elements = ISOTP_LoadOrAllocate<uint32_t[4]>(array);
+    ASSERT_NE(nullptr, elements);
+    EXPECT_EQ(elements, ISOTP_LoadOrAllocate<uint32_t[4]>(array));
+    delete[] array.load();
+}
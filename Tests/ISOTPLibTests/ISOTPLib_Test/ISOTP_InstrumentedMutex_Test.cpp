@@ -0,0 +1,69 @@
+#include "ISOTP_InstrumentedMutex.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "VirtualClockOSInterface.h"
+#include "gtest/gtest.h"
+
+TEST(ISOTP_InstrumentedMutex, wrap)
+{
+    VirtualClockOSInterface clock;
+
+    // Without counters the mutex is not wrapped.
+    OSInterface_Mutex* mutex = clock.osCreateMutex();
+    EXPECT_EQ(mutex, ISOTP_InstrumentedMutex::wrap(mutex, ISOTP_ConfigLock, clock, nullptr));
+    delete mutex;
+
+    ISOTP_Statistics statistics;
+    EXPECT_EQ(nullptr, ISOTP_InstrumentedMutex::wrap(nullptr, ISOTP_ConfigLock, clock, &statistics));
+}
+
+TEST(ISOTP_InstrumentedMutex, counters)
+{
+    VirtualClockOSInterface clock;
+    ISOTP_Statistics        statistics;
+    OSInterface_Mutex*      mutex =
+        ISOTP_InstrumentedMutex::wrap(clock.osCreateMutex(), ISOTP_RunnersLock, clock, &statistics);
+    ASSERT_NE(nullptr, mutex);
+
+    EXPECT_TRUE(mutex->wait(100));
+    EXPECT_FALSE(mutex->wait(0)); // A failed try is a timeout.
+    EXPECT_TRUE(mutex->signal());
+
+    ISOTP_LockStatistics counters = statistics.getLockStatistics(ISOTP_RunnersLock);
+    EXPECT_EQ(1, counters.acquisitions);
+    EXPECT_EQ(0, counters.contendedAcquisitions);
+    EXPECT_EQ(1, counters.timeouts);
+    EXPECT_EQ(1, counters.waits.count);
+    EXPECT_EQ(0, statistics.getLockStatistics(ISOTP_ConfigLock).acquisitions);
+
+    // Another thread holds the mutex while the clock moves 5 ms.
+    std::atomic<bool> locked{false};
+    std::thread       holder(
+        [&]
+        {
+            ASSERT_TRUE(mutex->wait(100));
+            locked = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            clock.advance(5);
+            mutex->signal();
+        });
+    while (!locked)
+    {
+        std::this_thread::yield();
+    }
+    EXPECT_TRUE(mutex->wait(1000));
+    EXPECT_TRUE(mutex->signal());
+    holder.join();
+
+    counters = statistics.getLockStatistics(ISOTP_RunnersLock);
+    EXPECT_EQ(3, counters.acquisitions);
+    EXPECT_EQ(1, counters.contendedAcquisitions);
+    EXPECT_EQ(1, counters.timeouts);
+    EXPECT_EQ(2, counters.waits.count);
+    EXPECT_EQ(5, counters.waits.max_ms);
+
+    delete mutex;
+}
@@ -0,0 +1,79 @@
+#include "ISOTP_LatencyHistogram.h"
+
+#include <cstring>
+
+#include "gtest/gtest.h"
+
+TEST(ISOTP_LatencyHistogram, buckets)
+{
+    // One bucket per ms below the linear buckets.
+    for (uint32_t value = 0; value < ISOTP_LatencyHistogramLinearBuckets; value++)
+    {
+        EXPECT_EQ(value, ISOTP_LatencyHistogram::getBucketIndex(value));
+    }
+
+    // Then 4 buckets per power of two: 8-9, 10-11, 12-13, 14-15, 16-19...
+    EXPECT_EQ(8, ISOTP_LatencyHistogram::getBucketIndex(9));
+    EXPECT_EQ(9, ISOTP_LatencyHistogram::getBucketIndex(10));
+    EXPECT_EQ(11, ISOTP_LatencyHistogram::getBucketIndex(15));
+    EXPECT_EQ(12, ISOTP_LatencyHistogram::getBucketIndex(16));
+    EXPECT_EQ(16, ISOTP_LatencyHistogram::getBucketLowerBound(12));
+    EXPECT_EQ(19, ISOTP_LatencyHistogram::getBucketUpperBound(12));
+    EXPECT_EQ(ISOTP_LatencyHistogramBucketCount - 1, ISOTP_LatencyHistogram::getBucketIndex(UINT32_MAX));
+    EXPECT_EQ(UINT32_MAX, ISOTP_LatencyHistogram::getBucketUpperBound(ISOTP_LatencyHistogramBucketCount - 1));
+
+    // The buckets are contiguous and every value falls between the bounds of its bucket.
+    for (uint32_t index = 0; index < ISOTP_LatencyHistogramBucketCount - 1; index++)
+    {
+        const uint32_t lower = ISOTP_LatencyHistogram::getBucketLowerBound(index);
+        const uint32_t upper = ISOTP_LatencyHistogram::getBucketUpperBound(index);
+        EXPECT_EQ(upper + 1, ISOTP_LatencyHistogram::getBucketLowerBound(index + 1));
+        EXPECT_EQ(index, ISOTP_LatencyHistogram::getBucketIndex(lower));
+        EXPECT_EQ(index, ISOTP_LatencyHistogram::getBucketIndex(upper));
+    }
+}
+
+TEST(ISOTP_LatencyHistogram, percentiles)
+{
+    ISOTP_LatencyHistogram histogram;
+    EXPECT_EQ(0, histogram.getSnapshot().getPercentile(50));
+
+    for (uint32_t value = 1; value <= 100; value++)
+    {
+        histogram.record(value);
+    }
+
+    const ISOTP_LatencyHistogramSnapshot snapshot = histogram.getSnapshot();
+    EXPECT_EQ(100, snapshot.count);
+    EXPECT_EQ(5050, snapshot.sum_ms);
+    EXPECT_EQ(100, snapshot.max_ms);
+    EXPECT_EQ(1, snapshot.getPercentile(0));
+    EXPECT_EQ(5, snapshot.getPercentile(5));
+    EXPECT_EQ(55, snapshot.getPercentile(50)); // 50 falls in the 48-55 bucket.
+    EXPECT_EQ(100, snapshot.getPercentile(99)); // Capped to the max.
+    EXPECT_EQ(100, snapshot.getPercentile(100));
+
+    histogram.reset();
+    EXPECT_EQ(0, histogram.getSnapshot().count);
+    EXPECT_EQ(0, histogram.getSnapshot().max_ms);
+    EXPECT_EQ(0, histogram.getSnapshot().getPercentile(50));
+}
+
+TEST(ISOTP_LatencyHistogram, print)
+{
+    ISOTP_LatencyHistogram histogram;
+    histogram.record(3);
+    histogram.record(3);
+    histogram.record(17);
+
+    char         buffer[128];
+    const size_t length   = histogram.getSnapshot().print(buffer, sizeof(buffer));
+    const char*  expected = "3-3 ms: 2\n16-19 ms: 1\ncount: 3, sum: 23 ms, max: 17 ms\n";
+    EXPECT_STREQ(expected, buffer);
+    EXPECT_EQ(strlen(expected), length);
+
+    // A small buffer is truncated but the full length is still returned.
+    char small[8];
+    EXPECT_EQ(length, histogram.getSnapshot().print(small, sizeof(small)));
+    EXPECT_STREQ("3-3 ms:", small);
+}
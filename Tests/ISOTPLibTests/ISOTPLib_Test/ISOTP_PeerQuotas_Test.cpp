@@ -0,0 +1,65 @@
+#include "ISOTP_PeerQuotas.h"
+
+#include "gtest/gtest.h"
+
+TEST(ISOTP_PeerQuotas, noQuotas)
+{
+    ISOTP_PeerQuotas quotas;
+    bool             charged;
+
+    // Without quotas everything is admitted and nothing is charged.
+    EXPECT_TRUE(quotas.admit(1, 1000, 0, charged));
+    EXPECT_FALSE(charged);
+    EXPECT_EQ(0, quotas.getUsedMemory(1));
+    EXPECT_EQ(ISOTP_DefaultPeerQuota.maxMemory, quotas.getQuota(1).maxMemory);
+}
+
+TEST(ISOTP_PeerQuotas, maxMemoryAndReceptions)
+{
+    ISOTP_PeerQuotas quotas;
+    bool             charged;
+
+    ASSERT_TRUE(quotas.setQuota(1, {100, 0, 2}));
+    EXPECT_EQ(100, quotas.getQuota(1).maxMemory);
+    EXPECT_EQ(2, quotas.getQuota(1).maxReceptions);
+
+    EXPECT_FALSE(quotas.admit(1, 101, 1000, charged));
+    EXPECT_FALSE(charged);
+    EXPECT_TRUE(quotas.admit(1, 60, 1000, charged));
+    EXPECT_TRUE(charged);
+    EXPECT_FALSE(quotas.admit(1, 60, 1000, charged)); // Over maxMemory.
+    EXPECT_TRUE(quotas.admit(1, 40, 1000, charged));
+    EXPECT_EQ(100, quotas.getUsedMemory(1));
+
+    quotas.release(1, 40);
+    EXPECT_TRUE(quotas.admit(1, 10, 1000, charged));
+    EXPECT_FALSE(quotas.admit(1, 10, 1000, charged)); // Over maxReceptions.
+
+    // Other peers are not affected.
+    EXPECT_TRUE(quotas.admit(2, 500, 1000, charged));
+}
+
+TEST(ISOTP_PeerQuotas, reservedMemory)
+{
+    constexpr int64_t availableMemory = 100;
+    ISOTP_PeerQuotas  quotas;
+    bool              charged;
+
+    ASSERT_TRUE(quotas.setQuota(1, {ISOTP_DefaultPeerQuota.maxMemory, 30, ISOTP_DefaultPeerQuota.maxReceptions}));
+
+    // The other peers can not take the 30 bytes reserved for N_SA 1.
+    EXPECT_FALSE(quotas.admit(2, 71, availableMemory, charged));
+    EXPECT_TRUE(quotas.admit(2, 70, availableMemory, charged));
+
+    // N_SA 1 can still use its reserve.
+    EXPECT_TRUE(quotas.admit(1, 30, availableMemory - 70, charged));
+
+    // Once N_SA 1 uses its reserve, the remaining memory is shared again.
+    quotas.release(2, 70);
+    EXPECT_TRUE(quotas.admit(2, 70, availableMemory - 30, charged));
+    quotas.release(2, 70);
+
+    // Releasing the messages of N_SA 1 reserves the memory again.
+    quotas.release(1, 30);
+    EXPECT_FALSE(quotas.admit(2, 71, availableMemory, charged));
+}
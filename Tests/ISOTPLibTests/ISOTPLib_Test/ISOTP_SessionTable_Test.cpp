@@ -0,0 +1,143 @@
+#include "ISOTP_SessionTable.h"
+
+#include <cstring>
+
+#include "ISOTP.h"
+#include "TwoNodeTransfer.h"
+#include "VirtualClockOSInterface.h"
+#include "gtest/gtest.h"
+
+TEST(ISOTP_SessionTable, publish)
+{
+    ISOTP_SessionTable    table;
+    ISOTP_SessionSnapshot snapshot{};
+    EXPECT_FALSE(table.read(snapshot)); // Never published.
+
+    ISOTP_SessionInfo sessions[ISOTP_SessionTableSize + 2] = {};
+    for (uint32_t i = 0; i < ISOTP_SessionTableSize + 2; i++)
+    {
+        sessions[i].nAi.N_TA         = i;
+        sessions[i].bytesTransferred = i * 7;
+        sessions[i].internalStatus   = "SEND_CF";
+    }
+
+    table.publish(sessions, 2, 100);
+    ASSERT_TRUE(table.read(snapshot));
+    EXPECT_EQ(100, snapshot.timestamp);
+    EXPECT_EQ(2, snapshot.totalSessions);
+    EXPECT_EQ(2, snapshot.sessionCount);
+    EXPECT_EQ(1, snapshot.sessions[1].nAi.N_TA);
+    EXPECT_EQ(7, snapshot.sessions[1].bytesTransferred);
+    EXPECT_STREQ("SEND_CF", snapshot.sessions[1].internalStatus);
+
+    // The sessions that do not fit are only counted.
+    table.publish(sessions, ISOTP_SessionTableSize + 2, 101);
+    ASSERT_TRUE(table.read(snapshot));
+    EXPECT_EQ(ISOTP_SessionTableSize + 2, snapshot.totalSessions);
+    EXPECT_EQ(ISOTP_SessionTableSize, snapshot.sessionCount);
+    EXPECT_EQ(ISOTP_SessionTableSize - 1, snapshot.sessions[ISOTP_SessionTableSize - 1].nAi.N_TA);
+
+    table.publish(sessions, 0, 102);
+    ASSERT_TRUE(table.read(snapshot));
+    EXPECT_EQ(0, snapshot.sessionCount);
+}
+
+TEST(ISOTP_SessionTable, armTimer)
+{
+    VirtualClockOSInterface clock(1000);
+    Timer_N                 timerA(clock);
+    Timer_N                 timerB(clock);
+
+    ISOTP_SessionInfo info{};
+    info.armedTimer = ISOTP_TimingPhaseCount;
+    info.armTimer(ISOTP_N_AsPhase, timerA, 100, clock.osMillis()); // Not running.
+    EXPECT_EQ(ISOTP_TimingPhaseCount, info.armedTimer);
+
+    timerA.startTimer();
+    timerB.startTimer();
+    clock.advance(30);
+    info.armTimer(ISOTP_N_AsPhase, timerA, 100, clock.osMillis());
+    info.armTimer(ISOTP_N_BsPhase, timerB, 50, clock.osMillis());
+    EXPECT_EQ(ISOTP_N_BsPhase, info.armedTimer);
+    EXPECT_EQ(20, info.remainingTime_ms);
+
+    clock.advance(30);
+    info.armTimer(ISOTP_N_AsPhase, timerA, 100, clock.osMillis()); // Further than N_Bs, which is now late.
+    EXPECT_EQ(ISOTP_N_BsPhase, info.armedTimer);
+}
+
+static const ISOTP_SessionInfo* findSession(const ISOTP_SessionSnapshot& snapshot, const ISOTP_SessionState state)
+{
+    for (uint32_t i = 0; i < snapshot.sessionCount; i++)
+    {
+        if (snapshot.sessions[i].state == state)
+        {
+            return &snapshot.sessions[i];
+        }
+    }
+    return nullptr;
+}
+
+TEST(ISOTP_SessionTable, sessions)
+{
+    VirtualClockOSInterface clock;
+    TwoNodeTransfer transfer(clock, {.senderMemory = 1000, .receiverMemory = 1000, .receiverSTmin = {10, ms}});
+    ISOTP&          sender   = transfer.getSender();
+    ISOTP&          receiver = transfer.getReceiver();
+
+    // The first call only enables the table.
+    ISOTP_SessionSnapshot sent{};
+    ISOTP_SessionSnapshot received{};
+    EXPECT_FALSE(sender.getSessions(sent));
+    EXPECT_FALSE(receiver.getSessions(received));
+
+    // The second message waits for the first one, as they have the same N_AI.
+    constexpr uint8_t message[100] = {};
+    ASSERT_TRUE(transfer.send(message, sizeof(message)));
+    ASSERT_TRUE(transfer.send(message, 20));
+
+    // Wait until a few CFs are sent, the receiver asked for 10 ms between them.
+    const auto sendingCFs = [&]
+    {
+        return sender.getSessions(sent) && receiver.getSessions(received) && sent.sessionCount == 2 &&
+               findSession(sent, ISOTP_SessionActive) != nullptr &&
+               findSession(sent, ISOTP_SessionActive)->bytesTransferred > 6 + 7 * 2;
+    };
+    ASSERT_TRUE(transfer.getDriver().runUntil(sendingCFs, 1000));
+
+    const ISOTP_SessionInfo* active = findSession(sent, ISOTP_SessionActive);
+    ASSERT_NE(nullptr, active);
+    EXPECT_EQ(N_USData_Runner::RunnerRequestType, active->direction);
+    EXPECT_EQ(2, active->nAi.N_TA);
+    EXPECT_EQ(100, active->messageLength);
+    EXPECT_LT(active->bytesTransferred, 100);
+    EXPECT_EQ(10, active->stMin.value);
+    EXPECT_EQ(ms, active->stMin.unit);
+    const bool sendingCF = strcmp("SEND_CF", active->internalStatus) == 0;
+    EXPECT_TRUE(sendingCF || strcmp("AWAITING_CF_ACK", active->internalStatus) == 0) << active->internalStatus;
+    EXPECT_EQ(sendingCF ? 0 : 1, active->pendingACKs);
+    EXPECT_NE(ISOTP_TimingPhaseCount, active->armedTimer);
+    EXPECT_LE(active->remainingTime_ms, N_USData_Runner::N_As_TIMEOUT_MS);
+
+    const ISOTP_SessionInfo* pending = findSession(sent, ISOTP_SessionPending);
+    ASSERT_NE(nullptr, pending);
+    EXPECT_EQ(20, pending->messageLength);
+    EXPECT_EQ(0, pending->bytesTransferred);
+    EXPECT_STREQ("NOT_RUNNING_FF", pending->internalStatus);
+    EXPECT_EQ(0, pending->pendingACKs);
+
+    const ISOTP_SessionInfo* receiving = findSession(received, ISOTP_SessionActive);
+    ASSERT_NE(nullptr, receiving);
+    EXPECT_EQ(N_USData_Runner::RunnerIndicationType, receiving->direction);
+    EXPECT_EQ(1, receiving->nAi.N_SA);
+    EXPECT_EQ(100, receiving->messageLength);
+    EXPECT_GT(receiving->bytesTransferred, 6);
+    EXPECT_EQ(ISOTP_N_CrPhase, receiving->armedTimer);
+
+    // Once both messages are sent, the table is empty again.
+    ASSERT_TRUE(transfer.runUntilDone(2, 2));
+    ASSERT_TRUE(sender.getSessions(sent));
+    EXPECT_EQ(0, sent.totalSessions);
+    ASSERT_TRUE(receiver.getSessions(received));
+    EXPECT_EQ(0, received.totalSessions);
+}
@@ -0,0 +1,121 @@
+#include "ISOTP_SlabAllocator.h"
+
+#include <cstring>
+#include "LinuxOSInterface.h"
+#include "gtest/gtest.h"
+
+static LinuxOSInterface linuxOSInterface;
+
+TEST(ISOTP_SlabAllocator, disabled)
+{
+    ISOTP_SlabAllocator allocator(linuxOSInterface, 0);
+
+    EXPECT_FALSE(allocator.isEnabled());
+    EXPECT_EQ(0, allocator.getCapacity());
+    EXPECT_EQ(nullptr, allocator.allocate(1));
+}
+
+TEST(ISOTP_SlabAllocator, sizeClasses)
+{
+    EXPECT_EQ(ISOTP_SlabAllocator::MinBlockSize, ISOTP_SlabAllocator::getBlockSize(0));
+    EXPECT_EQ(ISOTP_SlabAllocator::MinBlockSize, ISOTP_SlabAllocator::getBlockSize(1));
+    EXPECT_EQ(32, ISOTP_SlabAllocator::getBlockSize(17));
+    EXPECT_EQ(4096, ISOTP_SlabAllocator::getBlockSize(4096));
+    EXPECT_EQ(8192, ISOTP_SlabAllocator::getBlockSize(4097));
+}
+
+TEST(ISOTP_SlabAllocator, splitAndMerge)
+{
+    ISOTP_SlabAllocator allocator(linuxOSInterface, 1024);
+
+    ASSERT_TRUE(allocator.isEnabled());
+    EXPECT_EQ(1024, allocator.getCapacity());
+
+    // The 1024 byte block is split in halves until there is a 16 byte block.
+    uint8_t* small = static_cast<uint8_t*>(allocator.allocate(10));
+    ASSERT_NE(nullptr, small);
+    EXPECT_EQ(16, allocator.getUsedMemory());
+    memset(small, 0xAA, 10);
+
+    uint8_t* large = static_cast<uint8_t*>(allocator.allocate(300));
+    ASSERT_NE(nullptr, large);
+    EXPECT_EQ(nullptr, allocator.allocate(512)); // Only the half split for the small block is left.
+    EXPECT_EQ(16 + 512, allocator.getUsedMemory());
+
+    // Releasing the small block merges all the halves back into a 512 byte block.
+    allocator.release(small);
+    void* merged = allocator.allocate(512);
+    EXPECT_NE(nullptr, merged);
+
+    allocator.release(large);
+    allocator.release(merged);
+    EXPECT_EQ(0, allocator.getUsedMemory());
+    EXPECT_NE(nullptr, allocator.allocate(1024));
+}
+
+TEST(ISOTP_SlabAllocator, unevenRegion)
+{
+    ISOTP_SlabAllocator allocator(linuxOSInterface, 1000); // Blocks of 512, 256, 128, 64 and 32 bytes.
+
+    EXPECT_EQ(992, allocator.getCapacity());
+    EXPECT_EQ(512, allocator.getLargestBlockSize());
+    EXPECT_EQ(nullptr, allocator.allocate(513));
+
+    void* blocks[] = {allocator.allocate(512), allocator.allocate(256), allocator.allocate(128), allocator.allocate(64),
+                      allocator.allocate(32)};
+    for (void* block : blocks)
+    {
+        EXPECT_NE(nullptr, block);
+    }
+    EXPECT_EQ(992, allocator.getUsedMemory());
+    EXPECT_EQ(nullptr, allocator.allocate(1));
+
+    for (void* block : blocks)
+    {
+        allocator.release(block);
+    }
+    EXPECT_EQ(0, allocator.getUsedMemory());
+}
+
+TEST(ISOTP_SlabAllocator, fragmentation)
+{
+    ISOTP_SlabAllocator allocator(linuxOSInterface, 1024);
+
+    void* blocks[4];
+    for (void*& block : blocks)
+    {
+        block = allocator.allocate(256);
+        ASSERT_NE(nullptr, block);
+    }
+
+    // The free blocks are not buddies, so 512 bytes are free but there is no 512 byte block.
+    allocator.release(blocks[0]);
+    allocator.release(blocks[2]);
+    EXPECT_EQ(512, allocator.getUsedMemory());
+    EXPECT_EQ(nullptr, allocator.allocate(512));
+
+    allocator.release(blocks[1]);
+    EXPECT_NE(nullptr, allocator.allocate(512));
+    allocator.release(blocks[3]);
+}
+
+TEST(ISOTP_SlabAllocator, exhaustion)
+{
+    ISOTP_SlabAllocator allocator(linuxOSInterface, 256);
+
+    void* blocks[256 / ISOTP_SlabAllocator::MinBlockSize];
+    for (void*& block : blocks)
+    {
+        block = allocator.allocate(ISOTP_SlabAllocator::MinBlockSize);
+        ASSERT_NE(nullptr, block);
+    }
+    EXPECT_EQ(nullptr, allocator.allocate(1));
+    EXPECT_EQ(256, allocator.getUsedMemory());
+
+    for (void* block : blocks)
+    {
+        allocator.release(block);
+    }
+    EXPECT_EQ(0, allocator.getUsedMemory());
+    EXPECT_NE(nullptr, allocator.allocate(256));
+}
@@ -0,0 +1,219 @@
+#include "ISOTP_Statistics.h"
+
+#include "ISOTP.h"
+#include "TwoNodeTransfer.h"
+#include "gtest/gtest.h"
+
+TEST(ISOTP_Statistics, counters)
+{
+    ISOTP_Statistics statistics;
+    ASSERT_TRUE(statistics.enablePeerStatistics());
+
+    CANFrame frame            = {};
+    frame.identifier.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical;
+    frame.identifier.N_TA     = 2;
+    frame.identifier.N_SA     = 1;
+    frame.data_length_code    = 8;
+    statistics.onFrameWritten(frame);
+    statistics.onFrameWritten(frame);
+    frame.data_length_code = 3;
+    statistics.onFrameReceived(frame);
+
+    statistics.onSessionStarted(2);
+    statistics.onSessionStarted(3);
+    statistics.onRequestFinished(2, N_OK);
+    statistics.onIndicationFinished(3, N_TIMEOUT_Cr);
+    statistics.onFrameHeld();
+    statistics.onOverflowFCSent();
+    statistics.onN_CsPerformanceMiss();
+
+    const ISOTP_StatisticsSnapshot snapshot = statistics.getSnapshot();
+    EXPECT_EQ(2, snapshot.total.framesTx);
+    EXPECT_EQ(16, snapshot.total.bytesTx);
+    EXPECT_EQ(1, snapshot.total.framesRx);
+    EXPECT_EQ(3, snapshot.total.bytesRx);
+    EXPECT_EQ(2, snapshot.total.sessionsStarted);
+    EXPECT_EQ(1, snapshot.total.sessionsCompleted);
+    EXPECT_EQ(1, snapshot.total.sessionsFailed);
+    EXPECT_EQ(1, snapshot.requestResults[N_OK]);
+    EXPECT_EQ(1, snapshot.indicationResults[N_TIMEOUT_Cr]);
+    EXPECT_EQ(0, snapshot.indicationResults[N_OK]);
+    EXPECT_EQ(1, snapshot.heldFrames);
+    EXPECT_EQ(1, snapshot.overflowFCsSent);
+    EXPECT_EQ(1, snapshot.N_CsPerformanceMisses);
+    EXPECT_EQ(0, snapshot.N_BrPerformanceMisses);
+
+    // Frames written are counted for their N_TA and frames received for their N_SA.
+    const ISOTP_PeerStatistics peer2 = statistics.getPeerStatistics(2);
+    EXPECT_EQ(2, peer2.framesTx);
+    EXPECT_EQ(0, peer2.framesRx);
+    EXPECT_EQ(1, peer2.sessionsCompleted);
+    const ISOTP_PeerStatistics peer1 = statistics.getPeerStatistics(1);
+    EXPECT_EQ(0, peer1.framesTx);
+    EXPECT_EQ(1, peer1.framesRx);
+    EXPECT_EQ(1, statistics.getPeerStatistics(3).sessionsFailed);
+    EXPECT_EQ(0, statistics.getPeerStatistics(4).sessionsStarted);
+}
+
+TEST(ISOTP_Statistics, peerStatistics)
+{
+    ISOTP_Statistics statistics;
+    statistics.setMemoryForRunners(100000);
+
+    CANFrame frame            = {};
+    frame.identifier.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical;
+    frame.identifier.N_TA     = 2;
+    frame.data_length_code    = 8;
+
+    // Until enabled, only the totals are counted.
+    statistics.onFrameWritten(frame);
+    EXPECT_FALSE(statistics.arePeerStatisticsEnabled());
+    EXPECT_EQ(0, statistics.getPeerStatistics(2).framesTx);
+    EXPECT_FALSE(statistics.enablePeerLatencyHistograms(2));
+
+    ASSERT_TRUE(statistics.enablePeerStatistics());
+    EXPECT_TRUE(statistics.arePeerStatisticsEnabled());
+    statistics.onFrameWritten(frame);
+    statistics.onSessionStarted(ISOTP_Statistics::getTargetPeer(frame.identifier));
+    EXPECT_EQ(1, statistics.getPeerStatistics(2).framesTx);
+    EXPECT_EQ(1, statistics.getPeerStatistics(2).sessionsStarted);
+    EXPECT_TRUE(statistics.enablePeerLatencyHistograms(2));
+
+    // A functional N_TA is not a peer.
+    frame.identifier.N_TAtype = N_TATYPE_6_CAN_CLASSIC_29bit_Functional;
+    EXPECT_EQ(ISOTP_Statistics::NoPeer, ISOTP_Statistics::getTargetPeer(frame.identifier));
+    statistics.onFrameWritten(frame);
+    statistics.onSessionStarted(ISOTP_Statistics::getTargetPeer(frame.identifier));
+    statistics.onRequestFinished(ISOTP_Statistics::getTargetPeer(frame.identifier), N_OK);
+    statistics.recordLatency(ISOTP_RequestPhase, ISOTP_Statistics::getTargetPeer(frame.identifier), 5);
+    EXPECT_EQ(1, statistics.getPeerStatistics(2).framesTx);
+    EXPECT_EQ(1, statistics.getPeerStatistics(2).sessionsStarted);
+    EXPECT_EQ(0, statistics.getPeerStatistics(2).sessionsCompleted);
+    EXPECT_EQ(3, statistics.getSnapshot().total.framesTx);
+    EXPECT_EQ(2, statistics.getSnapshot().total.sessionsStarted);
+    EXPECT_EQ(1, statistics.getLatencyHistogram(ISOTP_RequestPhase).count);
+
+    // The table is taken out of the memory for runners, it is not counted as memory in use.
+    statistics.recordAvailableMemory(100000 - ISOTP_Statistics::getPeerTableSize());
+    EXPECT_EQ(0, statistics.getSnapshot().memoryForRunnersHighWater);
+}
+
+TEST(ISOTP_Statistics, highWaters)
+{
+    ISOTP_Statistics statistics;
+
+    // No peer table is needed to read the counters of a peer.
+    EXPECT_EQ(0, statistics.getPeerStatistics(1).framesTx);
+
+    statistics.setMemoryForRunners(1000);
+    statistics.recordAvailableMemory(700);
+    statistics.recordAvailableMemory(900);
+    statistics.recordACKQueueDepth(3);
+    statistics.recordACKQueueDepth(1);
+
+    EXPECT_EQ(300, statistics.getSnapshot().memoryForRunnersHighWater);
+    EXPECT_EQ(3, statistics.getSnapshot().ackQueueDepthHighWater);
+}
+
+TEST(ISOTP_Statistics, transfer)
+{
+    // The tables of the peers are taken out of the memory for runners.
+    const auto              tableSize = static_cast<uint32_t>(ISOTP_Statistics::getPeerTableSize());
+    VirtualClockOSInterface clock;
+    TwoNodeTransfer transfer(clock, {.senderMemory = 4096 + tableSize, .receiverMemory = 1000 + tableSize});
+    ISOTP&          sender   = transfer.getSender();
+    ISOTP&          receiver = transfer.getReceiver();
+    sender.setRunStepTimingEnabled(true);
+    ASSERT_TRUE(sender.enablePeerStatistics());
+    ASSERT_TRUE(receiver.enablePeerStatistics());
+
+    // 100 bytes are sent in an FF with 6 bytes and 14 CFs, with one FC as BS is 0.
+    constexpr uint8_t message[100] = {};
+    ASSERT_TRUE(transfer.send(message, sizeof(message)));
+    ASSERT_TRUE(transfer.runUntilDone(1, 1));
+    EXPECT_EQ(N_OK, transfer.getConfirmResult());
+
+    const ISOTP_StatisticsSnapshot sent = sender.getStatistics();
+    EXPECT_EQ(15, sent.total.framesTx);
+    EXPECT_EQ(8 * 14 + 4, sent.total.bytesTx); // The last CF has 3 bytes of data.
+    EXPECT_EQ(1, sent.total.framesRx);
+    EXPECT_EQ(1, sent.total.sessionsStarted);
+    EXPECT_EQ(1, sent.total.sessionsCompleted);
+    EXPECT_EQ(1, sent.requestResults[N_OK]);
+    EXPECT_EQ(100, sent.memoryForRunnersHighWater);
+    EXPECT_GE(sent.ackQueueDepthHighWater, 1);
+    EXPECT_EQ(15, sender.getPeerStatistics(2).framesTx);
+
+    const ISOTP_StatisticsSnapshot received = receiver.getStatistics();
+    EXPECT_EQ(1, received.total.framesTx);
+    EXPECT_EQ(15, received.total.framesRx);
+    EXPECT_EQ(1, received.total.sessionsCompleted);
+    EXPECT_EQ(1, received.indicationResults[N_OK]);
+    EXPECT_EQ(100, received.memoryForRunnersHighWater);
+    EXPECT_EQ(15, receiver.getPeerStatistics(1).framesRx);
+    EXPECT_EQ(0, receiver.getPeerStatistics(3).framesRx);
+
+    // Each frame written by the sender is ACKed, and each CF but the first follows an N_Cs.
+    EXPECT_EQ(15, sender.getLatencyHistogram(ISOTP_N_AsPhase).count);
+    EXPECT_EQ(1, sender.getLatencyHistogram(ISOTP_N_BsPhase).count);
+    EXPECT_EQ(14, sender.getLatencyHistogram(ISOTP_N_CsPhase).count);
+    EXPECT_EQ(1, sender.getLatencyHistogram(ISOTP_RequestPhase).count);
+    EXPECT_EQ(1, receiver.getLatencyHistogram(ISOTP_N_ArPhase).count);
+    EXPECT_EQ(1, receiver.getLatencyHistogram(ISOTP_N_BrPhase).count);
+    EXPECT_EQ(14, receiver.getLatencyHistogram(ISOTP_N_CrPhase).count);
+    EXPECT_EQ(1, receiver.getLatencyHistogram(ISOTP_IndicationPhase).count);
+    EXPECT_GE(sender.getLatencyHistogram(ISOTP_RequestPhase).max_ms,
+              receiver.getLatencyHistogram(ISOTP_IndicationPhase).max_ms);
+
+    // The mutexes are counted and the runStep is timed, nothing waits in a single thread.
+    EXPECT_GT(sender.getLockStatistics(ISOTP_RunnersLock).acquisitions, 0);
+    EXPECT_GT(sender.getLockStatistics(ISOTP_ACKQueueLock).acquisitions, 0);
+    EXPECT_EQ(0, sender.getLockStatistics(ISOTP_RunnersLock).contendedAcquisitions);
+    EXPECT_EQ(0, sender.getLockStatistics(ISOTP_RunnersLock).timeouts);
+    EXPECT_EQ(0, sender.getLockStatistics(ISOTP_RunnerLock).acquisitions); // The runners are SingleThreadedRunner.
+    EXPECT_GT(sender.getRunStepHistogram(ISOTP_RunStepTotal).count, 0);
+    EXPECT_EQ(sender.getRunStepHistogram(ISOTP_RunStepTotal).count,
+              sender.getRunStepHistogram(ISOTP_StartRunnersStep).count);
+    EXPECT_EQ(0, receiver.getRunStepHistogram(ISOTP_RunStepTotal).count); // Not enabled, the clock is not read.
+
+    // The histograms of a peer are only recorded once enabled.
+    ISOTP_LatencyHistogramSnapshot peerHistogram{};
+    EXPECT_FALSE(sender.getPeerLatencyHistogram(2, ISOTP_RequestPhase, peerHistogram));
+    EXPECT_TRUE(sender.enablePeerLatencyHistograms(2));
+    sender.resetLatencyHistograms();
+    EXPECT_EQ(0, sender.getLatencyHistogram(ISOTP_N_AsPhase).count);
+
+    // A message that does not fit in the memory for runners of the receiver is refused with an OVERFLOW FC.
+    constexpr uint8_t bigMessage[2000] = {};
+    ASSERT_TRUE(transfer.send(bigMessage, sizeof(bigMessage)));
+    ASSERT_TRUE(transfer.runUntilDone(2, 1));
+    EXPECT_EQ(N_BUFFER_OVFLW, transfer.getConfirmResult());
+    EXPECT_EQ(1, sender.getStatistics().requestResults[N_BUFFER_OVFLW]);
+    EXPECT_EQ(1, sender.getStatistics().total.sessionsFailed);
+    EXPECT_EQ(1, receiver.getStatistics().overflowFCsSent);
+    EXPECT_EQ(1, receiver.getStatistics().total.sessionsFailed);
+    ASSERT_TRUE(sender.getPeerLatencyHistogram(2, ISOTP_RequestPhase, peerHistogram));
+    EXPECT_EQ(1, peerHistogram.count);
+    ASSERT_TRUE(sender.getPeerLatencyHistogram(2, ISOTP_N_BsPhase, peerHistogram));
+    EXPECT_EQ(1, peerHistogram.count); // The OVERFLOW FC.
+}
+
+TEST(ISOTP_Statistics, peerStatisticsMemory)
+{
+    VirtualClockOSInterface clock;
+    TwoNodeTransfer         transfer(clock, {.senderMemory = 4096});
+    ISOTP&                  sender = transfer.getSender();
+    ASSERT_GT(ISOTP_Statistics::getPeerTableSize(), 4096);
+
+    // The table does not fit in the memory for runners, so the counters of the peers stay disabled.
+    EXPECT_FALSE(sender.enablePeerStatistics());
+    EXPECT_FALSE(sender.enablePeerLatencyHistograms(2));
+
+    // The memory for runners is left untouched.
+    constexpr uint8_t message[4000] = {};
+    ASSERT_TRUE(transfer.send(message, sizeof(message)));
+    ASSERT_TRUE(transfer.runUntilDone(1, 1));
+    EXPECT_EQ(N_OK, transfer.getConfirmResult());
+    EXPECT_EQ(0, sender.getPeerStatistics(2).framesTx);
+    EXPECT_GT(sender.getStatistics().total.framesTx, 0);
+}
@@ -1,5 +1,6 @@
 #include "ISOTP.h"
 
+#include <algorithm>
 #include <LocalCANNetwork.h>
 #include "ASSERT_MACROS.h"
 #include "LinuxOSInterface.h"
@@ -222,6 +223,231 @@ TEST(ISOTP_SystemTests, ManySendReceiveTestSF)
 }
 // END ManySendReceiveTestSF
 
+// QueuedSendReceiveOrderTestSF
+constexpr uint32_t QueuedSendReceiveOrderTestSF_messageCount  = 20;
+constexpr uint32_t QueuedSendReceiveOrderTestSF_messageLength = 1;
+
+static uint32_t QueuedSendReceiveOrderTestSF_N_USData_confirm_cb_calls = 0;
+void            QueuedSendReceiveOrderTestSF_N_USData_confirm_cb(N_AI nAi, N_Result nResult, Mtype mtype)
+{
+    QueuedSendReceiveOrderTestSF_N_USData_confirm_cb_calls++;
+
+    N_AI expectedNAi = {.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical, .N_TA = 2, .N_SA = 1};
+    EXPECT_EQ_N_AI(expectedNAi, nAi);
+    EXPECT_EQ(N_OK, nResult);
+    EXPECT_EQ(Mtype_Diagnostics, mtype);
+
+    if (QueuedSendReceiveOrderTestSF_N_USData_confirm_cb_calls == QueuedSendReceiveOrderTestSF_messageCount)
+    {
+        OSInterfaceLogInfo("QueuedSendReceiveOrderTestSF_N_USData_confirm_cb", "SenderKeepRunning set to false");
+        senderKeepRunning = false;
+    }
+}
+
+static uint32_t QueuedSendReceiveOrderTestSF_N_USData_indication_cb_calls = 0;
+void QueuedSendReceiveOrderTestSF_N_USData_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength,
+                                                         N_Result nResult, Mtype mtype)
+{
+    N_AI expectedNAi = {.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical, .N_TA = 2, .N_SA = 1};
+    EXPECT_EQ(N_OK, nResult);
+    EXPECT_EQ(Mtype_Diagnostics, mtype);
+    EXPECT_EQ_N_AI(expectedNAi, nAi);
+    ASSERT_EQ(QueuedSendReceiveOrderTestSF_messageLength, messageLength);
+    ASSERT_NE(nullptr, messageData);
+    EXPECT_EQ(QueuedSendReceiveOrderTestSF_N_USData_indication_cb_calls, messageData[0]); // Submission order
+
+    QueuedSendReceiveOrderTestSF_N_USData_indication_cb_calls++;
+    if (QueuedSendReceiveOrderTestSF_N_USData_indication_cb_calls == QueuedSendReceiveOrderTestSF_messageCount)
+    {
+        OSInterfaceLogInfo("QueuedSendReceiveOrderTestSF_N_USData_indication_cb", "ReceiverKeepRunning set to false");
+        receiverKeepRunning = false;
+    }
+}
+
+static uint32_t QueuedSendReceiveOrderTestSF_N_USData_FF_indication_cb_calls = 0;
+void QueuedSendReceiveOrderTestSF_N_USData_FF_indication_cb(const N_AI nAi, const uint32_t messageLength,
+                                                            const Mtype mtype)
+{
+    QueuedSendReceiveOrderTestSF_N_USData_FF_indication_cb_calls++;
+}
+
+TEST(ISOTP_SystemTests, QueuedSendReceiveOrderTestSF)
+{
+    constexpr uint32_t TIMEOUT = 10000; // 10 seconds
+    senderKeepRunning          = true;
+    receiverKeepRunning        = true;
+
+    LocalCANNetwork network(linuxOSInterface);
+    CANInterface*   senderInterface   = network.newCANInterfaceConnection("senderInterface");
+    CANInterface*   receiverInterface = network.newCANInterfaceConnection("receiverInterface");
+    ISOTP*          senderISOTP       = new ISOTP(
+        1, 4000, QueuedSendReceiveOrderTestSF_N_USData_confirm_cb, QueuedSendReceiveOrderTestSF_N_USData_indication_cb,
+        QueuedSendReceiveOrderTestSF_N_USData_FF_indication_cb, linuxOSInterface, *senderInterface, 2,
+        ISOTP_DefaultSTmin, "senderISOTP");
+    ISOTP* receiverISOTP = new ISOTP(
+        2, 2000, QueuedSendReceiveOrderTestSF_N_USData_confirm_cb, QueuedSendReceiveOrderTestSF_N_USData_indication_cb,
+        QueuedSendReceiveOrderTestSF_N_USData_FF_indication_cb, linuxOSInterface, *receiverInterface, 2,
+        ISOTP_DefaultSTmin, "receiverISOTP");
+
+    uint32_t initialTime = linuxOSInterface.osMillis();
+    uint32_t step        = 0;
+    while ((senderKeepRunning || receiverKeepRunning) && linuxOSInterface.osMillis() - initialTime < TIMEOUT)
+    {
+        senderISOTP->runStep();
+        senderISOTP->canMessageACKQueueRunStep();
+        receiverISOTP->runStep();
+        receiverISOTP->canMessageACKQueueRunStep();
+
+        if (step == 5)
+        {
+            // All the requests share the same N_AI, so they must be sent one after the other in submission order.
+            for (uint8_t i = 0; i < QueuedSendReceiveOrderTestSF_messageCount; i++)
+            {
+                EXPECT_TRUE(senderISOTP->N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, &i,
+                                                          QueuedSendReceiveOrderTestSF_messageLength,
+                                                          Mtype_Diagnostics));
+            }
+        }
+
+        step++;
+    }
+    uint32_t elapsedTime = linuxOSInterface.osMillis() - initialTime;
+
+    EXPECT_EQ(0, QueuedSendReceiveOrderTestSF_N_USData_FF_indication_cb_calls);
+    EXPECT_EQ(QueuedSendReceiveOrderTestSF_messageCount, QueuedSendReceiveOrderTestSF_N_USData_confirm_cb_calls);
+    EXPECT_EQ(QueuedSendReceiveOrderTestSF_messageCount, QueuedSendReceiveOrderTestSF_N_USData_indication_cb_calls);
+
+    ASSERT_LT(elapsedTime, TIMEOUT) << "Test took too long: " << elapsedTime << " ms, Timeout was: " << TIMEOUT;
+
+    delete senderISOTP;
+    delete receiverISOTP;
+    delete senderInterface;
+    delete receiverInterface;
+}
+// END QueuedSendReceiveOrderTestSF
+
+// MultiAddressReceiverTestSF
+constexpr char     MultiAddressReceiverTestSF_message[]     = "patata";
+constexpr uint32_t MultiAddressReceiverTestSF_messageLength = 7;
+
+static uint32_t MultiAddressReceiverTestSF_N_USData_confirm_cb_calls = 0;
+void            MultiAddressReceiverTestSF_N_USData_confirm_cb(N_AI nAi, N_Result nResult, Mtype mtype)
+{
+    MultiAddressReceiverTestSF_N_USData_confirm_cb_calls++;
+
+    EXPECT_EQ(N_OK, nResult);
+    EXPECT_EQ(Mtype_Diagnostics, mtype);
+
+    if (MultiAddressReceiverTestSF_N_USData_confirm_cb_calls == 4)
+    {
+        OSInterfaceLogInfo("MultiAddressReceiverTestSF_N_USData_confirm_cb", "SenderKeepRunning set to false");
+        senderKeepRunning = false;
+    }
+}
+
+static uint32_t MultiAddressReceiverTestSF_N_USData_indication_cb_calls = 0;
+static uint32_t MultiAddressReceiverTestSF_receivedN_TAs[3]             = {};
+void MultiAddressReceiverTestSF_N_USData_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength,
+                                                       N_Result nResult, Mtype mtype)
+{
+    EXPECT_EQ(N_OK, nResult);
+    EXPECT_EQ(Mtype_Diagnostics, mtype);
+    EXPECT_EQ(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, nAi.N_TAtype);
+    ASSERT_EQ(MultiAddressReceiverTestSF_messageLength, messageLength);
+    ASSERT_NE(nullptr, messageData);
+    EXPECT_EQ_ARRAY(MultiAddressReceiverTestSF_message, messageData, MultiAddressReceiverTestSF_messageLength);
+    ASSERT_LT(MultiAddressReceiverTestSF_N_USData_indication_cb_calls, 3);
+
+    // Store N_TA and N_SA together, the reception order between different N_AIs is not relevant.
+    MultiAddressReceiverTestSF_receivedN_TAs[MultiAddressReceiverTestSF_N_USData_indication_cb_calls] =
+        nAi.N_TA << 8 | nAi.N_SA;
+
+    MultiAddressReceiverTestSF_N_USData_indication_cb_calls++;
+    if (MultiAddressReceiverTestSF_N_USData_indication_cb_calls == 3)
+    {
+        OSInterfaceLogInfo("MultiAddressReceiverTestSF_N_USData_indication_cb", "ReceiverKeepRunning set to false");
+        receiverKeepRunning = false;
+    }
+}
+
+static uint32_t MultiAddressReceiverTestSF_N_USData_FF_indication_cb_calls = 0;
+void MultiAddressReceiverTestSF_N_USData_FF_indication_cb(const N_AI nAi, const uint32_t messageLength,
+                                                          const Mtype mtype)
+{
+    MultiAddressReceiverTestSF_N_USData_FF_indication_cb_calls++;
+}
+
+TEST(ISOTP_SystemTests, MultiAddressReceiverTestSF)
+{
+    constexpr uint32_t TIMEOUT = 10000; // 10 seconds
+    senderKeepRunning          = true;
+    receiverKeepRunning        = true;
+
+    LocalCANNetwork network(linuxOSInterface);
+    CANInterface*   senderInterface   = network.newCANInterfaceConnection("senderInterface");
+    CANInterface*   receiverInterface = network.newCANInterfaceConnection("receiverInterface");
+    ISOTP*          senderISOTP       = new ISOTP(
+        1, 2000, MultiAddressReceiverTestSF_N_USData_confirm_cb, MultiAddressReceiverTestSF_N_USData_indication_cb,
+        MultiAddressReceiverTestSF_N_USData_FF_indication_cb, linuxOSInterface, *senderInterface, 2,
+        ISOTP_DefaultSTmin, "senderISOTP");
+    ISOTP* receiverISOTP = new ISOTP(
+        2, 2000, MultiAddressReceiverTestSF_N_USData_confirm_cb, MultiAddressReceiverTestSF_N_USData_indication_cb,
+        MultiAddressReceiverTestSF_N_USData_FF_indication_cb, linuxOSInterface, *receiverInterface, 2,
+        ISOTP_DefaultSTmin, "receiverISOTP");
+
+    receiverISOTP->addLocalN_SA(3);
+
+    uint32_t initialTime = linuxOSInterface.osMillis();
+    uint32_t step        = 0;
+    while ((senderKeepRunning || receiverKeepRunning) && linuxOSInterface.osMillis() - initialTime < TIMEOUT)
+    {
+        senderISOTP->runStep();
+        senderISOTP->canMessageACKQueueRunStep();
+        receiverISOTP->runStep();
+        receiverISOTP->canMessageACKQueueRunStep();
+
+        if (step == 5)
+        {
+            EXPECT_TRUE(senderISOTP->N_USData_request(
+                2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                reinterpret_cast<const uint8_t*>(MultiAddressReceiverTestSF_message),
+                MultiAddressReceiverTestSF_messageLength, Mtype_Diagnostics));
+            EXPECT_TRUE(senderISOTP->N_USData_request(
+                3, N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                reinterpret_cast<const uint8_t*>(MultiAddressReceiverTestSF_message),
+                MultiAddressReceiverTestSF_messageLength, Mtype_Diagnostics));
+            EXPECT_TRUE(senderISOTP->N_USData_request(
+                4, N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                reinterpret_cast<const uint8_t*>(MultiAddressReceiverTestSF_message),
+                MultiAddressReceiverTestSF_messageLength, Mtype_Diagnostics)); // Nobody owns N_SA 4.
+            EXPECT_TRUE(receiverISOTP->N_USData_request(
+                3, 1, N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                reinterpret_cast<const uint8_t*>(MultiAddressReceiverTestSF_message),
+                MultiAddressReceiverTestSF_messageLength, Mtype_Diagnostics));
+        }
+
+        step++;
+    }
+    uint32_t elapsedTime = linuxOSInterface.osMillis() - initialTime;
+
+    EXPECT_EQ(0, MultiAddressReceiverTestSF_N_USData_FF_indication_cb_calls);
+    EXPECT_EQ(4, MultiAddressReceiverTestSF_N_USData_confirm_cb_calls);
+    EXPECT_EQ(3, MultiAddressReceiverTestSF_N_USData_indication_cb_calls);
+
+    std::sort(std::begin(MultiAddressReceiverTestSF_receivedN_TAs), std::end(MultiAddressReceiverTestSF_receivedN_TAs));
+    EXPECT_EQ(1 << 8 | 3, MultiAddressReceiverTestSF_receivedN_TAs[0]); // From the secondary N_SA to the sender.
+    EXPECT_EQ(2 << 8 | 1, MultiAddressReceiverTestSF_receivedN_TAs[1]);
+    EXPECT_EQ(3 << 8 | 1, MultiAddressReceiverTestSF_receivedN_TAs[2]);
+
+    ASSERT_LT(elapsedTime, TIMEOUT) << "Test took too long: " << elapsedTime << " ms, Timeout was: " << TIMEOUT;
+
+    delete senderISOTP;
+    delete receiverISOTP;
+    delete senderInterface;
+    delete receiverInterface;
+}
+// END MultiAddressReceiverTestSF
+
 // BigSFTestBroadcast
 constexpr char     BigSFTestBroadcast_message[]     = "patatasFritas";
 constexpr uint32_t BigSFTestBroadcast_messageLength = 14;
@@ -451,70 +677,64 @@ void            ManySendReceiveTestBroadcast_N_USData_confirm_cb(N_AI nAi, N_Res
 {
     ManySendReceiveTestBroadcast_N_USData_confirm_cb_calls++;
 
-    if (ManySendReceiveTestBroadcast_N_USData_confirm_cb_calls == 2)
+    // Both SFs are written directly in the order they were requested.
+    if (ManySendReceiveTestBroadcast_N_USData_confirm_cb_calls == 1)
     {
         N_AI expectedNAi = {.N_TAtype = N_TATYPE_6_CAN_CLASSIC_29bit_Functional, .N_TA = 2, .N_SA = 1};
         EXPECT_EQ_N_AI(expectedNAi, nAi);
         EXPECT_EQ(N_OK, nResult);
         EXPECT_EQ(Mtype_Diagnostics, mtype);
 
-        OSInterfaceLogInfo("ManySendReceiveTestBroadcast_N_USData_confirm_cb", "SenderKeepRunning set to false");
-        senderKeepRunning = false;
+        OSInterfaceLogInfo("ManySendReceiveTestBroadcast_N_USData_confirm_cb", "First call");
     }
 
-    if (ManySendReceiveTestBroadcast_N_USData_confirm_cb_calls == 1)
+    if (ManySendReceiveTestBroadcast_N_USData_confirm_cb_calls == 2)
     {
         N_AI expectedNAi = {.N_TAtype = N_TATYPE_6_CAN_CLASSIC_29bit_Functional, .N_TA = 3, .N_SA = 1};
         EXPECT_EQ_N_AI(expectedNAi, nAi);
         EXPECT_EQ(N_OK, nResult);
         EXPECT_EQ(Mtype_Diagnostics, mtype);
 
-        OSInterfaceLogInfo("ManySendReceiveTestBroadcast_N_USData_confirm_cb", "First call");
+        OSInterfaceLogInfo("ManySendReceiveTestBroadcast_N_USData_confirm_cb", "SenderKeepRunning set to false");
+        senderKeepRunning = false;
     }
 }
 
-static uint32_t ManySendReceiveTestBroadcast_N_USData_indication_cb_calls = 0;
+static uint32_t ManySendReceiveTestBroadcast_N_USData_indication_cb_calls      = 0;
+static uint32_t ManySendReceiveTestBroadcast_N_USData_indication_cb_calls_N_TA2 = 0;
+static uint32_t ManySendReceiveTestBroadcast_N_USData_indication_cb_calls_N_TA3 = 0;
 void ManySendReceiveTestBroadcast_N_USData_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength,
                                                          N_Result nResult, Mtype mtype)
 {
     ManySendReceiveTestBroadcast_N_USData_indication_cb_calls++;
 
-    if (ManySendReceiveTestBroadcast_N_USData_indication_cb_calls == 1)
-    {
-        N_AI expectedNAi = {.N_TAtype = N_TATYPE_6_CAN_CLASSIC_29bit_Functional, .N_TA = 3, .N_SA = 1};
-        EXPECT_EQ(N_OK, nResult);
-        EXPECT_EQ(Mtype_Diagnostics, mtype);
-        EXPECT_EQ_N_AI(expectedNAi, nAi);
-
-        ASSERT_EQ(ManySendReceiveTestBroadcast_messageLength2, messageLength);
-        ASSERT_NE(nullptr, messageData);
-        EXPECT_EQ_ARRAY(ManySendReceiveTestBroadcast_message2, messageData,
-                        ManySendReceiveTestBroadcast_messageLength2);
+    EXPECT_EQ(N_OK, nResult);
+    EXPECT_EQ(Mtype_Diagnostics, mtype);
+    EXPECT_EQ(N_TATYPE_6_CAN_CLASSIC_29bit_Functional, nAi.N_TAtype);
+    EXPECT_EQ(1, nAi.N_SA);
+    ASSERT_NE(nullptr, messageData);
 
-        OSInterfaceLogInfo("ManySendReceiveTestBroadcast_N_USData_indication_cb", "First call");
-    }
-    else if (ManySendReceiveTestBroadcast_N_USData_indication_cb_calls <= 3)
+    // The receivers run in turns, so the indications of both messages may interleave.
+    if (nAi.N_TA == 2)
     {
-        N_AI expectedNAi = {.N_TAtype = N_TATYPE_6_CAN_CLASSIC_29bit_Functional, .N_TA = 2, .N_SA = 1};
-        EXPECT_EQ(N_OK, nResult);
-        EXPECT_EQ(Mtype_Diagnostics, mtype);
-        EXPECT_EQ_N_AI(expectedNAi, nAi);
-
+        ManySendReceiveTestBroadcast_N_USData_indication_cb_calls_N_TA2++;
         ASSERT_EQ(ManySendReceiveTestBroadcast_messageLength1, messageLength);
-        ASSERT_NE(nullptr, messageData);
         EXPECT_EQ_ARRAY(ManySendReceiveTestBroadcast_message1, messageData,
                         ManySendReceiveTestBroadcast_messageLength1);
+    }
+    else
+    {
+        ManySendReceiveTestBroadcast_N_USData_indication_cb_calls_N_TA3++;
+        EXPECT_EQ(3, nAi.N_TA);
+        ASSERT_EQ(ManySendReceiveTestBroadcast_messageLength2, messageLength);
+        EXPECT_EQ_ARRAY(ManySendReceiveTestBroadcast_message2, messageData,
+                        ManySendReceiveTestBroadcast_messageLength2);
+    }
 
-        if (ManySendReceiveTestBroadcast_N_USData_indication_cb_calls == 2)
-        {
-            OSInterfaceLogInfo("ManySendReceiveTestBroadcast_N_USData_indication_cb", "Second call");
-        }
-        else if (ManySendReceiveTestBroadcast_N_USData_indication_cb_calls == 3)
-        {
-            OSInterfaceLogInfo("ManySendReceiveTestBroadcast_N_USData_indication_cb",
-                               "ReceiverKeepRunning set to false");
-            receiverKeepRunning = false;
-        }
+    if (ManySendReceiveTestBroadcast_N_USData_indication_cb_calls == 3)
+    {
+        OSInterfaceLogInfo("ManySendReceiveTestBroadcast_N_USData_indication_cb", "ReceiverKeepRunning set to false");
+        receiverKeepRunning = false;
     }
 }
 
@@ -584,6 +804,8 @@ TEST(ISOTP_SystemTests, ManySendReceiveTestBroadcast)
     EXPECT_EQ(0, ManySendReceiveTestBroadcast_N_USData_FF_indication_cb_calls);
     EXPECT_EQ(2, ManySendReceiveTestBroadcast_N_USData_confirm_cb_calls);
     EXPECT_EQ(3, ManySendReceiveTestBroadcast_N_USData_indication_cb_calls);
+    EXPECT_EQ(2, ManySendReceiveTestBroadcast_N_USData_indication_cb_calls_N_TA2); // Both receivers accept N_TA 2.
+    EXPECT_EQ(1, ManySendReceiveTestBroadcast_N_USData_indication_cb_calls_N_TA3);
 
     ASSERT_LT(elapsedTime, TIMEOUT) << "Test took too long: " << elapsedTime << " ms, Timeout was: " << TIMEOUT;
 
@@ -692,6 +914,328 @@ TEST(ISOTP_SystemTests, SimpleSendReceiveTestMF)
 }
 // END SimpleSendReceiveTestMF
 
+// SlabSendReceiveTestMF
+constexpr char     SlabSendReceiveTestMF_message[]     = "01234567890123456789";
+constexpr uint32_t SlabSendReceiveTestMF_messageLength = 21;
+
+static uint32_t SlabSendReceiveTestMF_N_USData_confirm_cb_calls = 0;
+void            SlabSendReceiveTestMF_N_USData_confirm_cb(N_AI nAi, N_Result nResult, Mtype mtype)
+{
+    SlabSendReceiveTestMF_N_USData_confirm_cb_calls++;
+
+    N_AI expectedNAi = {.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical, .N_TA = 2, .N_SA = 1};
+    EXPECT_EQ_N_AI(expectedNAi, nAi);
+    EXPECT_EQ(N_OK, nResult);
+    EXPECT_EQ(Mtype_Diagnostics, mtype);
+
+    OSInterfaceLogInfo("SlabSendReceiveTestMF_N_USData_confirm_cb", "SenderKeepRunning set to false");
+    senderKeepRunning = false;
+}
+
+static uint32_t SlabSendReceiveTestMF_N_USData_indication_cb_calls = 0;
+void SlabSendReceiveTestMF_N_USData_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength,
+                                                    N_Result nResult, Mtype mtype)
+{
+    SlabSendReceiveTestMF_N_USData_indication_cb_calls++;
+    N_AI expectedNAi = {.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical, .N_TA = 2, .N_SA = 1};
+    EXPECT_EQ(N_OK, nResult);
+    EXPECT_EQ(Mtype_Diagnostics, mtype);
+    EXPECT_EQ_N_AI(expectedNAi, nAi);
+    ASSERT_EQ(SlabSendReceiveTestMF_messageLength, messageLength);
+    ASSERT_NE(nullptr, messageData);
+    ASSERT_EQ_ARRAY(SlabSendReceiveTestMF_message, messageData, SlabSendReceiveTestMF_messageLength);
+
+    OSInterfaceLogInfo("SlabSendReceiveTestMF_N_USData_indication_cb", "ReceiverKeepRunning set to false");
+    receiverKeepRunning = false;
+}
+
+static uint32_t SlabSendReceiveTestMF_N_USData_FF_indication_cb_calls = 0;
+void SlabSendReceiveTestMF_N_USData_FF_indication_cb(const N_AI nAi, const uint32_t messageLength, const Mtype mtype)
+{
+    SlabSendReceiveTestMF_N_USData_FF_indication_cb_calls++;
+    N_AI expectedNAi = {.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical, .N_TA = 2, .N_SA = 1};
+    EXPECT_EQ_N_AI(expectedNAi, nAi);
+    ASSERT_EQ(SlabSendReceiveTestMF_messageLength, messageLength);
+    EXPECT_EQ(Mtype_Diagnostics, mtype);
+}
+
+TEST(ISOTP_SystemTests, SlabSendReceiveTestMF)
+{
+    constexpr uint32_t TIMEOUT = 10000;
+    senderKeepRunning          = true;
+    receiverKeepRunning        = true;
+
+    LocalCANNetwork network(linuxOSInterface);
+    CANInterface*   senderInterface   = network.newCANInterfaceConnection();
+    CANInterface*   receiverInterface = network.newCANInterfaceConnection();
+    ISOTP*       senderISOTP =
+        new ISOTP(1, 2000, SlabSendReceiveTestMF_N_USData_confirm_cb,
+                     SlabSendReceiveTestMF_N_USData_indication_cb, SlabSendReceiveTestMF_N_USData_FF_indication_cb,
+                     linuxOSInterface, *senderInterface, 2, ISOTP_DefaultSTmin, "senderISOTP", ISOTP_SlabPayloads);
+    ISOTP* receiverISOTP =
+        new ISOTP(2, 2000, SlabSendReceiveTestMF_N_USData_confirm_cb,
+                     SlabSendReceiveTestMF_N_USData_indication_cb, SlabSendReceiveTestMF_N_USData_FF_indication_cb,
+                     linuxOSInterface, *receiverInterface, 2, ISOTP_DefaultSTmin, "receiverISOTP", ISOTP_SlabPayloads);
+
+    uint32_t initialTime = linuxOSInterface.osMillis();
+    uint32_t step        = 0;
+    while ((senderKeepRunning || receiverKeepRunning) && linuxOSInterface.osMillis() - initialTime < TIMEOUT)
+    {
+        senderISOTP->runStep();
+        senderISOTP->canMessageACKQueueRunStep();
+        receiverISOTP->runStep();
+        receiverISOTP->canMessageACKQueueRunStep();
+
+        if (step == 5)
+        {
+            EXPECT_TRUE(
+                senderISOTP->N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                                                 reinterpret_cast<const uint8_t*>(SlabSendReceiveTestMF_message),
+                                                 SlabSendReceiveTestMF_messageLength, Mtype_Diagnostics));
+        }
+        step++;
+    }
+    uint32_t elapsedTime = linuxOSInterface.osMillis() - initialTime;
+
+    EXPECT_EQ(1, SlabSendReceiveTestMF_N_USData_FF_indication_cb_calls);
+    EXPECT_EQ(1, SlabSendReceiveTestMF_N_USData_confirm_cb_calls);
+    EXPECT_EQ(1, SlabSendReceiveTestMF_N_USData_indication_cb_calls);
+
+    ASSERT_LT(elapsedTime, TIMEOUT) << "Test took too long: " << elapsedTime << " ms, Timeout was: " << TIMEOUT;
+
+    delete senderISOTP;
+    delete receiverISOTP;
+    delete senderInterface;
+    delete receiverInterface;
+}
+// END SlabSendReceiveTestMF
+
+// ChunkedSendReceiveTestMF
+constexpr uint32_t ChunkedSendReceiveTestMF_messageLength = 2 * ISOTP_DefaultChunkSize + 100; // 3 chunks.
+static uint8_t     ChunkedSendReceiveTestMF_message[ChunkedSendReceiveTestMF_messageLength];
+
+static uint32_t ChunkedSendReceiveTestMF_N_USData_confirm_cb_calls = 0;
+void            ChunkedSendReceiveTestMF_N_USData_confirm_cb(N_AI nAi, N_Result nResult, Mtype mtype)
+{
+    ChunkedSendReceiveTestMF_N_USData_confirm_cb_calls++;
+
+    N_AI expectedNAi = {.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical, .N_TA = 2, .N_SA = 1};
+    EXPECT_EQ_N_AI(expectedNAi, nAi);
+    EXPECT_EQ(N_OK, nResult);
+    EXPECT_EQ(Mtype_Diagnostics, mtype);
+
+    OSInterfaceLogInfo("ChunkedSendReceiveTestMF_N_USData_confirm_cb", "SenderKeepRunning set to false");
+    senderKeepRunning = false;
+}
+
+static uint32_t ChunkedSendReceiveTestMF_N_USData_indication_cb_calls = 0;
+void ChunkedSendReceiveTestMF_N_USData_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength,
+                                                     N_Result nResult, Mtype mtype)
+{
+    ChunkedSendReceiveTestMF_N_USData_indication_cb_calls++;
+    N_AI expectedNAi = {.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical, .N_TA = 2, .N_SA = 1};
+    EXPECT_EQ(N_OK, nResult);
+    EXPECT_EQ(Mtype_Diagnostics, mtype);
+    EXPECT_EQ_N_AI(expectedNAi, nAi);
+    ASSERT_EQ(ChunkedSendReceiveTestMF_messageLength, messageLength);
+    ASSERT_NE(nullptr, messageData);
+    ASSERT_EQ_ARRAY(ChunkedSendReceiveTestMF_message, messageData, ChunkedSendReceiveTestMF_messageLength);
+
+    OSInterfaceLogInfo("ChunkedSendReceiveTestMF_N_USData_indication_cb", "ReceiverKeepRunning set to false");
+    receiverKeepRunning = false;
+}
+
+static uint32_t ChunkedSendReceiveTestMF_N_USData_indication_segments_cb_calls = 0;
+void ChunkedSendReceiveTestMF_N_USData_indication_segments_cb(N_AI nAi, const ISOTP_MessageView& message,
+                                                              N_Result nResult, Mtype mtype)
+{
+    ChunkedSendReceiveTestMF_N_USData_indication_segments_cb_calls++;
+    N_AI expectedNAi = {.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical, .N_TA = 2, .N_SA = 1};
+    EXPECT_EQ(N_OK, nResult);
+    EXPECT_EQ(Mtype_Diagnostics, mtype);
+    EXPECT_EQ_N_AI(expectedNAi, nAi);
+    ASSERT_EQ(ChunkedSendReceiveTestMF_messageLength, message.length);
+    ASSERT_EQ(3, message.segmentCount);
+
+    uint32_t offset = 0;
+    for (uint32_t segment = 0; segment < message.segmentCount; segment++)
+    {
+        const uint32_t segmentLength = message.segments[segment].length;
+        ASSERT_EQ_ARRAY(&ChunkedSendReceiveTestMF_message[offset], message.segments[segment].data, segmentLength);
+        offset += segmentLength;
+    }
+
+    OSInterfaceLogInfo("ChunkedSendReceiveTestMF_N_USData_indication_segments_cb", "ReceiverKeepRunning set to false");
+    receiverKeepRunning = false;
+}
+
+static void ChunkedSendReceiveTestMF_run(const bool segments)
+{
+    constexpr uint32_t TIMEOUT = 10000;
+    senderKeepRunning          = true;
+    receiverKeepRunning        = true;
+    for (uint32_t i = 0; i < ChunkedSendReceiveTestMF_messageLength; i++)
+    {
+        ChunkedSendReceiveTestMF_message[i] = i * 7;
+    }
+
+    LocalCANNetwork network(linuxOSInterface);
+    CANInterface*   senderInterface   = network.newCANInterfaceConnection();
+    CANInterface*   receiverInterface = network.newCANInterfaceConnection();
+    ISOTP* senderISOTP   = new ISOTP(1, 2000, ChunkedSendReceiveTestMF_N_USData_confirm_cb, nullptr, nullptr,
+                                     linuxOSInterface, *senderInterface, 0, {0, ms}, "senderISOTP");
+    ISOTP* receiverISOTP = new ISOTP(2, 2000, nullptr, ChunkedSendReceiveTestMF_N_USData_indication_cb, nullptr,
+                                     linuxOSInterface, *receiverInterface, 0, {0, ms}, "receiverISOTP",
+                                     ISOTP_ChunkedPayloads);
+    if (segments)
+    {
+        receiverISOTP->setIndicationSegmentsCallback(ChunkedSendReceiveTestMF_N_USData_indication_segments_cb);
+    }
+
+    EXPECT_TRUE(senderISOTP->N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                                              ChunkedSendReceiveTestMF_message,
+                                              ChunkedSendReceiveTestMF_messageLength, Mtype_Diagnostics));
+
+    uint32_t initialTime = linuxOSInterface.osMillis();
+    while ((senderKeepRunning || receiverKeepRunning) && linuxOSInterface.osMillis() - initialTime < TIMEOUT)
+    {
+        senderISOTP->runStep();
+        senderISOTP->canMessageACKQueueRunStep();
+        receiverISOTP->runStep();
+        receiverISOTP->canMessageACKQueueRunStep();
+    }
+    uint32_t elapsedTime = linuxOSInterface.osMillis() - initialTime;
+
+    ASSERT_LT(elapsedTime, TIMEOUT) << "Test took too long: " << elapsedTime << " ms, Timeout was: " << TIMEOUT;
+
+    delete senderISOTP;
+    delete receiverISOTP;
+    delete senderInterface;
+    delete receiverInterface;
+}
+
+TEST(ISOTP_SystemTests, ChunkedSendReceiveTestMF)
+{
+    // Without the segments callback, N_USData_indication_cb gets a contiguous copy.
+    ChunkedSendReceiveTestMF_run(false);
+    EXPECT_EQ(1, ChunkedSendReceiveTestMF_N_USData_confirm_cb_calls);
+    EXPECT_EQ(1, ChunkedSendReceiveTestMF_N_USData_indication_cb_calls);
+    EXPECT_EQ(0, ChunkedSendReceiveTestMF_N_USData_indication_segments_cb_calls);
+
+    ChunkedSendReceiveTestMF_run(true);
+    EXPECT_EQ(2, ChunkedSendReceiveTestMF_N_USData_confirm_cb_calls);
+    EXPECT_EQ(1, ChunkedSendReceiveTestMF_N_USData_indication_cb_calls);
+    EXPECT_EQ(1, ChunkedSendReceiveTestMF_N_USData_indication_segments_cb_calls);
+}
+// END ChunkedSendReceiveTestMF
+
+// PushModeSendReceiveTestMF
+constexpr char     PushModeSendReceiveTestMF_message[]     = "01234567890123456789";
+constexpr uint32_t PushModeSendReceiveTestMF_messageLength = 21;
+
+static uint32_t PushModeSendReceiveTestMF_N_USData_confirm_cb_calls = 0;
+void            PushModeSendReceiveTestMF_N_USData_confirm_cb(N_AI nAi, N_Result nResult, Mtype mtype)
+{
+    PushModeSendReceiveTestMF_N_USData_confirm_cb_calls++;
+
+    N_AI expectedNAi = {.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical, .N_TA = 2, .N_SA = 1};
+    EXPECT_EQ_N_AI(expectedNAi, nAi);
+    EXPECT_EQ(N_OK, nResult);
+    EXPECT_EQ(Mtype_Diagnostics, mtype);
+
+    OSInterfaceLogInfo("PushModeSendReceiveTestMF_N_USData_confirm_cb", "SenderKeepRunning set to false");
+    senderKeepRunning = false;
+}
+
+static uint32_t PushModeSendReceiveTestMF_N_USData_indication_cb_calls = 0;
+void PushModeSendReceiveTestMF_N_USData_indication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength,
+                                                      N_Result nResult, Mtype mtype)
+{
+    PushModeSendReceiveTestMF_N_USData_indication_cb_calls++;
+    N_AI expectedNAi = {.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical, .N_TA = 2, .N_SA = 1};
+    EXPECT_EQ(N_OK, nResult);
+    EXPECT_EQ(Mtype_Diagnostics, mtype);
+    EXPECT_EQ_N_AI(expectedNAi, nAi);
+    ASSERT_EQ(PushModeSendReceiveTestMF_messageLength, messageLength);
+    ASSERT_NE(nullptr, messageData);
+    ASSERT_EQ_ARRAY(PushModeSendReceiveTestMF_message, messageData, PushModeSendReceiveTestMF_messageLength);
+
+    OSInterfaceLogInfo("PushModeSendReceiveTestMF_N_USData_indication_cb", "ReceiverKeepRunning set to false");
+    receiverKeepRunning = false;
+}
+
+static uint32_t PushModeSendReceiveTestMF_wakeUp_cb_calls = 0;
+void            PushModeSendReceiveTestMF_wakeUp_cb(ISOTP& isotp)
+{
+    PushModeSendReceiveTestMF_wakeUp_cb_calls++;
+}
+
+// Plays the role of a CAN driver that delivers its frames and ACKs by callback.
+void PushModeSendReceiveTestMF_driverStep(CANInterface& canInterface, ISOTP& isotp)
+{
+    CANFrame frame;
+    while (canInterface.frameAvailable() && canInterface.readFrame(&frame))
+    {
+        EXPECT_TRUE(isotp.onFrameReceived(frame));
+    }
+    if (const ACKResult ack = canInterface.getWriteFrameACK(); ack != ACK_NONE)
+    {
+        EXPECT_TRUE(isotp.onWriteAck(ack));
+    }
+}
+
+TEST(ISOTP_SystemTests, PushModeSendReceiveTestMF)
+{
+    constexpr uint32_t TIMEOUT = 10000;
+    senderKeepRunning          = true;
+    receiverKeepRunning        = true;
+
+    LocalCANNetwork network(linuxOSInterface);
+    CANInterface*   senderInterface   = network.newCANInterfaceConnection();
+    CANInterface*   receiverInterface = network.newCANInterfaceConnection();
+    ISOTP*          senderISOTP =
+        new ISOTP(1, 2000, PushModeSendReceiveTestMF_N_USData_confirm_cb,
+                  PushModeSendReceiveTestMF_N_USData_indication_cb, nullptr, linuxOSInterface, *senderInterface, 2,
+                  ISOTP_DefaultSTmin, "senderISOTP");
+    ISOTP* receiverISOTP =
+        new ISOTP(2, 2000, PushModeSendReceiveTestMF_N_USData_confirm_cb,
+                  PushModeSendReceiveTestMF_N_USData_indication_cb, nullptr, linuxOSInterface, *receiverInterface, 2,
+                  ISOTP_DefaultSTmin, "receiverISOTP");
+
+    EXPECT_FALSE(senderISOTP->isPushModeEnabled());
+    senderISOTP->setPushMode(true, PushModeSendReceiveTestMF_wakeUp_cb);
+    receiverISOTP->setPushMode(true, PushModeSendReceiveTestMF_wakeUp_cb);
+    EXPECT_TRUE(senderISOTP->isPushModeEnabled());
+
+    EXPECT_TRUE(senderISOTP->N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
+                                              reinterpret_cast<const uint8_t*>(PushModeSendReceiveTestMF_message),
+                                              PushModeSendReceiveTestMF_messageLength, Mtype_Diagnostics));
+
+    uint32_t initialTime = linuxOSInterface.osMillis();
+    while ((senderKeepRunning || receiverKeepRunning) && linuxOSInterface.osMillis() - initialTime < TIMEOUT)
+    {
+        PushModeSendReceiveTestMF_driverStep(*senderInterface, *senderISOTP);
+        PushModeSendReceiveTestMF_driverStep(*receiverInterface, *receiverISOTP);
+
+        // canMessageACKQueueRunStep is not needed, runStep takes the ACKs given to onWriteAck.
+        senderISOTP->runStep();
+        receiverISOTP->runStep();
+    }
+    uint32_t elapsedTime = linuxOSInterface.osMillis() - initialTime;
+
+    EXPECT_EQ(1, PushModeSendReceiveTestMF_N_USData_confirm_cb_calls);
+    EXPECT_EQ(1, PushModeSendReceiveTestMF_N_USData_indication_cb_calls);
+    EXPECT_LT(0, PushModeSendReceiveTestMF_wakeUp_cb_calls);
+
+    ASSERT_LT(elapsedTime, TIMEOUT) << "Test took too long: " << elapsedTime << " ms, Timeout was: " << TIMEOUT;
+
+    delete senderISOTP;
+    delete receiverISOTP;
+    delete senderInterface;
+    delete receiverInterface;
+}
+// END PushModeSendReceiveTestMF
+
 // ManySendReceiveTestMF
 constexpr char     ManySendReceiveTestMF_message1[]     = "01234567890123456789";
 constexpr uint32_t ManySendReceiveTestMF_messageLength1 = 21;
@@ -1098,24 +1642,20 @@ TEST(ISOTP_SystemTests, LowMemorySenderTestSF)
 
         if (step == 5)
         {
-            EXPECT_FALSE(
+            // SFs to an idle N_AI are written directly, they do not need memory for runners.
+            EXPECT_TRUE(
                 senderISOTP->N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical,
                                                  reinterpret_cast<const uint8_t*>(LowMemorySenderTestSF_message),
                                                  LowMemorySenderTestSF_messageLength, Mtype_Diagnostics));
         }
-        if (step == 10)
-        {
-            senderKeepRunning   = false;
-            receiverKeepRunning = false;
-        }
 
         step++;
     }
     uint32_t elapsedTime = linuxOSInterface.osMillis() - initialTime;
 
     EXPECT_EQ(0, LowMemorySenderTestSF_N_USData_FF_indication_cb_calls);
-    EXPECT_EQ(0, LowMemorySenderTestSF_N_USData_confirm_cb_calls);
-    EXPECT_EQ(0, LowMemorySenderTestSF_N_USData_indication_cb_calls);
+    EXPECT_EQ(1, LowMemorySenderTestSF_N_USData_confirm_cb_calls);
+    EXPECT_EQ(1, LowMemorySenderTestSF_N_USData_indication_cb_calls);
 
     ASSERT_LT(elapsedTime, TIMEOUT) << "Test took too long: " << elapsedTime << " ms, Timeout was: " << TIMEOUT;
 
@@ -1150,11 +1690,12 @@ void LowMemoryReceiverTestSF_N_USData_indication_cb(N_AI nAi, const uint8_t* mes
 {
     LowMemoryReceiverTestSF_N_USData_indication_cb_calls++;
     N_AI expectedNAi = {.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical, .N_TA = 2, .N_SA = 1};
-    EXPECT_EQ(N_ERROR, nResult);
+    EXPECT_EQ(N_OK, nResult); // SFs are delivered straight from the frame, they do not need memory for runners.
     EXPECT_EQ(Mtype_Diagnostics, mtype);
     EXPECT_EQ_N_AI(expectedNAi, nAi);
     ASSERT_EQ(LowMemoryReceiverTestSF_messageLength, messageLength);
-    ASSERT_EQ(nullptr, messageData);
+    ASSERT_NE(nullptr, messageData);
+    EXPECT_EQ_ARRAY(LowMemoryReceiverTestSF_message, messageData, LowMemoryReceiverTestSF_messageLength);
 
     OSInterfaceLogInfo("LowMemoryReceiverTestSF_N_USData_indication_cb", "ReceiverKeepRunning set to false");
     receiverKeepRunning = false;
@@ -1273,7 +1814,7 @@ TEST(ISOTP_SystemTests, LowMemorySenderTestMF)
     CANInterface*   senderInterface   = network.newCANInterfaceConnection();
     CANInterface*   receiverInterface = network.newCANInterfaceConnection();
     ISOTP*       senderISOTP =
-        new ISOTP(1, 100, LowMemorySenderTestMF_N_USData_confirm_cb, LowMemorySenderTestMF_N_USData_indication_cb,
+        new ISOTP(1, 20, LowMemorySenderTestMF_N_USData_confirm_cb, LowMemorySenderTestMF_N_USData_indication_cb,
                      LowMemorySenderTestMF_N_USData_FF_indication_cb, linuxOSInterface, *senderInterface, 2,
                      ISOTP_DefaultSTmin, "senderISOTP");
     ISOTP* receiverISOTP =
@@ -1378,7 +1919,7 @@ TEST(ISOTP_SystemTests, LowMemoryReceiverTestMF)
                      LowMemoryReceiverTestMF_N_USData_indication_cb, LowMemoryReceiverTestMF_N_USData_FF_indication_cb,
                      linuxOSInterface, *senderInterface, 2, ISOTP_DefaultSTmin, "senderISOTP");
     ISOTP* receiverISOTP =
-        new ISOTP(2, 100, LowMemoryReceiverTestMF_N_USData_confirm_cb,
+        new ISOTP(2, 20, LowMemoryReceiverTestMF_N_USData_confirm_cb,
                      LowMemoryReceiverTestMF_N_USData_indication_cb, LowMemoryReceiverTestMF_N_USData_FF_indication_cb,
                      linuxOSInterface, *receiverInterface, 2, ISOTP_DefaultSTmin, "receiverISOTP");
 
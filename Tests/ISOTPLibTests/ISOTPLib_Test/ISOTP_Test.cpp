@@ -60,6 +60,37 @@ TEST(ISOTP, getTag)
     delete canInterface;
 }
 
+TEST(ISOTP, LocalN_SA)
+{
+    LocalCANNetwork canNetwork(linuxOSInterface);
+    CANInterface*   canInterface = canNetwork.newCANInterfaceConnection();
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                      linuxOSInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+
+    EXPECT_TRUE(ISOTP.hasLocalN_SA(1));
+    EXPECT_FALSE(ISOTP.hasLocalN_SA(2));
+
+    ISOTP.addLocalN_SA(2);
+    ISOTP.addLocalN_SA(255);
+    EXPECT_TRUE(ISOTP.hasLocalN_SA(2));
+    EXPECT_TRUE(ISOTP.hasLocalN_SA(255));
+    EXPECT_EQ(ISOTP.getN_SA(), 1);
+
+    EXPECT_TRUE(ISOTP.removeLocalN_SA(2));
+    EXPECT_FALSE(ISOTP.hasLocalN_SA(2));
+    EXPECT_FALSE(ISOTP.removeLocalN_SA(2));
+
+    EXPECT_FALSE(ISOTP.removeLocalN_SA(1)); // The constructor N_SA cannot be removed.
+    EXPECT_TRUE(ISOTP.hasLocalN_SA(1));
+
+    const uint8_t message[] = "msg";
+    EXPECT_FALSE(ISOTP.N_USData_request(3, 4, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+    EXPECT_TRUE(ISOTP.N_USData_request(255, 4, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+
+    delete canInterface;
+}
+
 TEST(ISOTP, AcceptedFunctionalN_TA)
 {
     LocalCANNetwork canNetwork(linuxOSInterface);
@@ -127,3 +158,239 @@ TEST(ISOTP, STmin)
 
     delete canInterface;
 }
+
+TEST(ISOTP, PeerQuota)
+{
+    LocalCANNetwork canNetwork(linuxOSInterface);
+    CANInterface*   canInterface = canNetwork.newCANInterfaceConnection();
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                linuxOSInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+
+    EXPECT_EQ(ISOTP_DefaultPeerQuota.maxMemory, ISOTP.getPeerQuota(2).maxMemory);
+
+    EXPECT_TRUE(ISOTP.setPeerQuota(2, {500, 100, 1}));
+    EXPECT_EQ(500, ISOTP.getPeerQuota(2).maxMemory);
+    EXPECT_EQ(100, ISOTP.getPeerQuota(2).reservedMemory);
+    EXPECT_EQ(1, ISOTP.getPeerQuota(2).maxReceptions);
+    EXPECT_EQ(ISOTP_DefaultPeerQuota.maxMemory, ISOTP.getPeerQuota(3).maxMemory);
+
+    delete canInterface;
+}
+
+TEST(ISOTP, PushMode)
+{
+    LocalCANNetwork canNetwork(linuxOSInterface);
+    CANInterface*   canInterface = canNetwork.newCANInterfaceConnection();
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                linuxOSInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+
+    CANFrame frame            = {};
+    frame.extd                = 1;
+    frame.identifier.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical;
+    frame.identifier.N_TA     = 1;
+    frame.identifier.N_SA     = 2;
+
+    // Polling mode is the default, pushed frames and ACKs are rejected.
+    EXPECT_FALSE(ISOTP.isPushModeEnabled());
+    EXPECT_FALSE(ISOTP.onFrameReceived(frame));
+    EXPECT_FALSE(ISOTP.onWriteAck(ACK_SUCCESS));
+
+    ISOTP.setPushMode(true);
+    EXPECT_FALSE(ISOTP.onWriteAck(ACK_NONE));
+    EXPECT_TRUE(ISOTP.onFrameReceived(frame));
+    EXPECT_TRUE(ISOTP.hasPendingCANEvents());
+    EXPECT_EQ(0, ISOTP.getNextRunTime());
+
+    for (uint32_t i = 1; i < ISOTP_FrameInboxSize; i++)
+    {
+        EXPECT_TRUE(ISOTP.onFrameReceived(frame));
+    }
+    EXPECT_FALSE(ISOTP.onFrameReceived(frame)); // The inbox is full.
+
+    ISOTP.setPushMode(false);
+
+    delete canInterface;
+}
+
+static uint32_t PushModeDisabled_cb_calls = 0;
+void PushModeDisabled_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength, N_Result nResult, Mtype mtype)
+{
+    PushModeDisabled_cb_calls++;
+    EXPECT_EQ(N_OK, nResult);
+}
+
+TEST(ISOTP, PushModeDisabledWithQueuedFrame)
+{
+    LocalCANNetwork canNetwork(linuxOSInterface);
+    CANInterface*   canInterface = canNetwork.newCANInterfaceConnection();
+
+    ISOTP ISOTP(1, 0, Dummy_N_USData_confirm_cb, PushModeDisabled_cb, Dummy_N_USData_FF_indication_cb,
+                linuxOSInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+
+    CANFrame frame            = {};
+    frame.extd                = 1;
+    frame.identifier.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical;
+    frame.identifier.N_TA     = 1;
+    frame.identifier.N_SA     = 2;
+    frame.data_length_code    = 2;
+    frame.data[0]             = 0x01; // SF with 1 byte
+    frame.data[1]             = 'a';
+
+    ISOTP.setPushMode(true);
+    EXPECT_TRUE(ISOTP.onFrameReceived(frame));
+    ISOTP.setPushMode(false);
+    EXPECT_TRUE(ISOTP.hasPendingCANEvents());
+    EXPECT_EQ(0, ISOTP.getNextRunTime());
+
+    // The queued frame is processed in polling mode, and then there is nothing left to run.
+    PushModeDisabled_cb_calls = 0;
+    linuxOSInterface.osSleep(1);
+    ISOTP.runStep();
+    EXPECT_EQ(1, PushModeDisabled_cb_calls);
+    EXPECT_FALSE(ISOTP.hasPendingCANEvents());
+    EXPECT_EQ(ISOTP_NoNextRunTime, ISOTP.getNextRunTime());
+
+    delete canInterface;
+}
+
+static uint32_t AcceptanceFilters_cb_calls = 0;
+void            AcceptanceFilters_cb(ISOTP& isotp)
+{
+    AcceptanceFilters_cb_calls++;
+}
+
+TEST(ISOTP, AcceptanceFilters)
+{
+    LocalCANNetwork canNetwork(linuxOSInterface);
+    CANInterface*   canInterface = canNetwork.newCANInterfaceConnection();
+
+    ISOTP ISOTP(1, 2000, Dummy_N_USData_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                linuxOSInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+
+    AcceptanceFilters_cb_calls = 0;
+    ISOTP.setAcceptanceFiltersCallback(AcceptanceFilters_cb);
+    EXPECT_EQ(1, AcceptanceFilters_cb_calls); // Initial filters
+
+    auto filters = ISOTP.getAcceptanceFilters();
+    ASSERT_EQ(1, filters.size());
+    EXPECT_EQ(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, filters[0].id.N_TAtype);
+    EXPECT_EQ(1, filters[0].id.N_TA);
+
+    ISOTP.addAcceptedFunctionalN_TA(1);
+    EXPECT_EQ(2, AcceptanceFilters_cb_calls);
+    ISOTP.addAcceptedFunctionalN_TA(1); // Already accepted, nothing changes.
+    EXPECT_EQ(2, AcceptanceFilters_cb_calls);
+    EXPECT_EQ(1, ISOTP.getAcceptanceFilters().size()); // Physical and functional N_TA 1 share a filter.
+
+    ISOTP.addLocalN_SA(0x80);
+    EXPECT_EQ(3, AcceptanceFilters_cb_calls);
+    EXPECT_EQ(2, ISOTP.getAcceptanceFilters().size());
+    EXPECT_EQ(1, ISOTP.getAcceptanceFilters(1).size());
+
+    EXPECT_TRUE(ISOTP.removeLocalN_SA(0x80));
+    EXPECT_TRUE(ISOTP.removeAcceptedFunctionalN_TA(1));
+    EXPECT_FALSE(ISOTP.removeAcceptedFunctionalN_TA(1));
+    EXPECT_EQ(5, AcceptanceFilters_cb_calls);
+
+    ISOTP.setAcceptanceFiltersCallback(nullptr);
+    ISOTP.addLocalN_SA(0x80);
+    EXPECT_EQ(5, AcceptanceFilters_cb_calls);
+
+    delete canInterface;
+}
+
+static uint32_t SFIndication_cb_calls  = 0;
+static N_Result SFIndication_cb_result = NOT_STARTED;
+void SFIndication_cb(N_AI nAi, const uint8_t* messageData, uint32_t messageLength, N_Result nResult, Mtype mtype)
+{
+    SFIndication_cb_calls++;
+    SFIndication_cb_result = nResult;
+    EXPECT_EQ(Mtype_Diagnostics, mtype);
+    if (nResult == N_OK)
+    {
+        ASSERT_EQ(3, messageLength);
+        EXPECT_EQ_ARRAY("abc", messageData, 3);
+    }
+}
+
+TEST(ISOTP, SFIndication)
+{
+    LocalCANNetwork canNetwork(linuxOSInterface);
+    CANInterface*   canInterface = canNetwork.newCANInterfaceConnection();
+
+    // No memory for runners is needed to receive SFs.
+    ISOTP ISOTP(1, 0, Dummy_N_USData_confirm_cb, SFIndication_cb, Dummy_N_USData_FF_indication_cb, linuxOSInterface,
+                *canInterface, 2, ISOTP_DefaultSTmin);
+    ISOTP.setPushMode(true);
+
+    CANFrame frame            = {};
+    frame.extd                = 1;
+    frame.identifier.N_TAtype = N_TATYPE_5_CAN_CLASSIC_29bit_Physical;
+    frame.identifier.N_TA     = 1;
+    frame.identifier.N_SA     = 2;
+    frame.data_length_code    = 4;
+    frame.data[0]             = 0x03; // SF with 3 bytes
+    frame.data[1]             = 'a';
+    frame.data[2]             = 'b';
+    frame.data[3]             = 'c';
+
+    EXPECT_TRUE(ISOTP.onFrameReceived(frame));
+    ISOTP.runStep();
+    EXPECT_EQ(1, SFIndication_cb_calls);
+    EXPECT_EQ(N_OK, SFIndication_cb_result);
+
+    frame.data_length_code = 3; // The payload does not fit in the frame.
+    EXPECT_TRUE(ISOTP.onFrameReceived(frame));
+    linuxOSInterface.osSleep(1);
+    ISOTP.runStep();
+    EXPECT_EQ(2, SFIndication_cb_calls);
+    EXPECT_EQ(N_ERROR, SFIndication_cb_result);
+
+    delete canInterface;
+}
+
+static uint32_t DirectSF_confirm_cb_calls = 0;
+void            DirectSF_confirm_cb(N_AI nAi, N_Result nResult, Mtype mtype)
+{
+    DirectSF_confirm_cb_calls++;
+    EXPECT_EQ(N_OK, nResult);
+    EXPECT_EQ(2, nAi.N_TA);
+}
+
+TEST(ISOTP, DirectSFRequest)
+{
+    LocalCANNetwork canNetwork(linuxOSInterface);
+    CANInterface*   canInterface  = canNetwork.newCANInterfaceConnection();
+    CANInterface*   peerInterface = canNetwork.newCANInterfaceConnection();
+
+    ISOTP ISOTP(1, 2000, DirectSF_confirm_cb, Dummy_N_USData_indication_cb, Dummy_N_USData_FF_indication_cb,
+                linuxOSInterface, *canInterface, 2, ISOTP_DefaultSTmin);
+
+    constexpr uint8_t message[] = {1, 2, 3};
+    DirectSF_confirm_cb_calls   = 0;
+
+    // The N_AI is idle, so the SF is written before any runStep.
+    EXPECT_TRUE(ISOTP.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+    EXPECT_TRUE(ISOTP.isWaitingForACKs());
+    EXPECT_TRUE(peerInterface->frameAvailable());
+
+    // The N_AI is busy until the first SF is confirmed, so this one takes the usual path.
+    EXPECT_TRUE(ISOTP.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+
+    const uint32_t initialTime = linuxOSInterface.osMillis();
+    while (DirectSF_confirm_cb_calls < 2 && linuxOSInterface.osMillis() - initialTime < 2000)
+    {
+        ISOTP.runStep();
+        ISOTP.canMessageACKQueueRunStep();
+    }
+    EXPECT_EQ(2, DirectSF_confirm_cb_calls);
+
+    // A nullptr message is refused before it can be copied into the SF.
+    EXPECT_FALSE(ISOTP.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, nullptr, sizeof(message)));
+    EXPECT_FALSE(ISOTP.isWaitingForACKs());
+
+    delete canInterface;
+    delete peerInterface;
+}
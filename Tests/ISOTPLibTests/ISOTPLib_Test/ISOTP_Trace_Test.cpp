@@ -0,0 +1,309 @@
+#include "ISOTP_Trace.h"
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ISOTP.h"
+#include "TwoNodeTransfer.h"
+#include "VirtualClockOSInterface.h"
+#include "gtest/gtest.h"
+
+static CANFrame TraceTest_frame(const uint8_t nTa, const uint8_t nSa, const uint8_t dlc)
+{
+    CANFrame frame         = {};
+    frame.extd             = 1;
+    frame.identifier       = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, nTa, nSa);
+    frame.data_length_code = dlc;
+    for (uint8_t i = 0; i < dlc; i++)
+    {
+        frame.data[i] = i + 1;
+    }
+    return frame;
+}
+
+static bool TraceTest_sink(const uint8_t* data, const uint32_t length, void* context)
+{
+    auto* bytes = static_cast<std::vector<uint8_t>*>(context);
+    bytes->insert(bytes->end(), data, data + length);
+    return true;
+}
+
+TEST(ISOTP_Trace, canId)
+{
+    const CANFrame frame = TraceTest_frame(2, 1, 2);
+    EXPECT_EQ(0x18DA0201u, ISOTP_GetCANId(frame.identifier));
+}
+
+TEST(ISOTP_Trace, ring)
+{
+    VirtualClockOSInterface clock;
+    ISOTP_TraceBuffer       buffer(clock, 6);
+    ASSERT_TRUE(buffer.isEnabled());
+    EXPECT_EQ(4, buffer.getCapacity()); // Rounded down to a power of 2.
+
+    ISOTP_TraceRecord record{};
+    EXPECT_FALSE(buffer.pop(record));
+
+    clock.advance(1250);
+    buffer.record(ISOTP_TraceFrameWritten, TraceTest_frame(2, 1, 3));
+    buffer.recordACK(TraceTest_frame(2, 1, 3).identifier, ACK_SUCCESS);
+
+    ASSERT_TRUE(buffer.pop(record));
+    EXPECT_EQ(ISOTP_TraceFrameWritten, record.event);
+    EXPECT_EQ(1250, record.timestamp_ms);
+    EXPECT_EQ(0x18DA0201u, record.canId);
+    EXPECT_EQ(ACK_NONE, record.ack);
+    EXPECT_EQ(3, record.dlc);
+    EXPECT_EQ(3, record.data[2]);
+    ASSERT_TRUE(buffer.pop(record));
+    EXPECT_EQ(ISOTP_TraceACK, record.event);
+    EXPECT_EQ(ACK_SUCCESS, record.ack);
+    EXPECT_EQ(0, record.dlc);
+    EXPECT_FALSE(buffer.pop(record));
+
+    // The records that do not fit are dropped, the ones in the ring are kept.
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        buffer.record(ISOTP_TraceFrameRead, TraceTest_frame(i, 1, 1));
+    }
+    EXPECT_EQ(2, buffer.getDroppedRecords());
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        ASSERT_TRUE(buffer.pop(record));
+        EXPECT_EQ(0x18DA0001u + (i << 8), record.canId);
+    }
+    EXPECT_FALSE(buffer.pop(record));
+
+    // A ring without capacity records nothing.
+    ISOTP_TraceBuffer disabled(clock, 0);
+    EXPECT_FALSE(disabled.isEnabled());
+    disabled.record(ISOTP_TraceFrameRead, TraceTest_frame(2, 1, 1));
+    EXPECT_FALSE(disabled.pop(record));
+}
+
+TEST(ISOTP_Trace, encoding)
+{
+    uint8_t header[ISOTP_TraceHeaderSize];
+    ISOTP_TraceWriter::encodeHeader(header);
+    EXPECT_EQ(0, memcmp(header, "ISOTPTRC", 8));
+    EXPECT_TRUE(ISOTP_TraceWriter::decodeHeader(header));
+    header[8] = ISOTP_TraceVersion + 1;
+    EXPECT_FALSE(ISOTP_TraceWriter::decodeHeader(header));
+
+    ISOTP_TraceRecord record{};
+    record.timestamp_ms = 0x01020304;
+    record.canId        = 0x18DA0201;
+    record.event        = ISOTP_TraceFrameRead;
+    record.ack          = ACK_NONE;
+    record.dlc          = 2;
+    record.data[0]      = 0x02;
+    record.data[1]      = 0x10;
+
+    uint8_t encoded[ISOTP_TraceRecordSize];
+    ISOTP_TraceWriter::encode(record, encoded);
+    EXPECT_EQ(0x04, encoded[0]); // Little endian.
+    EXPECT_EQ(0x18, encoded[7]);
+
+    ISOTP_TraceRecord decoded{};
+    ASSERT_TRUE(ISOTP_TraceWriter::decode(encoded, decoded));
+    EXPECT_EQ(record.timestamp_ms, decoded.timestamp_ms);
+    EXPECT_EQ(record.canId, decoded.canId);
+    EXPECT_EQ(record.event, decoded.event);
+    EXPECT_EQ(record.dlc, decoded.dlc);
+    EXPECT_EQ(0, memcmp(record.data, decoded.data, CAN_FRAME_MAX_DLC));
+
+    encoded[10] = CAN_FRAME_MAX_DLC + 1;
+    EXPECT_FALSE(ISOTP_TraceWriter::decode(encoded, decoded));
+
+    record.timestamp_ms = 1250;
+    char line[80];
+    EXPECT_EQ(strlen("(0000000001.250000) can0 18DA0201#0210\n"),
+              ISOTP_TraceWriter::toCandump(record, "can0", line, sizeof(line)));
+    EXPECT_STREQ("(0000000001.250000) can0 18DA0201#0210\n", line);
+
+    record.event = ISOTP_TraceACK;
+    EXPECT_EQ(0, ISOTP_TraceWriter::toCandump(record, "can0", line, sizeof(line)));
+    EXPECT_STREQ("", line);
+}
+
+TEST(ISOTP_Trace, candumpParsing)
+{
+    ISOTP_TraceRecord record{};
+    ASSERT_TRUE(ISOTP_TraceWriter::fromCandump("(0000000001.250000) can0 18DA0201#0210\n", record));
+    EXPECT_EQ(ISOTP_TraceFrameRead, record.event);
+    EXPECT_EQ(1250, record.timestamp_ms);
+    EXPECT_EQ(0x18DA0201u, record.canId);
+    EXPECT_EQ(2, record.dlc);
+    EXPECT_EQ(0x10, record.data[1]);
+
+    const N_AI nAi = ISOTP_GetN_AI(record.canId);
+    EXPECT_EQ(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, nAi.N_TAtype);
+    EXPECT_EQ(2, nAi.N_TA);
+    EXPECT_EQ(1, nAi.N_SA);
+    EXPECT_EQ(0x18DA0201u, ISOTP_GetCANId(nAi));
+
+    // The text after the data is ignored, and a frame without data is valid.
+    ASSERT_TRUE(ISOTP_TraceWriter::fromCandump("(1700000000.000999) vcan0 18DB33F1#0102030405060708 R", record));
+    EXPECT_EQ(8, record.dlc);
+    EXPECT_EQ(0x18DB33F1u, record.canId);
+    EXPECT_TRUE(ISOTP_TraceWriter::fromCandump("(0.000000) can0 18DA0201#", record));
+    EXPECT_EQ(0, record.dlc);
+
+    EXPECT_FALSE(ISOTP_TraceWriter::fromCandump("(0.000000) can0 123#11", record));               // Standard.
+    EXPECT_FALSE(ISOTP_TraceWriter::fromCandump("(0.000000) can0 18DA0201##10011", record));      // CAN FD.
+    EXPECT_FALSE(ISOTP_TraceWriter::fromCandump("(0.000000) can0 18DA0201#R", record));           // Remote.
+    EXPECT_FALSE(ISOTP_TraceWriter::fromCandump("(0.000000) can0 18DA0201#021", record));         // Half a byte.
+    EXPECT_FALSE(ISOTP_TraceWriter::fromCandump("(0.000000) can0 18DA0201#010203040506070809", record));
+    EXPECT_FALSE(ISOTP_TraceWriter::fromCandump("(0.000000) can0 FFFFFFFF#01", record)); // Not 29 bits.
+    EXPECT_FALSE(ISOTP_TraceWriter::fromCandump("# comment", record));
+}
+
+TEST(ISOTP_Trace, writer)
+{
+    VirtualClockOSInterface clock;
+    ISOTP_TraceBuffer       buffer(clock, 4);
+    std::vector<uint8_t>    binary;
+    std::vector<uint8_t>    text;
+    ISOTP_TraceWriter       writer(buffer, TraceTest_sink, &binary, TraceTest_sink, &text, "vcan0");
+
+    // The header is written even without records.
+    EXPECT_EQ(0, writer.drain());
+    ASSERT_EQ(ISOTP_TraceHeaderSize, binary.size());
+    EXPECT_TRUE(ISOTP_TraceWriter::decodeHeader(binary.data()));
+
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        buffer.record(ISOTP_TraceFrameRead, TraceTest_frame(2, 1, 1));
+    }
+    buffer.recordACK(TraceTest_frame(2, 1, 1).identifier, ACK_ERROR); // Dropped too.
+
+    EXPECT_EQ(2, writer.drain(2));
+    EXPECT_EQ(2, writer.drain());
+    EXPECT_EQ(0, writer.getLostRecords());
+
+    // The drop is reported before the records, then the 4 records that were kept follow.
+    ASSERT_EQ(ISOTP_TraceHeaderSize + 5 * ISOTP_TraceRecordSize, binary.size());
+    ISOTP_TraceRecord record{};
+    ASSERT_TRUE(ISOTP_TraceWriter::decode(&binary[ISOTP_TraceHeaderSize], record));
+    EXPECT_EQ(ISOTP_TraceRecordsDropped, record.event);
+    EXPECT_EQ(2, record.canId);
+    ASSERT_TRUE(ISOTP_TraceWriter::decode(&binary[ISOTP_TraceHeaderSize + 4 * ISOTP_TraceRecordSize], record));
+    EXPECT_EQ(ISOTP_TraceFrameRead, record.event);
+
+    const std::string line = "(0000000000.000000) vcan0 18DA0201#01\n";
+    EXPECT_EQ(line + line + line + line, std::string(text.begin(), text.end()));
+
+    // The records refused by a sink are counted.
+    ISOTP_TraceWriter refusing(buffer, [](const uint8_t*, uint32_t, void*) { return false; }, nullptr);
+    EXPECT_EQ(0, refusing.drain()); // The header could not be written.
+    ISOTP_TraceBuffer other(clock, 4);
+    ISOTP_TraceWriter textOnly(other, nullptr, nullptr, [](const uint8_t*, uint32_t, void*) { return false; });
+    other.record(ISOTP_TraceFrameWritten, TraceTest_frame(2, 1, 1));
+    EXPECT_EQ(1, textOnly.drain());
+    EXPECT_EQ(1, textOnly.getLostRecords());
+}
+
+TEST(ISOTP_Trace, producers)
+{
+    constexpr uint32_t producers = 4;
+    constexpr uint32_t records   = 10000;
+
+    VirtualClockOSInterface clock;
+    ISOTP_TraceBuffer       buffer(clock, 256);
+    std::atomic<uint32_t>   running{producers};
+
+    std::vector<std::thread> threads;
+    for (uint32_t producer = 0; producer < producers; producer++)
+    {
+        threads.emplace_back(
+            [&, producer]
+            {
+                for (uint32_t i = 0; i < records; i++)
+                {
+                    buffer.record(ISOTP_TraceFrameWritten, TraceTest_frame(producer, 1, 8));
+                }
+                running--;
+            });
+    }
+
+    // Each record is either popped once or dropped.
+    uint32_t          popped[producers] = {};
+    ISOTP_TraceRecord record{};
+    bool              finished = false;
+    while (!finished)
+    {
+        finished = running == 0; // Checked before popping, so the last records are popped after it.
+        while (buffer.pop(record))
+        {
+            const uint32_t producer = record.canId >> 8 & 0xFF;
+            EXPECT_EQ(8, record.dlc);
+            EXPECT_EQ(8, record.data[7]);
+            popped[producer % producers]++;
+        }
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    uint32_t total = 0;
+    for (const uint32_t count : popped)
+    {
+        total += count;
+    }
+    EXPECT_EQ(producers * records, total + buffer.getDroppedRecords());
+}
+
+TEST(ISOTP_Trace, transfer)
+{
+    VirtualClockOSInterface clock;
+    TwoNodeTransfer         transfer(clock, {.receiverMemory = 1000});
+    ISOTP&                  sender   = transfer.getSender();
+    ISOTP&                  receiver = transfer.getReceiver();
+
+    ISOTP_TraceBuffer senderTrace(clock);
+    ISOTP_TraceBuffer receiverTrace(clock);
+    sender.setTraceBuffer(&senderTrace);
+    receiver.setTraceBuffer(&receiverTrace);
+
+    constexpr uint8_t message[100] = {};
+    ASSERT_TRUE(transfer.send(message, sizeof(message)));
+    ASSERT_TRUE(transfer.runUntilDone(1, 1));
+
+    // The FF and the 14 CFs are written and ACKed by the sender, which reads the FC.
+    uint32_t          events[ISOTP_TraceEventCount] = {};
+    ISOTP_TraceRecord record{};
+    ISOTP_TraceRecord first{};
+    while (senderTrace.pop(record))
+    {
+        first = events[ISOTP_TraceFrameWritten] == 0 ? record : first;
+        events[record.event]++;
+    }
+    EXPECT_EQ(15, events[ISOTP_TraceFrameWritten]);
+    EXPECT_EQ(15, events[ISOTP_TraceACK]);
+    EXPECT_EQ(1, events[ISOTP_TraceFrameRead]);
+    EXPECT_EQ(0, events[ISOTP_TraceWriteFailed]);
+    EXPECT_EQ(ISOTP_TraceFrameWritten, first.event);
+    EXPECT_EQ(0x18DA0201u, first.canId);
+    EXPECT_EQ(0x10, first.data[0]); // FF.
+    EXPECT_EQ(100, first.data[1]);
+
+    std::fill_n(events, ISOTP_TraceEventCount, 0);
+    while (receiverTrace.pop(record))
+    {
+        events[record.event]++;
+    }
+    EXPECT_EQ(15, events[ISOTP_TraceFrameRead]);
+    EXPECT_EQ(1, events[ISOTP_TraceFrameWritten]);
+    EXPECT_EQ(1, events[ISOTP_TraceACK]);
+
+    // Nothing is recorded once the trace is removed.
+    sender.setTraceBuffer(nullptr);
+    receiver.setTraceBuffer(nullptr);
+    ASSERT_TRUE(transfer.send(message, 3));
+    ASSERT_TRUE(transfer.runUntilDone(2, 2));
+    EXPECT_FALSE(senderTrace.pop(record));
+    EXPECT_FALSE(receiverTrace.pop(record));
+}
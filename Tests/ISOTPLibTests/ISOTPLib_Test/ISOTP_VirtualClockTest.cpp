@@ -0,0 +1,111 @@
+#include "VirtualClockOSInterface.h"
+
+#include <chrono>
+#include "ISOTP.h"
+#include "LocalCANNetwork.h"
+#include "TwoNodeTransfer.h"
+#include "gtest/gtest.h"
+
+TEST(VirtualClockOSInterface, clock)
+{
+    VirtualClockOSInterface clock(100);
+
+    EXPECT_EQ(100, clock.osMillis());
+    clock.advance(50);
+    EXPECT_EQ(150, clock.osMillis());
+    clock.osSleep(10); // Sleeping only moves the clock.
+    EXPECT_EQ(160, clock.osMillis());
+    clock.advanceTo(120); // Never backwards.
+    EXPECT_EQ(160, clock.osMillis());
+    clock.advanceTo(1000);
+    EXPECT_EQ(1000, clock.osMillis());
+
+    OSInterface_Mutex* mutex = clock.osCreateMutex();
+    ASSERT_NE(nullptr, mutex);
+    EXPECT_TRUE(mutex->wait(0));
+    EXPECT_FALSE(mutex->wait(0));
+    EXPECT_TRUE(mutex->signal());
+    delete mutex;
+}
+
+// VirtualClockTransfer
+constexpr uint32_t VirtualClockTransfer_messageLength = 4095;
+
+static uint32_t VirtualClockTransfer_confirms = 0;
+static N_Result VirtualClockTransfer_result   = NOT_STARTED;
+
+void VirtualClockTransfer_N_USData_confirm_cb(N_AI, const N_Result nResult, Mtype)
+{
+    VirtualClockTransfer_confirms++;
+    VirtualClockTransfer_result = nResult;
+}
+
+// Sends one message with STmin 5 ms and returns the virtual time it took.
+static uint32_t VirtualClockTransfer_run(uint64_t& steps)
+{
+    VirtualClockOSInterface clock;
+    TwoNodeTransfer         transfer(clock, {.senderMemory      = 8192,
+                                             .receiverMemory    = 8192,
+                                             .receiverBlockSize = 8,
+                                             .receiverSTmin     = {5, ms}});
+    EXPECT_FALSE(transfer.getDriver().addInstance(transfer.getSender()));
+
+    uint8_t message[VirtualClockTransfer_messageLength];
+    for (uint32_t i = 0; i < VirtualClockTransfer_messageLength; i++)
+    {
+        message[i] = static_cast<uint8_t>(i);
+    }
+    EXPECT_TRUE(transfer.send(message, sizeof(message)));
+
+    EXPECT_TRUE(transfer.runUntilDone(1, 1, 60000));
+    EXPECT_EQ(N_OK, transfer.getConfirmResult());
+    EXPECT_EQ(N_OK, transfer.getIndicationResult());
+    EXPECT_EQ(std::vector<uint8_t>(message, message + sizeof(message)), transfer.getReceivedMessage());
+    steps = transfer.getDriver().getStepCount();
+    return clock.osMillis();
+}
+
+TEST(VirtualClockOSInterface, longTransferIsDeterministic)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    uint64_t       firstSteps;
+    uint64_t       secondSteps;
+    const uint32_t first  = VirtualClockTransfer_run(firstSteps);
+    const uint32_t second = VirtualClockTransfer_run(secondSteps);
+
+    // 585 CFs separated by at least 5 ms take seconds of virtual time, but much less in real time.
+    EXPECT_GE(first, 585 * 5);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(firstSteps, secondSteps);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(first));
+}
+TEST(VirtualClockOSInterface, timeoutWithoutReceiver)
+{
+    VirtualClockTransfer_confirms = 0;
+
+    VirtualClockOSInterface clock;
+    LocalCANNetwork         network(clock);
+    CANInterface*           senderInterface = network.newCANInterfaceConnection();
+    ISOTP sender(1, 8192, VirtualClockTransfer_N_USData_confirm_cb, nullptr, nullptr, clock, *senderInterface);
+
+    VirtualClockDriver driver(clock);
+    ASSERT_TRUE(driver.addInstance(sender));
+
+    constexpr uint8_t message[20] = {};
+    ASSERT_TRUE(sender.N_USData_request(2, N_TATYPE_5_CAN_CLASSIC_29bit_Physical, message, sizeof(message)));
+
+    // Nobody answers the FF, so the request fails when N_Bs expires. The driver jumps to it in a few steps.
+    ASSERT_TRUE(driver.runUntil([] { return VirtualClockTransfer_confirms == 1; }, 10000));
+    EXPECT_EQ(N_TIMEOUT_Bs, VirtualClockTransfer_result);
+    EXPECT_GE(clock.osMillis(), static_cast<uint32_t>(N_USData_Runner::N_Bs_TIMEOUT_MS));
+    EXPECT_LT(clock.osMillis(), static_cast<uint32_t>(N_USData_Runner::N_Bs_TIMEOUT_MS + 10));
+    EXPECT_LT(driver.getStepCount(), 100);
+
+    // Once idle, the clock jumps to the end of the period.
+    driver.runFor(3600 * 1000);
+    EXPECT_LT(driver.getStepCount(), 110);
+
+    delete senderInterface;
+}
+// END VirtualClockTransfer
@@ -0,0 +1,45 @@
+#include "LockFreeInbox.h"
+
+#include "gtest/gtest.h"
+
+TEST(LockFreeInbox, pushPop)
+{
+    LockFreeInbox<uint32_t, 4> inbox;
+    uint32_t                   value = 0;
+
+    EXPECT_TRUE(inbox.empty());
+    EXPECT_FALSE(inbox.pop(value));
+
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        EXPECT_TRUE(inbox.push(i));
+    }
+    EXPECT_FALSE(inbox.push(4)); // Full
+    EXPECT_FALSE(inbox.empty());
+
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        EXPECT_TRUE(inbox.pop(value));
+        EXPECT_EQ(i, value);
+    }
+    EXPECT_TRUE(inbox.empty());
+    EXPECT_FALSE(inbox.pop(value));
+}
+
+TEST(LockFreeInbox, wrapAround)
+{
+    LockFreeInbox<uint32_t, 2> inbox;
+    uint32_t                   value = 0;
+
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        EXPECT_TRUE(inbox.push(i));
+        EXPECT_TRUE(inbox.push(i + 1000));
+        EXPECT_FALSE(inbox.push(i + 2000));
+        EXPECT_TRUE(inbox.pop(value));
+        EXPECT_EQ(i, value);
+        EXPECT_TRUE(inbox.pop(value));
+        EXPECT_EQ(i + 1000, value);
+    }
+    EXPECT_TRUE(inbox.empty());
+}
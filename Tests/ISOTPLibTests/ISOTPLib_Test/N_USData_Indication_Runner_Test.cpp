@@ -57,7 +57,7 @@ TEST(N_USData_Indication_Runner, constructor_destructor_argument_availableMemory
                                           canMessageACKQueue);
         int64_t                    actualMemory;
         ASSERT_TRUE(availableMemoryMock.get(&actualMemory));
-        ASSERT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, actualMemory + N_USDATA_INDICATION_RUNNER_TAG_SIZE);
+        ASSERT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, actualMemory); // Tags are not charged to the runners memory.
         ASSERT_TRUE(result);
     }
     int64_t actualMemory;
@@ -85,7 +85,7 @@ TEST(N_USData_Indication_Runner, constructor_destructor_argument_notAvailableMem
         int64_t                    actualMemory;
         ASSERT_TRUE(availableMemoryMock.get(&actualMemory));
         ASSERT_EQ(availableMemoryConst, actualMemory);
-        ASSERT_FALSE(result);
+        ASSERT_TRUE(result); // The runner only needs memory for the message, which is allocated when the FF arrives.
     }
 
     int64_t actualMemory;
@@ -459,6 +459,57 @@ TEST(N_USData_Indication_Runner, runStep_FF_invalid_no_memory)
     delete canInterface;
 }
 
+TEST(N_USData_Indication_Runner, runStep_FF_invalid_peer_quota)
+{
+    LocalCANNetwork can_network(linuxOSInterface);
+
+    Atomic_int64_t availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+
+    CANInterface*      canInterface  = can_network.newCANInterfaceConnection();
+    CANInterface*      peerInterface = can_network.newCANInterfaceConnection();
+    CANMessageACKQueue canMessageACKQueue(*canInterface, linuxOSInterface);
+
+    N_AI NAi = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2);
+
+    ISOTP_PeerQuotas peerQuotas;
+    ASSERT_TRUE(peerQuotas.setQuota(NAi.N_SA, {10, 0, ISOTP_DefaultPeerQuota.maxReceptions}));
+
+    bool result;
+    {
+        N_USData_Indication_Runner runner(result, NAi, availableMemoryMock, 0, ISOTP_DefaultSTmin, linuxOSInterface,
+                                          canMessageACKQueue, N_USData_Runner::ThreadSafeRunner, &peerQuotas);
+
+        CANFrame sentFrame   = NewCANFrameISOTP();
+        sentFrame.identifier = NAi;
+        sentFrame.data[0]    = (N_USData_Runner::FF_CODE << 4);
+        sentFrame.data[1]    = 20; // The message fits in the memory for runners but not in the quota of the N_SA.
+
+        ASSERT_EQ(N_ERROR, runner.runStep(&sentFrame));
+
+        CANFrame receivedFrame;
+        ASSERT_TRUE(peerInterface->readFrame(&receivedFrame));
+        EXPECT_EQ(N_USData_Runner::FC_CODE << 4 | N_USData_Runner::OVERFLOW, receivedFrame.data[0]);
+        EXPECT_EQ(0, peerQuotas.getUsedMemory(NAi.N_SA));
+    }
+
+    {
+        N_USData_Indication_Runner runner(result, NAi, availableMemoryMock, 0, ISOTP_DefaultSTmin, linuxOSInterface,
+                                          canMessageACKQueue, N_USData_Runner::ThreadSafeRunner, &peerQuotas);
+
+        CANFrame sentFrame   = NewCANFrameISOTP();
+        sentFrame.identifier = NAi;
+        sentFrame.data[0]    = (N_USData_Runner::FF_CODE << 4);
+        sentFrame.data[1]    = 10;
+
+        ASSERT_EQ(IN_PROGRESS_FF, runner.runStep(&sentFrame));
+        EXPECT_EQ(10, peerQuotas.getUsedMemory(NAi.N_SA));
+    }
+    EXPECT_EQ(0, peerQuotas.getUsedMemory(NAi.N_SA)); // Given back by the destructor.
+
+    delete canInterface;
+    delete peerInterface;
+}
+
 TEST(N_USData_Indication_Runner, runStep_FF_nullptr)
 {
     LocalCANNetwork can_network(linuxOSInterface);
@@ -741,6 +792,95 @@ TEST(N_USData_Indication_Runner, runStep_CF_blockSize0_valid)
     delete receiverCanInterface;
 }
 
+TEST(N_USData_Indication_Runner, runStep_CF_chunked_valid)
+{
+    LocalCANNetwork can_network(linuxOSInterface);
+
+    Atomic_int64_t  availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+    ISOTP_ChunkPool chunkPool(linuxOSInterface, 8);
+
+    CANInterface*      canInterface = can_network.newCANInterfaceConnection();
+    CANMessageACKQueue canMessageACKQueue(*canInterface, linuxOSInterface);
+
+    N_AI NAi = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2);
+
+    uint8_t blockSize = 0;
+    STmin   stMin     = {10, ms};
+
+    const char*    testMessageString = "012345678901234567890123456789"; // strlen = 30
+    size_t         messageLen        = strlen(testMessageString);
+    const uint8_t* testMessage       = reinterpret_cast<const uint8_t*>(testMessageString);
+    bool           result;
+
+    {
+        N_USData_Indication_Runner runner(result, NAi, availableMemoryMock, blockSize, stMin, linuxOSInterface,
+                                          canMessageACKQueue, N_USData_Runner::ThreadSafeRunner, nullptr, nullptr,
+                                          &chunkPool);
+
+        CANFrame sentFrame   = NewCANFrameISOTP();
+        sentFrame.identifier = NAi;
+        sentFrame.data[0]    = (N_USData_Runner::FF_CODE << 4) | messageLen >> 8;
+        sentFrame.data[1]    = messageLen & 0xFF;
+        memcpy(&sentFrame.data[2], testMessage, 6);
+
+        CANInterface* receiverCanInterface = can_network.newCANInterfaceConnection();
+
+        ASSERT_EQ(IN_PROGRESS_FF, runner.runStep(&sentFrame));
+        ASSERT_EQ(IN_PROGRESS, runner.runStep(nullptr));
+
+        // 4 chunks of 8 bytes and their segments are charged, but only the first chunk is taken for the FF.
+        int64_t availableMemory;
+        ASSERT_TRUE(availableMemoryMock.get(&availableMemory));
+        EXPECT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST - 4 * (8 + sizeof(ISOTP_MessageSegment)), availableMemory);
+        EXPECT_EQ(nullptr, runner.getMessageData());
+        EXPECT_EQ(1, runner.getMessageView().segmentCount);
+        EXPECT_EQ(6, runner.getMessageView().length);
+
+        CANFrame receivedFrame;
+        ASSERT_TRUE(receiverCanInterface->readFrame(&receivedFrame));
+        canMessageACKQueue.runStep(); // Get ACK
+        canMessageACKQueue.runAvailableAckCallbacks();
+
+        CANFrame cfFrame         = NewCANFrameISOTP();
+        cfFrame.identifier       = NAi;
+        cfFrame.data_length_code = 8;
+        for (uint8_t sequenceNumber = 1; sequenceNumber <= 3; sequenceNumber++)
+        {
+            cfFrame.data[0] = (N_USData_Runner::CF_CODE << 4) | sequenceNumber;
+            memcpy(&cfFrame.data[1], &testMessage[6 + (sequenceNumber - 1) * 7], 7);
+            ASSERT_EQ(IN_PROGRESS, runner.runStep(&cfFrame));
+        }
+
+        cfFrame.data_length_code = 4;
+        cfFrame.data[0]          = (N_USData_Runner::CF_CODE << 4) | 4; // sequence number
+        memcpy(&cfFrame.data[1], &testMessage[27], 3);
+
+        ASSERT_EQ(N_OK, runner.runStep(&cfFrame));
+
+        const ISOTP_MessageView message = runner.getMessageView();
+        ASSERT_EQ(4, message.segmentCount);
+        ASSERT_EQ(messageLen, message.length);
+        EXPECT_EQ(8, message.segments[0].length);
+        EXPECT_EQ(6, message.segments[3].length);
+        EXPECT_EQ_ARRAY(&testMessage[24], message.segments[3].data, 6);
+
+        uint8_t copy[30];
+        EXPECT_FALSE(message.copyTo(copy, 29));
+        ASSERT_TRUE(message.copyTo(copy, sizeof(copy)));
+        EXPECT_EQ_ARRAY(testMessage, copy, messageLen);
+
+        delete receiverCanInterface;
+    }
+
+    // The chunks are kept for the next message.
+    EXPECT_EQ(4, chunkPool.getFreeChunkCount());
+    int64_t availableMemory;
+    ASSERT_TRUE(availableMemoryMock.get(&availableMemory));
+    EXPECT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, availableMemory);
+
+    delete canInterface;
+}
+
 TEST(N_USData_Indication_Runner, timeout_N_Br_FF_Performance)
 {
     LocalCANNetwork can_network(linuxOSInterface);
@@ -55,7 +55,7 @@ TEST(N_USData_Request_Runner, constructor_destructor_argument_availableMemoryTes
 
         int64_t actualMemory;
         ASSERT_TRUE(availableMemoryMock.get(&actualMemory));
-        ASSERT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, actualMemory + messageLen + N_USDATA_REQUEST_RUNNER_TAG_SIZE);
+        ASSERT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, actualMemory + messageLen);
         ASSERT_TRUE(result);
     }
     int64_t actualMemory;
@@ -95,6 +95,41 @@ TEST(N_USData_Request_Runner, constructor_destructor_argument_notAvailableMemory
     delete canInterface;
 }
 
+TEST(N_USData_Request_Runner, constructor_destructor_slabAllocator)
+{
+    LocalCANNetwork     can_network(linuxOSInterface);
+    Atomic_int64_t      availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+    CANInterface*       canInterface = can_network.newCANInterfaceConnection();
+    CANMessageACKQueue  canMessageACKQueue(*canInterface, linuxOSInterface);
+    ISOTP_SlabAllocator slabAllocator(linuxOSInterface, DEFAULT_AVAILABLE_MEMORY_CONST);
+    N_AI                NAi               = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2);
+    const char*         testMessageString = "Message with 24 bytes..";
+    size_t              messageLen        = strlen(testMessageString);
+    const uint8_t*      testMessage       = reinterpret_cast<const uint8_t*>(testMessageString);
+
+    {
+        bool                    result;
+        N_USData_Request_Runner runner(result, NAi, availableMemoryMock, Mtype_Diagnostics, testMessage, messageLen,
+                                       linuxOSInterface, canMessageACKQueue, N_USData_Runner::ThreadSafeRunner,
+                                       &slabAllocator);
+        ASSERT_TRUE(result);
+        ASSERT_EQ_ARRAY(testMessage, runner.getMessageData(), messageLen);
+
+        // The memory for runners is charged with the whole block taken from the slab.
+        int64_t actualMemory;
+        ASSERT_TRUE(availableMemoryMock.get(&actualMemory));
+        EXPECT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST - 32, actualMemory);
+        EXPECT_EQ(32, slabAllocator.getUsedMemory());
+    }
+
+    int64_t actualMemory;
+    ASSERT_TRUE(availableMemoryMock.get(&actualMemory));
+    EXPECT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, actualMemory);
+    EXPECT_EQ(0, slabAllocator.getUsedMemory());
+
+    delete canInterface;
+}
+
 TEST(N_USData_Request_Runner, runStep_SF_valid)
 {
     LocalCANNetwork    can_network(linuxOSInterface);
@@ -133,6 +168,38 @@ TEST(N_USData_Request_Runner, runStep_SF_valid)
     delete canInterfaceRunner;
 }
 
+TEST(N_USData_Request_Runner, runStep_SF_valid_singleThreaded)
+{
+    LocalCANNetwork    can_network(linuxOSInterface);
+    Atomic_int64_t     availableMemoryMock(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+    CANInterface*      canInterfaceRunner = can_network.newCANInterfaceConnection();
+    CANMessageACKQueue canMessageACKQueue(*canInterfaceRunner, linuxOSInterface);
+    N_AI               NAi               = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2);
+    const char*        testMessageString = "1234567"; // strlen = 7
+    size_t             messageLen        = strlen(testMessageString);
+    const uint8_t*     testMessage       = reinterpret_cast<const uint8_t*>(testMessageString);
+    bool               result;
+    CANInterface*      canInterface = can_network.newCANInterfaceConnection();
+
+    N_USData_Request_Runner runner(result, NAi, availableMemoryMock, Mtype_Diagnostics, testMessage, messageLen,
+                                   linuxOSInterface, canMessageACKQueue, N_USData_Runner::SingleThreadedRunner);
+    ASSERT_TRUE(result);
+
+    ASSERT_EQ(IN_PROGRESS, runner.runStep(nullptr));
+
+    CANFrame receivedFrame;
+    ASSERT_TRUE(canInterface->readFrame(&receivedFrame));
+
+    canMessageACKQueue.runStep(); // Get ACK
+    canMessageACKQueue.runAvailableAckCallbacks();
+    ASSERT_EQ(N_OK, runner.runStep(nullptr));
+    ASSERT_EQ(N_OK, runner.getResult());
+    ASSERT_EQ(0, memcmp(testMessage, &receivedFrame.data[1], messageLen));
+
+    delete canInterface;
+    delete canInterfaceRunner;
+}
+
 TEST(N_USData_Request_Runner, runStep_SF_valid_empty)
 {
     LocalCANNetwork    can_network(linuxOSInterface);
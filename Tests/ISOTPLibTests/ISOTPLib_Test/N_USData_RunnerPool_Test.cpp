@@ -0,0 +1,95 @@
+#include "N_USData_RunnerPool.h"
+
+#include <cstring>
+#include "ASSERT_MACROS.h"
+#include "ISOTP.h"
+#include "LinuxOSInterface.h"
+#include "LocalCANNetwork.h"
+#include "gtest/gtest.h"
+
+static LinuxOSInterface linuxOSInterface;
+
+constexpr int64_t DEFAULT_AVAILABLE_MEMORY_CONST = 200;
+
+TEST(N_USData_RunnerPool, createAndDispatch)
+{
+    LocalCANNetwork    can_network(linuxOSInterface);
+    Atomic_int64_t     availableMemory(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+    CANInterface*      canInterface = can_network.newCANInterfaceConnection();
+    CANMessageACKQueue canMessageACKQueue(*canInterface, linuxOSInterface);
+    N_AI               requestNAi    = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2);
+    N_AI               indicationNAi = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 2, 1);
+    const char*        message       = "Message";
+
+    N_USData_RunnerPool pool(linuxOSInterface);
+    bool                result;
+
+    N_USData_RunnerSlot* request = pool.create<N_USData_Request_Runner>(
+        result, requestNAi, availableMemory, Mtype_Diagnostics, reinterpret_cast<const uint8_t*>(message),
+        strlen(message), linuxOSInterface, canMessageACKQueue, N_USData_Runner::SingleThreadedRunner);
+    ASSERT_TRUE(result);
+    ASSERT_NE(nullptr, request);
+    EXPECT_EQ(N_USData_Runner::RunnerRequestType, request->getRunnerType());
+    EXPECT_EQ_N_AI(requestNAi, request->getN_AI());
+    EXPECT_EQ(strlen(message), request->getMessageLength());
+    EXPECT_EQ(nullptr, request->getIndicationRunner());
+
+    N_USData_RunnerSlot* indication = pool.create<N_USData_Indication_Runner>(
+        result, indicationNAi, availableMemory, 0, ISOTP_DefaultSTmin, linuxOSInterface, canMessageACKQueue);
+    ASSERT_TRUE(result);
+    ASSERT_NE(nullptr, indication);
+    EXPECT_EQ(N_USData_Runner::RunnerIndicationType, indication->getRunnerType());
+    EXPECT_EQ_N_AI(indicationNAi, indication->getN_AI());
+    EXPECT_NE(nullptr, indication->getIndicationRunner());
+    EXPECT_EQ(2, pool.getSlotCount());
+
+    // Releasing a runner destroys it, so its memory is given back.
+    pool.release(request);
+    EXPECT_TRUE(request->empty());
+    int64_t memory;
+    ASSERT_TRUE(availableMemory.get(&memory));
+    EXPECT_EQ(DEFAULT_AVAILABLE_MEMORY_CONST, memory);
+
+    delete canInterface;
+}
+
+TEST(N_USData_RunnerPool, slotReuse)
+{
+    LocalCANNetwork    can_network(linuxOSInterface);
+    Atomic_int64_t     availableMemory(DEFAULT_AVAILABLE_MEMORY_CONST, linuxOSInterface);
+    CANInterface*      canInterface = can_network.newCANInterfaceConnection();
+    CANMessageACKQueue canMessageACKQueue(*canInterface, linuxOSInterface);
+    N_AI               nAi     = ISOTP_N_AI_CONFIG(N_TATYPE_5_CAN_CLASSIC_29bit_Physical, 1, 2);
+    const char*        message = "Message";
+
+    N_USData_RunnerPool pool(linuxOSInterface);
+    bool                result;
+
+    N_USData_RunnerSlot* first = pool.create<N_USData_Request_Runner>(
+        result, nAi, availableMemory, Mtype_Diagnostics, reinterpret_cast<const uint8_t*>(message), strlen(message),
+        linuxOSInterface, canMessageACKQueue);
+    ASSERT_NE(nullptr, first);
+    pool.release(first);
+
+    N_USData_RunnerSlot* second = pool.create<N_USData_Request_Runner>(
+        result, nAi, availableMemory, Mtype_Diagnostics, reinterpret_cast<const uint8_t*>(message), strlen(message),
+        linuxOSInterface, canMessageACKQueue);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(1, pool.getSlotCount());
+
+    // A runner that fails to be created does not keep its slot.
+    Atomic_int64_t       noMemory(0, linuxOSInterface);
+    N_USData_RunnerSlot* failed = pool.create<N_USData_Request_Runner>(
+        result, nAi, noMemory, Mtype_Diagnostics, reinterpret_cast<const uint8_t*>(message), strlen(message),
+        linuxOSInterface, canMessageACKQueue);
+    EXPECT_FALSE(result);
+    EXPECT_EQ(nullptr, failed);
+
+    N_USData_RunnerSlot* third = pool.create<N_USData_Request_Runner>(
+        result, nAi, availableMemory, Mtype_Diagnostics, reinterpret_cast<const uint8_t*>(message), strlen(message),
+        linuxOSInterface, canMessageACKQueue);
+    ASSERT_NE(nullptr, third);
+    EXPECT_EQ(2, pool.getSlotCount());
+
+    delete canInterface;
+}
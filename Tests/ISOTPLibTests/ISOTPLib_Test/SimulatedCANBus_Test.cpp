@@ -0,0 +1,164 @@
+#include "SimulatedCANBus.h"
+
+#include <memory>
+
+#include "ISOTP.h"
+#include "ISOTP_Trace.h"
+#include "TwoNodeTransfer.h"
+#include "VirtualClockOSInterface.h"
+#include "gtest/gtest.h"
+
+static CANFrame SimulatedCANBus_frame(const uint32_t canId, const uint8_t length, const bool extended = true)
+{
+    CANFrame frame         = {};
+    frame.extd             = extended;
+    frame.identifier       = ISOTP_GetN_AI(canId);
+    frame.data_length_code = length;
+    for (uint8_t i = 0; i < length; i++)
+    {
+        frame.data[i] = 0x55;
+    }
+    return frame;
+}
+
+TEST(SimulatedCANBus, frameBits)
+{
+    // 19 dominant bits and a CRC of 0 get a stuff bit every 5 bits.
+    uint32_t stuffBits = 0;
+    EXPECT_EQ(53, SimulatedCANBus::getFrameBits(SimulatedCANBus_frame(0, 0, false), stuffBits));
+    EXPECT_EQ(6, stuffBits);
+
+    EXPECT_EQ(111, SimulatedCANBus::getFrameBits(SimulatedCANBus_frame(0x2AA, 8, false), stuffBits) - stuffBits);
+    EXPECT_EQ(131, SimulatedCANBus::getFrameBits(SimulatedCANBus_frame(0x18DA0201, 8), stuffBits) - stuffBits);
+
+    // A payload with long runs of equal bits needs more stuff bits than alternating ones.
+    uint32_t alternatingStuffBits = 0;
+    SimulatedCANBus::getFrameBits(SimulatedCANBus_frame(0x18DA0201, 8), alternatingStuffBits);
+    CANFrame zeros = SimulatedCANBus_frame(0x18DA0201, 8);
+    memset(zeros.data, 0, sizeof(zeros.data));
+    SimulatedCANBus::getFrameBits(zeros, stuffBits);
+    EXPECT_GT(stuffBits, alternatingStuffBits + 8);
+}
+
+TEST(SimulatedCANBus, timing)
+{
+    VirtualClockOSInterface              clock;
+    SimulatedCANBus                      bus(clock, {.bitrate = 125000, .ackDelay_us = 2000}); // 8 us per bit.
+    std::unique_ptr<SimulatedCANBusNode> sender(bus.newCANInterfaceConnection("sender"));
+    std::unique_ptr<SimulatedCANBusNode> receiver(bus.newCANInterfaceConnection("receiver"));
+
+    CANFrame       frame     = SimulatedCANBus_frame(0x18DA0201, 8);
+    uint32_t       stuffBits = 0;
+    const uint32_t end_ms    = (SimulatedCANBus::getFrameBits(frame, stuffBits) * 8 + 999) / 1000;
+    ASSERT_TRUE(sender->writeFrame(&frame));
+
+    clock.advance(end_ms - 1);
+    EXPECT_FALSE(receiver->frameAvailable());
+    EXPECT_EQ(ACK_NONE, sender->getWriteFrameACK());
+    clock.advance(1);
+    EXPECT_TRUE(receiver->frameAvailable());
+    EXPECT_FALSE(sender->frameAvailable());
+    EXPECT_EQ(ACK_NONE, sender->getWriteFrameACK());
+    clock.advance(2);
+    EXPECT_EQ(ACK_SUCCESS, sender->getWriteFrameACK());
+
+    const SimulatedCANBusStatistics statistics = bus.getStatistics();
+    EXPECT_EQ(1, statistics.framesTransmitted);
+    EXPECT_EQ(statistics.bitsTransmitted * 8000, statistics.busyTime_ns);
+    EXPECT_EQ((end_ms + 2) * 1000000ULL, statistics.elapsedTime_ns);
+}
+
+TEST(SimulatedCANBus, arbitration)
+{
+    VirtualClockOSInterface              clock;
+    SimulatedCANBus                      bus(clock, {.txQueueDepth = 2});
+    std::unique_ptr<SimulatedCANBusNode> a(bus.newCANInterfaceConnection("a"));
+    std::unique_ptr<SimulatedCANBusNode> b(bus.newCANInterfaceConnection("b"));
+    std::unique_ptr<SimulatedCANBusNode> listener(bus.newCANInterfaceConnection("listener"));
+
+    // The first frame of a takes the idle bus, then b wins against the second frame of a with a lower identifier.
+    CANFrame a1 = SimulatedCANBus_frame(0x18DA0301, 1);
+    CANFrame a2 = SimulatedCANBus_frame(0x18DA0302, 1);
+    CANFrame b1 = SimulatedCANBus_frame(0x18DA0201, 1);
+    ASSERT_TRUE(a->writeFrame(&a1));
+    ASSERT_TRUE(a->writeFrame(&a2));
+    EXPECT_FALSE(a->writeFrame(&a2)); // The TX queue is full.
+    ASSERT_TRUE(b->writeFrame(&b1));
+
+    clock.advance(1);
+    CANFrame frame = {};
+    for (const CANFrame& expected : {a1, b1, a2})
+    {
+        ASSERT_TRUE(listener->readFrame(&frame));
+        EXPECT_EQ(ISOTP_GetCANId(expected.identifier), ISOTP_GetCANId(frame.identifier));
+    }
+    EXPECT_FALSE(listener->frameAvailable());
+
+    const SimulatedCANBusStatistics statistics = bus.getStatistics();
+    EXPECT_EQ(3, statistics.framesTransmitted);
+    EXPECT_EQ(1, statistics.arbitrationLosses);
+    EXPECT_EQ(1, statistics.txQueueFull);
+}
+
+TEST(SimulatedCANBus, errors)
+{
+    VirtualClockOSInterface              clock;
+    SimulatedCANBus                      bus(clock, {.errorRate = 1});
+    std::unique_ptr<SimulatedCANBusNode> sender(bus.newCANInterfaceConnection("sender"));
+
+    // Alone on the bus, the frame is not acknowledged.
+    CANFrame frame = SimulatedCANBus_frame(0x18DA0201, 8);
+    {
+        SimulatedCANBus                      cleanBus(clock);
+        std::unique_ptr<SimulatedCANBusNode> alone(cleanBus.newCANInterfaceConnection("alone"));
+        ASSERT_TRUE(alone->writeFrame(&frame));
+        clock.advance(1);
+        EXPECT_EQ(ACK_ERROR, alone->getWriteFrameACK());
+        EXPECT_EQ(1, cleanBus.getStatistics().unacknowledged);
+    }
+
+    // Every transmission is destroyed, so the frame is sent again and again.
+    std::unique_ptr<SimulatedCANBusNode> receiver(bus.newCANInterfaceConnection("receiver"));
+    ASSERT_TRUE(sender->writeFrame(&frame));
+    clock.advance(10);
+    EXPECT_FALSE(receiver->frameAvailable());
+    EXPECT_EQ(ACK_NONE, sender->getWriteFrameACK());
+    const SimulatedCANBusStatistics statistics = bus.getStatistics();
+    EXPECT_GT(statistics.busErrors, 10);
+    EXPECT_EQ(0, statistics.framesTransmitted);
+    EXPECT_GT(statistics.busyTime_ns, 9500000); // Busy since the write, but for the transmission in progress.
+}
+
+static uint32_t SimulatedCANBus_transfer(const uint32_t bitrate, SimulatedCANBusStatistics& statistics)
+{
+    VirtualClockOSInterface              clock;
+    SimulatedCANBus                      bus(clock, {.bitrate = bitrate});
+    std::unique_ptr<SimulatedCANBusNode> senderNode(bus.newCANInterfaceConnection("sender"));
+    std::unique_ptr<SimulatedCANBusNode> receiverNode(bus.newCANInterfaceConnection("receiver"));
+    TwoNodeTransfer                      transfer(clock, *senderNode, *receiverNode, {.receiverBlockSize = 8});
+
+    constexpr uint8_t message[1000] = {};
+    EXPECT_TRUE(transfer.send(message, sizeof(message)));
+    EXPECT_TRUE(transfer.runUntilDone(0, 1, 60000));
+    EXPECT_EQ(N_OK, transfer.getIndicationResult());
+
+    statistics = bus.getStatistics();
+    EXPECT_EQ(transfer.getSender().getStatistics().total.framesTx +
+                  transfer.getReceiver().getStatistics().total.framesTx,
+              statistics.framesTransmitted);
+    return clock.osMillis();
+}
+
+TEST(SimulatedCANBus, transfer)
+{
+    // At 500 kbit/s a frame is shorter than a step of ISOTP, at 20 kbit/s the bus is the bottleneck.
+    SimulatedCANBusStatistics fast{};
+    SimulatedCANBusStatistics slow{};
+    const uint32_t            fastDuration_ms = SimulatedCANBus_transfer(500000, fast);
+    const uint32_t            slowDuration_ms = SimulatedCANBus_transfer(20000, slow);
+
+    EXPECT_EQ(fast.framesTransmitted, slow.framesTransmitted);
+    EXPECT_GT(slowDuration_ms, 2 * fastDuration_ms);
+    EXPECT_GT(slow.busyTime_ns * 2, slow.elapsedTime_ns); // Mostly busy.
+    EXPECT_LT(fast.busyTime_ns * 2, fast.elapsedTime_ns); // Mostly idle.
+}
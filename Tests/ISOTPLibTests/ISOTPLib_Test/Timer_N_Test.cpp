@@ -65,3 +65,18 @@ TEST(Timer_N, getStartTimeStamp)
     ASSERT_GE(15, diff);
     ASSERT_LE(9, diff);
 }
+
+TEST(Timer_N, explicitTimeStamps)
+{
+    Timer_N timer(linuxOSInterface);
+    timer.startTimer(1000);
+    ASSERT_EQ(1000, timer.getStartTimeStamp());
+    ASSERT_EQ(1100, timer.getDeadline(100));
+    ASSERT_EQ(30, timer.getElapsedTime_ms(1030));
+    ASSERT_EQ(0, timer.getElapsedTime_ms(990)); // Sample taken before the timer was started.
+    timer.stopTimer(1050);
+    ASSERT_FALSE(timer.isTimerRunning());
+    ASSERT_EQ(50, timer.getElapsedTime_ms(2000));
+    timer.stopTimer(2000); // Stopping a stopped timer does not change the elapsed time.
+    ASSERT_EQ(50, timer.getElapsedTime_ms());
+}
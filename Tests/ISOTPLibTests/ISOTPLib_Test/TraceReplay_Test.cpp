@@ -0,0 +1,108 @@
+#include "TraceReplay.h"
+
+#include <vector>
+
+#include "ISOTP.h"
+#include "TwoNodeTransfer.h"
+#include "VirtualClockOSInterface.h"
+#include "gtest/gtest.h"
+
+static void TraceReplay_N_USData_indication_cb(N_AI, const uint8_t*, uint32_t, N_Result, Mtype)
+{
+}
+
+static bool TraceReplay_sink(const uint8_t* data, const uint32_t length, void* context)
+{
+    auto* bytes = static_cast<std::vector<uint8_t>*>(context);
+    bytes->insert(bytes->end(), data, data + length);
+    return true;
+}
+
+// Captures, on the receiver, a transfer of 3 messages of 100 bytes in a binary trace.
+static std::vector<uint8_t> TraceReplayCapture_record()
+{
+    VirtualClockOSInterface clock;
+    TwoNodeTransfer         transfer(clock, {.receiverBlockSize = 4, .receiverSTmin = {1, ms}});
+
+    ISOTP_TraceBuffer    trace(clock);
+    std::vector<uint8_t> binary;
+    ISOTP_TraceWriter    writer(trace, TraceReplay_sink, &binary);
+    transfer.getReceiver().setTraceBuffer(&trace);
+
+    constexpr uint8_t message[100] = {};
+    for (uint32_t i = 1; i <= 3; i++)
+    {
+        EXPECT_TRUE(transfer.send(message, sizeof(message)));
+        EXPECT_TRUE(transfer.runUntilDone(i, i));
+        transfer.getDriver().runFor(50);
+    }
+    writer.drain();
+    return binary;
+}
+
+TEST(TraceReplay, binaryTrace)
+{
+    const std::vector<uint8_t> binary = TraceReplayCapture_record();
+
+    for (const TraceReplayTiming timing : {TraceReplayRecordedTiming, TraceReplayAsFastAsPossible})
+    {
+        TraceReplay replay;
+        ASSERT_TRUE(replay.loadBinary(binary.data(), binary.size()));
+        EXPECT_EQ(3 * 15, replay.getFrameCount()); // The FF and 14 CFs of each message.
+
+        ISOTP receiver(2, 4096, nullptr, TraceReplay_N_USData_indication_cb, nullptr, replay.getOSInterface(),
+                       replay.getCANInterface(), 4, {1, ms}, "replayISOTP");
+        const TraceReplayReport report = replay.run(receiver, timing);
+
+        EXPECT_EQ(3 * 15, report.framesReplayed);
+        EXPECT_EQ(3 * 4 * 2, report.recordsSkipped); // The FCs written by the receiver and their ACKs.
+        EXPECT_EQ(3 * 4, report.framesWritten);      // The FCs are written again, one every 4 CFs.
+        EXPECT_EQ(3, report.pdusReassembled);
+        EXPECT_EQ(0, report.protocolErrors);
+        EXPECT_GE(report.duration_ms, TraceReplayDrainTime_ms);
+        EXPECT_GT(report.processingTotal_ns, 0);
+        EXPECT_LE(report.processingP50_ns, report.processingP99_ns);
+        EXPECT_LE(report.processingP99_ns, report.processingMax_ns);
+    }
+
+    TraceReplay replay;
+    EXPECT_FALSE(replay.loadBinary(binary.data() + 1, binary.size() - 1)); // No header.
+    std::vector<uint8_t> corrupted = binary;
+    corrupted[ISOTP_TraceHeaderSize + 8] = ISOTP_TraceEventCount;
+    EXPECT_FALSE(replay.loadBinary(corrupted.data(), corrupted.size()));
+    EXPECT_EQ(0, replay.getFrameCount());
+}
+
+TEST(TraceReplay, candumpLog)
+{
+    // A SF and a 20 byte message for 0x02, a message for another node, lines that are not 29 bit classic frames, and
+    // a FF from 0x03 whose CFs were not captured.
+    constexpr const char* log = "(0000000010.000000) can0 18DA0201#03AABBCC\n"
+                                "(0000000010.005000) can0 18DA0201#1014000102030405\n"
+                                "(0000000010.006000) can0 18DA0102#300000\n"
+                                "(0000000010.007000) can0 18DA0201#2106070809101112\n"
+                                "(0000000010.008000) can0 18DA0201#2213141516171819\n"
+                                "(0000000010.009000) can0 18DA0501#03010203\n"
+                                "(0000000010.010000) can0 123#11\n"
+                                "(0000000010.011000) can0 18DA0201##10011\n"
+                                "\n"
+                                "(0000000010.020000) can0 18DA0203#1014000102030405\n";
+
+    TraceReplay replay(1000);
+    ASSERT_TRUE(replay.loadCandump(log));
+    EXPECT_EQ(7, replay.getFrameCount());
+
+    ISOTP receiver(2, 4096, nullptr, TraceReplay_N_USData_indication_cb, nullptr, replay.getOSInterface(),
+                   replay.getCANInterface(), 0, {0, ms}, "replayISOTP");
+    const TraceReplayReport report = replay.run(receiver, TraceReplayRecordedTiming);
+
+    EXPECT_EQ(7, report.framesReplayed);
+    EXPECT_EQ(2, report.recordsSkipped);
+    EXPECT_EQ(2, report.framesWritten); // The FCs of the two FFs.
+    EXPECT_EQ(2, report.pdusReassembled);
+    EXPECT_EQ(1, report.protocolErrors);
+    EXPECT_EQ(1, report.indicationResults[N_TIMEOUT_Cr]);
+    EXPECT_GE(report.duration_ms, 20 + TraceReplayDrainTime_ms);
+
+    EXPECT_FALSE(replay.loadFile("/nonexistent/trace.log"));
+}